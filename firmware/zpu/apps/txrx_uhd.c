@@ -221,6 +221,25 @@ static void handle_udp_ctrl_packet(
         ctrl_data_out.id = USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE;
         break;
 
+    case USRP2_CTRL_ID_POKE_THESE_REGISTERS_BRO:{
+            const usrp2_ctrl_batch_t *batch_in = (usrp2_ctrl_batch_t *)payload;
+            uint32_t num_pokes = ctrl_data_in->data.batch_args.num_pokes;
+            uint32_t i;
+
+            //ensure that the packet holds all of the pokes
+            if (num_pokes > USRP2_CTRL_MAX_BATCH_POKES || payload_len <
+                sizeof(usrp2_ctrl_data_t) + num_pokes*sizeof(usrp2_ctrl_poke_t)
+            ) break;
+
+            //write the registers in order
+            for (i = 0; i < num_pokes; i++){
+                *((uint32_t *) batch_in->pokes[i].addr) = batch_in->pokes[i].data;
+            }
+            ctrl_data_out.data.batch_args.num_pokes = num_pokes;
+            ctrl_data_out.id = USRP2_CTRL_ID_POKED_THOSE_REGISTERS_DUDE;
+        }
+        break;
+
     /*******************************************************************
      * Echo test
      ******************************************************************/
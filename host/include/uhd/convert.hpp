@@ -23,7 +23,11 @@
 #include <uhd/types/otw_type.hpp>
 #include <uhd/types/ref_vector.hpp>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <complex>
 #include <string>
+#include <vector>
 
 namespace uhd{ namespace convert{
 
@@ -36,12 +40,16 @@ namespace uhd{ namespace convert{
      * A higher priority function takes precedence.
      * The general case function are the lowest.
      * Next comes the liborc implementations.
-     * Custom intrinsics implementations are highest.
+     * Then come the custom intrinsics implementations.
+     * The implementations for wider instruction sets are highest,
+     * they are registered only when the processor supports them.
      */
     enum priority_type{
         PRIORITY_GENERAL = 0,
         PRIORITY_LIBORC = 1,
         PRIORITY_CUSTOM = 2,
+        PRIORITY_AVX2 = 3,
+        PRIORITY_AVX512 = 4,
         PRIORITY_EMPTY = -1,
     };
 
@@ -85,6 +93,191 @@ namespace uhd{ namespace convert{
         size_t num_output_buffs
     );
 
+    /*!
+     * Enable or disable the converter calibration mode.
+     * In calibration mode, the first lookup of a converter times every
+     * registered implementation for the signature and selects the fastest,
+     * rather than the implementation with the highest priority.
+     * The selections are cached in a file keyed by the processor model,
+     * so later lookups and later processes skip the timing.
+     * Calibration is also enabled by the UHD_CONVERT_CALIBRATE environment variable.
+     * Disabling calibration restores the selection by priority.
+     * \param enb true to enable calibration
+     * \param cache_file the cache file path (empty for the temp directory)
+     */
+    UHD_API void set_calibration(bool enb, const std::string &cache_file = "");
+
+    //! The measured throughput of one registered converter
+    struct UHD_API benchmark_type{
+        std::string markup;
+        priority_type prio;
+        double samps_per_sec;
+        bool selected; //returned by the lookups
+    };
+
+    /*!
+     * Time every registered converter on a buffer of nsamps samples.
+     * This does not change the selected converters.
+     * \param nsamps the number of samples per conversion
+     * \return a result for every registered converter
+     */
+    UHD_API std::vector<benchmark_type> benchmark_converters(size_t nsamps = 1024);
+
+    /*!
+     * A receive stage converts otw items to complex floats
+     * and processes them in the same pass over memory.
+     * A stage may write fewer outputs than it reads inputs,
+     * and its state carries over between calls,
+     * so a stream may be fed in buffers of any size.
+     */
+    class UHD_API rx_stage : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<rx_stage> sptr;
+
+        virtual ~rx_stage(void){}
+
+        /*!
+         * Get the number of inputs that produce at most nouts outputs.
+         * \param nouts the number of outputs that fit the buffer
+         * \return the largest number of inputs to pass to the stage
+         */
+        virtual size_t get_max_inputs(size_t nouts) const = 0;
+
+        /*!
+         * Get the position of the next output in the input stream.
+         * The position is relative to the next input, in input samples:
+         * negative when the output started in an earlier call,
+         * positive when inputs are skipped before the output.
+         * \return the offset of the next output in input samples
+         */
+        virtual long get_output_offset(void) const = 0;
+
+        /*!
+         * Convert and process a buffer of otw items.
+         * \param input the otw items
+         * \param output the converted samples
+         * \param nsamps the number of input items
+         * \param scale_factor the conversion scale factor
+         * \return the number of output samples written
+         */
+        virtual size_t operator()(
+            const void *input,
+            std::complex<float> *output,
+            size_t nsamps,
+            double scale_factor
+        ) = 0;
+    };
+
+    /*!
+     * A fused receive stage converts otw items to complex floats,
+     * rotates the samples by a numerically controlled oscillator,
+     * and decimates by an integer factor, all in one pass over memory.
+     * The decimator averages each group of decim rotated samples.
+     * The oscillator phase and a partial group carry over between calls.
+     */
+    class UHD_API rx_fused_stage : public rx_stage{
+    public:
+        typedef boost::shared_ptr<rx_fused_stage> sptr;
+        typedef boost::function<sptr(void)> factory_type;
+
+        /*!
+         * Set the frequency of the rotation.
+         * A positive frequency shifts the spectrum up.
+         * \param freq the frequency in cycles per input sample
+         */
+        virtual void set_freq(double freq) = 0;
+
+        //! Get the frequency in cycles per input sample
+        virtual double get_freq(void) const = 0;
+
+        /*!
+         * Set the integer decimation factor (1 disables decimation).
+         * A partial group from earlier calls is discarded.
+         * \param decim the number of inputs per output
+         */
+        virtual void set_decim(size_t decim) = 0;
+
+        //! Get the integer decimation factor
+        virtual size_t get_decim(void) const = 0;
+
+        //! Get the number of inputs held in the partial group
+        virtual size_t get_pending(void) const = 0;
+
+        //! Reset the oscillator phase and discard the partial group
+        virtual void reset(void) = 0;
+
+        size_t get_max_inputs(size_t nouts) const{
+            return nouts*this->get_decim() - this->get_pending();
+        }
+
+        long get_output_offset(void) const{
+            return -long(this->get_pending());
+        }
+    };
+
+    /*!
+     * Register a fused receive stage for an otw type.
+     * The markup has the form fused_item32_1_to_fc32_1_<nswap or bswap>.
+     * \param markup representing the signature
+     * \param factory a function that makes a new stage
+     * \param prio the factory priority
+     */
+    UHD_API void register_rx_fused_stage(
+        const std::string &markup,
+        const rx_fused_stage::factory_type &factory,
+        priority_type prio
+    );
+
+    /*!
+     * Make a new fused receive stage for an otw type.
+     * The stage starts with no rotation and no decimation.
+     * \param otw_type the type of the input items
+     * \return a new stage from the highest priority factory
+     * \throw uhd::value_error when the otw type has no fused stage
+     */
+    UHD_API rx_fused_stage::sptr make_rx_fused_stage(const otw_type_t &otw_type);
+
+    /*!
+     * A symbol receive stage converts a stream of OFDM symbols
+     * into the layout of an FFT input: the symbols are packed
+     * back to back with nfft samples each, and the cyclic prefixes are dropped.
+     * The stream is a sequence of symbols of ncp + nfft samples,
+     * and the stage starts at the beginning of a cyclic prefix.
+     * The position in the symbol carries over between calls.
+     */
+    class UHD_API rx_symbol_stage : public rx_stage{
+    public:
+        typedef boost::shared_ptr<rx_symbol_stage> sptr;
+
+        //! Get the number of samples per symbol after the cyclic prefix
+        virtual size_t get_nfft(void) const = 0;
+
+        //! Get the number of samples in the cyclic prefix
+        virtual size_t get_ncp(void) const = 0;
+
+        /*!
+         * Set the position in the symbol of the next input.
+         * \param offset the offset from the start of the cyclic prefix
+         */
+        virtual void set_symbol_offset(size_t offset) = 0;
+
+        //! Get the position in the symbol of the next input
+        virtual size_t get_symbol_offset(void) const = 0;
+    };
+
+    /*!
+     * Make a new symbol receive stage for an otw type.
+     * The stage converts with the registered otw to complex float converter.
+     * \param otw_type the type of the input items
+     * \param nfft the number of samples per symbol after the cyclic prefix
+     * \param ncp the number of samples in the cyclic prefix
+     * \return a new stage at the start of a cyclic prefix
+     * \throw uhd::value_error when nfft is zero
+     */
+    UHD_API rx_symbol_stage::sptr make_rx_symbol_stage(
+        const otw_type_t &otw_type, size_t nfft, size_t ncp
+    );
+
 }} //namespace
 
 #endif /* INCLUDED_UHD_CONVERT_HPP */
@@ -27,6 +27,7 @@
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
+#include <vector>
 
 namespace uhd{
 
@@ -177,6 +178,97 @@ public:
         double timeout = 0.1
     ) = 0;
 
+    //! A read-only view of one channel in a borrowed receive packet
+    struct recv_view_type{
+        //! the payload of the packet, aligned to a 32-bit item
+        const void *mem;
+        //! the number of over-the-wire samples in the payload
+        size_t nsamps;
+        //! the time of the first sample in the payload
+        time_spec_t time_spec;
+    };
+
+    //! Typedef for the views of all channels in a borrowed receive
+    typedef std::vector<recv_view_type> recv_views_type;
+
+    /*!
+     * Typedef for the lease on borrowed receive packets.
+     * The packets are returned to the transport when the
+     * last copy of the lease is reset or destroyed.
+     */
+    typedef boost::shared_ptr<void> recv_lease_type;
+
+    /*!
+     * Borrow one aligned packet per channel without copy or conversion.
+     *
+     * The views point into the transport's receive buffers.
+     * The samples are left in the over-the-wire format:
+     * for sc16, each 32-bit item holds I in the upper and Q in the lower 16 bits,
+     * in the byte order of the transport (see the device application notes).
+     * The caller must drop the lease to give the buffers back to the transport;
+     * holding too many leases will starve the transport of frames.
+     *
+     * A borrow after a partial recv() returns the remainder of that packet.
+     * Borrow and recv share the same stream and metadata semantics
+     * as a recv() in one packet mode.
+     *
+     * \param views filled with one view per channel
+     * \param metadata data to fill describing the packets
+     * \param timeout the timeout in seconds to wait for a packet
+     * \return the lease on the packets, null on error (see metadata)
+     * \throw uhd::not_implemented_error when the device cannot lend buffers
+     */
+    virtual recv_lease_type borrow_recv(
+        recv_views_type &views,
+        rx_metadata_t &metadata,
+        double timeout = 0.1
+    );
+
+    //! A writable view of one channel in a borrowed send packet
+    struct send_view_type{
+        //! the payload of the packet, aligned to a 32-bit item
+        void *mem;
+        //! the most over-the-wire samples the payload can hold
+        size_t nsamps;
+    };
+
+    //! Typedef for the views of all channels in a borrowed send
+    typedef std::vector<send_view_type> send_views_type;
+
+    /*!
+     * Typedef for the commit of borrowed send packets.
+     * Call with the number of samples written into every view.
+     * Returns the number of samples sent, or zero once committed.
+     */
+    typedef boost::function<size_t(size_t)> send_commit_type;
+
+    /*!
+     * Borrow one packet per channel to fill in place, without a copy or conversion.
+     *
+     * The views point into the transport's send buffers, behind the packet headers.
+     * The samples must be written in the over-the-wire format:
+     * for sc16, each 32-bit item holds I in the upper and Q in the lower 16 bits,
+     * in the byte order of the transport (see the device application notes).
+     * The metadata applies to the borrowed packets as in a send() in one packet mode.
+     *
+     * Sending on the device is locked from the borrow until the commit,
+     * so the commit must be called on the same thread, before any other send().
+     * Dropping the commit function without calling it gives the buffers
+     * back to the transport with a zero length commit: nothing is sent
+     * over UDP or USB, and the E-Series driver gets empty frames.
+     *
+     * \param views filled with one view per channel
+     * \param metadata data describing the packets
+     * \param timeout the timeout in seconds to wait for a packet
+     * \return the commit function, empty on timeout
+     * \throw uhd::not_implemented_error when the device cannot lend buffers
+     */
+    virtual send_commit_type borrow_send(
+        send_views_type &views,
+        const tx_metadata_t &metadata,
+        double timeout = 0.1
+    );
+
     /*!
      * Get the maximum number of samples per packet on send.
      * \return the number of samples
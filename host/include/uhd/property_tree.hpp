@@ -142,6 +142,13 @@ public:
     //! Get access to a property in the tree
     template <typename T> property<T> &access(const fs_path &path);
 
+    /*!
+     * Get a handle to a property in the tree.
+     * A caller may hold the handle to skip the path lookup on each use.
+     * The handle keeps the property alive when the path is removed.
+     */
+    template <typename T> boost::shared_ptr<property<T> > handle(const fs_path &path);
+
 private:
     //! Internal create property with wild-card type
     virtual void _create(const fs_path &path, const boost::shared_ptr<void> &prop) = 0;
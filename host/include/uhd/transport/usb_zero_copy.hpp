@@ -21,6 +21,7 @@
 #include <uhd/transport/usb_device_handle.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <uhd/types/device_addr.hpp>
+#include <vector>
 
 namespace uhd { namespace transport {
 
@@ -79,6 +80,35 @@ public:
     static sptr make_wrapper(
         sptr usb_zc, size_t usb_frame_boundary = 512
     );
+
+    /*!
+     * Set the expected receive throughput of this transport.
+     * When the transport was made with the auto_tune_xfers hint,
+     * the receive transfer size and the number of transfers in flight
+     * are chosen from this rate and the observed completion latency.
+     * Otherwise, the transfer size and number remain fixed.
+     * \param bytes_per_sec the receive throughput in bytes per second
+     */
+    virtual void set_recv_rate_hint(double bytes_per_sec) = 0;
+
+    //! Get the size in bytes of newly submitted receive transfers
+    virtual size_t get_recv_xfer_size(void) const = 0;
+
+    //! Get the number of receive transfers kept in flight
+    virtual size_t get_num_recv_xfers(void) const = 0;
+
+    /*!
+     * Get a histogram of the receive completion latency:
+     * The time between a transfer completing and the caller picking it up.
+     * Bin 0 counts latencies under 2us, bin n counts latencies in [2^n, 2^(n+1)) us,
+     * and the last bin also counts any larger latency.
+     * Only a sample of the transfers is timed (one in every 16).
+     * \return a vector of timed transfer counts per bin
+     */
+    virtual std::vector<size_t> get_recv_latency_histogram(void) const = 0;
+
+    //! Get a histogram of the send completion latency (same bins as receive)
+    virtual std::vector<size_t> get_send_latency_histogram(void) const = 0;
 };
 
 }} //namespace
@@ -59,6 +59,29 @@ namespace vrt{
         bool has_tlr; boost::uint32_t tlr;
     };
 
+    /*!
+     * Definition for the continuity of a batch of vrt if packets.
+     * The settings are inputs to the batch unpack functions.
+     * The state carries over from one batch to the next;
+     * clear the has_next flags to start a new stream.
+     * The results are derived for each batch.
+     */
+    struct UHD_API if_batch_info_t{
+        //continuity settings
+        boost::uint64_t tick_rate;       //tsf ticks per tsi second, 0 when the tsf does not wrap
+        double ticks_per_payload_word32; //time step per payload word, 0 skips the time check
+
+        //continuity state (read/write)
+        bool has_next_count; size_t next_packet_count;
+        bool has_next_time; boost::uint64_t next_ticks;
+
+        //batch results
+        size_t num_sequence_gaps;  //data packets with an unexpected packet count
+        size_t num_time_gaps;      //data packets with an unexpected timestamp
+        size_t first_sequence_gap; //index of the first sequence gap or the batch size
+        size_t first_time_gap;     //index of the first time gap or the batch size
+    };
+
     /*!
      * Pack a vrt header from metadata (big endian format).
      * \param packet_buff memory to write the packed vrt header
@@ -99,6 +122,38 @@ namespace vrt{
         if_packet_info_t &if_packet_info
     );
 
+    /*!
+     * Unpack a batch of vrt headers to metadata (big endian format).
+     * The packet count and the timestamp of each data packet
+     * are checked against the packet before it in the stream.
+     * \param packet_buffs an array of pointers to the packed vrt headers
+     * \param if_packet_infos an array of if packet info (read/write)
+     * \param num_packets the number of packets in the batch
+     * \param if_batch_info the continuity of the batch (read/write)
+     */
+    UHD_API void if_hdr_unpack_batch_be(
+        const boost::uint32_t *const *packet_buffs,
+        if_packet_info_t *if_packet_infos,
+        size_t num_packets,
+        if_batch_info_t &if_batch_info
+    );
+
+    /*!
+     * Unpack a batch of vrt headers to metadata (little endian format).
+     * The packet count and the timestamp of each data packet
+     * are checked against the packet before it in the stream.
+     * \param packet_buffs an array of pointers to the packed vrt headers
+     * \param if_packet_infos an array of if packet info (read/write)
+     * \param num_packets the number of packets in the batch
+     * \param if_batch_info the continuity of the batch (read/write)
+     */
+    UHD_API void if_hdr_unpack_batch_le(
+        const boost::uint32_t *const *packet_buffs,
+        if_packet_info_t *if_packet_infos,
+        size_t num_packets,
+        if_batch_info_t &if_batch_info
+    );
+
 } //namespace vrt
 
 }} //namespace
@@ -22,6 +22,7 @@
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <vector>
 
 namespace uhd{ namespace transport{
 
@@ -91,6 +92,8 @@ namespace uhd{ namespace transport{
          * Signal to the transport that we are done with the buffer.
          * This should be called to commit the write to the transport object.
          * After calling, the referenced memory should be considered invalid.
+         * Committing zero bytes gives the buffer back without sending it;
+         * this is also what happens when the last reference is dropped.
          * \param num_bytes the number of bytes written into the buffer
          */
         virtual void commit(size_t num_bytes) = 0;
@@ -163,6 +166,29 @@ namespace uhd{ namespace transport{
          */
         virtual managed_send_buffer::sptr get_send_buff(double timeout = 0.1) = 0;
 
+        /*!
+         * Get up to max send buffers from this transport object.
+         * Only the first buffer is waited upon; the buffers that follow
+         * are taken only when they are available without waiting.
+         * The buffers should be committed in the order they were taken.
+         * Transports that can batch their commits override this call.
+         * \param buffs the new buffers are appended here
+         * \param max the maximum number of buffers to get
+         * \param timeout the timeout to get the first buffer in seconds
+         * \return the number of buffers appended
+         */
+        virtual size_t get_send_buffs(
+            std::vector<managed_send_buffer::sptr> &buffs,
+            size_t max, double timeout = 0.1
+        ){
+            for (size_t i = 0; i < max; i++){
+                managed_send_buffer::sptr buff = this->get_send_buff((i == 0)? timeout : 0.0);
+                if (buff.get() == NULL) return i;
+                buffs.push_back(buff);
+            }
+            return max;
+        }
+
         /*!
          * Get the number of send frames:
          * The number of simultaneous send buffers in use.
@@ -0,0 +1,77 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TRANSPORT_ZERO_COPY_PREFETCH_HPP
+#define INCLUDED_UHD_TRANSPORT_ZERO_COPY_PREFETCH_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace uhd{ namespace transport{
+
+/*!
+ * A prefetching zero copy interface wraps another transport.
+ * A background reader thread continuously pulls receive buffers
+ * from the wrapped transport and stores them into a ring in user-space.
+ * Calls to get_recv_buff() pop from the ring rather than the transport.
+ * This way, a stall in the application does not leave the socket
+ * buffer as the only cushion between the device and the caller.
+ *
+ * When the ring is full, the oldest buffer is dropped to make room,
+ * and the drop counter is incremented. The receive packet handler
+ * will see the missing packet as a sequence error (overflow).
+ *
+ * The send path is passed through to the wrapped transport.
+ */
+class UHD_API zero_copy_prefetch : public virtual zero_copy_if{
+public:
+    typedef boost::shared_ptr<zero_copy_prefetch> sptr;
+
+    /*!
+     * Make a new prefetching wrapper around a zero copy transport.
+     *
+     * The ring holds buffers owned by the wrapped transport,
+     * so its depth is derived from the transport's number of receive frames.
+     * A small number of frames is kept in reserve for the caller.
+     *
+     * The following hints are recognized:
+     * - prefetch_cpu: pin the reader thread to this CPU index
+     *
+     * \param xport the transport to wrap
+     * \param hints optional parameters for the prefetch reader
+     * \return a new prefetching zero copy interface
+     */
+    static sptr make(
+        zero_copy_if::sptr xport,
+        const device_addr_t &hints = device_addr_t()
+    );
+
+    //! Get the number of buffers the ring can hold
+    virtual size_t get_prefetch_depth(void) const = 0;
+
+    //! Get the number of buffers read from the transport
+    virtual size_t get_num_prefetched_frames(void) const = 0;
+
+    //! Get the number of buffers dropped because the ring was full
+    virtual size_t get_num_dropped_frames(void) const = 0;
+};
+
+}} //namespace
+
+#endif /* INCLUDED_UHD_TRANSPORT_ZERO_COPY_PREFETCH_HPP */
@@ -0,0 +1,137 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TYPES_TICK_SPEC_HPP
+#define INCLUDED_UHD_TYPES_TICK_SPEC_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/operators.hpp>
+#include <boost/cstdint.hpp>
+
+namespace uhd{
+
+    /*!
+     * A tick_spec_t holds a time as a 64-bit count of ticks at a tick rate.
+     * The arithmetic and the comparisons are exact integer operations
+     * when both operands share the tick rate, which makes the tick spec
+     * cheap enough for a timestamp per packet in the streaming code.
+     * Operands with different tick rates go through time_spec_t.
+     *
+     * With an integer tick rate, a tick count converts to a time_spec_t
+     * and back without error. A time_spec_t rounds to the nearest tick.
+     */
+    class UHD_API tick_spec_t :
+        boost::additive<tick_spec_t>,
+        boost::additive<tick_spec_t, boost::int64_t>,
+        boost::totally_ordered<tick_spec_t>
+    {
+    public:
+
+        /*!
+         * Create a tick_spec_t from a tick count.
+         * \param ticks the number of ticks (default = 0)
+         * \param tick_rate the number of ticks per second (default = 1)
+         */
+        tick_spec_t(boost::int64_t ticks = 0, double tick_rate = 1.0):
+            _ticks(ticks), _tick_rate(tick_rate)
+        {
+            /* NOP */
+        }
+
+        /*!
+         * Create a tick_spec_t from whole seconds and a tick count.
+         * This is the layout of the vrt integer and fractional timestamps.
+         * \param full_secs the whole/integer seconds count
+         * \param tick_count the fractional seconds tick count
+         * \param tick_rate the number of ticks per second
+         */
+        tick_spec_t(time_t full_secs, boost::uint64_t tick_count, double tick_rate);
+
+        /*!
+         * Create a tick_spec_t from a time_spec_t.
+         * \param time_spec the time to convert
+         * \param tick_rate the number of ticks per second
+         */
+        tick_spec_t(const time_spec_t &time_spec, double tick_rate);
+
+        //! Get the number of ticks
+        boost::int64_t get_ticks(void) const{
+            return _ticks;
+        }
+
+        //! Get the number of ticks per second
+        double get_tick_rate(void) const{
+            return _tick_rate;
+        }
+
+        /*!
+         * Convert the ticks into a time_spec_t.
+         * \return the time as whole and fractional seconds
+         */
+        time_spec_t to_time_spec(void) const;
+
+        /*!
+         * Get the ticks at another tick rate.
+         * \param tick_rate the new number of ticks per second
+         * \return the number of ticks at the new rate (rounded)
+         */
+        boost::int64_t get_ticks(double tick_rate) const;
+
+        //! Implement addable interface
+        tick_spec_t &operator+=(const tick_spec_t &rhs){
+            _ticks += (rhs._tick_rate == _tick_rate)? rhs._ticks : rhs.get_ticks(_tick_rate);
+            return *this;
+        }
+
+        //! Implement subtractable interface
+        tick_spec_t &operator-=(const tick_spec_t &rhs){
+            _ticks -= (rhs._tick_rate == _tick_rate)? rhs._ticks : rhs.get_ticks(_tick_rate);
+            return *this;
+        }
+
+        //! Add a number of ticks at this tick rate
+        tick_spec_t &operator+=(boost::int64_t ticks){
+            _ticks += ticks;
+            return *this;
+        }
+
+        //! Subtract a number of ticks at this tick rate
+        tick_spec_t &operator-=(boost::int64_t ticks){
+            _ticks -= ticks;
+            return *this;
+        }
+
+    //private time storage details
+    private: boost::int64_t _ticks; double _tick_rate;
+    };
+
+    //! Implement equality_comparable interface
+    UHD_INLINE bool operator==(const tick_spec_t &lhs, const tick_spec_t &rhs){
+        if (lhs.get_tick_rate() == rhs.get_tick_rate()) return lhs.get_ticks() == rhs.get_ticks();
+        return lhs.to_time_spec() == rhs.to_time_spec();
+    }
+
+    //! Implement less_than_comparable interface
+    UHD_INLINE bool operator<(const tick_spec_t &lhs, const tick_spec_t &rhs){
+        if (lhs.get_tick_rate() == rhs.get_tick_rate()) return lhs.get_ticks() < rhs.get_ticks();
+        return lhs.to_time_spec() < rhs.to_time_spec();
+    }
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_TYPES_TICK_SPEC_HPP */
@@ -62,7 +62,8 @@ namespace uhd{ namespace usrp{
         SUBDEV_PROP_CONNECTION,         //ro, subdev_conn_t
         SUBDEV_PROP_ENABLED,            //rw, bool
         SUBDEV_PROP_USE_LO_OFFSET,      //ro, bool
-        SUBDEV_PROP_BANDWIDTH           //rw, double
+        SUBDEV_PROP_BANDWIDTH,          //rw, double
+        SUBDEV_PROP_HOP_FREQS           //rw, std::vector<double>
     };
 
 /*!
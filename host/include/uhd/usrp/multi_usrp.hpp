@@ -424,6 +424,18 @@ public:
      */
     virtual double get_rx_bandwidth(size_t chan = 0) = 0;
 
+    /*!
+     * Precompute the RX LO settings for a list of frequencies.
+     * A later tune of the RF frontend to exactly one of these
+     * frequencies skips the synthesizer calculation and only
+     * writes the registers that differ from the current ones.
+     * An empty list clears the precomputed settings.
+     * \param freqs the RF frontend frequencies in Hz
+     * \param chan the channel index 0 to N-1
+     * \throw exception if the subdevice does not support it
+     */
+    virtual void set_rx_lo_hop_freqs(const std::vector<double> &freqs, size_t chan = 0) = 0;
+
     /*!
      * Read the RSSI value on the RX subdevice.
      * \param chan the channel index 0 to N-1
@@ -624,6 +636,18 @@ public:
      */
     virtual double get_tx_bandwidth(size_t chan = 0) = 0;
 
+    /*!
+     * Precompute the TX LO settings for a list of frequencies.
+     * A later tune of the RF frontend to exactly one of these
+     * frequencies skips the synthesizer calculation and only
+     * writes the registers that differ from the current ones.
+     * An empty list clears the precomputed settings.
+     * \param freqs the RF frontend frequencies in Hz
+     * \param chan the channel index 0 to N-1
+     * \throw exception if the subdevice does not support it
+     */
+    virtual void set_tx_lo_hop_freqs(const std::vector<double> &freqs, size_t chan = 0) = 0;
+
     /*!
      * Get the dboard interface object for the TX subdevice.
      * The dboard interface gives access to GPIOs, SPI, I2C, low-speed ADC and DAC.
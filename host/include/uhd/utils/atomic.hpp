@@ -0,0 +1,86 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_UTILS_ATOMIC_HPP
+#define INCLUDED_UHD_UTILS_ATOMIC_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/version.hpp>
+#include <boost/interprocess/detail/atomic.hpp>
+
+#if BOOST_VERSION >= 104800
+#  define BOOST_IPC_DETAIL boost::interprocess::ipcdetail
+#else
+#  define BOOST_IPC_DETAIL boost::interprocess::detail
+#endif
+
+namespace uhd{
+
+    /*!
+     * A 32-bit integer that can be atomically accessed across threads.
+     * The operations are implemented with the interprocess atomics,
+     * which map onto the compiler intrinsics on supported platforms.
+     * The write, cas, inc, and dec operations are full memory barriers,
+     * so a write is never reordered with a following read of another atomic.
+     * The read is only an acquire: later accesses stay after it.
+     */
+    class atomic_uint32_t{
+    public:
+
+        //! Create a new atomic 32-bit integer, initialized to zero
+        UHD_INLINE atomic_uint32_t(void): _num(0){
+            /* NOP */
+        }
+
+        //! Compare with cmp, swap with newval if same, return old value
+        UHD_INLINE boost::uint32_t cas(boost::uint32_t newval, boost::uint32_t cmp){
+            return BOOST_IPC_DETAIL::atomic_cas32(&_num, newval, cmp);
+        }
+
+        //! Sets the atomic integer to a new value (swap, a full barrier)
+        UHD_INLINE void write(const boost::uint32_t newval){
+            //the interprocess write is a plain store on some platforms (ex: arm, ppc)
+            boost::uint32_t oldval = this->read();
+            while (true){
+                const boost::uint32_t val = this->cas(newval, oldval);
+                if (val == oldval) return;
+                oldval = val;
+            }
+        }
+
+        //! Gets the current value of the atomic integer
+        UHD_INLINE boost::uint32_t read(void){
+            return BOOST_IPC_DETAIL::atomic_read32(&_num);
+        }
+
+        //! Increment by 1 and return the old value
+        UHD_INLINE boost::uint32_t inc(void){
+            return BOOST_IPC_DETAIL::atomic_inc32(&_num);
+        }
+
+        //! Decrement by 1 and return the old value
+        UHD_INLINE boost::uint32_t dec(void){
+            return BOOST_IPC_DETAIL::atomic_dec32(&_num);
+        }
+
+    private: volatile boost::uint32_t _num;
+    };
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_UTILS_ATOMIC_HPP */
@@ -19,6 +19,7 @@
 #define INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP
 
 #include <uhd/config.hpp>
+#include <cstddef>
 
 namespace uhd{
 
@@ -53,6 +54,20 @@ namespace uhd{
         bool realtime = true
     );
 
+    /*!
+     * Pin the current thread to a single CPU core.
+     * \param cpu the index of the core to run on
+     * \throw exception on set affinity failure
+     */
+    UHD_API void set_thread_affinity(size_t cpu);
+
+    /*!
+     * Pin the current thread to a single CPU core.
+     * Same as set_thread_affinity but does not throw on failure.
+     * \return true on success, false on failure
+     */
+    UHD_API bool set_thread_affinity_safe(size_t cpu);
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP */
@@ -104,4 +104,75 @@ static UHD_INLINE fc64_t item32_to_fc64(item32_t item, double scale_factor){
     );
 }
 
+/***********************************************************************
+ * Convert to/from the sc8 wire format:
+ * A sample is 16 bits (real in the upper byte, imag in the lower byte),
+ * two samples per item32 (the first sample in the upper 16 bits).
+ * The wire integer is the upper byte of the 16-bit dsp integer,
+ * so the scale factors of the 16-bit format apply unchanged.
+ * Conversion to the wire rounds to nearest and saturates.
+ **********************************************************************/
+static UHD_INLINE boost::uint8_t clip_sc8(int x){
+    if (x > 127) return boost::uint8_t(127);
+    if (x < -128) return boost::uint8_t(-128);
+    return boost::uint8_t(x);
+}
+
+static UHD_INLINE int round_sc8(double x){
+    x *= 1.0/256;
+    return int((x < 0)? x - 0.5 : x + 0.5);
+}
+
+static UHD_INLINE boost::uint16_t sc16_to_sc8(sc16_t num, double){
+    boost::uint16_t real = clip_sc8((int(num.real()) + 128) >> 8);
+    boost::uint16_t imag = clip_sc8((int(num.imag()) + 128) >> 8);
+    return (real << 8) | (imag << 0);
+}
+
+static UHD_INLINE boost::uint16_t fc32_to_sc8(fc32_t num, double scale_factor){
+    boost::uint16_t real = clip_sc8(round_sc8(num.real()*scale_factor));
+    boost::uint16_t imag = clip_sc8(round_sc8(num.imag()*scale_factor));
+    return (real << 8) | (imag << 0);
+}
+
+static UHD_INLINE boost::uint16_t fc64_to_sc8(fc64_t num, double scale_factor){
+    boost::uint16_t real = clip_sc8(round_sc8(num.real()*scale_factor));
+    boost::uint16_t imag = clip_sc8(round_sc8(num.imag()*scale_factor));
+    return (real << 8) | (imag << 0);
+}
+
+static UHD_INLINE sc16_t sc8_to_sc16(boost::uint16_t sample, double){
+    return sc16_t(
+        boost::int16_t(boost::int8_t(sample >> 8) << 8),
+        boost::int16_t(boost::int8_t(sample >> 0) << 8)
+    );
+}
+
+static UHD_INLINE fc32_t sc8_to_fc32(boost::uint16_t sample, double scale_factor){
+    return fc32_t(
+        float(boost::int8_t(sample >> 8)*256*scale_factor),
+        float(boost::int8_t(sample >> 0)*256*scale_factor)
+    );
+}
+
+static UHD_INLINE fc64_t sc8_to_fc64(boost::uint16_t sample, double scale_factor){
+    return fc64_t(
+        boost::int8_t(sample >> 8)*256*scale_factor,
+        boost::int8_t(sample >> 0)*256*scale_factor
+    );
+}
+
+/*!
+ * The sc8 items are half items when the sample count is odd.
+ * A receive buffer can start in the middle of an item,
+ * the buffer address tells the sample offset within the item.
+ * \param mem the address of the first sample
+ * \param offset set to the sample offset within the item (0 or 1)
+ * \return the address of the item holding the first sample
+ */
+static UHD_INLINE const item32_t *sc8_item_start(const void *mem, size_t &offset){
+    offset = (size_t(mem) & 0x3)/2;
+    return reinterpret_cast<const item32_t *>(size_t(mem) & ~size_t(0x3));
+}
+
 #endif /* INCLUDED_LIBUHD_CONVERT_COMMON_HPP */
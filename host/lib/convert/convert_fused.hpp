@@ -0,0 +1,133 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_CONVERT_FUSED_HPP
+#define INCLUDED_LIBUHD_CONVERT_FUSED_HPP
+
+#include "convert_common.hpp"
+#include <uhd/exception.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <algorithm>
+#include <cmath>
+
+/***********************************************************************
+ * Fused receive stage:
+ * The kernel converts, scales and rotates a block of items,
+ * the stage tracks the oscillator phase and averages the groups.
+ * The blocks are small so that the averaging reads from the cache.
+ *
+ * The kernel has a static function with the signature:
+ *   rotate(input, output, nsamps, scale, phase, freq)
+ * where phase and freq are in cycles and nsamps <= fused_block_size.
+ **********************************************************************/
+static const size_t fused_block_size = 256;
+
+//! The phasor at a phase in cycles with a magnitude
+static UHD_INLINE fc32_t fused_phasor(double mag, double phase){
+    return fc32_t(std::polar(mag, 2*M_PI*phase));
+}
+
+template <typename kernel> class fused_stage_impl : public uhd::convert::rx_fused_stage{
+public:
+    fused_stage_impl(void):
+        _freq(0.0), _decim(1)
+    {
+        this->reset();
+    }
+
+    void set_freq(double freq){
+        _freq = freq - boost::math::round(freq);
+    }
+
+    double get_freq(void) const{
+        return _freq;
+    }
+
+    void set_decim(size_t decim){
+        if (decim == 0) throw uhd::value_error("fused stage: decimation must be at least 1");
+        _decim = decim;
+        _accum = 0;
+        _pending = 0;
+    }
+
+    size_t get_decim(void) const{
+        return _decim;
+    }
+
+    size_t get_pending(void) const{
+        return _pending;
+    }
+
+    void reset(void){
+        _phase = 0.0;
+        _accum = 0;
+        _pending = 0;
+    }
+
+    size_t operator()(
+        const void *input, fc32_t *output,
+        size_t nsamps, double scale_factor
+    ){
+        const item32_t *items = reinterpret_cast<const item32_t *>(input);
+
+        //the groups are averaged, fold the 1/decim into the scale factor
+        const double scale = scale_factor/_decim;
+
+        fc32_t block[fused_block_size];
+        size_t nouts = 0;
+        for (size_t i = 0; i < nsamps; i += fused_block_size){
+            const size_t n = std::min(nsamps - i, fused_block_size);
+            fc32_t *rotated = (_decim == 1)? output + nouts : block;
+            kernel::rotate(items + i, rotated, n, scale, _phase, _freq);
+            _phase = std::fmod(_phase + n*_freq, 1.0);
+            nouts += (_decim == 1)? n : this->decimate(block, n, output + nouts);
+        }
+        return nouts;
+    }
+
+private:
+    double _freq, _phase;
+    size_t _decim, _pending;
+    fc32_t _accum;
+
+    size_t decimate(const fc32_t *input, size_t nsamps, fc32_t *output){
+        size_t nouts = 0;
+        for (size_t i = 0; i < nsamps;){
+            const size_t n = std::min(nsamps - i, _decim - _pending);
+            float re = _accum.real(), im = _accum.imag();
+            for (size_t j = i; j < i + n; j++){
+                re += input[j].real();
+                im += input[j].imag();
+            }
+            i += n;
+            _pending += n;
+            if (_pending == _decim){
+                output[nouts++] = fc32_t(re, im);
+                _accum = 0;
+                _pending = 0;
+            }
+            else _accum = fc32_t(re, im);
+        }
+        return nouts;
+    }
+};
+
+template <typename kernel> uhd::convert::rx_fused_stage::sptr make_fused_stage(void){
+    return uhd::convert::rx_fused_stage::sptr(new fused_stage_impl<kernel>());
+}
+
+#endif /* INCLUDED_LIBUHD_CONVERT_FUSED_HPP */
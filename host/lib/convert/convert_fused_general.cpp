@@ -0,0 +1,53 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_fused.hpp"
+#include <uhd/utils/byteswap.hpp>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * General fused kernel: one sample per iteration
+ **********************************************************************/
+template <bool bswap> struct fused_general{
+    static void rotate(
+        const item32_t *input, fc32_t *output, size_t nsamps,
+        double scale, double phase, double freq
+    ){
+        //the phasor carries the scale factor
+        const fc32_t start = fused_phasor(scale, phase);
+        float p_re = start.real(), p_im = start.imag();
+        const fc32_t step = fused_phasor(1.0, freq);
+
+        for (size_t i = 0; i < nsamps; i++){
+            const item32_t item = bswap? uhd::byteswap(input[i]) : input[i];
+            const float s_re = float(boost::int16_t(item >> 16));
+            const float s_im = float(boost::int16_t(item >> 0));
+            output[i] = fc32_t(s_re*p_re - s_im*p_im, s_re*p_im + s_im*p_re);
+            const float next_re = p_re*step.real() - p_im*step.imag();
+            p_im = p_re*step.imag() + p_im*step.real();
+            p_re = next_re;
+        }
+    }
+};
+
+UHD_STATIC_BLOCK(register_convert_fused_general){
+    register_rx_fused_stage("fused_item32_1_to_fc32_1_nswap",
+        &make_fused_stage<fused_general<false> >, PRIORITY_GENERAL);
+    register_rx_fused_stage("fused_item32_1_to_fc32_1_bswap",
+        &make_fused_stage<fused_general<true> >, PRIORITY_GENERAL);
+}
@@ -0,0 +1,96 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_fused.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * Multiply two pairs of interleaved complex floats
+ **********************************************************************/
+static UHD_INLINE __m128 cmul_sse2(__m128 a, __m128 b){
+    const __m128 sign = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    __m128 b_re = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 b_im = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 a_sw = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(a, b_re), _mm_xor_ps(_mm_mul_ps(a_sw, b_im), sign));
+}
+
+/***********************************************************************
+ * SSE2 fused kernel: four samples per iteration,
+ * each of the four lanes keeps its own phasor.
+ **********************************************************************/
+template <bool bswap> struct fused_sse2{
+    static void rotate(
+        const item32_t *input, fc32_t *output, size_t nsamps,
+        double scale, double phase, double freq
+    ){
+        //the phasors of the first four samples carry the scale factor
+        fc32_t phasors[4];
+        for (size_t k = 0; k < 4; k++){
+            phasors[k] = fused_phasor(scale, phase + k*freq);
+        }
+        __m128 ph01 = _mm_loadu_ps(reinterpret_cast<const float *>(phasors+0));
+        __m128 ph23 = _mm_loadu_ps(reinterpret_cast<const float *>(phasors+2));
+        const fc32_t step = fused_phasor(1.0, 4*freq);
+        const __m128 step4 = _mm_setr_ps(step.real(), step.imag(), step.real(), step.imag());
+
+        size_t i = 0;
+        for (; i+4 <= nsamps; i+=4){
+            __m128i tmpi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+i));
+
+            //put the shorts in the order real, imag
+            if (bswap){
+                tmpi = _mm_or_si128(_mm_slli_epi16(tmpi, 8), _mm_srli_epi16(tmpi, 8));
+            }
+            else{
+                tmpi = _mm_shufflelo_epi16(tmpi, _MM_SHUFFLE(2, 3, 0, 1));
+                tmpi = _mm_shufflehi_epi16(tmpi, _MM_SHUFFLE(2, 3, 0, 1));
+            }
+
+            //sign extend and convert
+            __m128 tmplo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(tmpi, tmpi), 16));
+            __m128 tmphi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(tmpi, tmpi), 16));
+
+            //rotate, scale, and advance the phasors
+            _mm_storeu_ps(reinterpret_cast<float *>(output+i+0), cmul_sse2(tmplo, ph01));
+            _mm_storeu_ps(reinterpret_cast<float *>(output+i+2), cmul_sse2(tmphi, ph23));
+            ph01 = cmul_sse2(ph01, step4);
+            ph23 = cmul_sse2(ph23, step4);
+        }
+
+        //convert remainder with the phasors of the lanes
+        _mm_storeu_ps(reinterpret_cast<float *>(phasors+0), ph01);
+        _mm_storeu_ps(reinterpret_cast<float *>(phasors+2), ph23);
+        for (size_t k = 0; i < nsamps; i++, k++){
+            const item32_t item = bswap? uhd::byteswap(input[i]) : input[i];
+            const fc32_t p = phasors[k];
+            const float s_re = float(boost::int16_t(item >> 16));
+            const float s_im = float(boost::int16_t(item >> 0));
+            output[i] = fc32_t(s_re*p.real() - s_im*p.imag(), s_re*p.imag() + s_im*p.real());
+        }
+    }
+};
+
+UHD_STATIC_BLOCK(register_convert_fused_with_sse2){
+    register_rx_fused_stage("fused_item32_1_to_fc32_1_nswap",
+        &make_fused_stage<fused_sse2<false> >, PRIORITY_CUSTOM);
+    register_rx_fused_stage("fused_item32_1_to_fc32_1_bswap",
+        &make_fused_stage<fused_sse2<true> >, PRIORITY_CUSTOM);
+}
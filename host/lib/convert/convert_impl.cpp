@@ -15,25 +15,67 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "cpu_features.hpp"
 #include <uhd/convert.hpp>
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/static.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/exception.hpp>
+#include <boost/tokenizer.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <fstream>
+#include <cstdlib>
+#include <limits>
+#include <map>
 
 using namespace uhd;
 
 #include "convert_pred.hpp"
 
 /***********************************************************************
- * Define types for the function tables
+ * Define types for the function tables:
+ * Every registered converter is kept as a candidate.
+ * The selected function is the highest priority candidate,
+ * or the fastest candidate once the entry is calibrated.
  **********************************************************************/
+struct fcn_candidate_type{
+    convert::priority_type prio;
+    convert::function_type fcn;
+    std::string markup;
+};
+
 struct fcn_table_entry_type{
     convert::priority_type prio;
     convert::function_type fcn;
+    std::vector<fcn_candidate_type> candidates;
+    bool calibrated;
     fcn_table_entry_type(void)
-    : prio(convert::PRIORITY_EMPTY), fcn(NULL){
+    : prio(convert::PRIORITY_EMPTY), fcn(NULL), calibrated(false){
         /* NOP */
     }
+
+    void select(const fcn_candidate_type &candidate){
+        fcn = candidate.fcn;
+        prio = candidate.prio;
+    }
+
+    void select_by_priority(void){
+        calibrated = false;
+        BOOST_FOREACH(const fcn_candidate_type &candidate, candidates){
+            if (candidate.prio == max_priority()) select(candidate);
+        }
+    }
+
+    convert::priority_type max_priority(void) const{
+        convert::priority_type max_prio = convert::PRIORITY_EMPTY;
+        BOOST_FOREACH(const fcn_candidate_type &candidate, candidates){
+            if (max_prio < candidate.prio) max_prio = candidate.prio;
+        }
+        return max_prio;
+    }
 };
 typedef std::vector<fcn_table_entry_type> fcn_table_type;
 
@@ -51,6 +93,142 @@ fcn_table_type &get_table(dir_type dir){
     UHD_THROW_INVALID_CODE_PATH();
 }
 
+/***********************************************************************
+ * Calibration state:
+ * The lock guards the selections against concurrent lookups.
+ * The cache maps a (direction, predicate) to the selected priority,
+ * it holds the lines of the cache file for this processor model.
+ **********************************************************************/
+typedef std::pair<dir_type, pred_type> cal_key_type;
+
+struct calibration_type{
+    boost::mutex mutex;
+    bool enabled;
+    bool loaded;
+    std::string cache_file;
+    std::string cpu_model;
+    std::map<cal_key_type, convert::priority_type> cache;
+
+    calibration_type(void): enabled(false), loaded(false){
+        enabled = (std::getenv("UHD_CONVERT_CALIBRATE") != NULL);
+        cpu_model = cpu_model_name();
+        if (cpu_model.empty()) cpu_model = "generic";
+    }
+};
+UHD_SINGLETON_FCN(calibration_type, get_calibration);
+
+static std::string get_default_cache_file(void){
+    const char *tmp_path = std::getenv("UHD_TEMP_PATH");
+    if (tmp_path == NULL) tmp_path = std::getenv("TMP");
+    if (tmp_path == NULL) tmp_path = std::getenv("TEMP");
+    if (tmp_path == NULL) tmp_path = std::getenv("TMPDIR");
+    if (tmp_path == NULL) tmp_path = "/tmp";
+    return (boost::filesystem::path(tmp_path) / "uhd_convert_cal.txt").string();
+}
+
+/*!
+ * Read the cache file lines for this processor model.
+ * Each line is: cpu model <tab> markup of the selection <tab> priority
+ */
+static void load_cache(calibration_type &cal){
+    cal.loaded = true;
+    std::ifstream file(cal.cache_file.c_str());
+    std::string line;
+    while (std::getline(file, line)){
+        const size_t tab0 = line.find('\t');
+        const size_t tab1 = line.rfind('\t');
+        if (tab0 == std::string::npos or tab0 == tab1) continue;
+        if (line.substr(0, tab0) != cal.cpu_model) continue;
+        try{
+            dir_type dir;
+            const pred_type pred = make_pred(line.substr(tab0+1, tab1-tab0-1), dir);
+            const int prio = boost::lexical_cast<int>(line.substr(tab1+1));
+            cal.cache[cal_key_type(dir, pred)] = convert::priority_type(prio);
+        }
+        catch(const std::exception &){
+            continue; //skip malformed lines
+        }
+    }
+}
+
+static void save_cache(calibration_type &cal, const fcn_candidate_type &selection){
+    std::ofstream file(cal.cache_file.c_str(), std::ofstream::out | std::ofstream::app);
+    file << cal.cpu_model << '\t' << selection.markup << '\t' << int(selection.prio) << std::endl;
+    if (not file) UHD_LOG << "convert: cannot write the calibration cache " << cal.cache_file << std::endl;
+}
+
+/***********************************************************************
+ * Time a converter on zeroed buffers:
+ * The number of buffers is taken from the markup.
+ * The best of several trials is kept to reject preemption.
+ **********************************************************************/
+static const size_t calibration_nsamps = 1024;
+static const size_t timing_trials = 5;
+static const size_t timing_reps = 32;
+
+static double time_converter(const fcn_candidate_type &candidate, size_t nsamps){
+    boost::tokenizer<boost::char_separator<char> > tokenizer(candidate.markup, boost::char_separator<char>("_"));
+    const std::vector<std::string> tokens(tokenizer.begin(), tokenizer.end());
+    const size_t num_inputs = boost::lexical_cast<size_t>(tokens.at(2));
+    const size_t num_outputs = boost::lexical_cast<size_t>(tokens.at(5));
+
+    //16 bytes per sample fits the widest type (fc64)
+    std::vector<std::vector<boost::uint64_t> > mem(num_inputs + num_outputs, std::vector<boost::uint64_t>(nsamps*2));
+    std::vector<const void *> input_buffs;
+    std::vector<void *> output_buffs;
+    for (size_t i = 0; i < num_inputs; i++) input_buffs.push_back(&mem[i].front());
+    for (size_t i = 0; i < num_outputs; i++) output_buffs.push_back(&mem[num_inputs + i].front());
+    const convert::input_type inputs(input_buffs);
+    const convert::output_type outputs(output_buffs);
+
+    candidate.fcn(inputs, outputs, nsamps, 1.0); //warm up
+    double best = std::numeric_limits<double>::max();
+    for (size_t trial = 0; trial < timing_trials; trial++){
+        const time_spec_t start = time_spec_t::get_system_time();
+        for (size_t rep = 0; rep < timing_reps; rep++){
+            candidate.fcn(inputs, outputs, nsamps, 1.0);
+        }
+        best = std::min(best, (time_spec_t::get_system_time() - start).get_real_secs());
+    }
+    return (nsamps*timing_reps)/std::max(best, 1e-9);
+}
+
+/*!
+ * Select the fastest candidate for a table entry,
+ * or the cached selection when it is still registered.
+ * Call with the calibration lock held.
+ */
+static void calibrate_entry(calibration_type &cal, dir_type dir, pred_type pred, fcn_table_entry_type &entry){
+    entry.calibrated = true;
+    if (entry.candidates.size() < 2) return;
+
+    if (not cal.loaded) load_cache(cal);
+    const cal_key_type key(dir, pred);
+    if (cal.cache.count(key) != 0){
+        BOOST_FOREACH(const fcn_candidate_type &candidate, entry.candidates){
+            if (candidate.prio == cal.cache[key]){
+                entry.select(candidate);
+                return;
+            }
+        }
+    }
+
+    double best_rate = 0;
+    size_t best_index = 0;
+    for (size_t i = 0; i < entry.candidates.size(); i++){
+        const double rate = time_converter(entry.candidates[i], calibration_nsamps);
+        UHD_LOG << "convert calibration: " << entry.candidates[i].markup
+            << " prio " << entry.candidates[i].prio << ": " << rate/1e6 << " Msps" << std::endl;
+        if (rate > best_rate){
+            best_rate = rate;
+            best_index = i;
+        }
+    }
+    entry.select(entry.candidates[best_index]);
+    cal.cache[key] = entry.candidates[best_index].prio;
+    save_cache(cal, entry.candidates[best_index]);
+}
+
 /***********************************************************************
  * The registry functions
  **********************************************************************/
@@ -69,11 +247,19 @@ void uhd::convert::register_converter(
     //resize the table so that its at least pred+1
     if (table.size() <= pred) table.resize(pred+1);
 
-    //register the function if higher priority
-    if (table[pred].prio < prio){
-        table[pred].fcn = fcn;
-        table[pred].prio = prio;
+    //add the candidate, the first registration of a priority is kept
+    fcn_table_entry_type &entry = table[pred];
+    BOOST_FOREACH(const fcn_candidate_type &candidate, entry.candidates){
+        if (candidate.prio == prio) return;
     }
+    fcn_candidate_type candidate;
+    candidate.prio = prio;
+    candidate.fcn = fcn;
+    candidate.markup = markup;
+    entry.candidates.push_back(candidate);
+
+    //select the highest priority function (calibrate again on lookup)
+    entry.select_by_priority();
 
     //----------------------------------------------------------------//
     UHD_LOGV(always) << "register_converter: " << markup << std::endl
@@ -85,9 +271,55 @@ void uhd::convert::register_converter(
     //----------------------------------------------------------------//
 }
 
+void uhd::convert::set_calibration(bool enb, const std::string &cache_file){
+    calibration_type &cal = get_calibration();
+    boost::mutex::scoped_lock lock(cal.mutex);
+    cal.enabled = enb;
+    cal.cache_file = cache_file;
+    cal.loaded = false;
+    cal.cache.clear();
+
+    //restore the priority selections, the lookups calibrate again
+    for (size_t dir = 0; dir < 2; dir++){
+        BOOST_FOREACH(fcn_table_entry_type &entry, get_table(dir_type(dir))){
+            entry.select_by_priority();
+        }
+    }
+}
+
+std::vector<convert::benchmark_type> uhd::convert::benchmark_converters(size_t nsamps){
+    calibration_type &cal = get_calibration();
+    boost::mutex::scoped_lock lock(cal.mutex);
+    std::vector<benchmark_type> results;
+    for (size_t dir = 0; dir < 2; dir++){
+        BOOST_FOREACH(const fcn_table_entry_type &entry, get_table(dir_type(dir))){
+            BOOST_FOREACH(const fcn_candidate_type &candidate, entry.candidates){
+                benchmark_type result;
+                result.markup = candidate.markup;
+                result.prio = candidate.prio;
+                result.samps_per_sec = time_converter(candidate, nsamps);
+                result.selected = (candidate.prio == entry.prio);
+                results.push_back(result);
+            }
+        }
+    }
+    return results;
+}
+
 /***********************************************************************
  * The converter functions
  **********************************************************************/
+static const convert::function_type &get_converter(dir_type dir, pred_type pred){
+    fcn_table_entry_type &entry = get_table(dir).at(pred);
+    calibration_type &cal = get_calibration();
+    boost::mutex::scoped_lock lock(cal.mutex);
+    if (cal.enabled and not entry.calibrated){
+        if (cal.cache_file.empty()) cal.cache_file = get_default_cache_file();
+        calibrate_entry(cal, dir, pred, entry);
+    }
+    return entry.fcn;
+}
+
 const convert::function_type &convert::get_converter_cpu_to_otw(
     const io_type_t &io_type,
     const otw_type_t &otw_type,
@@ -95,7 +327,7 @@ const convert::function_type &convert::get_converter_cpu_to_otw(
     size_t num_output_buffs
 ){
     pred_type pred = make_pred(io_type, otw_type, num_input_buffs, num_output_buffs);
-    return get_cpu_to_otw_table().at(pred).fcn;
+    return get_converter(DIR_CPU_TO_OTW, pred);
 }
 
 const convert::function_type &convert::get_converter_otw_to_cpu(
@@ -105,5 +337,52 @@ const convert::function_type &convert::get_converter_otw_to_cpu(
     size_t num_output_buffs
 ){
     pred_type pred = make_pred(io_type, otw_type, num_input_buffs, num_output_buffs);
-    return get_otw_to_cpu_table().at(pred).fcn;
+    return get_converter(DIR_OTW_TO_CPU, pred);
+}
+
+/***********************************************************************
+ * The fused receive stage registry:
+ * The markups share the converter predicates,
+ * each predicate keeps the highest priority factory.
+ **********************************************************************/
+struct fused_stage_entry_type{
+    convert::priority_type prio;
+    convert::rx_fused_stage::factory_type factory;
+};
+typedef std::map<pred_type, fused_stage_entry_type> fused_stage_table_type;
+
+UHD_SINGLETON_FCN(fused_stage_table_type, get_fused_stage_table);
+
+void uhd::convert::register_rx_fused_stage(
+    const std::string &markup,
+    const rx_fused_stage::factory_type &factory,
+    priority_type prio
+){
+    dir_type dir;
+    pred_type pred = make_pred(markup, dir);
+    if (dir != DIR_OTW_TO_CPU) throw uhd::value_error(
+        "register_rx_fused_stage: not a receive markup " + markup
+    );
+
+    fused_stage_table_type &table = get_fused_stage_table();
+    if (table.count(pred) != 0 and table[pred].prio >= prio) return;
+    table[pred].prio = prio;
+    table[pred].factory = factory;
+
+    //----------------------------------------------------------------//
+    UHD_LOGV(always) << "register_rx_fused_stage: " << markup << std::endl
+        << "    prio: " << prio << std::endl
+        << "    pred: " << pred << std::endl
+        << std::endl
+    ;
+    //----------------------------------------------------------------//
+}
+
+convert::rx_fused_stage::sptr convert::make_rx_fused_stage(const otw_type_t &otw_type){
+    pred_type pred = make_pred(io_type_t::COMPLEX_FLOAT32, otw_type, 1, 1);
+    fused_stage_table_type &table = get_fused_stage_table();
+    if (table.count(pred) == 0) throw uhd::value_error(
+        "make_rx_fused_stage: no fused stage for the otw type"
+    );
+    return table[pred].factory();
 }
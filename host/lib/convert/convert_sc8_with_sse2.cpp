@@ -0,0 +1,177 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * SSE2 converters for the sc8 wire format:
+ * Eight samples (four items) are converted per iteration.
+ * In memory, a byteswapped item holds the bytes re0, im0, re1, im1
+ * on a little endian host, the same order as the packed samples.
+ * The native order items are reversed in every 32-bit word.
+ **********************************************************************/
+template <bool bswap> static UHD_INLINE __m128i sc8_order(__m128i v){
+    if (bswap) return v;
+    v = _mm_or_si128(_mm_srli_epi16(v, 8), _mm_slli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/***********************************************************************
+ * Sample kernels: convert 8 samples to/from 16 packed bytes
+ **********************************************************************/
+struct fc32_sc8_sse2{
+    typedef fc32_t cpu_type;
+
+    static UHD_INLINE __m128i to_sc8(const fc32_t *input, double scale_factor){
+        const __m128 scalar = _mm_set_ps1(float(scale_factor/256));
+        const float *in = reinterpret_cast<const float *>(input);
+        __m128i tmpi0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+0),  scalar));
+        __m128i tmpi1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+4),  scalar));
+        __m128i tmpi2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+8),  scalar));
+        __m128i tmpi3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in+12), scalar));
+        return _mm_packs_epi16(_mm_packs_epi32(tmpi0, tmpi1), _mm_packs_epi32(tmpi2, tmpi3));
+    }
+
+    static UHD_INLINE void from_sc8(fc32_t *output, __m128i bytes, double scale_factor){
+        const __m128 scalar = _mm_set_ps1(float(scale_factor));
+        const __m128i zeroi = _mm_setzero_si128();
+        float *out = reinterpret_cast<float *>(output);
+        //the bytes go in the upper half of 16-bit words, then sign extend to 32 bits
+        __m128i tmplo = _mm_unpacklo_epi8(zeroi, bytes);
+        __m128i tmphi = _mm_unpackhi_epi8(zeroi, bytes);
+        _mm_storeu_ps(out+0,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(tmplo, tmplo), 16)), scalar));
+        _mm_storeu_ps(out+4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(tmplo, tmplo), 16)), scalar));
+        _mm_storeu_ps(out+8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(tmphi, tmphi), 16)), scalar));
+        _mm_storeu_ps(out+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(tmphi, tmphi), 16)), scalar));
+    }
+
+    static UHD_INLINE boost::uint16_t to_sc8_one(const fc32_t &num, double scale_factor){
+        return fc32_to_sc8(num, scale_factor);
+    }
+
+    static UHD_INLINE fc32_t from_sc8_one(boost::uint16_t sample, double scale_factor){
+        return sc8_to_fc32(sample, scale_factor);
+    }
+};
+
+struct sc16_sc8_sse2{
+    typedef sc16_t cpu_type;
+
+    static UHD_INLINE __m128i to_sc8(const sc16_t *input, double){
+        //round to nearest, the saturated add keeps the maximum in range
+        const __m128i half = _mm_set1_epi16(128);
+        __m128i tmplo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+0));
+        __m128i tmphi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+4));
+        tmplo = _mm_srai_epi16(_mm_adds_epi16(tmplo, half), 8);
+        tmphi = _mm_srai_epi16(_mm_adds_epi16(tmphi, half), 8);
+        return _mm_packs_epi16(tmplo, tmphi);
+    }
+
+    static UHD_INLINE void from_sc8(sc16_t *output, __m128i bytes, double){
+        const __m128i zeroi = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+0), _mm_unpacklo_epi8(zeroi, bytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+4), _mm_unpackhi_epi8(zeroi, bytes));
+    }
+
+    static UHD_INLINE boost::uint16_t to_sc8_one(const sc16_t &num, double scale_factor){
+        return sc16_to_sc8(num, scale_factor);
+    }
+
+    static UHD_INLINE sc16_t from_sc8_one(boost::uint16_t sample, double scale_factor){
+        return sc8_to_sc16(sample, scale_factor);
+    }
+};
+
+/***********************************************************************
+ * Converters for any kernel and byte order
+ **********************************************************************/
+template <typename kernel, bool bswap>
+static void convert_cpu_to_sc8item32(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    const cpu_type *input = reinterpret_cast<const cpu_type *>(inputs[0]);
+    item32_t *output = reinterpret_cast<item32_t *>(outputs[0]);
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        const __m128i bytes = sc8_order<bswap>(kernel::to_sc8(input+i, scale_factor));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+i/2), bytes);
+    }
+
+    //convert remainder, pad an odd sample with zero
+    for (; i < nsamps; i+=2){
+        item32_t item = item32_t(kernel::to_sc8_one(input[i], scale_factor)) << 16;
+        if (i+1 < nsamps) item |= kernel::to_sc8_one(input[i+1], scale_factor);
+        output[i/2] = bswap? uhd::byteswap(item) : item;
+    }
+}
+
+template <typename kernel, bool bswap>
+static void convert_sc8item32_to_cpu(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    size_t offset = 0;
+    const item32_t *input = sc8_item_start(inputs[0], offset);
+    cpu_type *output = reinterpret_cast<cpu_type *>(outputs[0]);
+    #define sc8item32_sample(j) \
+        boost::uint16_t((bswap? uhd::byteswap(input[(j)/2]) : input[(j)/2]) >> (((j) & 1)? 0 : 16))
+
+    //convert the second half of a split item
+    size_t i = 0;
+    if (offset != 0 and nsamps != 0){
+        output[i++] = kernel::from_sc8_one(sc8item32_sample(1), scale_factor);
+        input++;
+    }
+
+    for (; i+8 <= nsamps; i+=8){
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + (i-offset)/2));
+        kernel::from_sc8(output+i, sc8_order<bswap>(bytes), scale_factor);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = kernel::from_sc8_one(sc8item32_sample(i-offset), scale_factor);
+    }
+    #undef sc8item32_sample
+}
+
+/***********************************************************************
+ * Register the converters
+ **********************************************************************/
+#define REGISTER_SC8_CONVERTERS(cpu_type) \
+    register_converter("convert_" #cpu_type "_1_to_sc8item32_1_nswap", \
+        &convert_cpu_to_sc8item32<cpu_type##_sc8_sse2, false>, PRIORITY_CUSTOM); \
+    register_converter("convert_" #cpu_type "_1_to_sc8item32_1_bswap", \
+        &convert_cpu_to_sc8item32<cpu_type##_sc8_sse2, true>, PRIORITY_CUSTOM); \
+    register_converter("convert_sc8item32_1_to_" #cpu_type "_1_nswap", \
+        &convert_sc8item32_to_cpu<cpu_type##_sc8_sse2, false>, PRIORITY_CUSTOM); \
+    register_converter("convert_sc8item32_1_to_" #cpu_type "_1_bswap", \
+        &convert_sc8item32_to_cpu<cpu_type##_sc8_sse2, true>, PRIORITY_CUSTOM);
+
+UHD_STATIC_BLOCK(register_convert_sc8_with_sse2){
+    REGISTER_SC8_CONVERTERS(fc32)
+    REGISTER_SC8_CONVERTERS(sc16)
+}
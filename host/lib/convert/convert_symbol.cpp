@@ -0,0 +1,110 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <algorithm>
+
+using namespace uhd;
+using namespace uhd::convert;
+
+/***********************************************************************
+ * Symbol stage:
+ * Each run of samples after a cyclic prefix is converted straight
+ * into the output with the registered converter, so the layout
+ * costs no extra pass over memory and the simd converters apply.
+ **********************************************************************/
+class rx_symbol_stage_impl : public rx_symbol_stage{
+public:
+    rx_symbol_stage_impl(const otw_type_t &otw_type, size_t nfft, size_t ncp):
+        _converter(get_converter_otw_to_cpu(io_type_t::COMPLEX_FLOAT32, otw_type, 1, 1)),
+        _bytes_per_item(otw_type.get_sample_size()),
+        _nfft(nfft), _ncp(ncp), _offset(0)
+    {
+        if (nfft == 0) throw uhd::value_error("symbol stage: nfft must be at least 1");
+    }
+
+    size_t get_nfft(void) const{
+        return _nfft;
+    }
+
+    size_t get_ncp(void) const{
+        return _ncp;
+    }
+
+    void set_symbol_offset(size_t offset){
+        _offset = offset % (_ncp + _nfft);
+    }
+
+    size_t get_symbol_offset(void) const{
+        return _offset;
+    }
+
+    size_t get_max_inputs(size_t nouts) const{
+        if (nouts == 0) return 0;
+
+        //the rest of the prefix, then the rest of this symbol
+        const size_t cp_left = (_offset < _ncp)? _ncp - _offset : 0;
+        const size_t data_left = _ncp + _nfft - std::max(_offset, _ncp);
+        if (nouts <= data_left) return cp_left + nouts;
+
+        //every further symbol starts with a prefix
+        const size_t num_prefixes = (nouts - data_left + _nfft - 1)/_nfft;
+        return cp_left + nouts + num_prefixes*_ncp;
+    }
+
+    long get_output_offset(void) const{
+        return (_offset < _ncp)? long(_ncp - _offset) : 0;
+    }
+
+    size_t operator()(
+        const void *input, std::complex<float> *output,
+        size_t nsamps, double scale_factor
+    ){
+        const char *items = reinterpret_cast<const char *>(input);
+        const size_t stride = _ncp + _nfft;
+        size_t nouts = 0;
+        while (nsamps != 0){
+            //skip the prefix, or convert the rest of the symbol
+            const bool in_prefix = _offset < _ncp;
+            const size_t n = std::min(nsamps, in_prefix? _ncp - _offset : stride - _offset);
+            if (not in_prefix){
+                _converter(items, output + nouts, n, scale_factor);
+                nouts += n;
+            }
+            items += n*_bytes_per_item;
+            nsamps -= n;
+            _offset = (_offset + n) % stride;
+        }
+        return nouts;
+    }
+
+private:
+    const function_type _converter;
+    const size_t _bytes_per_item;
+    const size_t _nfft, _ncp;
+    size_t _offset;
+};
+
+/***********************************************************************
+ * The factory function
+ **********************************************************************/
+rx_symbol_stage::sptr uhd::convert::make_rx_symbol_stage(
+    const otw_type_t &otw_type, size_t nfft, size_t ncp
+){
+    return rx_symbol_stage::sptr(new rx_symbol_stage_impl(otw_type, nfft, ncp));
+}
@@ -0,0 +1,303 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include "cpu_features.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <immintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * AVX2 converters:
+ * The functions are compiled for AVX2 with the target attribute,
+ * and registered at run time only when the processor supports AVX2.
+ * Eight samples are converted per iteration, and the multi-width
+ * variants interleave the channels in registers (width 2 and 4)
+ * or through a small block on the stack (width 3).
+ **********************************************************************/
+#define AVX2 UHD_TARGET("avx2")
+
+//! Byte shuffle from an item32 to a complex short pair and back
+template <bool bswap> AVX2 static UHD_INLINE __m256i item32_shuffle(void){
+    if (bswap) return _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+    );
+    return _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13
+    );
+}
+
+//! Pack the 32-bit integers of 8 samples into complex shorts (saturated)
+AVX2 static UHD_INLINE __m256i pack_sc16(__m256i lo, __m256i hi){
+    //the pack works per 128-bit lane, put the samples back in order
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+/***********************************************************************
+ * Sample kernels: convert 8 samples to/from 8 items32 (host order)
+ **********************************************************************/
+struct fc32_avx2{
+    typedef fc32_t cpu_type;
+
+    AVX2 static UHD_INLINE __m256i to_item32(const fc32_t *input, double scale_factor){
+        const __m256 scalar = _mm256_set1_ps(float(scale_factor));
+        __m256 tmplo = _mm256_loadu_ps(reinterpret_cast<const float *>(input+0));
+        __m256 tmphi = _mm256_loadu_ps(reinterpret_cast<const float *>(input+4));
+        return pack_sc16(
+            _mm256_cvtps_epi32(_mm256_mul_ps(tmplo, scalar)),
+            _mm256_cvtps_epi32(_mm256_mul_ps(tmphi, scalar))
+        );
+    }
+
+    AVX2 static UHD_INLINE void from_item32(fc32_t *output, __m256i items, double scale_factor){
+        const __m256 scalar = _mm256_set1_ps(float(scale_factor));
+        __m256i tmpilo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(items));
+        __m256i tmpihi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(items, 1));
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+0), _mm256_mul_ps(_mm256_cvtepi32_ps(tmpilo), scalar));
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+4), _mm256_mul_ps(_mm256_cvtepi32_ps(tmpihi), scalar));
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const fc32_t &num, double scale_factor){
+        return fc32_to_item32(num, float(scale_factor));
+    }
+
+    static UHD_INLINE fc32_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_fc32(item, float(scale_factor));
+    }
+};
+
+struct fc64_avx2{
+    typedef fc64_t cpu_type;
+
+    AVX2 static UHD_INLINE __m256i to_item32(const fc64_t *input, double scale_factor){
+        const __m256d scalar = _mm256_set1_pd(scale_factor);
+        const double *in = reinterpret_cast<const double *>(input);
+        __m128i tmpi0 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_loadu_pd(in+0),  scalar));
+        __m128i tmpi1 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_loadu_pd(in+4),  scalar));
+        __m128i tmpi2 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_loadu_pd(in+8),  scalar));
+        __m128i tmpi3 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_loadu_pd(in+12), scalar));
+        return pack_sc16(
+            _mm256_inserti128_si256(_mm256_castsi128_si256(tmpi0), tmpi1, 1),
+            _mm256_inserti128_si256(_mm256_castsi128_si256(tmpi2), tmpi3, 1)
+        );
+    }
+
+    AVX2 static UHD_INLINE void from_item32(fc64_t *output, __m256i items, double scale_factor){
+        const __m256d scalar = _mm256_set1_pd(scale_factor);
+        __m256i tmpilo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(items));
+        __m256i tmpihi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(items, 1));
+        double *out = reinterpret_cast<double *>(output);
+        _mm256_storeu_pd(out+0,  _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(tmpilo)), scalar));
+        _mm256_storeu_pd(out+4,  _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(tmpilo, 1)), scalar));
+        _mm256_storeu_pd(out+8,  _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(tmpihi)), scalar));
+        _mm256_storeu_pd(out+12, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(tmpihi, 1)), scalar));
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const fc64_t &num, double scale_factor){
+        return fc64_to_item32(num, float(scale_factor));
+    }
+
+    static UHD_INLINE fc64_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_fc64(item, float(scale_factor));
+    }
+};
+
+struct sc16_avx2{
+    typedef sc16_t cpu_type;
+
+    AVX2 static UHD_INLINE __m256i to_item32(const sc16_t *input, double){
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input));
+    }
+
+    AVX2 static UHD_INLINE void from_item32(sc16_t *output, __m256i items, double){
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), items);
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const sc16_t &num, double scale_factor){
+        return sc16_to_item32(num, scale_factor);
+    }
+
+    static UHD_INLINE sc16_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_sc16(item, scale_factor);
+    }
+};
+
+/***********************************************************************
+ * Interleave width channels of 8 items each into the output, in place
+ **********************************************************************/
+template <size_t width> AVX2 static UHD_INLINE void interleave(__m256i *v){
+    if (width == 2){
+        __m256i t0 = _mm256_unpacklo_epi32(v[0], v[1]);
+        __m256i t1 = _mm256_unpackhi_epi32(v[0], v[1]);
+        v[0] = _mm256_permute2x128_si256(t0, t1, 0x20);
+        v[1] = _mm256_permute2x128_si256(t0, t1, 0x31);
+    }
+    if (width == 4){
+        __m256i t0 = _mm256_unpacklo_epi32(v[0], v[1]);
+        __m256i t1 = _mm256_unpackhi_epi32(v[0], v[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(v[2], v[3]);
+        __m256i t3 = _mm256_unpackhi_epi32(v[2], v[3]);
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+        __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+        __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+        v[0] = _mm256_permute2x128_si256(u0, u1, 0x20);
+        v[1] = _mm256_permute2x128_si256(u2, u3, 0x20);
+        v[2] = _mm256_permute2x128_si256(u0, u1, 0x31);
+        v[3] = _mm256_permute2x128_si256(u2, u3, 0x31);
+    }
+}
+
+//! The inverse of interleave
+template <size_t width> AVX2 static UHD_INLINE void deinterleave(__m256i *v){
+    if (width == 2){
+        const __m256i evens_odds = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        __m256i t0 = _mm256_permutevar8x32_epi32(v[0], evens_odds);
+        __m256i t1 = _mm256_permutevar8x32_epi32(v[1], evens_odds);
+        v[0] = _mm256_permute2x128_si256(t0, t1, 0x20);
+        v[1] = _mm256_permute2x128_si256(t0, t1, 0x31);
+    }
+    if (width == 4){
+        __m256i u0 = _mm256_permute2x128_si256(v[0], v[2], 0x20);
+        __m256i u1 = _mm256_permute2x128_si256(v[0], v[2], 0x31);
+        __m256i u2 = _mm256_permute2x128_si256(v[1], v[3], 0x20);
+        __m256i u3 = _mm256_permute2x128_si256(v[1], v[3], 0x31);
+        __m256i t0 = _mm256_unpacklo_epi32(u0, u1);
+        __m256i t1 = _mm256_unpackhi_epi32(u0, u1);
+        __m256i t2 = _mm256_unpacklo_epi32(u2, u3);
+        __m256i t3 = _mm256_unpackhi_epi32(u2, u3);
+        v[0] = _mm256_unpacklo_epi64(t0, t2);
+        v[1] = _mm256_unpackhi_epi64(t0, t2);
+        v[2] = _mm256_unpacklo_epi64(t1, t3);
+        v[3] = _mm256_unpackhi_epi64(t1, t3);
+    }
+}
+
+/***********************************************************************
+ * Converters for any kernel, width, and byte order
+ **********************************************************************/
+template <typename kernel, size_t width, bool bswap>
+AVX2 static void convert_cpu_to_item32(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    const cpu_type *input[width];
+    for (size_t w = 0; w < width; w++) input[w] = reinterpret_cast<const cpu_type *>(inputs[w]);
+    item32_t *output = reinterpret_cast<item32_t *>(outputs[0]);
+    const __m256i shuffle = item32_shuffle<bswap>();
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        __m256i v[width];
+        for (size_t w = 0; w < width; w++){
+            v[w] = _mm256_shuffle_epi8(kernel::to_item32(input[w]+i, scale_factor), shuffle);
+        }
+        if (width == 3){
+            UHD_ALIGNED(32) item32_t block[width][8];
+            for (size_t w = 0; w < width; w++) _mm256_store_si256(reinterpret_cast<__m256i *>(block[w]), v[w]);
+            for (size_t j = 0; j < 8; j++) for (size_t w = 0; w < width; w++){
+                output[(i+j)*width + w] = block[w][j];
+            }
+            continue;
+        }
+        interleave<width>(v);
+        for (size_t w = 0; w < width; w++){
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i*width) + w, v[w]);
+        }
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++) for (size_t w = 0; w < width; w++){
+        const item32_t item = kernel::to_item32_one(input[w][i], scale_factor);
+        output[i*width + w] = bswap? uhd::byteswap(item) : item;
+    }
+
+    //clear the upper vector state for the sse code of the caller
+    _mm256_zeroupper();
+}
+
+template <typename kernel, size_t width, bool bswap>
+AVX2 static void convert_item32_to_cpu(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    const item32_t *input = reinterpret_cast<const item32_t *>(inputs[0]);
+    cpu_type *output[width];
+    for (size_t w = 0; w < width; w++) output[w] = reinterpret_cast<cpu_type *>(outputs[w]);
+    const __m256i shuffle = item32_shuffle<bswap>();
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        __m256i v[width];
+        if (width == 3){
+            UHD_ALIGNED(32) item32_t block[width][8];
+            for (size_t j = 0; j < 8; j++) for (size_t w = 0; w < width; w++){
+                block[w][j] = input[(i+j)*width + w];
+            }
+            for (size_t w = 0; w < width; w++) v[w] = _mm256_load_si256(reinterpret_cast<const __m256i *>(block[w]));
+        }
+        else{
+            for (size_t w = 0; w < width; w++){
+                v[w] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i*width) + w);
+            }
+            deinterleave<width>(v);
+        }
+        for (size_t w = 0; w < width; w++){
+            kernel::from_item32(output[w]+i, _mm256_shuffle_epi8(v[w], shuffle), scale_factor);
+        }
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++) for (size_t w = 0; w < width; w++){
+        const item32_t item = input[i*width + w];
+        output[w][i] = kernel::from_item32_one(bswap? uhd::byteswap(item) : item, scale_factor);
+    }
+
+    //clear the upper vector state for the sse code of the caller
+    _mm256_zeroupper();
+}
+
+/***********************************************************************
+ * Register the converters when the processor supports AVX2
+ **********************************************************************/
+#define REGISTER_AVX2_CONVERTERS(cpu_type, width) \
+    register_converter("convert_" #cpu_type "_" #width "_to_item32_1_nswap", \
+        &convert_cpu_to_item32<cpu_type##_avx2, width, false>, PRIORITY_AVX2); \
+    register_converter("convert_" #cpu_type "_" #width "_to_item32_1_bswap", \
+        &convert_cpu_to_item32<cpu_type##_avx2, width, true>, PRIORITY_AVX2); \
+    register_converter("convert_item32_1_to_" #cpu_type "_" #width "_nswap", \
+        &convert_item32_to_cpu<cpu_type##_avx2, width, false>, PRIORITY_AVX2); \
+    register_converter("convert_item32_1_to_" #cpu_type "_" #width "_bswap", \
+        &convert_item32_to_cpu<cpu_type##_avx2, width, true>, PRIORITY_AVX2);
+
+#define REGISTER_AVX2_CONVERTERS_WIDTHS(cpu_type) \
+    REGISTER_AVX2_CONVERTERS(cpu_type, 1) \
+    REGISTER_AVX2_CONVERTERS(cpu_type, 2) \
+    REGISTER_AVX2_CONVERTERS(cpu_type, 3) \
+    REGISTER_AVX2_CONVERTERS(cpu_type, 4)
+
+UHD_STATIC_BLOCK(register_convert_with_avx2){
+    if (not cpu_has_avx2()) return;
+    REGISTER_AVX2_CONVERTERS_WIDTHS(fc64)
+    REGISTER_AVX2_CONVERTERS_WIDTHS(fc32)
+    REGISTER_AVX2_CONVERTERS_WIDTHS(sc16)
+}
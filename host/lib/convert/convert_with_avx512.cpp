@@ -0,0 +1,207 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include "cpu_features.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <immintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * AVX-512 converters (F and BW):
+ * Sixteen samples are converted per iteration.
+ * Only the single channel converters are implemented here,
+ * the multi-width converters come from the AVX2 implementation.
+ **********************************************************************/
+#define AVX512 UHD_TARGET("avx512f,avx512bw")
+
+//! Byte shuffle from an item32 to a complex short pair and back
+template <bool bswap> AVX512 static UHD_INLINE __m512i item32_shuffle(void){
+    const __m128i lane = bswap?
+        _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) :
+        _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    return _mm512_broadcast_i32x4(lane);
+}
+
+//! Pack the 32-bit integers of 16 samples into complex shorts (saturated)
+AVX512 static UHD_INLINE __m512i pack_sc16(__m512i lo, __m512i hi){
+    //the pack works per 128-bit lane, put the samples back in order
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    return _mm512_permutexvar_epi64(order, _mm512_packs_epi32(lo, hi));
+}
+
+/***********************************************************************
+ * Sample kernels: convert 16 samples to/from 16 items32 (host order)
+ **********************************************************************/
+struct fc32_avx512{
+    typedef fc32_t cpu_type;
+
+    AVX512 static UHD_INLINE __m512i to_item32(const fc32_t *input, double scale_factor){
+        const __m512 scalar = _mm512_set1_ps(float(scale_factor));
+        __m512 tmplo = _mm512_loadu_ps(reinterpret_cast<const float *>(input+0));
+        __m512 tmphi = _mm512_loadu_ps(reinterpret_cast<const float *>(input+8));
+        return pack_sc16(
+            _mm512_cvtps_epi32(_mm512_mul_ps(tmplo, scalar)),
+            _mm512_cvtps_epi32(_mm512_mul_ps(tmphi, scalar))
+        );
+    }
+
+    AVX512 static UHD_INLINE void from_item32(fc32_t *output, __m512i items, double scale_factor){
+        const __m512 scalar = _mm512_set1_ps(float(scale_factor));
+        __m512i tmpilo = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(items));
+        __m512i tmpihi = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(items, 1));
+        _mm512_storeu_ps(reinterpret_cast<float *>(output+0), _mm512_mul_ps(_mm512_cvtepi32_ps(tmpilo), scalar));
+        _mm512_storeu_ps(reinterpret_cast<float *>(output+8), _mm512_mul_ps(_mm512_cvtepi32_ps(tmpihi), scalar));
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const fc32_t &num, double scale_factor){
+        return fc32_to_item32(num, float(scale_factor));
+    }
+
+    static UHD_INLINE fc32_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_fc32(item, float(scale_factor));
+    }
+};
+
+struct fc64_avx512{
+    typedef fc64_t cpu_type;
+
+    AVX512 static UHD_INLINE __m512i to_item32(const fc64_t *input, double scale_factor){
+        const __m512d scalar = _mm512_set1_pd(scale_factor);
+        const double *in = reinterpret_cast<const double *>(input);
+        __m256i tmpi0 = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_loadu_pd(in+0),  scalar));
+        __m256i tmpi1 = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_loadu_pd(in+8),  scalar));
+        __m256i tmpi2 = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_loadu_pd(in+16), scalar));
+        __m256i tmpi3 = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_loadu_pd(in+24), scalar));
+        return pack_sc16(
+            _mm512_inserti64x4(_mm512_castsi256_si512(tmpi0), tmpi1, 1),
+            _mm512_inserti64x4(_mm512_castsi256_si512(tmpi2), tmpi3, 1)
+        );
+    }
+
+    AVX512 static UHD_INLINE void from_item32(fc64_t *output, __m512i items, double scale_factor){
+        const __m512d scalar = _mm512_set1_pd(scale_factor);
+        __m512i tmpilo = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(items));
+        __m512i tmpihi = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(items, 1));
+        double *out = reinterpret_cast<double *>(output);
+        _mm512_storeu_pd(out+0,  _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(tmpilo)), scalar));
+        _mm512_storeu_pd(out+8,  _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(tmpilo, 1)), scalar));
+        _mm512_storeu_pd(out+16, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(tmpihi)), scalar));
+        _mm512_storeu_pd(out+24, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(tmpihi, 1)), scalar));
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const fc64_t &num, double scale_factor){
+        return fc64_to_item32(num, float(scale_factor));
+    }
+
+    static UHD_INLINE fc64_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_fc64(item, float(scale_factor));
+    }
+};
+
+struct sc16_avx512{
+    typedef sc16_t cpu_type;
+
+    AVX512 static UHD_INLINE __m512i to_item32(const sc16_t *input, double){
+        return _mm512_loadu_si512(input);
+    }
+
+    AVX512 static UHD_INLINE void from_item32(sc16_t *output, __m512i items, double){
+        _mm512_storeu_si512(output, items);
+    }
+
+    static UHD_INLINE item32_t to_item32_one(const sc16_t &num, double scale_factor){
+        return sc16_to_item32(num, scale_factor);
+    }
+
+    static UHD_INLINE sc16_t from_item32_one(item32_t item, double scale_factor){
+        return item32_to_sc16(item, scale_factor);
+    }
+};
+
+/***********************************************************************
+ * Converters for any kernel and byte order
+ **********************************************************************/
+template <typename kernel, bool bswap>
+AVX512 static void convert_cpu_to_item32(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    const cpu_type *input = reinterpret_cast<const cpu_type *>(inputs[0]);
+    item32_t *output = reinterpret_cast<item32_t *>(outputs[0]);
+    const __m512i shuffle = item32_shuffle<bswap>();
+
+    size_t i = 0;
+    for (; i+16 <= nsamps; i+=16){
+        _mm512_storeu_si512(output+i, _mm512_shuffle_epi8(kernel::to_item32(input+i, scale_factor), shuffle));
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        const item32_t item = kernel::to_item32_one(input[i], scale_factor);
+        output[i] = bswap? uhd::byteswap(item) : item;
+    }
+
+    //clear the upper vector state for the sse code of the caller
+    _mm256_zeroupper();
+}
+
+template <typename kernel, bool bswap>
+AVX512 static void convert_item32_to_cpu(
+    const input_type &inputs, const output_type &outputs,
+    size_t nsamps, double scale_factor
+){
+    typedef typename kernel::cpu_type cpu_type;
+    const item32_t *input = reinterpret_cast<const item32_t *>(inputs[0]);
+    cpu_type *output = reinterpret_cast<cpu_type *>(outputs[0]);
+    const __m512i shuffle = item32_shuffle<bswap>();
+
+    size_t i = 0;
+    for (; i+16 <= nsamps; i+=16){
+        kernel::from_item32(output+i, _mm512_shuffle_epi8(_mm512_loadu_si512(input+i), shuffle), scale_factor);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = kernel::from_item32_one(bswap? uhd::byteswap(input[i]) : input[i], scale_factor);
+    }
+
+    //clear the upper vector state for the sse code of the caller
+    _mm256_zeroupper();
+}
+
+/***********************************************************************
+ * Register the converters when the processor supports AVX-512
+ **********************************************************************/
+#define REGISTER_AVX512_CONVERTERS(cpu_type) \
+    register_converter("convert_" #cpu_type "_1_to_item32_1_nswap", \
+        &convert_cpu_to_item32<cpu_type##_avx512, false>, PRIORITY_AVX512); \
+    register_converter("convert_" #cpu_type "_1_to_item32_1_bswap", \
+        &convert_cpu_to_item32<cpu_type##_avx512, true>, PRIORITY_AVX512); \
+    register_converter("convert_item32_1_to_" #cpu_type "_1_nswap", \
+        &convert_item32_to_cpu<cpu_type##_avx512, false>, PRIORITY_AVX512); \
+    register_converter("convert_item32_1_to_" #cpu_type "_1_bswap", \
+        &convert_item32_to_cpu<cpu_type##_avx512, true>, PRIORITY_AVX512);
+
+UHD_STATIC_BLOCK(register_convert_with_avx512){
+    if (not cpu_has_avx512bw()) return;
+    REGISTER_AVX512_CONVERTERS(fc64)
+    REGISTER_AVX512_CONVERTERS(fc32)
+    REGISTER_AVX512_CONVERTERS(sc16)
+}
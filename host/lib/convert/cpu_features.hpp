@@ -0,0 +1,114 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_CONVERT_CPU_FEATURES_HPP
+#define INCLUDED_LIBUHD_CONVERT_CPU_FEATURES_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    #include <cpuid.h>
+    #define UHD_HAVE_CPUID
+    #define UHD_TARGET(x) __attribute__((target(x)))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    #include <intrin.h>
+    #define UHD_HAVE_CPUID
+    #define UHD_TARGET(x)
+#else
+    #define UHD_TARGET(x)
+#endif
+
+/***********************************************************************
+ * Run-time x86 feature checks for the converter registration:
+ * The converters built for an instruction set register themselves
+ * only when both the processor and the operating system support it
+ * (the operating system must save the wider registers).
+ **********************************************************************/
+#ifdef UHD_HAVE_CPUID
+
+static UHD_INLINE void uhd_cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]){
+    #ifdef _MSC_VER
+    int r[4]; __cpuidex(r, int(leaf), int(subleaf));
+    for (size_t i = 0; i < 4; i++) regs[i] = unsigned(r[i]);
+    #else
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    if (leaf > __get_cpuid_max(leaf & 0x80000000, NULL)) return; //basic or extended range
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    #endif
+}
+
+static UHD_INLINE boost::uint64_t uhd_xgetbv(void){
+    #ifdef _MSC_VER
+    return _xgetbv(0);
+    #else
+    boost::uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (boost::uint64_t(edx) << 32) | eax;
+    #endif
+}
+
+//! True when the OS saves the register state in the mask (needs osxsave)
+static UHD_INLINE bool uhd_os_saves(const boost::uint64_t mask){
+    unsigned regs[4]; uhd_cpuid(1, 0, regs);
+    if ((regs[2] & (1 << 27)) == 0) return false; //osxsave
+    return (uhd_xgetbv() & mask) == mask;
+}
+
+static UHD_INLINE bool cpu_has_avx2(void){
+    unsigned regs[4]; uhd_cpuid(7, 0, regs);
+    if ((regs[1] & (1 << 5)) == 0) return false; //avx2
+    return uhd_os_saves(0x6); //xmm, ymm
+}
+
+static UHD_INLINE bool cpu_has_avx512bw(void){
+    unsigned regs[4]; uhd_cpuid(7, 0, regs);
+    if ((regs[1] & (1 << 16)) == 0) return false; //avx512f
+    if ((regs[1] & (1 << 30)) == 0) return false; //avx512bw
+    return uhd_os_saves(0xe6); //xmm, ymm, opmask, zmm
+}
+
+//! The processor brand string (or the vendor when there is none)
+static UHD_INLINE std::string cpu_model_name(void){
+    unsigned regs[12];
+    uhd_cpuid(0x80000000, 0, regs);
+    if (regs[0] < 0x80000004){
+        uhd_cpuid(0, 0, regs);
+        const unsigned vendor[3] = {regs[1], regs[3], regs[2]};
+        return std::string(reinterpret_cast<const char *>(vendor), sizeof(vendor));
+    }
+    for (size_t i = 0; i < 3; i++) uhd_cpuid(0x80000002 + i, 0, regs + 4*i);
+    const char *brand = reinterpret_cast<const char *>(regs);
+    const std::string name(brand, std::find(brand, brand + sizeof(regs), '\0'));
+
+    //trim the padding spaces
+    const size_t first = name.find_first_not_of(' ');
+    if (first == std::string::npos) return "";
+    return name.substr(first, name.find_last_not_of(' ') - first + 1);
+}
+
+#else
+
+static UHD_INLINE bool cpu_has_avx2(void){return false;}
+static UHD_INLINE bool cpu_has_avx512bw(void){return false;}
+static UHD_INLINE std::string cpu_model_name(void){return "";}
+
+#endif /* UHD_HAVE_CPUID */
+
+#endif /* INCLUDED_LIBUHD_CONVERT_CPU_FEATURES_HPP */
@@ -75,6 +75,40 @@ DECLARE_CONVERTER(convert_item32_1_to_$(cpu_type)_$(width)_$(swap), PRIORITY_GEN
 }
 """
 
+TMPL_CONV_TO_FROM_SC8ITEM32 = """
+DECLARE_CONVERTER(convert_$(cpu_type)_$(width)_to_sc8item32_1_$(swap), PRIORITY_GENERAL){
+    #for $w in range($width)
+    const $(cpu_type)_t *input$(w) = reinterpret_cast<const $(cpu_type)_t *>(inputs[$(w)]);
+    #end for
+    item32_t *output = reinterpret_cast<item32_t *>(outputs[0]);
+
+    //shift in two samples per item, pad an odd sample with zero
+    item32_t item = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < nsamps; i++){
+        #for $w in range($width)
+        item = (item << 16) | $(cpu_type)_to_sc8(input$(w)[i], scale_factor);
+        if ((++j & 1) == 0) *output++ = $(swap_fcn)(item);
+        #end for
+    }
+    if ((j & 1) != 0) *output = $(swap_fcn)(item32_t(item << 16));
+}
+
+DECLARE_CONVERTER(convert_sc8item32_1_to_$(cpu_type)_$(width)_$(swap), PRIORITY_GENERAL){
+    size_t j = 0;
+    const item32_t *input = sc8_item_start(inputs[0], j);
+    #for $w in range($width)
+    $(cpu_type)_t *output$(w) = reinterpret_cast<$(cpu_type)_t *>(outputs[$(w)]);
+    #end for
+
+    for (size_t i = 0; i < nsamps; i++){
+        #for $w in range($width)
+        output$(w)[i] = sc8_to_$(cpu_type)(boost::uint16_t($(swap_fcn)(input[j/2]) >> ((j & 1)? 0 : 16)), scale_factor); j++;
+        #end for
+    }
+}
+"""
+
 def parse_tmpl(_tmpl_text, **kwargs):
     from Cheetah.Template import Template
     return str(Template(_tmpl_text, kwargs))
@@ -90,4 +124,8 @@ if __name__ == '__main__':
                     TMPL_CONV_TO_FROM_ITEM32_1 if width == 1 else TMPL_CONV_TO_FROM_ITEM32_X,
                     width=width, swap=swap, swap_fcn=swap_fcn, cpu_type=cpu_type
                 )
+                output += parse_tmpl(
+                    TMPL_CONV_TO_FROM_SC8ITEM32,
+                    width=width, swap=swap, swap_fcn=swap_fcn, cpu_type=cpu_type
+                )
     open(sys.argv[1], 'w').write(output)
@@ -77,7 +77,8 @@ pred_type make_pred(const std::string &markup, dir_type &dir){
         else if (cpu_type == "sc8")  pred |= $ph.sc8_p;
         else throw pred_error("unhandled io type " + cpu_type);
 
-        if (otw_type == "item32") pred |= $ph.item32_p;
+        if      (otw_type == "item32")    pred |= $ph.item32_p;
+        else if (otw_type == "sc8item32") pred |= $ph.sc8item32_p;
         else throw pred_error("unhandled otw type " + otw_type);
 
         int num_inputs = boost::lexical_cast<int>(num_inps);
@@ -128,6 +129,14 @@ static pred_vector_type get_pred_io_type_table(void){
     return table;
 }
 
+static pred_vector_type get_pred_otw_width_table(void){
+    pred_vector_type table(pred_table_max_size, pred_table_wildcard);
+    table[0]  = $ph.item32_p; //unspecified width
+    table[16] = $ph.item32_p;
+    table[8]  = $ph.sc8item32_p;
+    return table;
+}
+
 static pred_vector_type get_pred_num_io_table(void){
     pred_vector_type table(pred_table_max_size, pred_table_wildcard);
     table[1] = $ph.chan1_p;
@@ -143,7 +152,10 @@ UHD_INLINE pred_type make_pred(
     size_t num_inputs,
     size_t num_outputs
 ){
-    pred_type pred = $ph.item32_p; //only item32 supported as of now
+    pred_type pred = 0;
+
+    static const pred_vector_type pred_otw_width_table(get_pred_otw_width_table());
+    pred |= pred_otw_width_table[pred_table_index(otw_type.width)];
 
     static const pred_vector_type pred_byte_order_table(get_pred_byte_order_table());
     pred |= pred_byte_order_table[pred_table_index(otw_type.byteorder)];
@@ -178,6 +190,7 @@ class ph:
     chan2_p  = 0b01000
     chan3_p  = 0b10000
     chan4_p  = 0b11000
+    sc8item32_p = 0b100000
 
 if __name__ == '__main__':
     import sys, os
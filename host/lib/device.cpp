@@ -153,3 +153,21 @@ device::sptr device::make(const device_addr_t &hint, size_t which){
         return dev;
     }
 }
+
+/***********************************************************************
+ * Borrow receive
+ **********************************************************************/
+device::recv_lease_type device::borrow_recv(
+    recv_views_type &, rx_metadata_t &, double
+){
+    throw uhd::not_implemented_error("borrow_recv is not supported on this device");
+}
+
+/***********************************************************************
+ * Borrow send
+ **********************************************************************/
+device::send_commit_type device::borrow_send(
+    send_views_type &, const tx_metadata_t &, double
+){
+    throw uhd::not_implemented_error("borrow_send is not supported on this device");
+}
@@ -18,8 +18,11 @@
 #include <uhd/property_tree.hpp>
 #include <uhd/types/dict.hpp>
 #include <boost/foreach.hpp>
-#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/make_shared.hpp>
+#include <algorithm>
 #include <iostream>
 
 using namespace uhd;
@@ -52,21 +55,26 @@ fs_path fs_path::branch_path(void) const{
 }
 
 fs_path uhd::operator/(const fs_path &lhs, const fs_path &rhs){
-    //strip trailing slash on left-hand-side
-    if (not lhs.empty() and *lhs.rbegin() == '/'){
-        return fs_path(lhs.substr(0, lhs.size()-1)) / rhs;
-    }
-
-    //strip leading slash on right-hand-side
-    if (not rhs.empty() and *rhs.begin() == '/'){
-        return lhs / fs_path(rhs.substr(1));
-    }
-
-    return fs_path(lhs + "/" + rhs);
+    //strip trailing slashes on left-hand-side
+    const size_t lhs_end = lhs.find_last_not_of('/') + 1; //npos + 1 == 0
+
+    //strip leading slashes on right-hand-side
+    const size_t rhs_begin = std::min(rhs.find_first_not_of('/'), rhs.size());
+
+    //join the paths in one allocation
+    fs_path path;
+    path.reserve(lhs_end + 1 + rhs.size() - rhs_begin);
+    path.append(lhs, 0, lhs_end);
+    path.append(1, '/');
+    path.append(rhs, rhs_begin, std::string::npos);
+    return path;
 }
 
 /***********************************************************************
- * Property tree implementation
+ * Property tree implementation:
+ * The nodes are also indexed by their canonical path ("/a/b/c"),
+ * so a lookup is one hash of the path rather than a walk of the tree.
+ * Lookups take a shared lock, create and remove take a unique lock.
  **********************************************************************/
 class property_tree_impl : public uhd::property_tree{
 public:
@@ -75,11 +83,12 @@ public:
         _root(root)
     {
         _guts = boost::make_shared<tree_guts_type>();
+        _guts->index[""] = &_guts->root;
     }
 
     sptr subtree(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        read_lock_type lock(_guts->mutex);
 
         property_tree_impl *subtree = new property_tree_impl(path);
         subtree->_guts = this->_guts; //copy the guts sptr
@@ -88,7 +97,7 @@ public:
 
     void remove(const fs_path &path_){
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        write_lock_type lock(_guts->mutex);
 
         node_type *parent = NULL;
         node_type *node = &_guts->root;
@@ -98,41 +107,46 @@ public:
             node = &(*node)[name];
         }
         if (parent == NULL) throw uhd::runtime_error("Cannot uproot");
+
+        //drop the node and everything below it from the index
+        const std::string key = canonical_path(path);
+        for (index_type::iterator it = _guts->index.begin(); it != _guts->index.end();){
+            if (it->first == key or it->first.compare(0, key.size()+1, key + "/") == 0){
+                it = _guts->index.erase(it);
+            }
+            else ++it;
+        }
         parent->pop(fs_path(path.leaf()));
     }
 
     bool exists(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        read_lock_type lock(_guts->mutex);
 
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) return false;
-            node = &(*node)[name];
-        }
-        return true;
+        return lookup(path) != NULL;
     }
 
     std::vector<std::string> list(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
-
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) throw_path_not_found(path);
-            node = &(*node)[name];
-        }
+        read_lock_type lock(_guts->mutex);
 
+        node_type *node = lookup(path);
+        if (node == NULL) throw_path_not_found(path);
         return node->keys();
     }
 
     void _create(const fs_path &path_, const boost::shared_ptr<void> &prop){
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        write_lock_type lock(_guts->mutex);
 
+        std::string key;
         node_type *node = &_guts->root;
         BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) (*node)[name] = node_type();
+            key += "/" + name;
+            if (not node->has_key(name)){
+                (*node)[name] = node_type();
+                _guts->index[key] = &(*node)[name];
+            }
             node = &(*node)[name];
         }
         if (node->prop.get() != NULL) throw uhd::runtime_error("Cannot create! Property already exists at: " + path);
@@ -141,13 +155,10 @@ public:
 
     boost::shared_ptr<void> &_access(const fs_path &path_) const{
         const fs_path path = _root / path_;
-        boost::mutex::scoped_lock lock(_guts->mutex);
+        read_lock_type lock(_guts->mutex);
 
-        node_type *node = &_guts->root;
-        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
-            if (not node->has_key(name)) throw_path_not_found(path);
-            node = &(*node)[name];
-        }
+        node_type *node = lookup(path);
+        if (node == NULL) throw_path_not_found(path);
         if (node->prop.get() == NULL) throw uhd::runtime_error("Cannot access! Property uninitialized at: " + path);
         return node->prop;
     }
@@ -157,15 +168,36 @@ private:
         throw uhd::lookup_error("Path not found in tree: " + path);
     }
 
+    //the index key of a path: the path without empty or trailing elements
+    static std::string canonical_path(const fs_path &path){
+        std::string key;
+        BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
+            key += "/" + name;
+        }
+        return key;
+    }
+
     //basic structural node element
     struct node_type : uhd::dict<std::string, node_type>{
         boost::shared_ptr<void> prop;
     };
 
+    typedef boost::unordered_map<std::string, node_type *> index_type;
+    typedef boost::shared_lock<boost::shared_mutex> read_lock_type;
+    typedef boost::unique_lock<boost::shared_mutex> write_lock_type;
+
+    //find a node in the index, or NULL when the path is not in the tree
+    node_type *lookup(const fs_path &path) const{
+        index_type::const_iterator it = _guts->index.find(path);
+        if (it == _guts->index.end()) it = _guts->index.find(canonical_path(path));
+        return (it == _guts->index.end())? NULL : it->second;
+    }
+
     //tree guts which may be referenced in a subtree
     struct tree_guts_type{
         node_type root;
-        boost::mutex mutex;
+        index_type index;
+        boost::shared_mutex mutex;
     };
 
     //members, the tree and root prefix
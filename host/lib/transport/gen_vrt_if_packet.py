@@ -70,6 +70,147 @@ static pred_table_type get_pred_unpack_table(void){
 
 static const pred_table_type pred_unpack_table(get_pred_unpack_table());
 
+/***********************************************************************
+ * Check the continuity of the data packets in a batch:
+ * The state lives in the checker so that it stays in registers,
+ * since the packet infos could alias the batch info.
+ **********************************************************************/
+class batch_checker{
+public:
+    batch_checker(const vrt::if_batch_info_t &if_batch_info, size_t num_packets):
+        _tick_rate(if_batch_info.tick_rate),
+        _ticks_per_payload_word32(if_batch_info.ticks_per_payload_word32),
+        _has_next_count(if_batch_info.has_next_count),
+        _next_packet_count(if_batch_info.next_packet_count),
+        _has_next_time(if_batch_info.has_next_time),
+        _next_ticks(if_batch_info.next_ticks),
+        _num_sequence_gaps(0), _first_sequence_gap(num_packets),
+        _num_time_gaps(0), _first_time_gap(num_packets),
+        _step_payload_words32(0), _step_ticks(0)
+    {
+        /* NOP */
+    }
+
+    UHD_INLINE void check(size_t i, const vrt::if_packet_info_t &if_packet_info){
+        //inline message packets are not part of the sample stream
+        if (if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA) return;
+
+        //check the packet count against the previous data packet
+        if (_has_next_count and _next_packet_count != if_packet_info.packet_count){
+            if (_num_sequence_gaps++ == 0) _first_sequence_gap = i;
+        }
+        _has_next_count = true;
+        _next_packet_count = (if_packet_info.packet_count + 1) & 0xf;
+
+        //check the timestamp against the end of the previous data packet
+        if (not if_packet_info.has_tsf or _ticks_per_payload_word32 == 0){
+            _has_next_time = false;
+            return;
+        }
+        boost::uint64_t ticks = if_packet_info.tsf;
+        if (if_packet_info.has_tsi) ticks += if_packet_info.tsi*_tick_rate;
+        if (_has_next_time and _next_ticks != ticks){
+            if (_num_time_gaps++ == 0) _first_time_gap = i;
+        }
+
+        //the time step is computed again only when the payload size changes
+        if (_step_payload_words32 != if_packet_info.num_payload_words32){
+            _step_payload_words32 = if_packet_info.num_payload_words32;
+            _step_ticks = boost::uint64_t(_step_payload_words32*_ticks_per_payload_word32 + 0.5);
+        }
+        _has_next_time = true;
+        _next_ticks = ticks + _step_ticks;
+    }
+
+    void finish(vrt::if_batch_info_t &if_batch_info) const{
+        if_batch_info.has_next_count = _has_next_count;
+        if_batch_info.next_packet_count = _next_packet_count;
+        if_batch_info.has_next_time = _has_next_time;
+        if_batch_info.next_ticks = _next_ticks;
+        if_batch_info.num_sequence_gaps = _num_sequence_gaps;
+        if_batch_info.first_sequence_gap = _first_sequence_gap;
+        if_batch_info.num_time_gaps = _num_time_gaps;
+        if_batch_info.first_time_gap = _first_time_gap;
+    }
+
+private:
+    const boost::uint64_t _tick_rate;
+    const double _ticks_per_payload_word32;
+    bool _has_next_count; size_t _next_packet_count;
+    bool _has_next_time; boost::uint64_t _next_ticks;
+    size_t _num_sequence_gaps, _first_sequence_gap;
+    size_t _num_time_gaps, _first_time_gap;
+    size_t _step_payload_words32; boost::uint64_t _step_ticks;
+};
+
+########################################################################
+#def gen_unpack_case($XE_MACRO, $pred)
+########################################################################
+        #set $num_header_words = 1
+        ########## Stream ID ##########
+        #if $pred & $sid_p
+            if_packet_info.has_sid = true;
+            if_packet_info.sid = $(XE_MACRO)(packet_buff[$num_header_words]);
+            #set $num_header_words += 1
+        #else
+            if_packet_info.has_sid = false;
+        #end if
+        ########## Class ID ##########
+        #if $pred & $cid_p
+            if_packet_info.has_cid = true;
+            if_packet_info.cid = 0; //not implemented
+            #set $num_header_words += 2
+        #else
+            if_packet_info.has_cid = false;
+        #end if
+        ########## Integer Time ##########
+        #if $pred & $tsi_p
+            if_packet_info.has_tsi = true;
+            if_packet_info.tsi = $(XE_MACRO)(packet_buff[$num_header_words]);
+            #set $num_header_words += 1
+        #else
+            if_packet_info.has_tsi = false;
+        #end if
+        ########## Fractional Time ##########
+        #if $pred & $tsf_p
+            if_packet_info.has_tsf = true;
+            if_packet_info.tsf = boost::uint64_t($(XE_MACRO)(packet_buff[$num_header_words])) << 32;
+            #set $num_header_words += 1
+            if_packet_info.tsf |= $(XE_MACRO)(packet_buff[$num_header_words]);
+            #set $num_header_words += 1
+        #else
+            if_packet_info.has_tsf = false;
+        #end if
+        ########## Trailer ##########
+        #if $pred & $tlr_p
+            if_packet_info.has_tlr = true;
+            if_packet_info.tlr = $(XE_MACRO)(packet_buff[packet_words32-1]);
+            #set $num_trailer_words = 1;
+        #else
+            if_packet_info.has_tlr = false;
+            #set $num_trailer_words = 0;
+        #end if
+        ########## Burst Flags ##########
+        #if $pred & $eob_p
+            if_packet_info.eob = true;
+        #else
+            if_packet_info.eob = false;
+        #end if
+        #if $pred & $sob_p
+            if_packet_info.sob = true;
+        #else
+            if_packet_info.sob = false;
+        #end if
+        ########## Variables ##########
+            //another failure case
+            if (packet_words32 < $($num_header_words + $num_trailer_words))
+                throw uhd::value_error("bad vrt header or invalid packet length");
+            if_packet_info.num_header_words32 = $num_header_words;
+            if_packet_info.num_payload_words32 = packet_words32 - $($num_header_words + $num_trailer_words);
+########################################################################
+#end def
+########################################################################
+
 ########################################################################
 #def gen_code($XE_MACRO, $suffix)
 ########################################################################
@@ -175,73 +316,53 @@ void vrt::if_hdr_unpack_$(suffix)(
     switch(pred){
     #for $pred in range(2**7)
     case $pred:
-        #set $has_time_spec = False
-        #set $num_header_words = 1
-        ########## Stream ID ##########
-        #if $pred & $sid_p
-            if_packet_info.has_sid = true;
-            if_packet_info.sid = $(XE_MACRO)(packet_buff[$num_header_words]);
-            #set $num_header_words += 1
-        #else
-            if_packet_info.has_sid = false;
-        #end if
-        ########## Class ID ##########
-        #if $pred & $cid_p
-            if_packet_info.has_cid = true;
-            if_packet_info.cid = 0; //not implemented
-            #set $num_header_words += 2
-        #else
-            if_packet_info.has_cid = false;
-        #end if
-        ########## Integer Time ##########
-        #if $pred & $tsi_p
-            if_packet_info.has_tsi = true;
-            if_packet_info.tsi = $(XE_MACRO)(packet_buff[$num_header_words]);
-            #set $num_header_words += 1
-        #else
-            if_packet_info.has_tsi = false;
-        #end if
-        ########## Fractional Time ##########
-        #if $pred & $tsf_p
-            if_packet_info.has_tsf = true;
-            if_packet_info.tsf = boost::uint64_t($(XE_MACRO)(packet_buff[$num_header_words])) << 32;
-            #set $num_header_words += 1
-            if_packet_info.tsf |= $(XE_MACRO)(packet_buff[$num_header_words]);
-            #set $num_header_words += 1
-        #else
-            if_packet_info.has_tsf = false;
-        #end if
-        ########## Trailer ##########
-        #if $pred & $tlr_p
-            if_packet_info.has_tlr = true;
-            if_packet_info.tlr = $(XE_MACRO)(packet_buff[packet_words32-1]);
-            #set $num_trailer_words = 1;
-        #else
-            if_packet_info.has_tlr = false;
-            #set $num_trailer_words = 0;
-        #end if
-        ########## Burst Flags ##########
-        #if $pred & $eob_p
-            if_packet_info.eob = true;
-        #else
-            if_packet_info.eob = false;
-        #end if
-        #if $pred & $sob_p
-            if_packet_info.sob = true;
-        #else
-            if_packet_info.sob = false;
-        #end if
-        ########## Variables ##########
-            //another failure case
-            if (packet_words32 < $($num_header_words + $num_trailer_words))
-                throw uhd::value_error("bad vrt header or invalid packet length");
-            if_packet_info.num_header_words32 = $num_header_words;
-            if_packet_info.num_payload_words32 = packet_words32 - $($num_header_words + $num_trailer_words);
+        $gen_unpack_case($XE_MACRO, $pred)
         break;
     #end for
     }
 }
 
+void vrt::if_hdr_unpack_batch_$(suffix)(
+    const boost::uint32_t *const *packet_buffs,
+    if_packet_info_t *if_packet_infos,
+    size_t num_packets,
+    if_batch_info_t &if_batch_info
+){
+    batch_checker checker(if_batch_info, num_packets);
+
+    //jump once per run of packets with the same header layout
+    size_t i = 0;
+    while (i < num_packets){
+        const size_t index = pred_table_index($(XE_MACRO)(packet_buffs[i][0]));
+        switch(pred_unpack_table[index]){
+        #for $pred in range(2**7)
+        case $pred:
+            do{
+                const boost::uint32_t *packet_buff = packet_buffs[i];
+                if_packet_info_t &if_packet_info = if_packet_infos[i];
+
+                //extract vrt header
+                const boost::uint32_t vrt_hdr_word = $(XE_MACRO)(packet_buff[0]);
+                const size_t packet_words32 = vrt_hdr_word & 0xffff;
+
+                //failure case
+                if (if_packet_info.num_packet_words32 < packet_words32)
+                    throw uhd::value_error("bad vrt header or packet fragment");
+
+                //extract fields from the header
+                if_packet_info.packet_type = if_packet_info_t::packet_type_t(vrt_hdr_word >> 29);
+                if_packet_info.packet_count = (vrt_hdr_word >> 16) & 0xf;
+                $gen_unpack_case($XE_MACRO, $pred)
+                checker.check(i, if_packet_info);
+            } while (++i < num_packets and pred_table_index($(XE_MACRO)(packet_buffs[i][0])) == index);
+            break;
+        #end for
+        }
+    }
+
+    checker.finish(if_batch_info);
+}
+
 ########################################################################
 #end def
 ########################################################################
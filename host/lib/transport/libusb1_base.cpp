@@ -19,8 +19,10 @@
 #include <uhd/exception.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
+#include <uhd/utils/tasks.hpp>
 #include <uhd/types/dict.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/foreach.hpp>
 #include <iostream>
@@ -36,9 +38,11 @@ public:
     libusb_session_impl(void){
         UHD_ASSERT_THROW(libusb_init(&_context) == 0);
         libusb_set_debug(_context, debug_level);
+        _event_handler_task = task::make(boost::bind(&libusb_session_impl::libusb_event_handler_task, this, _context));
     }
 
     ~libusb_session_impl(void){
+        _event_handler_task.reset();
         libusb_exit(_context);
     }
 
@@ -48,6 +52,18 @@ public:
 
 private:
     libusb_context *_context;
+    task::sptr _event_handler_task;
+
+    /*!
+     * Process libusb events for all transfers in this session.
+     * The timeout bounds how long the task takes to notice an interrupt.
+     */
+    void libusb_event_handler_task(libusb_context *context){
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 100000; /*100ms*/
+        libusb_handle_events_timeout(context, &tv);
+    }
 };
 
 libusb::session::sptr libusb::session::get_global_session(void){
@@ -39,6 +39,8 @@ namespace libusb {
      * This session class holds a global libusb context for this process.
      * The get global session call will create a new context if none exists.
      * When all references to session are destroyed, the context will be freed.
+     * The session runs a thread that handles libusb events for the context,
+     * so asynchronous transfer callbacks are called from that thread.
      */
     class session : boost::noncopyable {
     public:
@@ -18,10 +18,17 @@
 #include "libusb1_base.hpp"
 #include <uhd/transport/usb_zero_copy.hpp>
 #include <uhd/transport/buffer_pool.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
 #include <uhd/exception.hpp>
 #include <boost/foreach.hpp>
+#include <boost/format.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <cmath>
 #include <list>
 
 using namespace uhd;
@@ -30,6 +37,24 @@ using namespace uhd::transport;
 static const size_t DEFAULT_NUM_XFERS = 16;     //num xfers
 static const size_t DEFAULT_XFER_SIZE = 32*512; //bytes
 
+//! How long to wait for cancelled transfers when the transport is destroyed
+static const double CLEANUP_TIMEOUT = 0.1; //seconds
+
+//! The number of latency histogram bins (powers of two in microseconds)
+static const size_t NUM_LATENCY_BINS = 16;
+
+//! Only one in this many transfers is timed for the latency statistics
+static const size_t LATENCY_SAMPLE_INTERVAL = 16;
+
+//! Auto tuning: the time it should take to fill one receive transfer
+static const double TARGET_FILL_TIME = 0.001; //seconds
+
+//! Auto tuning: transfers kept in flight beyond the observed latency
+static const size_t DEPTH_MARGIN = 2;
+
+//! Auto tuning: completions between re-evaluations of the depth
+static const size_t RETUNE_INTERVAL = 256;
+
 //! Define LIBUSB_CALL when its missing (non-windows)
 #ifndef LIBUSB_CALL
     #define LIBUSB_CALL
@@ -40,114 +65,329 @@ static const size_t DEFAULT_XFER_SIZE = 32*512; //bytes
  * to ensure that they are compiled with the same calling convention as libusb.
  */
 
-//! helper function: handles all async callbacks
-static void LIBUSB_CALL libusb_async_cb(libusb_transfer *lut){
-    *(static_cast<bool *>(lut->user_data)) = true;
-}
+/***********************************************************************
+ * Completion queue:
+ *  - The libusb event thread pushes buffers as their transfers complete.
+ *  - The caller pops completed buffers with a timeout.
+ *  - Counts the transfers in flight so the transport can clean up.
+ *  - Measures the latency between transfer completion and pickup.
+ *    Only every LATENCY_SAMPLE_INTERVAL'th transfer is timed,
+ *    reading the clock is a system call on some platforms.
+ **********************************************************************/
+template <typename buffer_type> class libusb_completion_queue{
+public:
+    libusb_completion_queue(const size_t size):
+        _completed(size), _num_timed(0), _total_latency_us(0), _max_latency_us(0),
+        _histogram(NUM_LATENCY_BINS, 0)
+    {
+        /* NOP */
+    }
 
-/*!
- * Wait for a managed buffer to become complete.
- *
- * This routine processes async events until the transaction completes.
- * We must call the libusb handle events in a loop because the handler
- * may complete managed buffers other than the one we are waiting on.
- *
- * We cannot determine if handle events timed out or processed an event.
- * Therefore, the timeout condition is handled by using boost system time.
+    //! Push a completed buffer (called from the event thread)
+    UHD_INLINE void push(buffer_type *buff){
+        buff->completion_time = (_num_pushes.inc() % LATENCY_SAMPLE_INTERVAL == 0)?
+            boost::get_system_time() : boost::system_time(/*not a date time*/);
+        _completed.push_with_haste(buff);
+    }
+
+    //! Pop a completed buffer and its pickup latency (-1 if untimed), false on timeout
+    UHD_INLINE bool pop(buffer_type *&buff, const double timeout, boost::int64_t &latency_us){
+        if (not _completed.pop_with_timed_wait(buff, timeout)) return false;
+        latency_us = -1;
+        if (buff->completion_time.is_not_a_date_time()) return true;
+        latency_us = (boost::get_system_time() - buff->completion_time).total_microseconds();
+        if (latency_us < 0) latency_us = 0; //system time adjusted
+        this->record(latency_us);
+        return true;
+    }
+
+    //! Get a histogram of the completion to pickup latency
+    std::vector<size_t> get_latency_histogram(void) const{
+        boost::mutex::scoped_lock lock(_stats_mutex);
+        return _histogram;
+    }
+
+    //! Get a summary of the completion to pickup latency
+    std::string get_latency_stats(void) const{
+        boost::mutex::scoped_lock lock(_stats_mutex);
+        if (_num_timed == 0) return "no transfers";
+        return str(boost::format("average %.1f us, max %d us over %u timed transfers")
+            % (double(_total_latency_us)/_num_timed) % _max_latency_us % _num_timed
+        );
+    }
+
+    //! The number of transfers submitted to libusb and not yet completed
+    atomic_uint32_t num_in_flight;
+
+private:
+    //! Account for a timed transfer (once per sample interval)
+    void record(const boost::int64_t latency_us){
+        boost::mutex::scoped_lock lock(_stats_mutex);
+        _num_timed++;
+        _total_latency_us += latency_us;
+        if (latency_us > _max_latency_us) _max_latency_us = latency_us;
+        size_t bin = 0;
+        while (bin < NUM_LATENCY_BINS-1 and (latency_us >> (bin+1)) != 0) bin++;
+        _histogram[bin]++;
+    }
+
+    bounded_buffer<buffer_type *> _completed;
+    atomic_uint32_t _num_pushes;
+    mutable boost::mutex _stats_mutex;
+    size_t _num_timed;
+    boost::int64_t _total_latency_us, _max_latency_us;
+    std::vector<size_t> _histogram;
+};
+
+class libusb_zero_copy_mrb;
+
+/***********************************************************************
+ * Receive transfer tuner:
+ *  - Decides the length of each submitted receive transfer.
+ *  - Limits the number of transfers in flight (the depth).
+ *    Released buffers beyond the depth are parked until needed.
  *
- * \param ctx the libusb context structure
- * \param timeout the wait timeout in seconds
- * \param completed a reference to the completed flag
- * \return true for completion, false for timeout
- */
-UHD_INLINE bool wait_for_completion(libusb_context *ctx, const double timeout, bool &completed){
-    const boost::system_time timeout_time = boost::get_system_time() + boost::posix_time::microseconds(long(timeout*1000000));
+ * When auto tuning is enabled and the rate is known:
+ *  - The transfer size is the multiple of the minimum size
+ *    that fills in about TARGET_FILL_TIME at the expected rate.
+ *  - The depth covers the worst pickup latency seen in the last
+ *    RETUNE_INTERVAL completions, plus a margin of DEPTH_MARGIN.
+ *    The depth grows immediately and shrinks once per interval.
+ **********************************************************************/
+class libusb_recv_tuner{
+public:
+    libusb_recv_tuner(
+        atomic_uint32_t &num_in_flight,
+        const size_t max_size, const size_t min_size,
+        const size_t max_depth, const bool enabled
+    ):
+        _num_in_flight(num_in_flight),
+        _max_size(max_size), _min_size(std::min(min_size, max_size)),
+        _max_depth(max_depth), _enabled(enabled),
+        _rate(0.0), _xfer_size(max_size), _depth(max_depth),
+        _window_count(0), _window_max_latency_us(0)
+    {
+        /* NOP */
+    }
+
+    //! Submit the buffer or park it when enough transfers are in flight
+    void release(libusb_zero_copy_mrb *mrb);
+
+    //! Account for a completion and its latency (-1 if untimed), adjust the depth
+    void completed(const boost::int64_t latency_us);
 
-    while (not completed and (boost::get_system_time() < timeout_time)){
-        timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 10000; /*10ms*/
-        libusb_handle_events_timeout(ctx, &tv);
+    //! Choose the transfer size for the expected rate
+    void set_rate(const double bytes_per_sec){
+        boost::mutex::scoped_lock lock(_mutex);
+        _rate = bytes_per_sec;
+        if (not this->tuning()) return;
+
+        const size_t num_mins = std::max<size_t>(1, size_t(_rate*TARGET_FILL_TIME)/_min_size);
+        _xfer_size = std::min(num_mins*_min_size, _max_size);
+
+        //start deep, the observed latency will trim the depth down
+        _depth = _max_depth;
+        _window_count = 0;
+        _window_max_latency_us = 0;
+        this->submit_parked();
+
+        UHD_LOG << boost::format("USB recv tuning: %u byte transfers for %f bytes/sec") % _xfer_size % _rate << std::endl;
     }
 
-    return completed;
-}
+    size_t get_xfer_size(void) const{
+        boost::mutex::scoped_lock lock(_mutex);
+        return _xfer_size;
+    }
+
+    size_t get_depth(void) const{
+        boost::mutex::scoped_lock lock(_mutex);
+        return _depth;
+    }
+
+private:
+    UHD_INLINE bool tuning(void) const{
+        return _enabled and _rate > 0.0;
+    }
+
+    //! The depth needed to ride out a pickup latency
+    size_t depth_for(const boost::int64_t latency_us) const{
+        const double fill_time_us = _xfer_size/_rate*1e6;
+        const size_t depth = size_t(std::ceil(latency_us/fill_time_us)) + DEPTH_MARGIN;
+        return std::min(std::max<size_t>(depth, DEPTH_MARGIN), _max_depth);
+    }
+
+    //! Submit parked buffers while under the depth (lock must be held)
+    void submit_parked(void);
+
+    atomic_uint32_t &_num_in_flight;
+    const size_t _max_size, _min_size, _max_depth;
+    const bool _enabled;
+    mutable boost::mutex _mutex;
+    double _rate;
+    size_t _xfer_size, _depth;
+    size_t _window_count;
+    boost::int64_t _window_max_latency_us;
+    std::vector<libusb_zero_copy_mrb *> _parked;
+};
 
 /***********************************************************************
  * Reusable managed receiver buffer:
  *  - Associated with a particular libusb transfer struct.
  *  - Submits the transfer to libusb in the release method.
+ *  - Pushed into the completion queue by the transfer callback.
  **********************************************************************/
 class libusb_zero_copy_mrb : public managed_recv_buffer{
 public:
-    libusb_zero_copy_mrb(libusb_transfer *lut):
-        _ctx(libusb::session::get_global_session()->get_context()),
-        _lut(lut), _expired(false) { /* NOP */ }
+    typedef libusb_completion_queue<libusb_zero_copy_mrb> queue_type;
+
+    libusb_zero_copy_mrb(libusb_transfer *lut, queue_type &queue, libusb_recv_tuner &tuner):
+        _lut(lut), _queue(queue), _tuner(tuner), _expired(false) { /* NOP */ }
 
     void release(void){
         if (_expired) return;
-        completed = false;
-        UHD_ASSERT_THROW(libusb_submit_transfer(_lut) == 0);
         _expired = true;
+        _tuner.release(this);
     }
 
-    sptr get_new(const double timeout, size_t &index){
-        if (wait_for_completion(_ctx, timeout, completed)){
-            index++;
-            _expired = false;
-            return make_managed_buffer(this);
-        }
-        return managed_recv_buffer::sptr();
+    //! Submit the transfer to libusb with the given length
+    void submit(const size_t length){
+        _lut->length = int(length);
+        _queue.num_in_flight.inc(); //before the submit, the callback may run right away
+        const int ret = libusb_submit_transfer(_lut);
+        if (ret != 0) _queue.num_in_flight.dec();
+        UHD_ASSERT_THROW(ret == 0);
+    }
+
+    //! Submit the transfer again without handing it to the caller
+    void resubmit(void){
+        _expired = false;
+        this->release();
+    }
+
+    sptr get_new(void){
+        _expired = false;
+        return make_managed_buffer(this);
+    }
+
+    //! The libusb status of the last completed transfer
+    libusb_transfer_status get_status(void) const{
+        return _lut->status;
+    }
+
+    //! Handles the transfer completion in the libusb event thread
+    static void LIBUSB_CALL callback(libusb_transfer *lut){
+        libusb_zero_copy_mrb *mrb = static_cast<libusb_zero_copy_mrb *>(lut->user_data);
+        //cancelled transfers are only reaped when the transport is destroyed
+        if (lut->status != LIBUSB_TRANSFER_CANCELLED) mrb->_queue.push(mrb);
+        mrb->_queue.num_in_flight.dec();
     }
 
-    bool completed;
+    boost::system_time completion_time;
 
 private:
     const void *get_buff(void) const{return _lut->buffer;}
     size_t get_size(void) const{return _lut->actual_length;}
 
-    libusb_context *_ctx;
     libusb_transfer *_lut;
+    queue_type &_queue;
+    libusb_recv_tuner &_tuner;
     bool _expired;
 };
 
+/***********************************************************************
+ * Receive transfer tuner implementation (needs the mrb definition)
+ **********************************************************************/
+void libusb_recv_tuner::release(libusb_zero_copy_mrb *mrb){
+    if (not _enabled){
+        mrb->submit(_xfer_size);
+        return;
+    }
+
+    boost::mutex::scoped_lock lock(_mutex);
+    _parked.push_back(mrb);
+    this->submit_parked();
+}
+
+void libusb_recv_tuner::completed(const boost::int64_t latency_us){
+    if (not _enabled) return;
+
+    boost::mutex::scoped_lock lock(_mutex);
+    if (this->tuning()){
+        if (latency_us >= 0){ //only the sampled transfers are timed
+            _window_max_latency_us = std::max(_window_max_latency_us, latency_us);
+            _depth = std::max(_depth, this->depth_for(latency_us));
+        }
+        if (++_window_count == RETUNE_INTERVAL){
+            _depth = this->depth_for(_window_max_latency_us);
+            _window_count = 0;
+            _window_max_latency_us = 0;
+        }
+    }
+    this->submit_parked();
+}
+
+void libusb_recv_tuner::submit_parked(void){
+    while (not _parked.empty() and _num_in_flight.read() < _depth){
+        _parked.back()->submit(_xfer_size);
+        _parked.pop_back();
+    }
+}
+
 /***********************************************************************
  * Reusable managed send buffer:
  *  - Associated with a particular libusb transfer struct.
  *  - Submits the transfer to libusb in the commit method.
+ *  - Pushed into the completion queue by the transfer callback.
  **********************************************************************/
 class libusb_zero_copy_msb : public managed_send_buffer{
 public:
-    libusb_zero_copy_msb(libusb_transfer *lut):
-        _ctx(libusb::session::get_global_session()->get_context()),
-        _lut(lut), _expired(false) { /* NOP */ }
+    typedef libusb_completion_queue<libusb_zero_copy_msb> queue_type;
+
+    libusb_zero_copy_msb(libusb_transfer *lut, queue_type &queue):
+        _lut(lut), _queue(queue), _expired(false) { /* NOP */ }
 
     void commit(size_t len){
         if (_expired) return;
-        completed = false;
-        _lut->length = len;
-        if (len == 0) libusb_async_cb(_lut);
-        else UHD_ASSERT_THROW(libusb_submit_transfer(_lut) == 0);
         _expired = true;
+        _lut->length = len;
+        if (len == 0){
+            _queue.push(this); //nothing to send, its immediately available
+            return;
+        }
+        _queue.num_in_flight.inc(); //before the submit, the callback may run right away
+        const int ret = libusb_submit_transfer(_lut);
+        if (ret != 0) _queue.num_in_flight.dec();
+        UHD_ASSERT_THROW(ret == 0);
     }
 
-    sptr get_new(const double timeout, size_t &index){
-        if (wait_for_completion(_ctx, timeout, completed)){
-            index++;
-            _expired = false;
-            return make_managed_buffer(this);
+    sptr get_new(void){
+        _expired = false;
+        return make_managed_buffer(this);
+    }
+
+    //! Handles the transfer completion in the libusb event thread
+    static void LIBUSB_CALL callback(libusb_transfer *lut){
+        libusb_zero_copy_msb *msb = static_cast<libusb_zero_copy_msb *>(lut->user_data);
+        //cancelled transfers are only reaped when the transport is destroyed
+        if (lut->status == LIBUSB_TRANSFER_CANCELLED){
+            msb->_queue.num_in_flight.dec();
+            return;
         }
-        return managed_send_buffer::sptr();
+        //the buffer is free again either way, but its data did not go out
+        if (lut->status != LIBUSB_TRANSFER_COMPLETED) UHD_MSG(error)
+            << "USB send transfer failed with libusb status " << int(lut->status) << std::endl;
+        msb->_queue.push(msb);
+        msb->_queue.num_in_flight.dec();
     }
 
-    bool completed;
+    boost::system_time completion_time;
 
 private:
     void *get_buff(void) const{return _lut->buffer;}
     size_t get_size(void) const{return _lut->length;}
 
-    libusb_context *_ctx;
     libusb_transfer *_lut;
+    queue_type &_queue;
     bool _expired;
 };
 
@@ -172,8 +412,13 @@ public:
         _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_XFERS))),
         _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size)),
         _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size)),
-        _next_recv_buff_index(0),
-        _next_send_buff_index(0)
+        _recv_queue(_num_recv_frames),
+        _send_queue(_num_send_frames),
+        _recv_tuner(
+            _recv_queue.num_in_flight, _recv_frame_size,
+            size_t(hints.cast<double>("recv_frame_size_min", 512)),
+            _num_recv_frames, hints.has_key("auto_tune_xfers")
+        )
     {
         _handle->claim_interface(recv_interface);
         _handle->claim_interface(send_interface);
@@ -184,7 +429,7 @@ public:
             libusb_transfer *lut = libusb_alloc_transfer(0);
             UHD_ASSERT_THROW(lut != NULL);
 
-            _mrb_pool.push_back(boost::shared_ptr<libusb_zero_copy_mrb>(new libusb_zero_copy_mrb(lut)));
+            _mrb_pool.push_back(boost::shared_ptr<libusb_zero_copy_mrb>(new libusb_zero_copy_mrb(lut, _recv_queue, _recv_tuner)));
 
             libusb_fill_bulk_transfer(
                 lut,                                                    // transfer
@@ -192,8 +437,8 @@ public:
                 (recv_endpoint & 0x7f) | 0x80,                          // endpoint
                 static_cast<unsigned char *>(_recv_buffer_pool->at(i)), // buffer
                 this->get_recv_frame_size(),                            // length
-                libusb_transfer_cb_fn(&libusb_async_cb),                // callback
-                static_cast<void *>(&_mrb_pool.back()->completed),      // user_data
+                libusb_transfer_cb_fn(&libusb_zero_copy_mrb::callback), // callback
+                static_cast<void *>(_mrb_pool.back().get()),            // user_data
                 0                                                       // timeout (ms)
             );
 
@@ -207,7 +452,7 @@ public:
             libusb_transfer *lut = libusb_alloc_transfer(0);
             UHD_ASSERT_THROW(lut != NULL);
 
-            _msb_pool.push_back(boost::shared_ptr<libusb_zero_copy_msb>(new libusb_zero_copy_msb(lut)));
+            _msb_pool.push_back(boost::shared_ptr<libusb_zero_copy_msb>(new libusb_zero_copy_msb(lut, _send_queue)));
 
             libusb_fill_bulk_transfer(
                 lut,                                                    // transfer
@@ -215,8 +460,8 @@ public:
                 (send_endpoint & 0x7f) | 0x00,                          // endpoint
                 static_cast<unsigned char *>(_send_buffer_pool->at(i)), // buffer
                 this->get_send_frame_size(),                            // length
-                libusb_transfer_cb_fn(&libusb_async_cb),                // callback
-                static_cast<void *>(&_msb_pool.back()->completed),      // user_data
+                libusb_transfer_cb_fn(&libusb_zero_copy_msb::callback), // callback
+                static_cast<void *>(_msb_pool.back().get()),            // user_data
                 0                                                       // timeout
             );
 
@@ -226,16 +471,24 @@ public:
     }
 
     ~libusb_zero_copy_impl(void){
-        libusb_context *ctx = libusb::session::get_global_session()->get_context();
-
         //cancel all transfers
         BOOST_FOREACH(libusb_transfer *lut, _all_luts){
             libusb_cancel_transfer(lut);
         }
 
-        //process all transfers until timeout occurs
-        bool completed = false;
-        wait_for_completion(ctx, 0.01, completed);
+        //wait for the event thread to complete the cancelled transfers
+        const boost::system_time exit_time = boost::get_system_time() +
+            boost::posix_time::microseconds(long(CLEANUP_TIMEOUT*1000000));
+        while (_recv_queue.num_in_flight.read() + _send_queue.num_in_flight.read() != 0){
+            if (boost::get_system_time() > exit_time){
+                UHD_MSG(warning) << "libusb transfers did not complete on cleanup" << std::endl;
+                break;
+            }
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+
+        UHD_LOG << "USB recv completion latency: " << _recv_queue.get_latency_stats() << std::endl;
+        UHD_LOG << "USB send completion latency: " << _send_queue.get_latency_stats() << std::endl;
 
         //free all transfers
         BOOST_FOREACH(libusb_transfer *lut, _all_luts){
@@ -245,13 +498,29 @@ public:
     }
 
     managed_recv_buffer::sptr get_recv_buff(double timeout){
-        if (_next_recv_buff_index == _num_recv_frames) _next_recv_buff_index = 0;
-        return _mrb_pool[_next_recv_buff_index]->get_new(timeout, _next_recv_buff_index);
+        const boost::system_time exit_time = boost::get_system_time() +
+            boost::posix_time::microseconds(long(timeout*1000000));
+        libusb_zero_copy_mrb *mrb = NULL;
+        boost::int64_t latency_us;
+        while (_recv_queue.pop(mrb, timeout, latency_us)){
+            _recv_tuner.completed(latency_us);
+            const libusb_transfer_status status = mrb->get_status();
+            if (status == LIBUSB_TRANSFER_COMPLETED) return mrb->get_new();
+
+            //a failed transfer holds no data, submit it again and wait for the next one
+            if (status == LIBUSB_TRANSFER_NO_DEVICE) throw uhd::io_error("USB device disconnected");
+            UHD_MSG(error) << "USB receive transfer failed with libusb status " << int(status) << std::endl;
+            mrb->resubmit();
+            timeout = std::max(0.0, (exit_time - boost::get_system_time()).total_microseconds()/1e6);
+        }
+        return managed_recv_buffer::sptr();
     }
 
     managed_send_buffer::sptr get_send_buff(double timeout){
-        if (_next_send_buff_index == _num_send_frames) _next_send_buff_index = 0;
-        return _msb_pool[_next_send_buff_index]->get_new(timeout, _next_send_buff_index);
+        libusb_zero_copy_msb *msb = NULL;
+        boost::int64_t latency_us;
+        if (_send_queue.pop(msb, timeout, latency_us)) return msb->get_new();
+        return managed_send_buffer::sptr();
     }
 
     size_t get_num_recv_frames(void) const { return _num_recv_frames; }
@@ -260,6 +529,26 @@ public:
     size_t get_recv_frame_size(void) const { return _recv_frame_size; }
     size_t get_send_frame_size(void) const { return _send_frame_size; }
 
+    void set_recv_rate_hint(double bytes_per_sec){
+        _recv_tuner.set_rate(bytes_per_sec);
+    }
+
+    size_t get_recv_xfer_size(void) const{
+        return _recv_tuner.get_xfer_size();
+    }
+
+    size_t get_num_recv_xfers(void) const{
+        return _recv_tuner.get_depth();
+    }
+
+    std::vector<size_t> get_recv_latency_histogram(void) const{
+        return _recv_queue.get_latency_histogram();
+    }
+
+    std::vector<size_t> get_send_latency_histogram(void) const{
+        return _send_queue.get_latency_histogram();
+    }
+
 private:
     libusb::device_handle::sptr _handle;
     const size_t _recv_frame_size, _num_recv_frames;
@@ -267,9 +556,11 @@ private:
 
     //! Storage for transfer related objects
     buffer_pool::sptr _recv_buffer_pool, _send_buffer_pool;
+    libusb_zero_copy_mrb::queue_type _recv_queue;
+    libusb_zero_copy_msb::queue_type _send_queue;
+    libusb_recv_tuner _recv_tuner;
     std::vector<boost::shared_ptr<libusb_zero_copy_mrb> > _mrb_pool;
     std::vector<boost::shared_ptr<libusb_zero_copy_msb> > _msb_pool;
-    size_t _next_recv_buff_index, _next_send_buff_index;
 
     //! a list of all transfer structs we allocated
     std::list<libusb_transfer *> _all_luts;
@@ -23,17 +23,28 @@
 #include <uhd/convert.hpp>
 #include <uhd/device.hpp>
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
 #include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/utils/thread_priority.hpp>
 #include <uhd/types/io_type.hpp>
 #include <uhd/types/otw_type.hpp>
 #include <uhd/types/metadata.hpp>
+#include <uhd/types/tick_spec.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/utility.hpp>
 #include <boost/format.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -51,36 +62,210 @@ UHD_INLINE boost::uint32_t get_context_code(
 typedef boost::function<void(void)> handle_overflow_type;
 static inline void handle_overflow_nop(void){}
 
+/***********************************************************************
+ * Receive convert pool
+ *
+ * A pool of worker threads to copy-convert the channels of a wide group.
+ * The caller posts one job per channel and takes a share of the jobs.
+ * Worker n of N takes jobs n+1, n+1+(N+1), ... and the caller takes 0, N+1, ...
+ * Workers spin briefly on the job generation, then block on a condition,
+ * so a steady stream of packets is handed off without a context switch.
+ **********************************************************************/
+class recv_convert_pool : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<recv_convert_pool> sptr;
+
+    //! The description of a conversion for one channel
+    struct job_type{
+        const uhd::convert::function_type *converter;
+        const void *input;
+        std::vector<void *> outputs;
+        size_t nsamps;
+        double scale_factor;
+    };
+
+    /*!
+     * Make a new convert pool and start the workers.
+     * \param num_threads the number of worker threads
+     * \param first_cpu pin worker n to this cpu + n, or -1 to not pin
+     */
+    recv_convert_pool(const size_t num_threads, const int first_cpu = -1):
+        _num_threads(num_threads), _num_jobs(0), _running(true)
+    {
+        for (size_t i = 0; i < _num_threads; i++){
+            _threads.create_thread(boost::bind(&recv_convert_pool::worker_loop, this, i, first_cpu));
+        }
+    }
+
+    ~recv_convert_pool(void){
+        _running = false;
+        _generation.inc();
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _cond.notify_all();
+        }
+        _threads.join_all();
+    }
+
+    //! Get the job list to fill in before calling run
+    std::vector<job_type> &get_jobs(void){
+        return _jobs;
+    }
+
+    //! Run the first num_jobs jobs and wait for all of them to complete
+    UHD_INLINE void run(const size_t num_jobs){
+        _num_jobs = num_jobs;
+        _num_done.write(0);
+        _generation.inc(); //full barrier publishes the jobs
+        if (_num_sleeping.read() != 0){
+            boost::mutex::scoped_lock lock(_mutex);
+            _cond.notify_all();
+        }
+        this->run_share(0);
+        while (_num_done.read() != _num_threads){
+            boost::this_thread::yield();
+        }
+    }
+
+private:
+    static const size_t num_spins = 1000;
+
+    UHD_INLINE void run_share(const size_t which){
+        for (size_t i = which; i < _num_jobs; i += _num_threads + 1){
+            job_type &job = _jobs[i];
+            (*job.converter)(job.input, job.outputs, job.nsamps, job.scale_factor);
+        }
+    }
+
+    void worker_loop(const size_t index, const int first_cpu){
+        set_thread_priority_safe();
+        if (first_cpu >= 0) set_thread_affinity_safe(size_t(first_cpu) + index);
+
+        boost::uint32_t last_generation = 0; //the pool starts at generation zero
+        while (true){
+            //spin on the generation, then block until it changes
+            for (size_t i = 0; i < num_spins and _generation.read() == last_generation; i++){
+                boost::this_thread::yield();
+            }
+            if (_generation.read() == last_generation){
+                boost::mutex::scoped_lock lock(_mutex);
+                _num_sleeping.inc();
+                while (_generation.read() == last_generation) _cond.wait(lock);
+                _num_sleeping.dec();
+            }
+            last_generation = _generation.read();
+            if (not _running) return;
+
+            this->run_share(index + 1);
+            _num_done.inc();
+        }
+    }
+
+    const size_t _num_threads;
+    std::vector<job_type> _jobs;
+    size_t _num_jobs;
+    bool _running;
+    uhd::atomic_uint32_t _generation, _num_done, _num_sleeping;
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    boost::thread_group _threads;
+};
+
+/***********************************************************************
+ * Receive handler policies
+ *
+ * A device with a fixed configuration can instantiate the handler
+ * with these types instead of the run-time function objects.
+ * The per-packet calls are then direct calls that the compiler can see,
+ * rather than calls through a boost::function or a function pointer.
+ **********************************************************************/
+//! Get receive buffers from a zero copy transport
+class xport_get_recv_buff{
+public:
+    xport_get_recv_buff(void){/* NOP */}
+    xport_get_recv_buff(zero_copy_if::sptr xport): _xport(xport){/* NOP */}
+    UHD_INLINE managed_recv_buffer::sptr operator()(double timeout) const{
+        return _xport->get_recv_buff(timeout);
+    }
+private:
+    zero_copy_if::sptr _xport;
+};
+
+//! Unpack a vrt header in big endian byte order
+struct vrt_unpack_be{
+    UHD_INLINE void operator()(const boost::uint32_t *packet_buff, vrt::if_packet_info_t &if_packet_info) const{
+        vrt::if_hdr_unpack_be(packet_buff, if_packet_info);
+    }
+};
+
+//! Unpack a vrt header in little endian byte order
+struct vrt_unpack_le{
+    UHD_INLINE void operator()(const boost::uint32_t *packet_buff, vrt::if_packet_info_t &if_packet_info) const{
+        vrt::if_hdr_unpack_le(packet_buff, if_packet_info);
+    }
+};
+
 /***********************************************************************
  * Super receive packet handler
  *
  * A receive packet handler represents a group of channels.
  * The channel group shares a common sample rate.
  * All channels are received in unison in recv().
+ *
+ * The buffer getter and vrt unpacker are template parameters.
+ * The defaults are run-time function objects (see recv_packet_handler).
  **********************************************************************/
-class recv_packet_handler{
+template <
+    typename get_buff_type_ = boost::function<managed_recv_buffer::sptr(double)>,
+    typename vrt_unpacker_type_ = void(*)(const boost::uint32_t *, vrt::if_packet_info_t &)
+> class recv_packet_handler_t{
 public:
-    typedef boost::function<managed_recv_buffer::sptr(double)> get_buff_type;
-    typedef void(*vrt_unpacker_type)(const boost::uint32_t *, vrt::if_packet_info_t &);
-    //typedef boost::function<void(const boost::uint32_t *, vrt::if_packet_info_t &)> vrt_unpacker_type;
+    typedef get_buff_type_ get_buff_type;
+    typedef vrt_unpacker_type_ vrt_unpacker_type;
+
+    //! Statistics about recovering the multi-channel alignment
+    struct alignment_stats_type{
+        alignment_stats_type(void):
+            num_recoveries(0), num_discarded_samps(0),
+            last_recovery_time(0.0), max_recovery_time(0.0)
+        {/* NOP */}
+        size_t num_recoveries; //recoveries that discarded packets
+        size_t num_discarded_samps; //summed over the channels
+        double last_recovery_time; //seconds
+        double max_recovery_time; //seconds
+    };
+
+    //! What to do about the samples lost in a sequence error
+    enum gap_mode_t{
+        //! Report an overflow (the default)
+        GAP_MODE_NONE,
+        //! Report an overflow with the number of missing samples
+        GAP_MODE_REPORT,
+        //! Deliver the missing samples as zeros to keep the timeline
+        GAP_MODE_FILL
+    };
 
     /*!
      * Make a new packet handler for receive
      * \param size the number of transport channels
      */
-    recv_packet_handler(const size_t size = 1):
+    recv_packet_handler_t(const size_t size = 1):
         _queue_error_for_next_call(false),
+        _alignment_recovering(false),
+        _alignment_recovery_discarded_samps(0),
         _buffers_infos_index(0)
     {
         this->resize(size);
         set_alignment_failure_threshold(1000);
         this->set_scale_factor(1/32767.);
+        this->set_gap_mode(GAP_MODE_NONE);
     }
 
     //! Resize the number of transport channels
     void resize(const size_t size){
         if (this->size() == size) return;
         _props.resize(size);
+        _post_stages.clear(); //one stage per channel, set them again
         //re-initialize all buffers infos by re-creating the vector
         _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
     }
@@ -99,12 +284,20 @@ public:
     /*!
      * Set the threshold for alignment failure.
      * How many packets throw out before giving up?
+     * The packets of lagging channels are counted apart
+     * from the packets that move the alignment time.
      * \param threshold number of packets per channel
      */
     void set_alignment_failure_threshold(const size_t threshold){
         _alignment_faulure_threshold = threshold*this->size();
     }
 
+    //! Get the statistics about recovering the alignment
+    alignment_stats_type get_alignment_stats(void){
+        boost::mutex::scoped_lock lock(_alignment_stats_mutex);
+        return _alignment_stats;
+    }
+
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
         _tick_rate = rate;
@@ -142,6 +335,59 @@ public:
             }catch(const uhd::value_error &){} //we expect this, not all io_types valid...
         }
         _bytes_per_item = otw_type.get_sample_size();
+        _otw_type = otw_type;
+        _post_stages.clear(); //the stages read the old otw type, set them again
+    }
+
+    /*!
+     * Set the post-processing stages of the complex float samples.
+     * Each channel's samples are converted by its own stage,
+     * which may write fewer samples than it reads (see uhd::convert::rx_stage).
+     * The stages must convert from the otw type of set_converter().
+     * The other io types are converted without the stages.
+     * \param stages one stage per channel, or empty to remove the stages
+     */
+    void set_post_stages(const std::vector<uhd::convert::rx_stage::sptr> &stages){
+        if (not stages.empty() and stages.size() != this->size()) throw uhd::value_error(
+            "recv packet handler: the post stages need a stage per channel"
+        );
+        if (not stages.empty() and _io_buffs.size() != 1) throw uhd::not_implemented_error(
+            "recv packet handler: the post stages need one stream per channel"
+        );
+        _post_stages = stages;
+    }
+
+    /*!
+     * Set the post-processing stage of the complex float samples.
+     * The stage rotates the samples of each channel by a frequency,
+     * and decimates every channel by an integer factor,
+     * in the same pass over memory as the conversion.
+     * The other io types are converted without the stage.
+     * No rotation on any channel and no decimation removes the stage.
+     * \param freqs the frequency of each channel in cycles per sample
+     * \param decim the integer decimation factor
+     */
+    void set_post_stage(const std::vector<double> &freqs, const size_t decim = 1){
+        bool enabled = decim != 1;
+        BOOST_FOREACH(double freq, freqs) enabled = enabled or freq != 0.0;
+        if (not enabled){
+            this->set_post_stages(std::vector<uhd::convert::rx_stage::sptr>());
+            return;
+        }
+
+        //keep the existing fused stages so that the phases continue
+        std::vector<uhd::convert::rx_stage::sptr> stages(freqs.size());
+        for (size_t i = 0; i < freqs.size(); i++){
+            uhd::convert::rx_fused_stage::sptr stage;
+            if (_post_stages.size() == freqs.size()){
+                stage = boost::dynamic_pointer_cast<uhd::convert::rx_fused_stage>(_post_stages[i]);
+            }
+            if (stage.get() == NULL) stage = uhd::convert::make_rx_fused_stage(_otw_type);
+            stage->set_freq(freqs[i]);
+            if (stage->get_decim() != decim) stage->set_decim(decim);
+            stages[i] = stage;
+        }
+        this->set_post_stages(stages);
     }
 
     //! Set the transport channel's overflow handler
@@ -159,6 +405,32 @@ public:
         _scale_factor = scale_factor;
     }
 
+    /*!
+     * Set the number of threads that copy-convert the channels.
+     * With zero threads, the caller converts all channels (the default).
+     * Otherwise, the caller and the threads each convert a share.
+     * \param num_threads the number of worker threads
+     * \param first_cpu pin worker n to this cpu + n, or -1 to not pin
+     */
+    void set_converter_threads(const size_t num_threads, const int first_cpu = -1){
+        _convert_pool.reset(); //stops the old workers first
+        if (num_threads == 0) return;
+        _convert_pool.reset(new recv_convert_pool(num_threads, first_cpu));
+    }
+
+    /*!
+     * Set how sequence errors are reported.
+     * The number of missing samples comes from the vrt timestamps,
+     * or from the packet count when the packets have no timestamps.
+     * A gap larger than the fill limit is only reported.
+     * \param gap_mode none, report, or fill
+     * \param max_fill_samps the largest gap to zero-fill in samples
+     */
+    void set_gap_mode(const gap_mode_t gap_mode, const size_t max_fill_samps = 1 << 20){
+        _gap_mode = gap_mode;
+        _gap_max_fill_samps = max_fill_samps;
+    }
+
     /*******************************************************************
      * Receive:
      * The entry point for the fast-path receive calls.
@@ -222,6 +494,67 @@ public:
         }//switch(recv_mode)
     }
 
+    /*******************************************************************
+     * Borrow:
+     * Receive one aligned set of packets without any conversion.
+     * The views point at the payloads in the transport buffers.
+     * The buffers move into the lease and are released with it.
+     ******************************************************************/
+    UHD_INLINE uhd::device::recv_lease_type borrow(
+        uhd::device::recv_views_type &views,
+        uhd::rx_metadata_t &metadata,
+        double timeout
+    ){
+        boost::mutex::scoped_lock lock(_mutex);
+        views.clear();
+
+        //handle metadata queued from a previous receive
+        if (_queue_error_for_next_call){
+            _queue_error_for_next_call = false;
+            metadata = _queue_metadata;
+            if (_queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT){
+                return uhd::device::recv_lease_type();
+            }
+        }
+
+        //get the next buffer unless a fragment remains from a recv
+        if (get_curr_buffer_info().data_bytes_to_copy == 0){
+            get_curr_buffer_info().fragment_offset_in_samps = 0;
+            get_curr_buffer_info().alignment_time_valid = false;
+            get_curr_buffer_info().indexes_todo.set();
+            get_curr_buffer_info().heads_todo.set();
+            get_curr_buffer_info().gap_pending = false;
+            get_aligned_buffs(timeout);
+        }
+
+        buffers_info_type &info = get_curr_buffer_info();
+        metadata = info.metadata;
+        if (metadata.error_code != rx_metadata_t::ERROR_CODE_NONE){
+            return uhd::device::recv_lease_type();
+        }
+
+        //the whole remainder of the packets goes to the caller
+        const time_spec_t offset_time(0, info.fragment_offset_in_samps, _samp_rate);
+        const size_t nsamps = info.data_bytes_to_copy/_bytes_per_item;
+        metadata.time_spec += offset_time;
+        metadata.more_fragments = false;
+        metadata.fragment_offset = info.fragment_offset_in_samps;
+
+        typedef std::vector<managed_recv_buffer::sptr> lease_buffs_type;
+        boost::shared_ptr<lease_buffs_type> lease(new lease_buffs_type(this->size()));
+        views.resize(this->size());
+        for (size_t i = 0; i < this->size(); i++){
+            views[i].mem = info[i].copy_buff;
+            views[i].nsamps = nsamps;
+            views[i].time_spec = info[i].time.to_time_spec() + offset_time;
+            (*lease)[i].swap(info[i].buff);
+        }
+
+        info.data_bytes_to_copy = 0;
+        info.fragment_offset_in_samps += nsamps;
+        return lease;
+    }
+
 private:
 
     boost::mutex _mutex;
@@ -230,28 +563,44 @@ private:
     double _tick_rate, _samp_rate;
     bool _queue_error_for_next_call;
     size_t _alignment_faulure_threshold;
+    boost::mutex _alignment_stats_mutex;
+    alignment_stats_type _alignment_stats;
+    bool _alignment_recovering;
+    boost::system_time _alignment_recovery_start;
+    size_t _alignment_recovery_discarded_samps;
     rx_metadata_t _queue_metadata;
+    gap_mode_t _gap_mode;
+    size_t _gap_max_fill_samps;
+    std::vector<char> _gap_fill_buff; //zeros for a filled gap
     struct xport_chan_props_type{
         xport_chan_props_type(void):
             packet_count(0),
-            handle_overflow(&handle_overflow_nop)
+            handle_overflow(&handle_overflow_nop),
+            next_time_valid(false),
+            num_missing_samps(0)
         {}
         get_buff_type get_buff;
         size_t packet_count;
         handle_overflow_type handle_overflow;
+        tick_spec_t next_time; //expected time of the next packet
+        bool next_time_valid;
+        size_t num_missing_samps; //samples lost before the last packet
     };
     std::vector<xport_chan_props_type> _props;
     std::vector<void *> _io_buffs; //used in conversion
     size_t _bytes_per_item; //used in conversion
     std::vector<uhd::convert::function_type> _converters; //used in conversion
+    recv_convert_pool::sptr _convert_pool; //used in conversion when set
     double _scale_factor;
+    uhd::otw_type_t _otw_type;
+    std::vector<uhd::convert::rx_stage::sptr> _post_stages; //used in conversion when set
 
     //! information stored for a received buffer
     struct per_buffer_info_type{
         managed_recv_buffer::sptr buff;
         const boost::uint32_t *vrt_hdr;
         vrt::if_packet_info_t ifpi;
-        time_spec_t time;
+        tick_spec_t time;
         const char *copy_buff;
     };
 
@@ -259,16 +608,24 @@ private:
     struct buffers_info_type : std::vector<per_buffer_info_type> {
         buffers_info_type(const size_t size):
             std::vector<per_buffer_info_type>(size),
-            indexes_todo(size, true),
+            indexes_todo(size),
+            heads_todo(size),
             alignment_time_valid(false),
             data_bytes_to_copy(0),
-            fragment_offset_in_samps(0)
-        {/* NOP */}
+            fragment_offset_in_samps(0),
+            gap_pending(false)
+        {
+            //the bitset constructor takes a value, not a bit to fill with
+            indexes_todo.set();
+            heads_todo.set();
+        }
         boost::dynamic_bitset<> indexes_todo; //used in alignment logic
-        time_spec_t alignment_time; //used in alignment logic
+        boost::dynamic_bitset<> heads_todo; //used in alignment logic
+        tick_spec_t alignment_time; //used in alignment logic
         bool alignment_time_valid; //used in alignment logic
         size_t data_bytes_to_copy; //keeps track of state
         size_t fragment_offset_in_samps; //keeps track of state
+        bool gap_pending; //a channel lost samples, fill once the set is aligned
         rx_metadata_t metadata; //packet description
     };
 
@@ -317,7 +674,7 @@ private:
         info.ifpi.num_packet_words32 = num_packet_words32 - _header_offset_words32;
         info.vrt_hdr = buff->cast<const boost::uint32_t *>() + _header_offset_words32;
         _vrt_unpacker(info.vrt_hdr, info.ifpi);
-        info.time = time_spec_t(time_t(info.ifpi.tsi), size_t(info.ifpi.tsf), _tick_rate); //assumes has_tsi and has_tsf are true
+        info.time = tick_spec_t(time_t(info.ifpi.tsi), info.ifpi.tsf, _tick_rate); //assumes has_tsi and has_tsf are true
         info.copy_buff = reinterpret_cast<const char *>(info.vrt_hdr + info.ifpi.num_header_words32);
 
         //--------------------------------------------------------------
@@ -334,6 +691,7 @@ private:
         #ifndef SRPH_DONT_CHECK_SEQUENCE
         const size_t expected_packet_count = _props[index].packet_count;
         _props[index].packet_count = (info.ifpi.packet_count + 1)%16;
+        if (_gap_mode != GAP_MODE_NONE) measure_gap(index, info, expected_packet_count);
         if (expected_packet_count != info.ifpi.packet_count){
             return PACKET_SEQUENCE_ERROR;
         }
@@ -348,6 +706,41 @@ private:
         return PACKET_IF_DATA;
     }
 
+    //! The number of ticks in a number of samples (rounded)
+    UHD_INLINE boost::int64_t samps_to_ticks(const size_t nsamps) const{
+        return boost::int64_t(nsamps*_tick_rate/_samp_rate + 0.5);
+    }
+
+    /*******************************************************************
+     * Measure a gap:
+     * Count the samples between the expected time and this packet.
+     * Without timestamps, count the skipped packets of this size.
+     * Then set up the expected time for the packet that follows.
+     ******************************************************************/
+    UHD_INLINE void measure_gap(
+        const size_t index, const per_buffer_info_type &info, const size_t expected_packet_count
+    ){
+        xport_chan_props_type &props = _props[index];
+        const size_t nsamps = info.ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_item;
+        const bool has_time = info.ifpi.has_tsi and info.ifpi.has_tsf;
+
+        props.num_missing_samps = 0;
+        if (expected_packet_count == info.ifpi.packet_count){
+            /* NOP */
+        }
+        else if (has_time and props.next_time_valid){
+            if (info.time > props.next_time) props.num_missing_samps = size_t(
+                (info.time - props.next_time).get_ticks()*_samp_rate/_tick_rate + 0.5
+            );
+        }
+        else{
+            props.num_missing_samps = nsamps*((info.ifpi.packet_count + 16 - expected_packet_count)%16);
+        }
+
+        props.next_time = info.time + samps_to_ticks(nsamps);
+        props.next_time_valid = has_time;
+    }
+
     /*******************************************************************
      * Alignment check:
      * Check the received packet for alignment and mark accordingly.
@@ -381,7 +774,9 @@ private:
      * Get aligned buffers:
      * Iterate through each index and try to accumulate aligned buffers.
      * Handle all of the edge cases like inline messages and errors.
-     * The logic will throw out older packets until it finds a match.
+     * Every channel's head packet is received first,
+     * so that the alignment time is the newest of the heads.
+     * Then the packets of lagging channels are thrown out in bulk.
      ******************************************************************/
     UHD_INLINE void get_aligned_buffs(double timeout){
 
@@ -394,18 +789,38 @@ private:
         // - Receive a single packet and extract its info.
         // - Handle the packet type yielded by the receive.
         // - Check the timestamps for alignment conditions.
-        size_t iterations = 0;
+        size_t iterations = 0, num_discarded = 0;
         while (curr_info.indexes_todo.any()){
 
-            //get the index to process for this iteration
-            const size_t index = curr_info.indexes_todo.find_first();
+            //get the index to process for this iteration (heads first)
+            size_t index = curr_info.heads_todo.find_first();
+            const bool is_head = index != boost::dynamic_bitset<>::npos;
+            if (not is_head) index = curr_info.indexes_todo.find_first();
+            curr_info.heads_todo.reset(index);
             packet_type packet;
 
+            //a channel that already had a head packet is behind
+            if (not is_head and is_lagging(index, curr_info)){
+                this->discard_lagging_packet(curr_info[index]);
+                num_discarded++;
+            }
+
             //receive a single packet from the transport
             try{
                 packet = get_and_process_single_packet(
                     index, prev_info, curr_info, timeout
                 );
+
+                //with all of the heads in, drop a lagging channel's packets in bulk
+                while (
+                    packet == PACKET_IF_DATA and curr_info.heads_todo.none()
+                    and is_lagging(index, curr_info) and num_discarded++ < _alignment_faulure_threshold
+                ){
+                    this->discard_lagging_packet(curr_info[index]);
+                    packet = get_and_process_single_packet(
+                        index, prev_info, curr_info, timeout
+                    );
+                }
             }
 
             //handle the case when the get packet throws
@@ -443,7 +858,7 @@ private:
             case PACKET_INLINE_MESSAGE:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = next_info[index].ifpi.has_tsi and next_info[index].ifpi.has_tsf;
-                curr_info.metadata.time_spec = next_info[index].time;
+                curr_info.metadata.time_spec = next_info[index].time.to_time_spec();
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
@@ -468,10 +883,23 @@ private:
 
             case PACKET_SEQUENCE_ERROR:
                 alignment_check(index, curr_info);
+
+                //a measured gap is filled after the other channels are in,
+                //and only when they all lost the same number of samples
+                if (_gap_mode == GAP_MODE_FILL and _props[index].num_missing_samps != 0){
+                    curr_info.gap_pending = true;
+                    break;
+                }
+
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = prev_info.metadata.has_time_spec;
                 curr_info.metadata.time_spec = prev_info.metadata.time_spec + time_spec_t(0,
                     prev_info[index].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_item, _samp_rate);
+                if (_props[index].num_missing_samps != 0 and next_info[index].ifpi.has_tsi and next_info[index].ifpi.has_tsf){
+                    //the gap starts where the samples went missing before this packet
+                    curr_info.metadata.has_time_spec = true;
+                    curr_info.metadata.time_spec = (next_info[index].time - samps_to_ticks(_props[index].num_missing_samps)).to_time_spec();
+                }
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
@@ -483,12 +911,13 @@ private:
             }
 
             //too many iterations: detect alignment failure
-            if (iterations++ > _alignment_faulure_threshold){
+            if (iterations++ > _alignment_faulure_threshold or num_discarded > _alignment_faulure_threshold){
                 UHD_MSG(error) << boost::format(
                     "The receive packet handler failed to time-align packets.\n"
                     "%u received packets were processed by the handler.\n"
                     "However, a timestamp match could not be determined.\n"
-                ) % iterations << std::endl;
+                ) % (iterations + num_discarded) << std::endl;
+                _alignment_recovering = false;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = false;
                 curr_info.metadata.time_spec = time_spec_t(0.0);
@@ -502,9 +931,15 @@ private:
 
         }
 
+        //fill or report the gap in front of the aligned set
+        if (curr_info.gap_pending){
+            this->handle_gap(curr_info, next_info);
+            return;
+        }
+
         //set the metadata from the buffer information at index zero
         curr_info.metadata.has_time_spec = curr_info[0].ifpi.has_tsi and curr_info[0].ifpi.has_tsf;
-        curr_info.metadata.time_spec = curr_info[0].time;
+        curr_info.metadata.time_spec = curr_info[0].time.to_time_spec();
         curr_info.metadata.more_fragments = false;
         curr_info.metadata.fragment_offset = 0;
         /* TODO SOB on RX not supported in hardware
@@ -516,6 +951,86 @@ private:
         curr_info.metadata.end_of_burst   = curr_info[0].ifpi.has_tlr and (int(curr_info[0].ifpi.tlr & tlr_eob_flags) != 0);
         curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
 
+        if (_alignment_recovering) this->end_alignment_recovery();
+    }
+
+    /*******************************************************************
+     * Alignment recovery:
+     * Account for a packet thrown out of a lagging channel.
+     * A recovery lasts from the first packet thrown out
+     * until the channels are aligned, even across several calls.
+     ******************************************************************/
+    UHD_INLINE bool is_lagging(const size_t index, const buffers_info_type &info) const{
+        return info.alignment_time_valid and info[index].time < info.alignment_time
+            and info[index].ifpi.packet_type == vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    }
+
+    UHD_INLINE void discard_lagging_packet(per_buffer_info_type &info){
+        if (not _alignment_recovering){
+            _alignment_recovering = true;
+            _alignment_recovery_start = boost::get_system_time();
+            _alignment_recovery_discarded_samps = 0;
+        }
+        _alignment_recovery_discarded_samps += info.ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_item;
+        info.buff.reset(); //release back to the transport
+    }
+
+    void end_alignment_recovery(void){
+        _alignment_recovering = false;
+        const double recovery_time = (boost::get_system_time() - _alignment_recovery_start).total_microseconds()/1e6;
+        UHD_LOG << boost::format(
+            "The receive packet handler recovered the alignment in %f secs (%u samples discarded)"
+        ) % recovery_time % _alignment_recovery_discarded_samps << std::endl;
+
+        boost::mutex::scoped_lock lock(_alignment_stats_mutex);
+        _alignment_stats.num_recoveries++;
+        _alignment_stats.num_discarded_samps += _alignment_recovery_discarded_samps;
+        _alignment_stats.last_recovery_time = recovery_time;
+        _alignment_stats.max_recovery_time = std::max(_alignment_stats.max_recovery_time, recovery_time);
+    }
+
+    /*******************************************************************
+     * Handle a gap:
+     * The aligned set is saved for the next call, like an error would.
+     * When every channel lost the same number of samples,
+     * point every channel at a buffer of zeros for the missing samples.
+     * The zeros are received like a packet that starts at the time
+     * where the samples went missing, so the timeline stays contiguous.
+     * Channels that disagree cannot be filled and report an overflow.
+     ******************************************************************/
+    UHD_INLINE void handle_gap(buffers_info_type &curr_info, buffers_info_type &next_info){
+        curr_info.gap_pending = false;
+        const size_t num_missing = _props[0].num_missing_samps;
+        size_t max_missing = 0;
+        bool channels_agree = true;
+        for (size_t i = 0; i < _props.size(); i++){
+            channels_agree = channels_agree and _props[i].num_missing_samps == num_missing;
+            max_missing = std::max(max_missing, _props[i].num_missing_samps);
+        }
+
+        std::swap(curr_info, next_info); //save progress from curr -> next
+        curr_info.metadata.has_time_spec = next_info[0].ifpi.has_tsi and next_info[0].ifpi.has_tsf;
+        curr_info.metadata.time_spec = (next_info.alignment_time - samps_to_ticks(max_missing)).to_time_spec();
+        curr_info.metadata.more_fragments = false;
+        curr_info.metadata.fragment_offset = 0;
+        curr_info.metadata.start_of_burst = false;
+        curr_info.metadata.end_of_burst = false;
+
+        if (not channels_agree or num_missing == 0 or num_missing > _gap_max_fill_samps){
+            curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+            UHD_MSG(fastpath) << "O";
+            return;
+        }
+
+        const size_t num_bytes = num_missing*_bytes_per_item;
+        if (_gap_fill_buff.size() < num_bytes) _gap_fill_buff.resize(num_bytes, 0);
+        BOOST_FOREACH(per_buffer_info_type &buff_info, curr_info){
+            buff_info.buff.reset();
+            buff_info.copy_buff = &_gap_fill_buff.front();
+        }
+        curr_info.data_bytes_to_copy = num_bytes;
+        curr_info.fragment_offset_in_samps = 0;
+        curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
     }
 
     /*******************************************************************
@@ -539,6 +1054,8 @@ private:
             get_curr_buffer_info().fragment_offset_in_samps = 0;
             get_curr_buffer_info().alignment_time_valid = false;
             get_curr_buffer_info().indexes_todo.set();
+            get_curr_buffer_info().heads_todo.set();
+            get_curr_buffer_info().gap_pending = false;
 
             //perform receive with alignment logic
             get_aligned_buffs(timeout);
@@ -550,14 +1067,54 @@ private:
         //interpolate the time spec (useful when this is a fragment)
         metadata.time_spec += time_spec_t(0, info.fragment_offset_in_samps, _samp_rate);
 
+        //the post stages limit the inputs to the outputs that fit the buffer
+        const bool use_post_stages = not _post_stages.empty() and io_type.tid == io_type_t::COMPLEX_FLOAT32;
+        const size_t nsamps_max = use_post_stages?
+            _post_stages.front()->get_max_inputs(nsamps_per_buff) : nsamps_per_buff*_io_buffs.size();
+
         //extract the number of samples available to copy
         const size_t nsamps_available = info.data_bytes_to_copy/_bytes_per_item;
-        const size_t nsamps_to_copy = std::min(nsamps_per_buff*_io_buffs.size(), nsamps_available);
+        const size_t nsamps_to_copy = std::min(nsamps_max, nsamps_available);
         const size_t bytes_to_copy = nsamps_to_copy*_bytes_per_item;
-        const size_t nsamps_to_copy_per_io_buff = nsamps_to_copy/_io_buffs.size();
+        size_t nsamps_to_copy_per_io_buff = nsamps_to_copy/_io_buffs.size();
 
         size_t buff_index = 0;
-        BOOST_FOREACH(per_buffer_info_type &buff_info, info){
+        if (use_post_stages){
+
+            //the first output may start before or after the first input
+            metadata.time_spec += time_spec_t(0, _post_stages.front()->get_output_offset(), _samp_rate);
+
+            //convert and process each channel (one stream per channel)
+            for (size_t i = 0; i < info.size(); i++){
+                std::complex<float> *output = reinterpret_cast<std::complex<float> *>(
+                    reinterpret_cast<char *>(buffs[buff_index++]) + buffer_offset_bytes
+                );
+                nsamps_to_copy_per_io_buff = (*_post_stages[i])(
+                    info[i].copy_buff, output, nsamps_to_copy, _scale_factor
+                );
+                info[i].copy_buff += bytes_to_copy;
+            }
+        }
+        else if (_convert_pool.get() != NULL and info.size() > 1){
+
+            //describe one job per channel and hand them to the pool
+            std::vector<recv_convert_pool::job_type> &jobs = _convert_pool->get_jobs();
+            jobs.resize(info.size());
+            for (size_t i = 0; i < info.size(); i++){
+                recv_convert_pool::job_type &job = jobs[i];
+                job.converter = &_converters[io_type.tid];
+                job.input = info[i].copy_buff;
+                job.outputs.resize(_io_buffs.size());
+                BOOST_FOREACH(void *&io_buff, job.outputs){
+                    io_buff = reinterpret_cast<char *>(buffs[buff_index++]) + buffer_offset_bytes;
+                }
+                job.nsamps = nsamps_to_copy_per_io_buff;
+                job.scale_factor = _scale_factor;
+                info[i].copy_buff += bytes_to_copy;
+            }
+            _convert_pool->run(jobs.size());
+        }
+        else BOOST_FOREACH(per_buffer_info_type &buff_info, info){
 
             //fill a vector with pointers to the io buffers
             BOOST_FOREACH(void *&io_buff, _io_buffs){
@@ -589,6 +1146,9 @@ private:
     }
 };
 
+//! The receive packet handler with run-time function objects
+typedef recv_packet_handler_t<> recv_packet_handler;
+
 }}} //namespace
 
 #endif /* INCLUDED_LIBUHD_TRANSPORT_SUPER_RECV_PACKET_HANDLER_HPP */
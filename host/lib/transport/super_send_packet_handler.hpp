@@ -23,6 +23,7 @@
 #include <uhd/convert.hpp>
 #include <uhd/device.hpp>
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/io_type.hpp>
 #include <uhd/types/otw_type.hpp>
@@ -33,33 +34,85 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
+#include <algorithm>
 #include <iostream>
+#include <cmath>
 #include <vector>
 
 namespace uhd{ namespace transport{ namespace sph{
 
+/***********************************************************************
+ * Send handler policies
+ *
+ * A device with a fixed configuration can instantiate the handler
+ * with these types instead of the run-time function objects.
+ * The per-packet calls are then direct calls that the compiler can see,
+ * rather than calls through a boost::function or a function pointer.
+ **********************************************************************/
+//! Get send buffers from a zero copy transport
+class xport_get_send_buff{
+public:
+    xport_get_send_buff(void){/* NOP */}
+    xport_get_send_buff(zero_copy_if::sptr xport): _xport(xport){/* NOP */}
+    UHD_INLINE managed_send_buffer::sptr operator()(double timeout) const{
+        return _xport->get_send_buff(timeout);
+    }
+private:
+    zero_copy_if::sptr _xport;
+};
+
+//! Pack a vrt header in big endian byte order
+struct vrt_pack_be{
+    UHD_INLINE void operator()(boost::uint32_t *packet_buff, vrt::if_packet_info_t &if_packet_info) const{
+        vrt::if_hdr_pack_be(packet_buff, if_packet_info);
+    }
+};
+
+//! Pack a vrt header in little endian byte order
+struct vrt_pack_le{
+    UHD_INLINE void operator()(boost::uint32_t *packet_buff, vrt::if_packet_info_t &if_packet_info) const{
+        vrt::if_hdr_pack_le(packet_buff, if_packet_info);
+    }
+};
+
 /***********************************************************************
  * Super send packet handler
  *
  * A send packet handler represents a group of channels.
  * The channel group shares a common sample rate.
  * All channels are sent in unison in send().
+ *
+ * The buffer getter and vrt packer are template parameters.
+ * The defaults are run-time function objects (see send_packet_handler).
  **********************************************************************/
-class send_packet_handler{
+template <
+    typename get_buff_type_ = boost::function<managed_send_buffer::sptr(double)>,
+    typename vrt_packer_type_ = void(*)(boost::uint32_t *, vrt::if_packet_info_t &)
+> class send_packet_handler_t{
 public:
-    typedef boost::function<managed_send_buffer::sptr(double)> get_buff_type;
-    typedef void(*vrt_packer_type)(boost::uint32_t *, vrt::if_packet_info_t &);
-    //typedef boost::function<void(boost::uint32_t *, vrt::if_packet_info_t &)> vrt_packer_type;
+    typedef get_buff_type_ get_buff_type;
+    typedef vrt_packer_type_ vrt_packer_type;
+    typedef boost::function<size_t(std::vector<managed_send_buffer::sptr> &, size_t, double)> get_buffs_type;
+    typedef boost::function<void(std::vector<managed_send_buffer::sptr> &)> return_buffs_type;
+
+    //! The most packets claimed per channel in one batch
+    static const size_t max_batch_size = 32;
 
     /*!
      * Make a new packet handler for send
      * \param size the number of transport channels
      */
-    send_packet_handler(const size_t size = 1):
-        _next_packet_seq(0)
+    send_packet_handler_t(const size_t size = 1):
+        _tick_rate(1.0), _samp_rate(1.0),
+        _next_packet_seq(0),
+        _header_templates_enb(true),
+        _header_templates_valid(false),
+        _header_swap(false),
+        _lease(_mutex)
     {
         this->resize(size);
         this->set_scale_factor(32767.);
+        this->update_ticks_per_samp();
     }
 
     //! Resize the number of transport channels
@@ -79,16 +132,28 @@ public:
     void set_vrt_packer(const vrt_packer_type &vrt_packer, const size_t header_offset_words32 = 0){
         _vrt_packer = vrt_packer;
         _header_offset_words32 = header_offset_words32;
+        this->update_header_templates();
+    }
+
+    /*!
+     * Enable or disable the header templates (enabled by default).
+     * When disabled, every header is packed with the vrt packer
+     * and fragment times use time spec arithmetic (for comparison).
+     */
+    void set_header_templates(const bool enb){
+        _header_templates_enb = enb;
     }
 
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
         _tick_rate = rate;
+        this->update_ticks_per_samp();
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
         _samp_rate = rate;
+        this->update_ticks_per_samp();
     }
 
     /*!
@@ -100,6 +165,27 @@ public:
         _props.at(xport_chan).get_buff = get_buff;
     }
 
+    /*!
+     * Set the function to get a batch of managed buffers (optional).
+     * When set on every channel, a full buffer send claims
+     * several packets at once and commits them together.
+     * The return function takes back buffers claimed but not filled,
+     * for a transport that reserved something for each one (optional).
+     * Either way, the buffers are released with a zero length commit,
+     * which the transports discard without sending.
+     * \param xport_chan which transport channel
+     * \param get_buffs the batch getter function
+     * \param return_buffs the function to give back unused buffers
+     */
+    void set_xport_chan_get_buffs(
+        const size_t xport_chan,
+        const get_buffs_type &get_buffs,
+        const return_buffs_type &return_buffs = return_buffs_type()
+    ){
+        _props.at(xport_chan).get_buffs = get_buffs;
+        _props.at(xport_chan).return_buffs = return_buffs;
+    }
+
     /*!
      * Setup the conversion functions (homogeneous across transports).
      * Here, we load a table of converters for all possible io types.
@@ -156,15 +242,7 @@ public:
 
         //translate the metadata to vrt if packet info
         vrt::if_packet_info_t if_packet_info;
-        if_packet_info.has_sid = false;
-        if_packet_info.has_cid = false;
-        if_packet_info.has_tlr = false;
-        if_packet_info.has_tsi = metadata.has_time_spec;
-        if_packet_info.has_tsf = metadata.has_time_spec;
-        if_packet_info.tsi     = boost::uint32_t(metadata.time_spec.get_full_secs());
-        if_packet_info.tsf     = boost::uint64_t(metadata.time_spec.get_tick_count(_tick_rate));
-        if_packet_info.sob     = metadata.start_of_burst;
-        if_packet_info.eob     = metadata.end_of_burst;
+        this->metadata_to_if_packet_info(metadata, if_packet_info);
 
         if (nsamps_per_buff <= _max_samples_per_packet) send_mode = uhd::device::SEND_MODE_ONE_PACKET;
         switch(send_mode){
@@ -190,6 +268,10 @@ public:
         ////////////////////////////////////////////////////////////////
         case uhd::device::SEND_MODE_FULL_BUFF:{
         ////////////////////////////////////////////////////////////////
+            if (this->can_batch()) return send_batched(
+                buffs, nsamps_per_buff, if_packet_info, metadata, io_type, timeout
+            );
+
             size_t total_num_samps_sent = 0;
 
             //false until final fragment
@@ -211,9 +293,7 @@ public:
                 if (num_samps_sent == 0) return total_num_samps_sent;
 
                 //setup metadata for the next fragment
-                const time_spec_t time_spec = metadata.time_spec + time_spec_t(0, total_num_samps_sent, _samp_rate);
-                if_packet_info.tsi = boost::uint32_t(time_spec.get_full_secs());
-                if_packet_info.tsf = boost::uint64_t(time_spec.get_tick_count(_tick_rate));
+                this->advance_fragment_time(if_packet_info, metadata, num_samps_sent, total_num_samps_sent);
                 if_packet_info.sob = false;
 
             }
@@ -231,6 +311,53 @@ public:
         }//switch(send_mode)
     }
 
+    /*******************************************************************
+     * Borrow:
+     * Get one send buffer per channel for the caller to fill in place.
+     * The views point at the payloads behind the vrt headers.
+     * The returned function packs the headers and commits the buffers.
+     * The handler stays locked from the borrow until the commit.
+     * Another borrow or send blocks on the lock in the meantime.
+     ******************************************************************/
+    UHD_INLINE uhd::device::send_commit_type borrow(
+        uhd::device::send_views_type &views,
+        const uhd::tx_metadata_t &metadata,
+        double timeout
+    ){
+        if (_io_buffs.size() != 1) throw uhd::not_implemented_error(
+            "cannot borrow send buffers that interleave several streams"
+        );
+        views.clear();
+
+        //the lease is reused, the new token invalidates older commit functions
+        _mutex.lock();
+        const commit_type commit(this, &_lease, _lease.start());
+        vrt::if_packet_info_t &if_packet_info = _lease.if_packet_info;
+        this->metadata_to_if_packet_info(metadata, if_packet_info);
+        if_packet_info.num_payload_words32 = this->payload_words32(_max_samples_per_packet);
+        if_packet_info.packet_count = _next_packet_seq;
+
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            managed_send_buffer::sptr buff = props.get_buff(timeout);
+            if (buff.get() == NULL){ //timeout
+                views.clear();
+                return uhd::device::send_commit_type();
+            }
+
+            //pack a header to find where the payload starts
+            boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
+            this->pack_header(otw_mem, if_packet_info);
+
+            uhd::device::send_view_type view;
+            view.mem = otw_mem + if_packet_info.num_header_words32;
+            view.nsamps = _max_samples_per_packet;
+            views.push_back(view);
+            _lease.buffs.push_back(buff);
+        }
+
+        return commit;
+    }
+
 private:
 
     boost::mutex _mutex;
@@ -239,6 +366,9 @@ private:
     double _tick_rate, _samp_rate;
     struct xport_chan_props_type{
         get_buff_type get_buff;
+        get_buffs_type get_buffs;
+        return_buffs_type return_buffs;
+        std::vector<managed_send_buffer::sptr> buffs; //claimed in a batch
     };
     std::vector<xport_chan_props_type> _props;
     std::vector<const void *> _io_buffs; //used in conversion
@@ -249,6 +379,256 @@ private:
     size_t _next_packet_seq;
     double _scale_factor;
 
+    //integer tick arithmetic, zero ticks per sample when not integral
+    boost::uint64_t _ticks_per_sec, _ticks_per_samp;
+
+    /*!
+     * A packed header for each combination of the burst flags and time.
+     * The packet count, size, and time words are zero in the template,
+     * and are filled in per packet in the byte order of the packer.
+     */
+    struct header_template_type{
+        boost::uint32_t words[vrt::max_if_hdr_words32];
+        size_t num_header_words32;
+    };
+    header_template_type _header_templates[8];
+    bool _header_templates_enb, _header_templates_valid, _header_swap;
+
+    /*!
+     * The borrowed buffers, held with the lock until the commit.
+     * The commit functions of a borrow count references on the lease;
+     * when the last one is dropped, uncommitted buffers are discarded
+     * and the lock is released. The token of the live borrow (zero when
+     * there is none) tells it from the commit functions of older borrows,
+     * so they never touch the count or the lock of the live one.
+     * The commit functions of one borrow stay on the borrowing thread.
+     */
+    struct send_lease_type{
+        send_lease_type(boost::mutex &mutex): mutex(mutex), last_token(0){/* NOP */}
+
+        //! Start a borrow, called with the mutex locked, returns its token
+        boost::uint32_t start(void){
+            if (++last_token == 0) last_token++; //zero means no borrow
+            ref_count.write(0);
+            token.write(last_token);
+            return last_token;
+        }
+
+        //! Claim the buffers of a live borrow, true for the first caller
+        bool claim(const boost::uint32_t tok){
+            return token.cas(0, tok) == tok;
+        }
+
+        void add_ref(const boost::uint32_t tok){
+            if (token.read() == tok) ref_count.inc();
+        }
+
+        void remove_ref(const boost::uint32_t tok){
+            if (token.read() != tok or ref_count.dec() != 1) return;
+            if (not this->claim(tok)) return;
+            buffs.clear();
+            mutex.unlock();
+        }
+
+        boost::mutex &mutex;
+        std::vector<managed_send_buffer::sptr> buffs;
+        vrt::if_packet_info_t if_packet_info;
+        boost::uint32_t last_token; //only changed with the mutex locked
+        atomic_uint32_t token; //the token of the live borrow, or zero
+        atomic_uint32_t ref_count; //commit functions of the live borrow
+    };
+    send_lease_type _lease;
+
+    //! The commit function for a borrow (small enough to not allocate)
+    class commit_type{
+    public:
+        commit_type(send_packet_handler_t *handler, send_lease_type *lease, const boost::uint32_t token):
+            _handler(handler), _lease(lease), _token(token)
+        {
+            _lease->add_ref(_token);
+        }
+        commit_type(const commit_type &other):
+            _handler(other._handler), _lease(other._lease), _token(other._token)
+        {
+            _lease->add_ref(_token);
+        }
+        ~commit_type(void){
+            _lease->remove_ref(_token);
+        }
+        size_t operator()(size_t nsamps) const{
+            return _handler->commit_borrowed(*_lease, _token, nsamps);
+        }
+    private:
+        commit_type &operator=(const commit_type &); //not assignable
+        send_packet_handler_t *_handler;
+        send_lease_type *_lease;
+        boost::uint32_t _token;
+    };
+
+    UHD_INLINE void advance_fragment_time(
+        vrt::if_packet_info_t &if_packet_info,
+        const uhd::tx_metadata_t &metadata,
+        const size_t num_samps_sent,
+        const size_t total_num_samps_sent
+    ){
+        if (_header_templates_enb and _ticks_per_samp != 0){
+            //advance the time in whole ticks
+            if_packet_info.tsf += num_samps_sent*_ticks_per_samp;
+            while (if_packet_info.tsf >= _ticks_per_sec){
+                if_packet_info.tsf -= _ticks_per_sec;
+                if_packet_info.tsi++;
+            }
+        }
+        else{
+            const time_spec_t time_spec = metadata.time_spec + time_spec_t(0, total_num_samps_sent, _samp_rate);
+            if_packet_info.tsi = boost::uint32_t(time_spec.get_full_secs());
+            if_packet_info.tsf = boost::uint64_t(time_spec.get_tick_count(_tick_rate));
+        }
+    }
+
+    static UHD_INLINE size_t header_template_index(const vrt::if_packet_info_t &if_packet_info){
+        return (if_packet_info.sob? 1 : 0) | (if_packet_info.eob? 2 : 0) | (if_packet_info.has_tsi? 4 : 0);
+    }
+
+    void update_ticks_per_samp(void){
+        _ticks_per_sec = _ticks_per_samp = 0;
+        if (_tick_rate < 1.0 or _samp_rate <= 0.0) return;
+        if (_tick_rate != std::floor(_tick_rate)) return;
+        const double ticks_per_samp = _tick_rate/_samp_rate;
+        const double rounded = std::floor(ticks_per_samp + 0.5);
+        if (rounded < 1.0 or std::abs(ticks_per_samp - rounded) > 1e-6*rounded) return;
+        _ticks_per_sec = boost::uint64_t(_tick_rate);
+        _ticks_per_samp = boost::uint64_t(rounded);
+    }
+
+    /*!
+     * Pack a template for each combination with the vrt packer.
+     * The byte order is found by packing a packet count of one:
+     * the packer writes host order words or byte swapped words.
+     * Any other packer keeps packing every header itself.
+     */
+    void update_header_templates(void){
+        _header_templates_valid = false;
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        if_packet_info.has_sid = false;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tlr = false;
+        if_packet_info.num_payload_words32 = 0;
+        if_packet_info.tsi = 0;
+        if_packet_info.tsf = 0;
+
+        for (size_t i = 0; i < 8; i++){
+            if_packet_info.sob = (i & 1) != 0;
+            if_packet_info.eob = (i & 2) != 0;
+            if_packet_info.has_tsi = if_packet_info.has_tsf = (i & 4) != 0;
+            header_template_type &header_template = _header_templates[i];
+
+            boost::uint32_t probe[vrt::max_if_hdr_words32];
+            if_packet_info.packet_count = 1;
+            _vrt_packer(probe, if_packet_info);
+            if_packet_info.packet_count = 0;
+            _vrt_packer(header_template.words, if_packet_info);
+            header_template.num_header_words32 = if_packet_info.num_header_words32;
+            if (header_template.num_header_words32 != ((i & 4)? 4 : 1)) return;
+
+            //remove the size, which is the header size here
+            const boost::uint32_t count_bit = probe[0] ^ header_template.words[0];
+            if (count_bit == (1 << 16)) _header_swap = false;
+            else if (count_bit == uhd::byteswap(boost::uint32_t(1 << 16))) _header_swap = true;
+            else return;
+            header_template.words[0] ^= this->to_header_word(boost::uint32_t(header_template.num_header_words32));
+        }
+        _header_templates_valid = true;
+    }
+
+    /*!
+     * Get the payload length for a number of samples in 32-bit words.
+     * A sample narrower than a word (sc8) may leave a half-filled word,
+     * the converter pads the last word with zeros.
+     */
+    UHD_INLINE size_t payload_words32(const size_t nsamps) const{
+        return (nsamps*_bytes_per_item + sizeof(boost::uint32_t) - 1)/sizeof(boost::uint32_t);
+    }
+
+    UHD_INLINE boost::uint32_t to_header_word(const boost::uint32_t word) const{
+        return _header_swap? uhd::byteswap(word) : word;
+    }
+
+    /*!
+     * Pack a vrt header from the template for the packet info:
+     * Fill in the packet count, size, and time words,
+     * and derive the header and packet sizes as the packer would.
+     */
+    UHD_INLINE void pack_header(boost::uint32_t *otw_mem, vrt::if_packet_info_t &if_packet_info){
+        if (not _header_templates_enb or not _header_templates_valid){
+            _vrt_packer(otw_mem, if_packet_info);
+            return;
+        }
+        const header_template_type &header_template = _header_templates[header_template_index(if_packet_info)];
+        if_packet_info.num_header_words32 = header_template.num_header_words32;
+        if_packet_info.num_packet_words32 = header_template.num_header_words32 + if_packet_info.num_payload_words32;
+        otw_mem[0] = header_template.words[0] | this->to_header_word(boost::uint32_t(0
+            | ((if_packet_info.packet_count & 0xf) << 16)
+            | (if_packet_info.num_packet_words32 & 0xffff)
+        ));
+        if (not if_packet_info.has_tsi) return;
+        otw_mem[1] = this->to_header_word(if_packet_info.tsi);
+        otw_mem[2] = this->to_header_word(boost::uint32_t(if_packet_info.tsf >> 32));
+        otw_mem[3] = this->to_header_word(boost::uint32_t(if_packet_info.tsf >> 0));
+    }
+
+    UHD_INLINE void metadata_to_if_packet_info(
+        const uhd::tx_metadata_t &metadata,
+        vrt::if_packet_info_t &if_packet_info
+    ){
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        if_packet_info.has_sid = false;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tlr = false;
+        if_packet_info.has_tsi = metadata.has_time_spec;
+        if_packet_info.has_tsf = metadata.has_time_spec;
+        if_packet_info.tsi     = boost::uint32_t(metadata.time_spec.get_full_secs());
+        if_packet_info.tsf     = boost::uint64_t(metadata.time_spec.get_tick_count(_tick_rate));
+        if_packet_info.sob     = metadata.start_of_burst;
+        if_packet_info.eob     = metadata.end_of_burst;
+    }
+
+    /*******************************************************************
+     * Commit borrowed buffers:
+     * Pack the headers for the number of samples written and commit.
+     * The lock is released, so a second commit sends nothing.
+     ******************************************************************/
+    size_t commit_borrowed(send_lease_type &lease, const boost::uint32_t token, size_t nsamps){
+        if (not lease.claim(token)) return 0;
+        nsamps = std::min(nsamps, _max_samples_per_packet);
+        size_t nsamps_to_send = nsamps;
+
+        //TODO remove this code when sample counts of zero are supported by hardware
+        #ifndef SSPH_DONT_PAD_TO_ONE
+        if (nsamps_to_send == 0) nsamps_to_send = 1;
+        #endif
+
+        vrt::if_packet_info_t &if_packet_info = lease.if_packet_info;
+        if_packet_info.num_payload_words32 = this->payload_words32(nsamps_to_send);
+        BOOST_FOREACH(managed_send_buffer::sptr &buff, lease.buffs){
+            boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
+            this->pack_header(otw_mem, if_packet_info);
+            if (nsamps == 0) std::fill( //the padding sample
+                otw_mem + if_packet_info.num_header_words32,
+                otw_mem + if_packet_info.num_packet_words32, 0
+            );
+
+            //commit the samples to the zero-copy interface
+            size_t num_bytes_total = (_header_offset_words32+if_packet_info.num_packet_words32)*sizeof(boost::uint32_t);
+            buff->commit(num_bytes_total);
+        }
+        lease.buffs.clear();
+        _next_packet_seq++; //increment sequence after commits
+        _mutex.unlock();
+        return nsamps;
+    }
+
     /*******************************************************************
      * Send a single packet:
      ******************************************************************/
@@ -261,37 +641,136 @@ private:
         const size_t buffer_offset_bytes = 0
     ){
         //load the rest of the if_packet_info in here
-        if_packet_info.num_payload_words32 = (nsamps_per_buff*_io_buffs.size()*_bytes_per_item)/sizeof(boost::uint32_t);
+        if_packet_info.num_payload_words32 = this->payload_words32(nsamps_per_buff*_io_buffs.size());
         if_packet_info.packet_count = _next_packet_seq;
 
-        size_t buff_index = 0;
-        BOOST_FOREACH(xport_chan_props_type &props, _props){
-            managed_send_buffer::sptr buff = props.get_buff(timeout);
+        for (size_t chan = 0; chan < _props.size(); chan++){
+            managed_send_buffer::sptr buff = _props[chan].get_buff(timeout);
             if (buff.get() == NULL) return 0; //timeout
 
-            //fill a vector with pointers to the io buffers
-            BOOST_FOREACH(const void *&io_buff, _io_buffs){
-                io_buff = reinterpret_cast<const char *>(buffs[buff_index++]) + buffer_offset_bytes;
-            }
-            boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
+            //commit the samples to the zero-copy interface
+            buff->commit(this->fill_one_packet(
+                buff, chan, buffs, nsamps_per_buff, if_packet_info, io_type, buffer_offset_bytes
+            ));
+        }
+        _next_packet_seq++; //increment sequence after commits
+        return nsamps_per_buff;
+    }
 
-            //pack metadata into a vrt header
-            _vrt_packer(otw_mem, if_packet_info);
-            otw_mem += if_packet_info.num_header_words32;
+    /*******************************************************************
+     * Fill a single packet:
+     * Pack the header and copy-convert the samples of one channel.
+     * \return the number of bytes to commit
+     ******************************************************************/
+    UHD_INLINE size_t fill_one_packet(
+        managed_send_buffer::sptr &buff,
+        const size_t chan,
+        const uhd::device::send_buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        vrt::if_packet_info_t &if_packet_info,
+        const uhd::io_type_t &io_type,
+        const size_t buffer_offset_bytes
+    ){
+        //fill a vector with pointers to the io buffers
+        size_t buff_index = chan*_io_buffs.size();
+        BOOST_FOREACH(const void *&io_buff, _io_buffs){
+            io_buff = reinterpret_cast<const char *>(buffs[buff_index++]) + buffer_offset_bytes;
+        }
+        boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
 
-            //copy-convert the samples into the send buffer
-            _converters[io_type.tid](_io_buffs, otw_mem, nsamps_per_buff, _scale_factor);
+        //pack metadata into a vrt header
+        this->pack_header(otw_mem, if_packet_info);
+        otw_mem += if_packet_info.num_header_words32;
 
-            //commit the samples to the zero-copy interface
-            size_t num_bytes_total = (_header_offset_words32+if_packet_info.num_packet_words32)*sizeof(boost::uint32_t);
-            buff->commit(num_bytes_total);
+        //copy-convert the samples into the send buffer
+        _converters[io_type.tid](_io_buffs, otw_mem, nsamps_per_buff, _scale_factor);
 
+        return (_header_offset_words32+if_packet_info.num_packet_words32)*sizeof(boost::uint32_t);
+    }
+
+    //! True when every channel can get a batch of buffers
+    UHD_INLINE bool can_batch(void) const{
+        BOOST_FOREACH(const xport_chan_props_type &props, _props){
+            if (props.get_buffs.empty()) return false;
         }
-        _next_packet_seq++; //increment sequence after commits
-        return nsamps_per_buff;
+        return true;
+    }
+
+    /*******************************************************************
+     * Send a full buffer in batches:
+     * Claim a batch of buffers on every channel, fill every packet,
+     * then commit the batch in order, so that a batching transport
+     * can signal the device once per batch.
+     * A channel that claims fewer buffers shrinks the batch;
+     * the extra buffers on the other channels go into the next batch.
+     ******************************************************************/
+    UHD_INLINE size_t send_batched(
+        const uhd::device::send_buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        vrt::if_packet_info_t &if_packet_info,
+        const uhd::tx_metadata_t &metadata,
+        const uhd::io_type_t &io_type,
+        double timeout
+    ){
+        const size_t num_packets = (nsamps_per_buff-1)/_max_samples_per_packet + 1;
+        const size_t final_length = ((nsamps_per_buff-1)%_max_samples_per_packet)+1;
+        size_t num_packets_sent = 0, total_num_samps_sent = 0;
+
+        while (num_packets_sent < num_packets){
+
+            //claim the batch on every channel
+            size_t batch_size = std::min(num_packets - num_packets_sent, max_batch_size);
+            BOOST_FOREACH(xport_chan_props_type &props, _props){
+                if (props.buffs.size() < batch_size) props.get_buffs(
+                    props.buffs, batch_size - props.buffs.size(), timeout
+                );
+                batch_size = std::min(batch_size, props.buffs.size());
+            }
+            if (batch_size == 0) break; //timeout
+
+            //fill the packets of the batch
+            size_t num_bytes[max_batch_size];
+            for (size_t i = 0; i < batch_size; i++, num_packets_sent++){
+                const bool last = (num_packets_sent == num_packets-1);
+                const size_t nsamps = last? final_length : _max_samples_per_packet;
+                if_packet_info.num_payload_words32 = this->payload_words32(nsamps*_io_buffs.size());
+                if_packet_info.packet_count = _next_packet_seq++;
+                if_packet_info.eob = last and metadata.end_of_burst;
+                for (size_t chan = 0; chan < _props.size(); chan++){
+                    num_bytes[i] = this->fill_one_packet(
+                        _props[chan].buffs[i], chan, buffs, nsamps,
+                        if_packet_info, io_type, total_num_samps_sent*io_type.size
+                    );
+                }
+                total_num_samps_sent += nsamps;
+
+                //setup metadata for the next fragment
+                this->advance_fragment_time(if_packet_info, metadata, nsamps, total_num_samps_sent);
+                if_packet_info.sob = false;
+            }
+
+            //commit the batch to the zero-copy interfaces
+            BOOST_FOREACH(xport_chan_props_type &props, _props){
+                for (size_t i = 0; i < batch_size; i++) props.buffs[i]->commit(num_bytes[i]);
+                props.buffs.erase(props.buffs.begin(), props.buffs.begin() + batch_size);
+            }
+        }
+
+        //give back the buffers left over after a timeout (discarded, not sent)
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            if (not props.buffs.empty() and not props.return_buffs.empty()) props.return_buffs(props.buffs);
+            props.buffs.clear();
+        }
+        return total_num_samps_sent;
     }
 };
 
+template <typename get_buff_type_, typename vrt_packer_type_>
+const size_t send_packet_handler_t<get_buff_type_, vrt_packer_type_>::max_batch_size;
+
+//! The send packet handler with run-time function objects
+typedef send_packet_handler_t<> send_packet_handler;
+
 }}} //namespace
 
 #endif /* INCLUDED_LIBUHD_TRANSPORT_SUPER_SEND_PACKET_HANDLER_HPP */
@@ -102,7 +102,7 @@ public:
 
     void commit(size_t len){
         if (_len == 0) return;
-        ::send(_sock_fd, this->cast<const char *>(), len, 0);
+        if (len != 0) ::send(_sock_fd, this->cast<const char *>(), len, 0); //zero discards
         _pending.push_with_haste(this);
         _len = 0;
     }
@@ -176,6 +176,26 @@ public:
         return _internal_zc->get_send_frame_size();
     }
 
+    void set_recv_rate_hint(double bytes_per_sec){
+        _internal_zc->set_recv_rate_hint(bytes_per_sec);
+    }
+
+    size_t get_recv_xfer_size(void) const{
+        return _internal_zc->get_recv_xfer_size();
+    }
+
+    size_t get_num_recv_xfers(void) const{
+        return _internal_zc->get_num_recv_xfers();
+    }
+
+    std::vector<size_t> get_recv_latency_histogram(void) const{
+        return _internal_zc->get_recv_latency_histogram();
+    }
+
+    std::vector<size_t> get_send_latency_histogram(void) const{
+        return _internal_zc->get_send_latency_histogram();
+    }
+
 private:
     sptr _internal_zc;
     size_t _usb_frame_boundary;
@@ -0,0 +1,137 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/transport/zero_copy_prefetch.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+//The number of transport frames left for the caller to hold.
+//The receive packet handler keeps a few buffers per channel in flight.
+static const size_t num_reserved_frames = 4;
+
+//How long the reader blocks on the transport before checking for interrupts
+static const double reader_timeout = 0.1; //seconds
+
+/***********************************************************************
+ * Zero copy prefetch implementation:
+ *  - a reader task pulls from the transport and pushes into the ring
+ *  - get recv buff pops from the ring with timeout
+ *  - get send buff is a pass-through to the transport
+ **********************************************************************/
+class zero_copy_prefetch_impl : public zero_copy_prefetch{
+public:
+    zero_copy_prefetch_impl(zero_copy_if::sptr xport, const device_addr_t &hints):
+        _xport(xport),
+        _depth((xport->get_num_recv_frames() > num_reserved_frames)?
+            xport->get_num_recv_frames() - num_reserved_frames : 1),
+        _ring(_depth),
+        _cpu(int(hints.cast<double>("prefetch_cpu", -1)))
+    {
+        UHD_LOG << boost::format("Creating prefetch ring %u frames deep") % _depth << std::endl;
+        _reader_task = task::make(boost::bind(&zero_copy_prefetch_impl::reader_loop, this));
+    }
+
+    ~zero_copy_prefetch_impl(void){
+        //Stop the reader before the ring and transport are destroyed.
+        _reader_task.reset();
+    }
+
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        managed_recv_buffer::sptr buff;
+        _ring.pop_with_timed_wait(buff, timeout);
+        return buff;
+    }
+
+    size_t get_num_recv_frames(void) const{
+        return _xport->get_num_recv_frames();
+    }
+
+    size_t get_recv_frame_size(void) const{
+        return _xport->get_recv_frame_size();
+    }
+
+    managed_send_buffer::sptr get_send_buff(double timeout){
+        return _xport->get_send_buff(timeout);
+    }
+
+    size_t get_num_send_frames(void) const{
+        return _xport->get_num_send_frames();
+    }
+
+    size_t get_send_frame_size(void) const{
+        return _xport->get_send_frame_size();
+    }
+
+    size_t get_prefetch_depth(void) const{
+        return _depth;
+    }
+
+    size_t get_num_prefetched_frames(void) const{
+        return _num_prefetched.read();
+    }
+
+    size_t get_num_dropped_frames(void) const{
+        return _num_dropped.read();
+    }
+
+private:
+    /*******************************************************************
+     * Reader loop:
+     * Drain the transport as fast as it produces buffers.
+     * When the ring is full, the oldest buffer is popped and released
+     * back to the transport, so the freshest samples are always kept.
+     ******************************************************************/
+    void reader_loop(void){
+        set_thread_priority_safe();
+        if (_cpu >= 0) set_thread_affinity_safe(size_t(_cpu));
+
+        while (not boost::this_thread::interruption_requested()){
+            managed_recv_buffer::sptr buff = _xport->get_recv_buff(reader_timeout);
+            if (buff.get() == NULL) continue; //timeout or all frames in use
+            _num_prefetched.inc();
+            if (not _ring.push_with_pop_on_full(buff)) _num_dropped.inc();
+        }
+    }
+
+    //The transport is listed first so that it is deconstructed last,
+    //which is after the ring which may hold its managed buffers.
+    zero_copy_if::sptr _xport;
+    const size_t _depth;
+    bounded_buffer<managed_recv_buffer::sptr> _ring;
+    const int _cpu;
+    //written by the reader task, read by the caller's threads
+    mutable atomic_uint32_t _num_prefetched, _num_dropped;
+    task::sptr _reader_task;
+};
+
+/***********************************************************************
+ * Zero copy prefetch factory function
+ **********************************************************************/
+zero_copy_prefetch::sptr zero_copy_prefetch::make(
+    zero_copy_if::sptr xport, const device_addr_t &hints
+){
+    return sptr(new zero_copy_prefetch_impl(xport, hints));
+}
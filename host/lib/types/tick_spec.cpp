@@ -0,0 +1,79 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/types/tick_spec.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <cmath>
+
+using namespace uhd;
+
+/*!
+ * An integer tick rate converts whole seconds with integer math.
+ * Other rates convert whole seconds in floating point.
+ */
+static UHD_INLINE bool is_integer_rate(double tick_rate){
+    return tick_rate >= 1.0 and tick_rate < 9e18 and tick_rate == std::floor(tick_rate);
+}
+
+/***********************************************************************
+ * Tick spec constructors
+ **********************************************************************/
+tick_spec_t::tick_spec_t(time_t full_secs, boost::uint64_t tick_count, double tick_rate):
+    _tick_rate(tick_rate)
+{
+    if (is_integer_rate(tick_rate)){
+        _ticks = boost::int64_t(full_secs)*boost::int64_t(tick_rate) + boost::int64_t(tick_count);
+    }
+    else{
+        _ticks = boost::math::llround(full_secs*tick_rate) + boost::int64_t(tick_count);
+    }
+}
+
+tick_spec_t::tick_spec_t(const time_spec_t &time_spec, double tick_rate):
+    _tick_rate(tick_rate)
+{
+    const boost::int64_t frac_ticks = boost::math::llround(time_spec.get_frac_secs()*tick_rate);
+    if (is_integer_rate(tick_rate)){
+        _ticks = boost::int64_t(time_spec.get_full_secs())*boost::int64_t(tick_rate) + frac_ticks;
+    }
+    else{
+        _ticks = boost::math::llround(time_spec.get_full_secs()*tick_rate) + frac_ticks;
+    }
+}
+
+/***********************************************************************
+ * Tick spec conversions
+ **********************************************************************/
+time_spec_t tick_spec_t::to_time_spec(void) const{
+    if (is_integer_rate(_tick_rate)){
+        const boost::int64_t ticks_per_sec = boost::int64_t(_tick_rate);
+        boost::int64_t full_secs = _ticks/ticks_per_sec;
+        boost::int64_t tick_count = _ticks%ticks_per_sec;
+        if (tick_count < 0){
+            tick_count += ticks_per_sec;
+            full_secs -= 1;
+        }
+        return time_spec_t(time_t(full_secs), double(tick_count)/_tick_rate);
+    }
+    const double full_secs = std::floor(_ticks/_tick_rate);
+    return time_spec_t(time_t(full_secs), (_ticks - full_secs*_tick_rate)/_tick_rate);
+}
+
+boost::int64_t tick_spec_t::get_ticks(double tick_rate) const{
+    if (tick_rate == _tick_rate) return _ticks;
+    return tick_spec_t(this->to_time_spec(), tick_rate).get_ticks();
+}
@@ -199,6 +199,14 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
     _fpga_i2c_ctrl = i2c_core_100::make(_fpga_ctrl, B100_REG_SLAVE(3));
     _fpga_spi_ctrl = spi_core_100::make(_fpga_ctrl, B100_REG_SLAVE(2));
 
+    //the dsp and frontend settings hold state: skip rewrites of the same values
+    _fpga_wb_shadow = wb_shadow_iface::make(_fpga_ctrl);
+    _fpga_wb_shadow->set_shadowed(B100_REG_SR_ADDR(B100_SR_RX_DSP0), B100_REG_SR_ADDR(B100_SR_RX_DSP0 + 3));
+    _fpga_wb_shadow->set_shadowed(B100_REG_SR_ADDR(B100_SR_RX_DSP1), B100_REG_SR_ADDR(B100_SR_RX_DSP1 + 3));
+    _fpga_wb_shadow->set_shadowed(B100_REG_SR_ADDR(B100_SR_TX_DSP), B100_REG_SR_ADDR(B100_SR_TX_DSP + 2));
+    _fpga_wb_shadow->set_shadowed(B100_REG_SR_ADDR(B100_SR_RX_FRONT), B100_REG_SR_ADDR(B100_SR_RX_FRONT + 4));
+    _fpga_wb_shadow->set_shadowed(B100_REG_SR_ADDR(B100_SR_TX_FRONT), B100_REG_SR_ADDR(B100_SR_TX_FRONT + 4));
+
     ////////////////////////////////////////////////////////////////////
     // Create data transport
     // This happens after FPGA ctrl instantiated so any junk that might
@@ -210,6 +218,12 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
     data_xport_args["num_recv_frames"] = device_addr.get("num_recv_frames", "16");
     data_xport_args["send_frame_size"] = device_addr.get("send_frame_size", "16384");
     data_xport_args["num_send_frames"] = device_addr.get("num_send_frames", "16");
+    if (device_addr.has_key("auto_tune_xfers")){
+        data_xport_args["auto_tune_xfers"] = device_addr["auto_tune_xfers"];
+        //the FPGA pads each rx packet to 4 USB frames (B100_REG_MISC_RX_LEN),
+        //tuned transfers must stay a multiple of the padded packet size
+        data_xport_args["recv_frame_size_min"] = "2048";
+    }
 
     _data_transport = usb_zero_copy::make_wrapper(
         usb_zero_copy::make(
@@ -238,6 +252,18 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
         .set(mb_eeprom)
         .subscribe(boost::bind(&b100_impl::set_mb_eeprom, this, _1));
 
+    ////////////////////////////////////////////////////////////////////
+    // expose the data transport tuning and latency
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<size_t>(mb_path / "xport/recv_xfer_size")
+        .publish(boost::bind(&usb_zero_copy::get_recv_xfer_size, _data_transport));
+    _tree->create<size_t>(mb_path / "xport/num_recv_xfers")
+        .publish(boost::bind(&usb_zero_copy::get_num_recv_xfers, _data_transport));
+    _tree->create<std::vector<size_t> >(mb_path / "xport/recv_latency_histogram")
+        .publish(boost::bind(&usb_zero_copy::get_recv_latency_histogram, _data_transport));
+    _tree->create<std::vector<size_t> >(mb_path / "xport/send_latency_histogram")
+        .publish(boost::bind(&usb_zero_copy::get_send_latency_histogram, _data_transport));
+
     ////////////////////////////////////////////////////////////////////
     // create clock control objects
     ////////////////////////////////////////////////////////////////////
@@ -271,8 +297,8 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
     ////////////////////////////////////////////////////////////////////
     // create frontend control objects
     ////////////////////////////////////////////////////////////////////
-    _rx_fe = rx_frontend_core_200::make(_fpga_ctrl, B100_REG_SR_ADDR(B100_SR_RX_FRONT));
-    _tx_fe = tx_frontend_core_200::make(_fpga_ctrl, B100_REG_SR_ADDR(B100_SR_TX_FRONT));
+    _rx_fe = rx_frontend_core_200::make(_fpga_wb_shadow, B100_REG_SR_ADDR(B100_SR_RX_FRONT));
+    _tx_fe = tx_frontend_core_200::make(_fpga_wb_shadow, B100_REG_SR_ADDR(B100_SR_TX_FRONT));
     //TODO lots of properties to expose here for frontends
     _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec")
         .subscribe(boost::bind(&b100_impl::update_rx_subdev_spec, this, _1));
@@ -283,10 +309,10 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
     // create rx dsp control objects
     ////////////////////////////////////////////////////////////////////
     _rx_dsps.push_back(rx_dsp_core_200::make(
-        _fpga_ctrl, B100_REG_SR_ADDR(B100_SR_RX_DSP0), B100_REG_SR_ADDR(B100_SR_RX_CTRL0), B100_RX_SID_BASE + 0
+        _fpga_wb_shadow, B100_REG_SR_ADDR(B100_SR_RX_DSP0), B100_REG_SR_ADDR(B100_SR_RX_CTRL0), B100_RX_SID_BASE + 0
     ));
     _rx_dsps.push_back(rx_dsp_core_200::make(
-        _fpga_ctrl, B100_REG_SR_ADDR(B100_SR_RX_DSP1), B100_REG_SR_ADDR(B100_SR_RX_CTRL1), B100_RX_SID_BASE + 1
+        _fpga_wb_shadow, B100_REG_SR_ADDR(B100_SR_RX_DSP1), B100_REG_SR_ADDR(B100_SR_RX_CTRL1), B100_RX_SID_BASE + 1
     ));
     for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++){
         _rx_dsps[dspno]->set_link_rate(B100_LINK_RATE_BPS);
@@ -308,7 +334,7 @@ b100_impl::b100_impl(const device_addr_t &device_addr){
     // create tx dsp control objects
     ////////////////////////////////////////////////////////////////////
     _tx_dsp = tx_dsp_core_200::make(
-        _fpga_ctrl, B100_REG_SR_ADDR(B100_SR_TX_DSP), B100_REG_SR_ADDR(B100_SR_TX_CTRL), B100_TX_ASYNC_SID
+        _fpga_wb_shadow, B100_REG_SR_ADDR(B100_SR_TX_DSP), B100_REG_SR_ADDR(B100_SR_TX_CTRL), B100_TX_ASYNC_SID
     );
     _tx_dsp->set_link_rate(B100_LINK_RATE_BPS);
     _tree->access<double>(mb_path / "tick_rate")
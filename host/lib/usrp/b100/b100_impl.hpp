@@ -29,6 +29,7 @@
 #include "rx_dsp_core_200.hpp"
 #include "tx_dsp_core_200.hpp"
 #include "time64_core_200.hpp"
+#include "wb_shadow_iface.hpp"
 #include <uhd/device.hpp>
 #include <uhd/property_tree.hpp>
 #include <uhd/utils/pimpl.hpp>
@@ -78,6 +79,8 @@ public:
                 size_t, uhd::rx_metadata_t &,
                 const uhd::io_type_t &,
                 recv_mode_t, double);
+    recv_lease_type borrow_recv(recv_views_type &, uhd::rx_metadata_t &, double);
+    send_commit_type borrow_send(send_views_type &, const uhd::tx_metadata_t &, double);
     size_t get_max_send_samps_per_packet(void) const;
     size_t get_max_recv_samps_per_packet(void) const;
     bool recv_async_msg(uhd::async_metadata_t &, double);
@@ -96,10 +99,12 @@ private:
     b100_clock_ctrl::sptr _clock_ctrl;
     b100_codec_ctrl::sptr _codec_ctrl;
     b100_ctrl::sptr _fpga_ctrl;
+    wb_shadow_iface::sptr _fpga_wb_shadow;
     uhd::usrp::fx2_ctrl::sptr _fx2_ctrl;
 
     //transports
-    uhd::transport::zero_copy_if::sptr _data_transport, _ctrl_transport;
+    uhd::transport::usb_zero_copy::sptr _data_transport;
+    uhd::transport::zero_copy_if::sptr _ctrl_transport;
 
     //dboard stuff
     uhd::usrp::dboard_manager::sptr _dboard_manager;
@@ -124,6 +129,7 @@ private:
     void update_rx_samp_rate(const double rate);
     void update_tx_samp_rate(const double rate);
     void update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &);
+    void update_rx_xport_rate(void);
     void update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &);
     void update_clock_source(const std::string &);
     void reset_gpif(const boost::uint16_t);
@@ -46,8 +46,8 @@ struct b100_impl::io_impl{
     zero_copy_if::sptr data_transport;
     bounded_buffer<async_metadata_t> async_msg_fifo;
     recv_packet_demuxer::sptr demuxer;
-    sph::recv_packet_handler recv_handler;
-    sph::send_packet_handler send_handler;
+    sph::recv_packet_handler_t<recv_packet_demuxer::chan_get_buff, sph::vrt_unpack_le> recv_handler;
+    sph::send_packet_handler_t<sph::xport_get_send_buff, sph::vrt_pack_le> send_handler;
 };
 
 /***********************************************************************
@@ -76,13 +76,22 @@ void b100_impl::io_init(void){
     _io_impl = UHD_PIMPL_MAKE(io_impl, ());
     _io_impl->demuxer = recv_packet_demuxer::make(_data_transport, _rx_dsps.size(), B100_RX_SID_BASE);
 
+    //expose the demuxer queue statistics for each rx dsp
+    for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++){
+        const fs_path rx_dsp_path = str(boost::format("/mboards/0/rx_dsps/%u") % dspno);
+        _tree->create<size_t>(rx_dsp_path / "demux/depth")
+            .publish(boost::bind(&recv_packet_demuxer::get_queue_depth, _io_impl->demuxer, dspno));
+        _tree->create<size_t>(rx_dsp_path / "demux/max_depth")
+            .publish(boost::bind(&recv_packet_demuxer::get_max_queue_depth, _io_impl->demuxer, dspno));
+    }
+
     //now its safe to register the async callback
     _fpga_ctrl->set_async_cb(boost::bind(&b100_impl::handle_async_message, this, _1));
 
     //init some handler stuff
-    _io_impl->recv_handler.set_vrt_unpacker(&vrt::if_hdr_unpack_le);
+    _io_impl->recv_handler.set_vrt_unpacker(sph::vrt_unpack_le());
     _io_impl->recv_handler.set_converter(_rx_otw_type);
-    _io_impl->send_handler.set_vrt_packer(&vrt::if_hdr_pack_le);
+    _io_impl->send_handler.set_vrt_packer(sph::vrt_pack_le());
     _io_impl->send_handler.set_converter(_tx_otw_type);
     _io_impl->send_handler.set_max_samples_per_packet(get_max_send_samps_per_packet());
 }
@@ -132,6 +141,17 @@ void b100_impl::update_rx_samp_rate(const double rate){
     _io_impl->recv_handler.set_samp_rate(rate);
     const double adj = _rx_dsps.front()->get_scaling_adjustment();
     _io_impl->recv_handler.set_scale_factor(adj/32767.);
+    this->update_rx_xport_rate();
+}
+
+void b100_impl::update_rx_xport_rate(void){
+    //tune the usb transfers for the aggregate rate of the active channels
+    double bytes_per_sec = 0.0;
+    for (size_t i = 0; i < _io_impl->recv_handler.size(); i++){
+        property<double> &rate = _tree->access<double>(str(boost::format("/mboards/0/rx_dsps/%u/rate/value") % i));
+        if (not rate.empty()) bytes_per_sec += rate.get()*_rx_otw_type.get_sample_size();
+    }
+    _data_transport->set_recv_rate_hint(bytes_per_sec);
 }
 
 void b100_impl::update_tx_samp_rate(const double rate){
@@ -161,11 +181,14 @@ void b100_impl::update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
     //bind new callbacks for the handler
     for (size_t i = 0; i < _io_impl->recv_handler.size(); i++){
         _rx_dsps[i]->set_nsamps_per_packet(get_max_recv_samps_per_packet()); //seems to be a good place to set this
-        _io_impl->recv_handler.set_xport_chan_get_buff(i, boost::bind(
-            &recv_packet_demuxer::get_recv_buff, _io_impl->demuxer, i, _1
-        ));
+        _io_impl->recv_handler.set_xport_chan_get_buff(i,
+            recv_packet_demuxer::chan_get_buff(_io_impl->demuxer, i)
+        );
         _io_impl->recv_handler.set_overflow_handler(i, boost::bind(&rx_dsp_core_200::handle_overflow, _rx_dsps[i]));
     }
+
+    //the number of channels changed the aggregate rate
+    this->update_rx_xport_rate();
 }
 
 void b100_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
@@ -184,9 +207,9 @@ void b100_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
 
     //bind new callbacks for the handler
     for (size_t i = 0; i < _io_impl->send_handler.size(); i++){
-        _io_impl->send_handler.set_xport_chan_get_buff(i, boost::bind(
-            &zero_copy_if::get_send_buff, _data_transport, _1
-        ));
+        _io_impl->send_handler.set_xport_chan_get_buff(i,
+            sph::xport_get_send_buff(_data_transport)
+        );
     }
 }
 
@@ -248,3 +271,15 @@ size_t b100_impl::recv(
         recv_mode, timeout
     );
 }
+
+device::recv_lease_type b100_impl::borrow_recv(
+    recv_views_type &views, rx_metadata_t &metadata, double timeout
+){
+    return _io_impl->recv_handler.borrow(views, metadata, timeout);
+}
+
+device::send_commit_type b100_impl::borrow_send(
+    send_views_type &views, const tx_metadata_t &metadata, double timeout
+){
+    return _io_impl->send_handler.borrow(views, metadata, timeout);
+}
@@ -18,9 +18,13 @@
 #include "recv_packet_demuxer.hpp"
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
-#include <queue>
-#include <deque>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <vector>
 
 using namespace uhd;
@@ -32,6 +36,71 @@ static UHD_INLINE boost::uint32_t extract_sid(managed_recv_buffer::sptr &buff){
     return uhd::wtohx(buff->cast<const boost::uint32_t *>()[1]);
 }
 
+/***********************************************************************
+ * Single producer, single consumer queue of receive buffers:
+ *  - the producer is whichever thread currently owns the transport
+ *  - the consumer is the thread receiving on this channel
+ * The head is only written by the producer, the tail by the consumer.
+ **********************************************************************/
+class sid_queue{
+public:
+    sid_queue(const size_t capacity):
+        _buffs(capacity + 1) //one slot is always empty
+    {
+        /* NOP */
+    }
+
+    //! Move the buffer into the queue, false when full
+    UHD_INLINE bool push(managed_recv_buffer::sptr &buff){
+        const boost::uint32_t head = _head.read();
+        const boost::uint32_t next = this->next(head);
+        if (next == _tail.read()) return false;
+        std::swap(_buffs[head], buff);
+        _head.write(next);
+
+        //update the high water mark (only the producer writes it)
+        const boost::uint32_t depth = this->depth();
+        if (depth > _max_depth.read()) _max_depth.write(depth);
+        return true;
+    }
+
+    //! Move the front of the queue into the buffer, false when empty
+    UHD_INLINE bool pop(managed_recv_buffer::sptr &buff){
+        const boost::uint32_t tail = _tail.read();
+        if (tail == _head.read()) return false;
+        std::swap(buff, _buffs[tail]);
+        _tail.write(this->next(tail));
+        return true;
+    }
+
+    UHD_INLINE size_t depth(void) const{
+        const boost::uint32_t head = _head.read();
+        const boost::uint32_t tail = _tail.read();
+        return (head >= tail)? head - tail : head + _buffs.size() - tail;
+    }
+
+    UHD_INLINE size_t max_depth(void) const{
+        return _max_depth.read();
+    }
+
+private:
+    UHD_INLINE boost::uint32_t next(const boost::uint32_t i) const{
+        return (i + 1 == _buffs.size())? 0 : i + 1;
+    }
+
+    std::vector<managed_recv_buffer::sptr> _buffs;
+    mutable atomic_uint32_t _head, _tail, _max_depth;
+};
+
+/***********************************************************************
+ * Demuxer implementation:
+ * A caller first checks its own queue. When that is empty,
+ * it tries to take ownership of the transport with a compare and swap.
+ * The owner pulls one packet, routes it, and then gives up ownership,
+ * so a packet is always queued before the next owner looks at its queue.
+ * Callers that could not take the transport sleep until the owner
+ * gives it up, since the owner may have routed a packet to their queue.
+ **********************************************************************/
 class recv_packet_demuxer_impl : public uhd::usrp::recv_packet_demuxer{
 public:
     recv_packet_demuxer_impl(
@@ -39,47 +108,117 @@ public:
         const size_t size,
         const boost::uint32_t sid_base
     ):
-        _transport(transport), _sid_base(sid_base), _queues(size)
+        _transport(transport), _sid_base(sid_base)
     {
-        /* NOP */
+        //a queue never holds more buffers than the transport has frames
+        for (size_t i = 0; i < size; i++){
+            _queues.push_back(boost::shared_ptr<sid_queue>(
+                new sid_queue(_transport->get_num_recv_frames())
+            ));
+        }
     }
 
     managed_recv_buffer::sptr get_recv_buff(const size_t index, const double timeout){
-        boost::mutex::scoped_lock lock(_mutex);
+        const boost::system_time exit_time = boost::get_system_time() + to_time_dur(timeout);
         managed_recv_buffer::sptr buff;
 
-        //there is already an entry in the queue, so pop that
-        if (not _queues[index].wrapper.empty()){
-            std::swap(buff, _queues[index].wrapper.front());
-            _queues[index].wrapper.pop();
-            return buff;
-        }
-
         while (true){
+            //there is already an entry in the queue, so pop that
+            if (_queues[index]->pop(buff)) return buff;
+
+            //another thread owns the transport, wait for it until the timeout
+            if (_owner.cas(1, 0) != 0){
+                if (not this->wait_for_owner(index, exit_time)) return buff;
+                continue;
+            }
+
+            //the previous owner may have queued for us before giving up the transport
+            if (_queues[index]->pop(buff)){
+                this->release_owner();
+                return buff;
+            }
+
             //otherwise call into the transport
-            buff = _transport->get_recv_buff(timeout);
-            if (buff.get() == NULL) return buff; //timeout
+            try{
+                buff = _transport->get_recv_buff(time_left(exit_time));
+            }
+            catch(...){
+                this->release_owner();
+                throw;
+            }
+            if (buff.get() == NULL){ //timeout
+                this->release_owner();
+                return buff;
+            }
 
             //check the stream id to know which channel
-            const size_t rx_index = extract_sid(buff) - _sid_base;
-            if (rx_index == index) return buff; //got expected message
+            const boost::uint32_t sid = extract_sid(buff);
+            const size_t rx_index = sid - _sid_base;
+            if (rx_index == index){ //got expected message
+                this->release_owner();
+                return buff;
+            }
 
-            //otherwise queue and try again
-            if (rx_index < _queues.size()) _queues[rx_index].wrapper.push(buff);
-            else UHD_MSG(error) << "Got a data packet with unknown SID " << extract_sid(buff) << std::endl;
+            //otherwise queue (while still the owner, the only producer) and try again
+            if (rx_index < _queues.size()){
+                if (not _queues[rx_index]->push(buff)) UHD_MSG(error)
+                    << "Dropped a data packet, the queue for SID " << sid << " is full" << std::endl;
+            }
+            else UHD_MSG(error) << "Got a data packet with unknown SID " << sid << std::endl;
+            this->release_owner();
+            buff.reset(); //release now, not on the next timeout
         }
     }
 
+    size_t get_queue_depth(const size_t index) const{
+        return _queues.at(index)->depth();
+    }
+
+    size_t get_max_queue_depth(const size_t index) const{
+        return _queues.at(index)->max_depth();
+    }
+
 private:
+    //! Give up the transport and wake the callers waiting on it
+    //! The write is a full barrier, so it is seen before the waiter count is read;
+    //! a waiter increments the count before it reads the owner, so one side sees the other.
+    UHD_INLINE void release_owner(void){
+        _owner.write(0);
+        if (_num_waiters.read() == 0) return;
+        boost::mutex::scoped_lock lock(_mutex);
+        _cond.notify_all();
+    }
+
+    //! Sleep until the transport is free or there is a buffer queued, false on timeout
+    bool wait_for_owner(const size_t index, const boost::system_time &exit_time){
+        boost::mutex::scoped_lock lock(_mutex);
+        _num_waiters.inc();
+        bool ready = true;
+        while (_owner.read() != 0 and _queues[index]->depth() == 0){
+            if (not _cond.timed_wait(lock, exit_time)){
+                ready = _queues[index]->depth() != 0;
+                break;
+            }
+        }
+        _num_waiters.dec();
+        return ready;
+    }
+
+    static UHD_INLINE boost::posix_time::time_duration to_time_dur(const double timeout){
+        return boost::posix_time::microseconds(long(timeout*1e6));
+    }
+
+    static UHD_INLINE double time_left(const boost::system_time &exit_time){
+        const long us = (exit_time - boost::get_system_time()).total_microseconds();
+        return (us > 0)? us/1e6 : 0.0;
+    }
+
     transport::zero_copy_if::sptr _transport;
     const boost::uint32_t _sid_base;
+    atomic_uint32_t _owner, _num_waiters;
     boost::mutex _mutex;
-    struct channel_guts_type{
-        channel_guts_type(void): wrapper(container){}
-        std::deque<managed_recv_buffer::sptr> container;
-        std::queue<managed_recv_buffer::sptr> wrapper;
-    };
-    std::vector<channel_guts_type> _queues;
+    boost::condition_variable _cond;
+    std::vector<boost::shared_ptr<sid_queue> > _queues;
 };
 
 recv_packet_demuxer::sptr recv_packet_demuxer::make(transport::zero_copy_if::sptr transport, const size_t size, const boost::uint32_t sid_base){
@@ -25,6 +25,14 @@
 
 namespace uhd{ namespace usrp{
 
+    /*!
+     * The demuxer shares one transport between several receive channels.
+     * Each channel has its own single-consumer queue of buffers,
+     * so that separate threads may receive different channels concurrently.
+     * Any caller may take the transport to pull the next packet,
+     * and packets with another channel's SID are routed into that queue.
+     * The queues are lock-free, a thread never waits on another channel.
+     */
     class recv_packet_demuxer{
     public:
         typedef boost::shared_ptr<recv_packet_demuxer> sptr;
@@ -32,8 +40,31 @@ namespace uhd{ namespace usrp{
         //! Make a new demuxer from a transport and parameters
         static sptr make(transport::zero_copy_if::sptr transport, const size_t size, const boost::uint32_t sid_base);
 
-        //! Get a buffer at the given index from the transport
+        /*!
+         * Get a buffer at the given index from the transport.
+         * Only one thread at a time may call this for a given index.
+         */
         virtual transport::managed_recv_buffer::sptr get_recv_buff(const size_t index, const double timeout) = 0;
+
+        //! Get the number of buffers waiting in the queue for the given index
+        virtual size_t get_queue_depth(const size_t index) const = 0;
+
+        //! Get the largest number of buffers held in the queue for the given index
+        virtual size_t get_max_queue_depth(const size_t index) const = 0;
+
+        //! A buffer getter for one index, usable as a packet handler policy
+        class chan_get_buff{
+        public:
+            chan_get_buff(void): _index(0){/* NOP */}
+            chan_get_buff(sptr demuxer, const size_t index):
+                _demuxer(demuxer), _index(index){/* NOP */}
+            UHD_INLINE transport::managed_recv_buffer::sptr operator()(double timeout) const{
+                return _demuxer->get_recv_buff(_index, timeout);
+            }
+        private:
+            sptr _demuxer;
+            size_t _index;
+        };
     };
 
 }} //namespace uhd::usrp
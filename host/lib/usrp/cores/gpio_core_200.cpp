@@ -17,6 +17,7 @@
 
 #include "gpio_core_200.hpp"
 #include <uhd/types/dict.hpp>
+#include <boost/assign/list_inserter.hpp>
 
 #define REG_GPIO_IDLE          _base + 0
 #define REG_GPIO_RX_ONLY       _base + 4
@@ -72,13 +73,17 @@ private:
     }
 
     void update(void){
-        this->update(dboard_iface::ATR_REG_IDLE, REG_GPIO_IDLE);
-        this->update(dboard_iface::ATR_REG_TX_ONLY, REG_GPIO_TX_ONLY);
-        this->update(dboard_iface::ATR_REG_RX_ONLY, REG_GPIO_RX_ONLY);
-        this->update(dboard_iface::ATR_REG_FULL_DUPLEX, REG_GPIO_BOTH);
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_GPIO_IDLE, this->get_atr_val(dboard_iface::ATR_REG_IDLE))
+            (REG_GPIO_TX_ONLY, this->get_atr_val(dboard_iface::ATR_REG_TX_ONLY))
+            (REG_GPIO_RX_ONLY, this->get_atr_val(dboard_iface::ATR_REG_RX_ONLY))
+            (REG_GPIO_BOTH, this->get_atr_val(dboard_iface::ATR_REG_FULL_DUPLEX))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
-    void update(const atr_reg_t atr, const size_t addr){
+    boost::uint32_t get_atr_val(const atr_reg_t atr){
         const boost::uint32_t atr_val =
             (boost::uint32_t(_atr_regs[dboard_iface::UNIT_RX][atr]) << unit2shit(dboard_iface::UNIT_RX)) |
             (boost::uint32_t(_atr_regs[dboard_iface::UNIT_TX][atr]) << unit2shit(dboard_iface::UNIT_TX));
@@ -90,7 +95,7 @@ private:
         const boost::uint32_t ctrl =
             (boost::uint32_t(_pin_ctrl[dboard_iface::UNIT_RX]) << unit2shit(dboard_iface::UNIT_RX)) |
             (boost::uint32_t(_pin_ctrl[dboard_iface::UNIT_TX]) << unit2shit(dboard_iface::UNIT_TX));
-        _iface->poke32(addr, (ctrl & atr_val) | ((~ctrl) & gpio_val));
+        return (ctrl & atr_val) | ((~ctrl) & gpio_val);
     }
 
 };
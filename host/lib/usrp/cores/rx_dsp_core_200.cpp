@@ -20,6 +20,7 @@
 #include <uhd/exception.hpp>
 #include <uhd/utils/algorithm.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/assign/list_inserter.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/math/special_functions/sign.hpp>
 #include <algorithm>
@@ -66,16 +67,20 @@ public:
             issue_stream_command(stream_cmd);
         }
 
-        _iface->poke32(REG_RX_CTRL_CLEAR, 1); //reset
-        _iface->poke32(REG_RX_CTRL_NCHANNELS, 1);
-        _iface->poke32(REG_RX_CTRL_VRT_HDR, 0
-            | (0x1 << 28) //if data with stream id
-            | (0x1 << 26) //has trailer
-            | (0x3 << 22) //integer time other
-            | (0x1 << 20) //fractional time sample count
-        );
-        _iface->poke32(REG_RX_CTRL_VRT_SID, sid);
-        _iface->poke32(REG_RX_CTRL_VRT_TLR, 0);
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_RX_CTRL_CLEAR, 1) //reset
+            (REG_RX_CTRL_NCHANNELS, 1)
+            (REG_RX_CTRL_VRT_HDR, 0
+                | (0x1 << 28) //if data with stream id
+                | (0x1 << 26) //has trailer
+                | (0x3 << 22) //integer time other
+                | (0x1 << 20) //fractional time sample count
+            )
+            (REG_RX_CTRL_VRT_SID, sid)
+            (REG_RX_CTRL_VRT_TLR, 0)
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_nsamps_per_packet(const size_t nsamps){
@@ -109,9 +114,13 @@ public:
         cmd_word |= (inst_samps)? stream_cmd.num_samps : ((inst_stop)? 0 : 1);
 
         //issue the stream command
-        _iface->poke32(REG_RX_CTRL_STREAM_CMD, cmd_word);
-        _iface->poke32(REG_RX_CTRL_TIME_SECS, boost::uint32_t(stream_cmd.time_spec.get_full_secs()));
-        _iface->poke32(REG_RX_CTRL_TIME_TICKS, stream_cmd.time_spec.get_tick_count(_tick_rate)); //latches the command
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_RX_CTRL_STREAM_CMD, cmd_word)
+            (REG_RX_CTRL_TIME_SECS, boost::uint32_t(stream_cmd.time_spec.get_full_secs()))
+            (REG_RX_CTRL_TIME_TICKS, stream_cmd.time_spec.get_tick_count(_tick_rate)) //latches the command
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_mux(const std::string &mode, const bool fe_swapped){
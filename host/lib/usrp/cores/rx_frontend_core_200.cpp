@@ -17,6 +17,7 @@
 
 #include "rx_frontend_core_200.hpp"
 #include <boost/math/special_functions/round.hpp>
+#include <boost/assign/list_inserter.hpp>
 
 #define REG_RX_FE_SWAP_IQ             _base + 0 //lower bit
 #define REG_RX_FE_MAG_CORRECTION      _base + 4 //18 bits
@@ -42,13 +43,21 @@ public:
     }
 
     void set_offset(const std::complex<double> &off){
-        _iface->poke32(REG_RX_FE_OFFSET_I, fs_to_bits(off.real(), 24));
-        _iface->poke32(REG_RX_FE_OFFSET_Q, fs_to_bits(off.imag(), 24));
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_RX_FE_OFFSET_I, fs_to_bits(off.real(), 24))
+            (REG_RX_FE_OFFSET_Q, fs_to_bits(off.imag(), 24))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_correction(const std::complex<double> &cor){
-        _iface->poke32(REG_RX_FE_MAG_CORRECTION, fs_to_bits(std::abs(cor), 18));
-        _iface->poke32(REG_RX_FE_PHASE_CORRECTION, fs_to_bits(std::atan2(cor.real(), cor.imag()), 18));
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_RX_FE_MAG_CORRECTION, fs_to_bits(std::abs(cor), 18))
+            (REG_RX_FE_PHASE_CORRECTION, fs_to_bits(std::atan2(cor.real(), cor.imag()), 18))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
 private:
@@ -19,6 +19,7 @@
 #include <uhd/exception.hpp>
 #include <uhd/utils/assert_has.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/assign/list_inserter.hpp>
 
 #define REG_TIME64_SECS        _base + 0
 #define REG_TIME64_TICKS       _base + 4
@@ -83,15 +84,23 @@ public:
     }
 
     void set_time_now(const uhd::time_spec_t &time){
-        _iface->poke32(REG_TIME64_TICKS, time.get_tick_count(_tick_rate));
-        _iface->poke32(REG_TIME64_IMM, FLAG_TIME64_LATCH_NOW);
-        _iface->poke32(REG_TIME64_SECS, boost::uint32_t(time.get_full_secs())); //latches all 3
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TIME64_TICKS, time.get_tick_count(_tick_rate))
+            (REG_TIME64_IMM, FLAG_TIME64_LATCH_NOW)
+            (REG_TIME64_SECS, boost::uint32_t(time.get_full_secs())) //latches all 3
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_time_next_pps(const uhd::time_spec_t &time){
-        _iface->poke32(REG_TIME64_TICKS, time.get_tick_count(_tick_rate));
-        _iface->poke32(REG_TIME64_IMM, FLAG_TIME64_LATCH_NEXT_PPS);
-        _iface->poke32(REG_TIME64_SECS, boost::uint32_t(time.get_full_secs())); //latches all 3
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TIME64_TICKS, time.get_tick_count(_tick_rate))
+            (REG_TIME64_IMM, FLAG_TIME64_LATCH_NEXT_PPS)
+            (REG_TIME64_SECS, boost::uint32_t(time.get_full_secs())) //latches all 3
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_time_source(const std::string &source){
@@ -20,6 +20,7 @@
 #include <uhd/exception.hpp>
 #include <uhd/utils/algorithm.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/assign/list_inserter.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/math/special_functions/sign.hpp>
 #include <algorithm>
@@ -59,10 +60,14 @@ public:
         _iface(iface), _dsp_base(dsp_base), _ctrl_base(ctrl_base)
     {
         //init the tx control registers
-        _iface->poke32(REG_TX_CTRL_CLEAR_STATE, 1); //reset
-        _iface->poke32(REG_TX_CTRL_NUM_CHAN, 0);    //1 channel
-        _iface->poke32(REG_TX_CTRL_REPORT_SID, sid);
-        _iface->poke32(REG_TX_CTRL_POLICY, FLAG_TX_CTRL_POLICY_NEXT_PACKET);
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TX_CTRL_CLEAR_STATE, 1) //reset
+            (REG_TX_CTRL_NUM_CHAN, 0)    //1 channel
+            (REG_TX_CTRL_REPORT_SID, sid)
+            (REG_TX_CTRL_POLICY, FLAG_TX_CTRL_POLICY_NEXT_PACKET)
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_tick_rate(const double rate){
@@ -127,8 +132,12 @@ public:
     }
 
     void set_updates(const size_t cycles_per_up, const size_t packets_per_up){
-        _iface->poke32(REG_TX_CTRL_CYCLES_PER_UP,  (cycles_per_up  == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | cycles_per_up));
-        _iface->poke32(REG_TX_CTRL_PACKETS_PER_UP, (packets_per_up == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | packets_per_up));
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TX_CTRL_CYCLES_PER_UP,  (cycles_per_up  == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | cycles_per_up))
+            (REG_TX_CTRL_PACKETS_PER_UP, (packets_per_up == 0)? 0 : (FLAG_TX_CTRL_UP_ENB | packets_per_up))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
 private:
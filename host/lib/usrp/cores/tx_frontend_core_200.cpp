@@ -20,6 +20,7 @@
 #include <uhd/exception.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/math/special_functions/round.hpp>
+#include <boost/assign/list_inserter.hpp>
 
 #define REG_TX_FE_DC_OFFSET_I         _base + 0 //24 bits
 #define REG_TX_FE_DC_OFFSET_Q         _base + 4 //24 bits
@@ -51,13 +52,21 @@ public:
     }
 
     void set_dc_offset(const std::complex<double> &off){
-        _iface->poke32(REG_TX_FE_DC_OFFSET_I, fs_to_bits(off.real(), 24));
-        _iface->poke32(REG_TX_FE_DC_OFFSET_Q, fs_to_bits(off.imag(), 24));
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TX_FE_DC_OFFSET_I, fs_to_bits(off.real(), 24))
+            (REG_TX_FE_DC_OFFSET_Q, fs_to_bits(off.imag(), 24))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
     void set_correction(const std::complex<double> &cor){
-        _iface->poke32(REG_TX_FE_MAG_CORRECTION, fs_to_bits(std::abs(cor), 18));
-        _iface->poke32(REG_TX_FE_PHASE_CORRECTION, fs_to_bits(std::atan2(cor.real(), cor.imag()), 18));
+        wb_iface::poke32_batch_type pokes;
+        boost::assign::push_back(pokes)
+            (REG_TX_FE_MAG_CORRECTION, fs_to_bits(std::abs(cor), 18))
+            (REG_TX_FE_PHASE_CORRECTION, fs_to_bits(std::atan2(cor.real(), cor.imag()), 18))
+        ;
+        _iface->batch_poke32(pokes);
     }
 
 private:
@@ -21,6 +21,8 @@
 #include <uhd/config.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
+#include <vector>
+#include <utility>
 
 class wb_iface{
 public:
@@ -55,6 +57,20 @@ public:
      */
     virtual boost::uint16_t peek16(wb_addr_type addr) = 0;
 
+    typedef std::vector<std::pair<wb_addr_type, boost::uint32_t> > poke32_batch_type;
+
+    /*!
+     * Write a list of registers (32 bits) in order.
+     * An interface with a slow transport can override this
+     * to send the writes in fewer transactions.
+     * \param pokes a list of address and 32bit data pairs
+     */
+    virtual void batch_poke32(const poke32_batch_type &pokes){
+        for (size_t i = 0; i < pokes.size(); i++){
+            this->poke32(pokes[i].first, pokes[i].second);
+        }
+    }
+
 };
 
 #endif /* INCLUDED_LIBUHD_USRP_WB_IFACE_HPP */
@@ -0,0 +1,160 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "wb_shadow_iface.hpp"
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/safe_call.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <vector>
+
+class wb_shadow_iface_impl : public wb_shadow_iface{
+public:
+    wb_shadow_iface_impl(wb_iface::sptr iface):
+        _iface(iface), _burst_depth(0)
+    {
+        _stats.num_pokes = 0;
+        _stats.num_redundant = 0;
+        _stats.num_transactions = 0;
+    }
+
+    ~wb_shadow_iface_impl(void){UHD_SAFE_CALL(
+        boost::mutex::scoped_lock lock(_mutex);
+        this->flush();
+        UHD_LOG << "wb shadow iface: " << _stats.num_pokes << " pokes, "
+            << _stats.num_redundant << " redundant, "
+            << _stats.num_transactions << " transactions" << std::endl;
+    )}
+
+    /*******************************************************************
+     * Peek and Poke
+     ******************************************************************/
+    void poke32(wb_addr_type addr, boost::uint32_t data){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->queue(addr, data);
+        if (_burst_depth == 0) this->flush();
+    }
+
+    void batch_poke32(const poke32_batch_type &pokes){
+        boost::mutex::scoped_lock lock(_mutex);
+        for (size_t i = 0; i < pokes.size(); i++){
+            this->queue(pokes[i].first, pokes[i].second);
+        }
+        if (_burst_depth == 0) this->flush();
+    }
+
+    boost::uint32_t peek32(wb_addr_type addr){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->flush();
+        return _iface->peek32(addr);
+    }
+
+    void poke16(wb_addr_type addr, boost::uint16_t data){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->flush();
+        _shadow.erase(addr & ~wb_addr_type(0x3)); //now partly unknown
+        _iface->poke16(addr, data);
+    }
+
+    boost::uint16_t peek16(wb_addr_type addr){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->flush();
+        return _iface->peek16(addr);
+    }
+
+    /*******************************************************************
+     * Shadow control
+     ******************************************************************/
+    void set_shadowed(wb_addr_type first, wb_addr_type last){
+        boost::mutex::scoped_lock lock(_mutex);
+        _ranges.push_back(std::make_pair(first, last));
+    }
+
+    void clear_shadow(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _shadow.clear();
+    }
+
+    void begin_burst(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _burst_depth++;
+    }
+
+    void end_burst(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_burst_depth == 0) return;
+        if (--_burst_depth == 0) this->flush();
+    }
+
+    stats_type get_stats(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _stats;
+    }
+
+private:
+    wb_iface::sptr _iface;
+    boost::mutex _mutex;
+    size_t _burst_depth;
+    stats_type _stats;
+    std::vector<std::pair<wb_addr_type, wb_addr_type> > _ranges;
+    boost::unordered_map<wb_addr_type, boost::uint32_t> _shadow;
+    poke32_batch_type _queue;
+
+    bool is_shadowed(wb_addr_type addr) const{
+        for (size_t i = 0; i < _ranges.size(); i++){
+            if (addr >= _ranges[i].first and addr <= _ranges[i].second) return true;
+        }
+        return false;
+    }
+
+    //! Queue the poke unless the shadow says it changes nothing
+    void queue(wb_addr_type addr, boost::uint32_t data){
+        _stats.num_pokes++;
+        if (this->is_shadowed(addr)){
+            boost::unordered_map<wb_addr_type, boost::uint32_t>::iterator it = _shadow.find(addr);
+            if (it != _shadow.end() and it->second == data){
+                _stats.num_redundant++;
+                return;
+            }
+            _shadow[addr] = data;
+        }
+        _queue.push_back(std::make_pair(addr, data));
+    }
+
+    //! Send the queued pokes in one call on the wrapped iface
+    void flush(void){
+        if (_queue.empty()) return;
+        poke32_batch_type pokes;
+        pokes.swap(_queue);
+        _stats.num_transactions++;
+        try{
+            if (pokes.size() == 1) _iface->poke32(pokes.front().first, pokes.front().second);
+            else _iface->batch_poke32(pokes);
+        }
+        catch(...){
+            _shadow.clear(); //the writes may not have landed
+            throw;
+        }
+    }
+};
+
+/***********************************************************************
+ * Public make function for the shadow iface
+ **********************************************************************/
+wb_shadow_iface::sptr wb_shadow_iface::make(wb_iface::sptr iface){
+    return sptr(new wb_shadow_iface_impl(iface));
+}
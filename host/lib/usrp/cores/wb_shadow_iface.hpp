@@ -0,0 +1,95 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_WB_SHADOW_IFACE_HPP
+#define INCLUDED_LIBUHD_USRP_WB_SHADOW_IFACE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/utils/safe_call.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include "wb_iface.hpp"
+
+/*!
+ * The shadow iface wraps another wb_iface:
+ *  - Writes to shadowed registers that do not change the value are skipped.
+ *    Only registers that hold state should be shadowed, not strobes or latches.
+ *  - Pokes between begin_burst() and end_burst() are queued
+ *    and sent to the wrapped iface as one batch.
+ *  - Reads are never cached, and they send the queued pokes first.
+ */
+class wb_shadow_iface : public wb_iface{
+public:
+    typedef boost::shared_ptr<wb_shadow_iface> sptr;
+
+    struct stats_type{
+        size_t num_pokes;        //pokes requested by the caller
+        size_t num_redundant;    //pokes skipped by the shadow
+        size_t num_transactions; //poke calls made on the wrapped iface
+    };
+
+    //! makes a new shadow iface that wraps iface
+    static sptr make(wb_iface::sptr iface);
+
+    //! Shadow the registers from first to last (inclusive)
+    virtual void set_shadowed(wb_addr_type first, wb_addr_type last) = 0;
+
+    //! Forget the shadowed values, ex: after a reset of the hardware
+    virtual void clear_shadow(void) = 0;
+
+    //! Queue pokes until the matching end_burst() (may be nested)
+    virtual void begin_burst(void) = 0;
+
+    //! Send the queued pokes when the outermost burst ends
+    virtual void end_burst(void) = 0;
+
+    //! Get the counts of pokes since the iface was made
+    virtual stats_type get_stats(void) = 0;
+
+    /*!
+     * A burst for the life of a scope, used like a scoped lock:
+     * The burst begins on construction and ends on destruction,
+     * so an exception that leaves the scope cannot leave it open.
+     * Call end() to send the pokes with errors thrown to the caller;
+     * the destructor only logs the errors of the send.
+     */
+    class scoped_burst : boost::noncopyable{
+    public:
+        scoped_burst(wb_shadow_iface::sptr iface): _iface(iface), _open(true){
+            _iface->begin_burst();
+        }
+
+        ~scoped_burst(void){
+            if (_open) UHD_SAFE_CALL(this->end();)
+        }
+
+        //! End the burst now and send the queued pokes
+        void end(void){
+            if (not _open) return;
+            _open = false;
+            _iface->end_burst();
+        }
+
+    private:
+        wb_shadow_iface::sptr _iface;
+        bool _open;
+    };
+
+};
+
+#endif /* INCLUDED_LIBUHD_USRP_WB_SHADOW_IFACE_HPP */
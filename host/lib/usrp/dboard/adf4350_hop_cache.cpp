@@ -0,0 +1,169 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "adf4350_hop_cache.hpp"
+#include <uhd/types/time_spec.hpp>
+#include <uhd/utils/log.hpp>
+#include <boost/format.hpp>
+#include <map>
+
+using namespace uhd;
+
+static const size_t NUM_REGS = 6;
+
+adf4350_hop_cache::timing_type::timing_type(void):
+    compute_time(0.0), write_time(0.0), num_writes(0), precomputed(false)
+{
+    /* NOP */
+}
+
+/***********************************************************************
+ * Hop cache implementation
+ **********************************************************************/
+class adf4350_hop_cache_impl : public adf4350_hop_cache{
+public:
+    adf4350_hop_cache_impl(
+        const compute_fcn_type &compute,
+        const write_fcn_type &write,
+        const rate_fcn_type &rate,
+        const std::string &name
+    ):
+        _compute(compute), _write(write), _rate(rate), _name(name),
+        _hop_table_rate(0.0), _written_valid(false)
+    {
+        /* NOP */
+    }
+
+    double tune(double target_freq){
+        const time_spec_t t0 = time_spec_t::get_system_time();
+
+        //the table holds registers for one reference clock rate
+        const double rate = _rate();
+        if (rate != _hop_table_rate and not _hop_table.empty()){
+            UHD_LOGV(often) << boost::format(
+                "%s reference clock changed to %f MHz, recomputing the hop table"
+            ) % _name % (rate/1e6) << std::endl;
+            this->set_hop_freqs(this->get_hop_freqs());
+        }
+
+        //get the register words from the table or compute them
+        entry_type entry;
+        const hop_table_type::const_iterator it = _hop_table.find(target_freq);
+        _timing.precomputed = it != _hop_table.end();
+        if (_timing.precomputed) entry = it->second;
+        else entry = this->compute_entry(target_freq);
+
+        const time_spec_t t1 = time_spec_t::get_system_time();
+
+        //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
+        //only the changed registers are written, but 0 latches the new frequency
+        _timing.num_writes = 0;
+        try{
+            for (int addr = NUM_REGS-1; addr >= 0; addr--){
+                if (addr != 0 and _written_valid and _written[addr] == entry.words[addr]) continue;
+                UHD_LOGV(often) << boost::format(
+                    "%s SPI Reg (0x%02x): 0x%08x"
+                ) % _name % addr % entry.words[addr] << std::endl;
+                _write(entry.words[addr]);
+                _written[addr] = entry.words[addr];
+                _timing.num_writes++;
+            }
+        }
+        catch(...){
+            //the synthesizer state is unknown after a failed write
+            _written_valid = false;
+            throw;
+        }
+        _written_valid = true;
+
+        const time_spec_t t2 = time_spec_t::get_system_time();
+        _timing.compute_time = (t1 - t0).get_real_secs();
+        _timing.write_time = (t2 - t1).get_real_secs();
+
+        UHD_LOGV(often) << boost::format(
+            "%s tune timing: %s %f us, spi %f us for %u registers"
+        ) % _name % (_timing.precomputed? "lookup" : "compute")
+          % (_timing.compute_time*1e6) % (_timing.write_time*1e6) % _timing.num_writes << std::endl;
+
+        return entry.actual_freq;
+    }
+
+    void set_hop_freqs(const std::vector<double> &freqs){
+        const double rate = _rate();
+        hop_table_type hop_table;
+        for (size_t i = 0; i < freqs.size(); i++){
+            hop_table[freqs[i]] = this->compute_entry(freqs[i]);
+        }
+        _hop_table.swap(hop_table);
+        _hop_table_rate = rate;
+    }
+
+    std::vector<double> get_hop_freqs(void){
+        std::vector<double> freqs;
+        for (hop_table_type::const_iterator it = _hop_table.begin(); it != _hop_table.end(); it++){
+            freqs.push_back(it->first);
+        }
+        return freqs;
+    }
+
+    void invalidate(void){
+        _written_valid = false;
+    }
+
+    timing_type get_timing(void){
+        return _timing;
+    }
+
+private:
+    struct entry_type{
+        boost::uint32_t words[NUM_REGS];
+        double actual_freq;
+    };
+    typedef std::map<double, entry_type> hop_table_type;
+
+    entry_type compute_entry(double target_freq){
+        adf4350_regs_t regs;
+        entry_type entry;
+        entry.actual_freq = _compute(target_freq, regs);
+        for (size_t addr = 0; addr < NUM_REGS; addr++){
+            entry.words[addr] = regs.get_reg(boost::uint8_t(addr));
+        }
+        return entry;
+    }
+
+    const compute_fcn_type _compute;
+    const write_fcn_type _write;
+    const rate_fcn_type _rate;
+    const std::string _name;
+    hop_table_type _hop_table;
+    double _hop_table_rate; //the reference clock rate of the table
+    boost::uint32_t _written[NUM_REGS];
+    bool _written_valid;
+    timing_type _timing;
+};
+
+/***********************************************************************
+ * Hop cache factory function
+ **********************************************************************/
+adf4350_hop_cache::sptr adf4350_hop_cache::make(
+    const compute_fcn_type &compute,
+    const write_fcn_type &write,
+    const rate_fcn_type &rate,
+    const std::string &name
+){
+    return sptr(new adf4350_hop_cache_impl(compute, write, rate, name));
+}
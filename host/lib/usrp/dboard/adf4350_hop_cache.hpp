@@ -0,0 +1,103 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_DBOARD_ADF4350_HOP_CACHE_HPP
+#define INCLUDED_LIBUHD_USRP_DBOARD_ADF4350_HOP_CACHE_HPP
+
+#include "adf4350_regs.hpp"
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <string>
+#include <vector>
+
+/*!
+ * Tunes one ADF4350 synthesizer and keeps its register state:
+ * Registers that hold the same word as the last write are skipped,
+ * and the register sets for a list of hop frequencies can be computed
+ * ahead of time so that hopping to one of them is only spi writes.
+ */
+class adf4350_hop_cache : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<adf4350_hop_cache> sptr;
+
+    //! Fill in the registers for a target frequency, return the actual frequency
+    typedef boost::function<double(double, adf4350_regs_t &)> compute_fcn_type;
+
+    //! Write one 32 bit register word to the synthesizer
+    typedef boost::function<void(boost::uint32_t)> write_fcn_type;
+
+    //! Get the reference clock rate that the registers are computed for
+    typedef boost::function<double(void)> rate_fcn_type;
+
+    //! Where the time of the last tune went
+    struct timing_type{
+        timing_type(void);
+        double compute_time; //seconds spent computing or looking up the registers
+        double write_time; //seconds spent writing the registers
+        size_t num_writes; //number of registers written
+        bool precomputed; //true when the registers came from the hop table
+    };
+
+    /*!
+     * Make a new synthesizer cache.
+     * \param compute the register computation of the dboard
+     * \param write the spi write for this synthesizer
+     * \param rate the reference clock rate of this synthesizer
+     * \param name a name for the log messages
+     * \return a new cache object
+     */
+    static sptr make(
+        const compute_fcn_type &compute,
+        const write_fcn_type &write,
+        const rate_fcn_type &rate,
+        const std::string &name
+    );
+
+    virtual ~adf4350_hop_cache(void){};
+
+    /*!
+     * Tune the synthesizer.
+     * The registers come from the hop table when the target is in it.
+     * Registers 5 through 1 are written only when they changed,
+     * register 0 is always written last since it starts the relock.
+     * \param target_freq the desired frequency in Hz
+     * \return the actual frequency in Hz
+     */
+    virtual double tune(double target_freq) = 0;
+
+    /*!
+     * Compute and keep the registers for a list of frequencies.
+     * This replaces the previous table, an empty list clears it.
+     * A tune to exactly one of these frequencies skips the computation.
+     * The table is recomputed when the reference clock rate changes.
+     * \param freqs the hop frequencies in Hz
+     */
+    virtual void set_hop_freqs(const std::vector<double> &freqs) = 0;
+
+    //! Get the frequencies in the hop table
+    virtual std::vector<double> get_hop_freqs(void) = 0;
+
+    //! Forget the written registers (ex: the synthesizer lost power)
+    virtual void invalidate(void) = 0;
+
+    //! Get the timing of the last tune
+    virtual timing_type get_timing(void) = 0;
+};
+
+#endif /* INCLUDED_LIBUHD_USRP_DBOARD_ADF4350_HOP_CACHE_HPP */
@@ -73,6 +73,7 @@
 #define ANT_XX          LNASW                   //dont care how the antenna is set
 
 #include "adf4350_regs.hpp"
+#include "adf4350_hop_cache.hpp"
 #include <uhd/types/dict.hpp>
 #include <uhd/types/ranges.hpp>
 #include <uhd/types/sensors.hpp>
@@ -85,6 +86,7 @@
 #include <uhd/usrp/dboard_manager.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/format.hpp>
+#include <boost/bind.hpp>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/thread.hpp>
 
@@ -113,6 +115,8 @@ static const prop_names_t sbx_tx_antennas = list_of("TX/RX");
 
 static const prop_names_t sbx_rx_antennas = list_of("TX/RX")("RX2");
 
+static const prop_names_t sbx_sensor_names = list_of("lo_locked")("lo_compute_time")("lo_write_time")("lo_writes");
+
 static const uhd::dict<std::string, gain_range_t> sbx_tx_gain_ranges = map_list_of
     ("PGA0", gain_range_t(0, 31.5, double(0.5)))
 ;
@@ -139,6 +143,7 @@ private:
     uhd::dict<std::string, double> _tx_gains, _rx_gains;
     double       _rx_lo_freq, _tx_lo_freq;
     std::string  _tx_ant, _rx_ant;
+    uhd::dict<dboard_iface::unit_t, adf4350_hop_cache::sptr> _lo_hop;
 
     void set_rx_lo_freq(double freq);
     void set_tx_lo_freq(double freq);
@@ -157,6 +162,32 @@ private:
      */
     double set_lo_freq(dboard_iface::unit_t unit, double target_freq);
 
+    /*!
+     * Compute the LO registers for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param target_freq the desired frequency in Hz
+     * \param regs the registers to fill in
+     * \return the actual frequency in Hz
+     */
+    double compute_lo_regs(dboard_iface::unit_t unit, double target_freq, adf4350_regs_t &regs);
+
+    /*!
+     * Write one LO register for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param reg the 32 bit register word
+     */
+    void write_lo_reg(dboard_iface::unit_t unit, boost::uint32_t reg){
+        this->get_iface()->write_spi(unit, spi_config_t::EDGE_RISE, reg, 32);
+    }
+
+    /*!
+     * Get the LO tuning time sensor for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param name the name of the timing sensor
+     * \return the sensor value
+     */
+    sensor_value_t get_lo_timing(dboard_iface::unit_t unit, const std::string &name);
+
     /*!
      * Get the lock detect status of the LO.
      * \param unit which unit rx or tx
@@ -271,6 +302,20 @@ sbx_xcvr::sbx_xcvr(ctor_args_t args) : xcvr_dboard_base(args){
         "SBX GPIO Direction: RX: 0x%08x, TX: 0x%08x"
     ) % RXIO_MASK % TXIO_MASK << std::endl;
 
+    //the synthesizers, tuned through a cache of their registers
+    _lo_hop[dboard_iface::UNIT_RX] = adf4350_hop_cache::make(
+        boost::bind(&sbx_xcvr::compute_lo_regs, this, dboard_iface::UNIT_RX, _1, _2),
+        boost::bind(&sbx_xcvr::write_lo_reg, this, dboard_iface::UNIT_RX, _1),
+        boost::bind(&dboard_iface::get_clock_rate, this->get_iface(), dboard_iface::UNIT_RX),
+        "SBX RX"
+    );
+    _lo_hop[dboard_iface::UNIT_TX] = adf4350_hop_cache::make(
+        boost::bind(&sbx_xcvr::compute_lo_regs, this, dboard_iface::UNIT_TX, _1, _2),
+        boost::bind(&sbx_xcvr::write_lo_reg, this, dboard_iface::UNIT_TX, _1),
+        boost::bind(&dboard_iface::get_clock_rate, this->get_iface(), dboard_iface::UNIT_TX),
+        "SBX TX"
+    );
+
     //set some default values
     set_rx_lo_freq((sbx_freq_range.start() + sbx_freq_range.stop())/2.0);
     set_tx_lo_freq((sbx_freq_range.start() + sbx_freq_range.stop())/2.0);
@@ -432,6 +477,25 @@ void sbx_xcvr::set_tx_lo_freq(double freq){
 double sbx_xcvr::set_lo_freq(
     dboard_iface::unit_t unit,
     double target_freq
+){
+    return _lo_hop[unit]->tune(target_freq);
+}
+
+sensor_value_t sbx_xcvr::get_lo_timing(
+    dboard_iface::unit_t unit,
+    const std::string &name
+){
+    const adf4350_hop_cache::timing_type timing = _lo_hop[unit]->get_timing();
+    if (name == "lo_compute_time") return sensor_value_t("LO compute", timing.compute_time*1e6, "us");
+    if (name == "lo_write_time") return sensor_value_t("LO write", timing.write_time*1e6, "us");
+    if (name == "lo_writes") return sensor_value_t("LO writes", int(timing.num_writes), "registers");
+    throw uhd::key_error("SBX: unknown sensor " + name);
+}
+
+double sbx_xcvr::compute_lo_regs(
+    dboard_iface::unit_t unit,
+    double target_freq,
+    adf4350_regs_t &regs
 ){
     UHD_LOGV(often) << boost::format(
         "SBX tune: target frequency %f Mhz"
@@ -537,8 +601,6 @@ double sbx_xcvr::set_lo_freq(
             ) % (target_freq/1e6) % (actual_freq/1e6) % (vco_freq/1e6) % (pfd_freq/1e6) % (pfd_freq/BS/1e6) << std::endl;
 
     //load the register values
-    adf4350_regs_t regs;
-
     if ((unit == dboard_iface::UNIT_TX) and (actual_freq == sbx_tx_lo_2dbm.clip(actual_freq))) 
         regs.output_power = adf4350_regs_t::OUTPUT_POWER_2DBM;
     else
@@ -555,20 +617,6 @@ double sbx_xcvr::set_lo_freq(
     UHD_ASSERT_THROW(rfdivsel_to_enum.has_key(RFdiv));
     regs.rf_divider_select = rfdivsel_to_enum[RFdiv];
 
-    //write the registers
-    //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
-    int addr;
-
-    for(addr=5; addr>=0; addr--){
-        UHD_LOGV(often) << boost::format(
-            "SBX SPI Reg (0x%02x): 0x%08x"
-        ) % addr % regs.get_reg(addr) << std::endl;
-        this->get_iface()->write_spi(
-            unit, spi_config_t::EDGE_RISE,
-            regs.get_reg(addr), 32
-        );
-    }
-
     //return the actual frequency
     UHD_LOGV(often) << boost::format(
         "SBX tune: actual frequency %f Mhz"
@@ -635,12 +683,18 @@ void sbx_xcvr::rx_get(const wax::obj &key_, wax::obj &val){
         return;
 
     case SUBDEV_PROP_SENSOR:
-        UHD_ASSERT_THROW(key.name == "lo_locked");
-        val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_RX), "locked", "unlocked");
+        if (key.name == "lo_locked")
+            val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_RX), "locked", "unlocked");
+        else
+            val = this->get_lo_timing(dboard_iface::UNIT_RX, key.name);
         return;
 
     case SUBDEV_PROP_SENSOR_NAMES:
-        val = prop_names_t(1, "lo_locked");
+        val = sbx_sensor_names;
+        return;
+
+    case SUBDEV_PROP_HOP_FREQS:
+        val = _lo_hop[dboard_iface::UNIT_RX]->get_hop_freqs();
         return;
 
     case SUBDEV_PROP_BANDWIDTH:
@@ -661,6 +715,10 @@ void sbx_xcvr::rx_set(const wax::obj &key_, const wax::obj &val){
         this->set_rx_lo_freq(val.as<double>());
         return;
 
+    case SUBDEV_PROP_HOP_FREQS:
+        _lo_hop[dboard_iface::UNIT_RX]->set_hop_freqs(val.as<std::vector<double> >());
+        return;
+
     case SUBDEV_PROP_GAIN:
         this->set_rx_gain(val.as<double>(), key.name);
         return;
@@ -739,12 +797,18 @@ void sbx_xcvr::tx_get(const wax::obj &key_, wax::obj &val){
         return;
 
     case SUBDEV_PROP_SENSOR:
-        UHD_ASSERT_THROW(key.name == "lo_locked");
-        val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_TX), "locked", "unlocked");
+        if (key.name == "lo_locked")
+            val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_TX), "locked", "unlocked");
+        else
+            val = this->get_lo_timing(dboard_iface::UNIT_TX, key.name);
         return;
 
     case SUBDEV_PROP_SENSOR_NAMES:
-        val = prop_names_t(1, "lo_locked");
+        val = sbx_sensor_names;
+        return;
+
+    case SUBDEV_PROP_HOP_FREQS:
+        val = _lo_hop[dboard_iface::UNIT_TX]->get_hop_freqs();
         return;
 
     case SUBDEV_PROP_BANDWIDTH:
@@ -765,6 +829,10 @@ void sbx_xcvr::tx_set(const wax::obj &key_, const wax::obj &val){
         this->set_tx_lo_freq(val.as<double>());
         return;
 
+    case SUBDEV_PROP_HOP_FREQS:
+        _lo_hop[dboard_iface::UNIT_TX]->set_hop_freqs(val.as<std::vector<double> >());
+        return;
+
     case SUBDEV_PROP_GAIN:
         this->set_tx_gain(val.as<double>(), key.name);
         return;
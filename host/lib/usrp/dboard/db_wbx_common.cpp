@@ -69,6 +69,7 @@
 #include <uhd/usrp/dboard_base.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/format.hpp>
+#include <boost/bind.hpp>
 #include <boost/math/special_functions/round.hpp>
 
 using namespace uhd;
@@ -90,6 +91,8 @@ static const uhd::dict<std::string, gain_range_t> wbx_rx_gain_ranges = map_list_
     ("PGA0", gain_range_t(0, 31.5, 0.5))
 ;
 
+static const prop_names_t wbx_sensor_names = list_of("lo_locked")("lo_compute_time")("lo_write_time")("lo_writes");
+
 /***********************************************************************
  * WBX Common Implementation
  **********************************************************************/
@@ -120,6 +123,20 @@ wbx_base::wbx_base(ctor_args_t args) : xcvr_dboard_base(args){
     this->get_iface()->set_atr_reg(dboard_iface::UNIT_RX, dboard_iface::ATR_REG_RX_ONLY,     RX_MIXER_ENB, RX_MIXER_DIS | RX_MIXER_ENB);
     this->get_iface()->set_atr_reg(dboard_iface::UNIT_RX, dboard_iface::ATR_REG_FULL_DUPLEX, RX_MIXER_ENB, RX_MIXER_DIS | RX_MIXER_ENB);
 
+    //the synthesizers, tuned through a cache of their registers
+    _lo_hop[dboard_iface::UNIT_RX] = adf4350_hop_cache::make(
+        boost::bind(&wbx_base::compute_lo_regs, this, dboard_iface::UNIT_RX, _1, _2),
+        boost::bind(&wbx_base::write_lo_reg, this, dboard_iface::UNIT_RX, _1),
+        boost::bind(&dboard_iface::get_clock_rate, this->get_iface(), dboard_iface::UNIT_RX),
+        "WBX RX"
+    );
+    _lo_hop[dboard_iface::UNIT_TX] = adf4350_hop_cache::make(
+        boost::bind(&wbx_base::compute_lo_regs, this, dboard_iface::UNIT_TX, _1, _2),
+        boost::bind(&wbx_base::write_lo_reg, this, dboard_iface::UNIT_TX, _1),
+        boost::bind(&dboard_iface::get_clock_rate, this->get_iface(), dboard_iface::UNIT_TX),
+        "WBX TX"
+    );
+
     //set some default values
     if (is_v3()) {
         BOOST_FOREACH(const std::string &name, wbx_v3_tx_gain_ranges.keys()){
@@ -150,12 +167,16 @@ void wbx_base::set_rx_enabled(bool enb){
     this->get_iface()->set_gpio_out(dboard_iface::UNIT_RX,
         (enb)? RX_POWER_UP : RX_POWER_DOWN, RX_POWER_UP | RX_POWER_DOWN
     );
+    //the synthesizer may lose its registers while powered down
+    _lo_hop[dboard_iface::UNIT_RX]->invalidate();
 }
 
 void wbx_base::set_tx_enabled(bool enb){
     this->get_iface()->set_gpio_out(dboard_iface::UNIT_TX,
         (enb)? TX_POWER_UP | ADF4350_CE : TX_POWER_DOWN, TX_POWER_UP | TX_POWER_DOWN | (is_v3() ? 0 : ADF4350_CE)
     );
+    //the synthesizer may lose its registers while powered down
+    _lo_hop[dboard_iface::UNIT_TX]->invalidate();
 }
 
 /***********************************************************************
@@ -275,6 +296,29 @@ void wbx_base::set_rx_gain(double gain, const std::string &name){
 double wbx_base::set_lo_freq(
     dboard_iface::unit_t unit,
     double target_freq
+){
+    return _lo_hop[unit]->tune(target_freq);
+}
+
+void wbx_base::write_lo_reg(dboard_iface::unit_t unit, boost::uint32_t reg){
+    this->get_iface()->write_spi(unit, spi_config_t::EDGE_RISE, reg, 32);
+}
+
+sensor_value_t wbx_base::get_lo_timing(
+    dboard_iface::unit_t unit,
+    const std::string &name
+){
+    const adf4350_hop_cache::timing_type timing = _lo_hop[unit]->get_timing();
+    if (name == "lo_compute_time") return sensor_value_t("LO compute", timing.compute_time*1e6, "us");
+    if (name == "lo_write_time") return sensor_value_t("LO write", timing.write_time*1e6, "us");
+    if (name == "lo_writes") return sensor_value_t("LO writes", int(timing.num_writes), "registers");
+    throw uhd::key_error("WBX: unknown sensor " + name);
+}
+
+double wbx_base::compute_lo_regs(
+    dboard_iface::unit_t unit,
+    double target_freq,
+    adf4350_regs_t &regs
 ){
     UHD_LOGV(often) << boost::format(
         "WBX tune: target frequency %f Mhz"
@@ -379,8 +423,6 @@ double wbx_base::set_lo_freq(
             ) % (target_freq/1e6) % (actual_freq/1e6) % (vco_freq/1e6) % (pfd_freq/1e6) % (pfd_freq/BS/1e6) << std::endl;
 
     //load the register values
-    adf4350_regs_t regs;
-
     regs.frac_12_bit = FRAC;
     regs.int_16_bit = N;
     regs.mod_12_bit = MOD;
@@ -421,20 +463,6 @@ double wbx_base::set_lo_freq(
 
     }
 
-    //write the registers
-    //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
-    int addr;
-
-    for(addr=5; addr>=0; addr--){
-        UHD_LOGV(often) << boost::format(
-            "WBX SPI Reg (0x%02x): 0x%08x"
-        ) % addr % regs.get_reg(addr) << std::endl;
-        this->get_iface()->write_spi(
-            unit, spi_config_t::EDGE_RISE,
-            regs.get_reg(addr), 32
-        );
-    }
-
     //return the actual frequency
     UHD_LOGV(often) << boost::format(
         "WBX tune: actual frequency %f Mhz"
@@ -509,12 +537,18 @@ void wbx_base::rx_get(const wax::obj &key_, wax::obj &val){
         return;
 
     case SUBDEV_PROP_SENSOR:
-        UHD_ASSERT_THROW(key.name == "lo_locked");
-        val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_RX), "locked", "unlocked");
+        if (key.name == "lo_locked")
+            val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_RX), "locked", "unlocked");
+        else
+            val = this->get_lo_timing(dboard_iface::UNIT_RX, key.name);
         return;
 
     case SUBDEV_PROP_SENSOR_NAMES:
-        val = prop_names_t(1, "lo_locked");
+        val = wbx_sensor_names;
+        return;
+
+    case SUBDEV_PROP_HOP_FREQS:
+        val = _lo_hop[dboard_iface::UNIT_RX]->get_hop_freqs();
         return;
 
     case SUBDEV_PROP_BANDWIDTH:
@@ -540,6 +574,10 @@ void wbx_base::rx_set(const wax::obj &key_, const wax::obj &val){
         this->set_rx_enabled(_rx_enabled);
         return;
 
+    case SUBDEV_PROP_HOP_FREQS:
+        _lo_hop[dboard_iface::UNIT_RX]->set_hop_freqs(val.as<std::vector<double> >());
+        return;
+
     case SUBDEV_PROP_BANDWIDTH:
         UHD_MSG(warning) << "WBX: No tunable bandwidth, fixed filtered to 40MHz";
         return;
@@ -616,12 +654,18 @@ void wbx_base::tx_get(const wax::obj &key_, wax::obj &val){
         return;
 
     case SUBDEV_PROP_SENSOR:
-        UHD_ASSERT_THROW(key.name == "lo_locked");
-        val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_TX), "locked", "unlocked");
+        if (key.name == "lo_locked")
+            val = sensor_value_t("LO", this->get_locked(dboard_iface::UNIT_TX), "locked", "unlocked");
+        else
+            val = this->get_lo_timing(dboard_iface::UNIT_TX, key.name);
         return;
 
     case SUBDEV_PROP_SENSOR_NAMES:
-        val = prop_names_t(1, "lo_locked");
+        val = wbx_sensor_names;
+        return;
+
+    case SUBDEV_PROP_HOP_FREQS:
+        val = _lo_hop[dboard_iface::UNIT_TX]->get_hop_freqs();
         return;
 
     case SUBDEV_PROP_BANDWIDTH:
@@ -647,6 +691,10 @@ void wbx_base::tx_set(const wax::obj &key_, const wax::obj &val){
         this->set_tx_enabled(_tx_enabled);
         return;
 
+    case SUBDEV_PROP_HOP_FREQS:
+        _lo_hop[dboard_iface::UNIT_TX]->set_hop_freqs(val.as<std::vector<double> >());
+        return;
+
     case SUBDEV_PROP_BANDWIDTH:
         UHD_MSG(warning) << "WBX: No tunable bandwidth, fixed filtered to 40MHz";
         return;
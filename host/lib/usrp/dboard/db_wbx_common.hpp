@@ -19,8 +19,10 @@
 #define INCLUDED_LIBUHD_USRP_DBOARD_DB_WBX_COMMON_HPP
 
 #include "adf4350_regs.hpp"
+#include "adf4350_hop_cache.hpp"
 #include <uhd/types/dict.hpp>
 #include <uhd/types/ranges.hpp>
+#include <uhd/types/sensors.hpp>
 #include <uhd/utils/props.hpp>
 #include <uhd/usrp/dboard_base.hpp>
 
@@ -55,6 +57,30 @@ protected:
      */
     virtual double set_lo_freq(dboard_iface::unit_t unit, double target_freq);
 
+    /*!
+     * Compute the LO registers for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param target_freq the desired frequency in Hz
+     * \param regs the registers to fill in
+     * \return the actual frequency in Hz
+     */
+    double compute_lo_regs(dboard_iface::unit_t unit, double target_freq, adf4350_regs_t &regs);
+
+    /*!
+     * Write one LO register for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param reg the 32 bit register word
+     */
+    void write_lo_reg(dboard_iface::unit_t unit, boost::uint32_t reg);
+
+    /*!
+     * Get the LO tuning time sensor for the particular dboard unit.
+     * \param unit which unit rx or tx
+     * \param name the name of the timing sensor
+     * \return the sensor value
+     */
+    sensor_value_t get_lo_timing(dboard_iface::unit_t unit, const std::string &name);
+
     /*!
      * Get the lock detect status of the LO.
      * \param unit which unit rx or tx
@@ -71,6 +97,7 @@ protected:
 private:
     uhd::dict<std::string, double> _tx_gains, _rx_gains;
     bool _rx_enabled, _tx_enabled;
+    uhd::dict<dboard_iface::unit_t, adf4350_hop_cache::sptr> _lo_hop;
 };
 
 }} //namespace uhd::usrp
@@ -434,6 +434,10 @@ static double get_freq(wax::obj subdev){
     return subdev[SUBDEV_PROP_FREQ].as<double>();
 }
 
+static void set_hop_freqs(wax::obj subdev, const std::vector<double> &freqs){
+    subdev[SUBDEV_PROP_HOP_FREQS] = freqs;
+}
+
 static meta_range_t get_freq_range(wax::obj subdev){
     return subdev[SUBDEV_PROP_FREQ_RANGE].as<meta_range_t>();
 }
@@ -506,6 +510,9 @@ void dboard_manager::populate_prop_tree_from_subdev(
     subtree->create<meta_range_t>("freq/range")
         .publish(boost::bind(&get_freq_range, subdev));
 
+    subtree->create<std::vector<double> >("freq/hop_freqs")
+        .subscribe(boost::bind(&set_hop_freqs, subdev, _1));
+
     subtree->create<std::string>("antenna/value")
         .publish(boost::bind(&get_ant, subdev))
         .subscribe(boost::bind(&set_ant, subdev, _1));
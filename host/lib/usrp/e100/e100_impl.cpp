@@ -188,7 +188,7 @@ e100_impl::e100_impl(const uhd::device_addr_t &device_addr){
     ////////////////////////////////////////////////////////////////////
     _fpga_i2c_ctrl = i2c_core_100::make(_fpga_ctrl, E100_REG_SLAVE(3));
     _fpga_spi_ctrl = spi_core_100::make(_fpga_ctrl, E100_REG_SLAVE(2));
-    _data_transport = e100_make_mmap_zero_copy(_fpga_ctrl);
+    _data_transport = e100_mmap_zero_copy::make(e100_mmap_ring::make(_fpga_ctrl), device_addr);
 
     ////////////////////////////////////////////////////////////////////
     // Initialize the properties tree
@@ -16,6 +16,7 @@
 //
 
 #include "e100_ctrl.hpp"
+#include "e100_mmap_zero_copy.hpp"
 #include "clock_ctrl.hpp"
 #include "codec_ctrl.hpp"
 #include "spi_core_100.hpp"
@@ -42,8 +43,6 @@
 #ifndef INCLUDED_E100_IMPL_HPP
 #define INCLUDED_E100_IMPL_HPP
 
-uhd::transport::zero_copy_if::sptr e100_make_mmap_zero_copy(e100_ctrl::sptr iface);
-
 // = gpmc_clock_rate/clk_div/cycles_per_transaction*bytes_per_transaction
 static const double          E100_RX_LINK_RATE_BPS = 166e6/3/2*2;
 static const double          E100_TX_LINK_RATE_BPS = 166e6/3/1*2;
@@ -80,6 +79,8 @@ public:
     //the io interface
     size_t send(const send_buffs_type &, size_t, const uhd::tx_metadata_t &, const uhd::io_type_t &, send_mode_t, double);
     size_t recv(const recv_buffs_type &, size_t, uhd::rx_metadata_t &, const uhd::io_type_t &, recv_mode_t, double);
+    recv_lease_type borrow_recv(recv_views_type &, uhd::rx_metadata_t &, double);
+    send_commit_type borrow_send(send_views_type &, const uhd::tx_metadata_t &, double);
     bool recv_async_msg(uhd::async_metadata_t &, double);
     size_t get_max_send_samps_per_packet(void) const;
     size_t get_max_recv_samps_per_packet(void) const;
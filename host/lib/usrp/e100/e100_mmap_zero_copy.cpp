@@ -15,11 +15,11 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include "e100_ctrl.hpp"
-#include <uhd/transport/zero_copy.hpp>
+#include "e100_mmap_zero_copy.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/exception.hpp>
-#include <linux/usrp_e.h>
+#include <boost/thread/thread_time.hpp>
+#include <algorithm> //min
 #include <sys/mman.h> //mmap
 #include <unistd.h> //getpagesize
 #include <poll.h> //poll
@@ -30,10 +30,93 @@ using namespace uhd::transport;
 
 #define fp_verbose false //fast-path verbose
 static const size_t poll_breakout = 10; //how many poll timeouts constitute a full timeout
+static const size_t spins_per_clock = 64; //how many flag checks between reads of the clock
+
+/***********************************************************************
+ * The mapped ring of the usrp_e driver:
+ *  - The memory is mapped from the device file descriptor.
+ *  - Waiting is a poll on the descriptor, notify is a zero-length write.
+ **********************************************************************/
+class e100_mmap_ring_impl : public e100_mmap_ring{
+public:
+    e100_mmap_ring_impl(e100_ctrl::sptr iface):
+        _fd(iface->get_file_descriptor())
+    {
+        //get system sizes
+        iface->ioctl(USRP_E_GET_RB_INFO, &_rb_size);
+        _page_size = getpagesize();
+        const size_t frame_size = _page_size/2;
+
+        //calculate the memory size
+        _map_size =
+            (_rb_size.num_pages_rx_flags + _rb_size.num_pages_tx_flags) * _page_size +
+            (_rb_size.num_rx_frames + _rb_size.num_tx_frames) * frame_size;
+
+        //print sizes summary
+        UHD_LOG
+            << "page_size:          " << _page_size                  << std::endl
+            << "frame_size:         " << frame_size                  << std::endl
+            << "num_pages_rx_flags: " << _rb_size.num_pages_rx_flags << std::endl
+            << "num_rx_frames:      " << _rb_size.num_rx_frames      << std::endl
+            << "num_pages_tx_flags: " << _rb_size.num_pages_tx_flags << std::endl
+            << "num_tx_frames:      " << _rb_size.num_tx_frames      << std::endl
+            << "map_size:           " << _map_size                   << std::endl
+        ;
+
+        //call mmap to get the memory
+        _mapped_mem = ::mmap(
+            NULL, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0
+        );
+        UHD_ASSERT_THROW(_mapped_mem != MAP_FAILED);
+    }
+
+    ~e100_mmap_ring_impl(void){
+        UHD_LOG << "cleanup: munmap" << std::endl;
+        ::munmap(_mapped_mem, _map_size);
+    }
+
+    const usrp_e_ring_buffer_size_t &get_rb_size(void) const{
+        return _rb_size;
+    }
+
+    size_t get_page_size(void) const{
+        return _page_size;
+    }
+
+    char *get_mem(void) const{
+        return reinterpret_cast<char *>(_mapped_mem);
+    }
+
+    bool wait(short events, double timeout){
+        pollfd pfd;
+        pfd.fd = _fd;
+        pfd.events = events;
+        ssize_t poll_ret = ::poll(&pfd, 1, size_t(timeout*1e3));
+        if (fp_verbose) UHD_LOGV(always) << "  poll " << events << ": " << poll_ret << std::endl;
+        return poll_ret > 0;
+    }
+
+    void notify(void){
+        if (::write(_fd, NULL, 0) < 0){ //notifies the kernel
+            UHD_LOGV(rarely) << UHD_THROW_SITE_INFO("write error") << std::endl;
+        }
+    }
+
+private:
+    int _fd;
+    usrp_e_ring_buffer_size_t _rb_size;
+    size_t _page_size, _map_size;
+    void *_mapped_mem;
+};
+
+e100_mmap_ring::sptr e100_mmap_ring::make(e100_ctrl::sptr iface){
+    return sptr(new e100_mmap_ring_impl(iface));
+}
 
 /***********************************************************************
  * Reusable managed receiver buffer:
  *  - The buffer knows how to claim and release a frame.
+ *  - The flags are volatile, the driver changes them under our feet.
  **********************************************************************/
 class e100_mmap_zero_copy_mrb : public managed_recv_buffer{
 public:
@@ -46,9 +129,9 @@ public:
         _info->flags = RB_KERNEL; //release the frame
     }
 
-    bool ready(void){return _info->flags & RB_USER;}
+    UHD_INLINE bool ready(void){return _info->flags & RB_USER;}
 
-    sptr get_new(void){
+    UHD_INLINE sptr get_new(void){
         if (fp_verbose) UHD_LOGV(always) << "  make_recv_buff: " << get_size() << std::endl;
         _info->flags = RB_USER_PROCESS; //claim the frame
         return make_managed_buffer(this);
@@ -59,32 +142,33 @@ private:
     size_t get_size(void) const{return _info->len;}
 
     void *_mem;
-    ring_buffer_info *_info;
+    volatile ring_buffer_info *_info;
 };
 
 /***********************************************************************
  * Reusable managed send buffer:
  *  - The buffer knows how to claim and release a frame.
+ *  - The buffer counts down the frames left in its batch,
+ *    and the last commit of the batch notifies the driver.
  **********************************************************************/
 class e100_mmap_zero_copy_msb : public managed_send_buffer{
 public:
-    e100_mmap_zero_copy_msb(void *mem, ring_buffer_info *info, size_t len, int fd):
-        _mem(mem), _info(info), _len(len), _fd(fd) { /* NOP */ }
+    e100_mmap_zero_copy_msb(void *mem, ring_buffer_info *info, size_t len, e100_mmap_ring *ring):
+        _mem(mem), _info(info), _len(len), _ring(ring), _batch(NULL) { /* NOP */ }
 
     void commit(size_t len){
         if (_info->flags != RB_USER_PROCESS) return;
         if (fp_verbose) UHD_LOGV(always) << "send buff: commit " << len << std::endl;
-        _info->len = len;
+        _info->len = len; //zero length: the ring stays in step, the frame holds no data
         _info->flags = RB_USER; //release the frame
-        if (::write(_fd, NULL, 0) < 0){ //notifies the kernel
-            UHD_LOGV(rarely) << UHD_THROW_SITE_INFO("write error") << std::endl;
-        }
+        if (--(*_batch) == 0) _ring->notify();
     }
 
-    bool ready(void){return _info->flags & RB_KERNEL;}
+    UHD_INLINE bool ready(void){return _info->flags & RB_KERNEL;}
 
-    sptr get_new(void){
+    UHD_INLINE sptr get_new(size_t *batch){
         if (fp_verbose) UHD_LOGV(always) << "  make_send_buff: " << get_size() << std::endl;
+        _batch = batch;
         _info->flags = RB_USER_PROCESS; //claim the frame
         return make_managed_buffer(this);
     }
@@ -94,45 +178,25 @@ private:
     size_t get_size(void) const{return _len;}
 
     void *_mem;
-    ring_buffer_info *_info;
+    volatile ring_buffer_info *_info;
     size_t _len;
-    int _fd;
+    e100_mmap_ring *_ring;
+    size_t *_batch;
 };
 
 /***********************************************************************
  * The zero copy interface implementation
  **********************************************************************/
-class e100_mmap_zero_copy_impl : public zero_copy_if{
+class e100_mmap_zero_copy_impl : public e100_mmap_zero_copy{
 public:
-    e100_mmap_zero_copy_impl(e100_ctrl::sptr iface):
-        _fd(iface->get_file_descriptor()), _recv_index(0), _send_index(0)
+    e100_mmap_zero_copy_impl(e100_mmap_ring::sptr ring, const device_addr_t &hints):
+        _ring(ring), _rb_size(ring->get_rb_size()),
+        _frame_size(ring->get_page_size()/2),
+        _busy_poll_time(hints.cast<double>("busy_poll_time", 0.0)),
+        _recv_index(0), _send_index(0)
     {
-        //get system sizes
-        iface->ioctl(USRP_E_GET_RB_INFO, &_rb_size);
-        size_t page_size = getpagesize();
-        _frame_size = page_size/2;
-
-        //calculate the memory size
-        _map_size =
-            (_rb_size.num_pages_rx_flags + _rb_size.num_pages_tx_flags) * page_size +
-            (_rb_size.num_rx_frames + _rb_size.num_tx_frames) * _frame_size;
-
-        //print sizes summary
-        UHD_LOG
-            << "page_size:          " << page_size                   << std::endl
-            << "frame_size:         " << _frame_size                 << std::endl
-            << "num_pages_rx_flags: " << _rb_size.num_pages_rx_flags << std::endl
-            << "num_rx_frames:      " << _rb_size.num_rx_frames      << std::endl
-            << "num_pages_tx_flags: " << _rb_size.num_pages_tx_flags << std::endl
-            << "num_tx_frames:      " << _rb_size.num_tx_frames      << std::endl
-            << "map_size:           " << _map_size                   << std::endl
-        ;
-
-        //call mmap to get the memory
-        _mapped_mem = ::mmap(
-            NULL, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0
-        );
-        UHD_ASSERT_THROW(_mapped_mem != MAP_FAILED);
+        const size_t page_size = ring->get_page_size();
+        if (_busy_poll_time > 0.0) UHD_LOG << "busy_poll_time:     " << _busy_poll_time << std::endl;
 
         //calculate the memory offsets for info and buffers
         size_t recv_info_off = 0;
@@ -154,7 +218,7 @@ public:
 
         //set the internal pointers for info and buffers
         typedef ring_buffer_info (*rbi_pta)[];
-        char *rb_ptr = reinterpret_cast<char *>(_mapped_mem);
+        char *rb_ptr = ring->get_mem();
         recv_info = reinterpret_cast<rbi_pta>(rb_ptr + recv_info_off);
         recv_buff = rb_ptr + recv_buff_off;
         send_info = reinterpret_cast<rbi_pta>(rb_ptr + send_info_off);
@@ -168,35 +232,26 @@ public:
         }
 
         //initialize the managed send buffers
-        for (size_t i = 0; i < get_num_recv_frames(); i++){
+        for (size_t i = 0; i < get_num_send_frames(); i++){
             _msb_pool.push_back(e100_mmap_zero_copy_msb(
                 send_buff + get_send_frame_size()*i, (*send_info) + i,
-                get_send_frame_size(), _fd
+                get_send_frame_size(), _ring.get()
             ));
         }
-    }
 
-    ~e100_mmap_zero_copy_impl(void){
-        UHD_LOG << "cleanup: munmap" << std::endl;
-        ::munmap(_mapped_mem, _map_size);
+        //one batch counter per send frame, indexed by the first frame of a batch;
+        //a first frame cannot be claimed again until its whole batch was sent
+        _send_batches.resize(get_num_send_frames(), 0);
     }
 
     managed_recv_buffer::sptr get_recv_buff(double timeout){
         if (fp_verbose) UHD_LOGV(always) << "get_recv_buff: " << _recv_index << std::endl;
         e100_mmap_zero_copy_mrb &mrb = _mrb_pool[_recv_index];
 
-        //poll/wait for a ready frame
-        if (not mrb.ready()){
-            for (size_t i = 0; i < poll_breakout; i++){
-                pollfd pfd;
-                pfd.fd = _fd;
-                pfd.events = POLLIN;
-                ssize_t poll_ret = ::poll(&pfd, 1, size_t(timeout*1e3/poll_breakout));
-                if (fp_verbose) UHD_LOGV(always) << "  POLLIN: " << poll_ret << std::endl;
-                if (poll_ret > 0) goto found_user_frame; //good poll, continue on
-            }
+        //spin/poll/wait for a ready frame
+        if (not wait_for_frame(mrb, POLLIN, timeout, poll_breakout)){
             return managed_recv_buffer::sptr(); //timed-out for real
-        } found_user_frame:
+        }
 
         //increment the index for the next call
         if (++_recv_index == get_num_recv_frames()) _recv_index = 0;
@@ -205,6 +260,21 @@ public:
         return mrb.get_new();
     }
 
+    size_t get_recv_buffs(std::vector<managed_recv_buffer::sptr> &buffs, size_t max, double timeout){
+        if (max == 0) return 0;
+        managed_recv_buffer::sptr buff = this->get_recv_buff(timeout);
+        if (buff.get() == NULL) return 0;
+        buffs.push_back(buff);
+
+        //claim the frames that follow while they are ready
+        size_t num_claimed = 1;
+        for (; num_claimed < max and _mrb_pool[_recv_index].ready(); num_claimed++){
+            buffs.push_back(_mrb_pool[_recv_index].get_new());
+            if (++_recv_index == get_num_recv_frames()) _recv_index = 0;
+        }
+        return num_claimed;
+    }
+
     size_t get_num_recv_frames(void) const{
         return _rb_size.num_rx_frames;
     }
@@ -217,21 +287,43 @@ public:
         if (fp_verbose) UHD_LOGV(always) << "get_send_buff: " << _send_index << std::endl;
         e100_mmap_zero_copy_msb &msb = _msb_pool[_send_index];
 
-        //poll/wait for a ready frame
-        if (not msb.ready()){
-            pollfd pfd;
-            pfd.fd = _fd;
-            pfd.events = POLLOUT;
-            ssize_t poll_ret = ::poll(&pfd, 1, size_t(timeout*1e3));
-            if (fp_verbose) UHD_LOGV(always) << "  POLLOUT: " << poll_ret << std::endl;
-            if (poll_ret <= 0) return managed_send_buffer::sptr();
+        //spin/poll/wait for a ready frame
+        if (not wait_for_frame(msb, POLLOUT, timeout, 1)){
+            return managed_send_buffer::sptr();
         }
 
+        //a batch of one notifies the driver on commit
+        size_t *batch = &_send_batches[_send_index];
+        *batch = 1;
+
         //increment the index for the next call
         if (++_send_index == get_num_send_frames()) _send_index = 0;
 
         //return the managed buffer for this frame
-        return msb.get_new();
+        return msb.get_new(batch);
+    }
+
+    size_t get_send_buffs(std::vector<managed_send_buffer::sptr> &buffs, size_t max, double timeout){
+        if (max == 0) return 0;
+        if (fp_verbose) UHD_LOGV(always) << "get_send_buffs: " << _send_index << std::endl;
+
+        //wait for the first frame of the batch
+        if (not wait_for_frame(_msb_pool[_send_index], POLLOUT, timeout, 1)) return 0;
+
+        //count the frames that are ready before claiming any of them,
+        //so the batch counter is complete before the first commit
+        size_t num_claimed = 1;
+        while (num_claimed < max and _msb_pool[(_send_index + num_claimed) % get_num_send_frames()].ready()){
+            num_claimed++;
+        }
+        size_t *batch = &_send_batches[_send_index];
+        *batch = num_claimed;
+
+        for (size_t i = 0; i < num_claimed; i++){
+            buffs.push_back(_msb_pool[_send_index].get_new(batch));
+            if (++_send_index == get_num_send_frames()) _send_index = 0;
+        }
+        return num_claimed;
     }
 
     size_t get_num_send_frames(void) const{
@@ -243,19 +335,51 @@ public:
     }
 
 private:
-    //file descriptor for mmap
-    int _fd;
+    /*******************************************************************
+     * Wait for a frame to become ready:
+     * Spin on the frame flags for the busy poll time,
+     * which avoids the cost of a system call and a wake-up
+     * when the driver turns the frame around quickly.
+     * The clock is a system call too, so its only read
+     * once per spins_per_clock checks of the flags.
+     * Then block on the ring for the remainder of the timeout.
+     ******************************************************************/
+    template <typename buffer_type> UHD_INLINE bool wait_for_frame(
+        buffer_type &buff, short events, double timeout, size_t num_polls
+    ){
+        if (buff.ready()) return true;
+
+        if (_busy_poll_time > 0.0){
+            const double spin_time = std::min(_busy_poll_time, timeout);
+            const boost::system_time exit_time = boost::get_system_time() +
+                boost::posix_time::microseconds(long(spin_time*1e6));
+            do{
+                for (size_t i = 0; i < spins_per_clock; i++){
+                    if (buff.ready()) return true;
+                }
+            } while (boost::get_system_time() < exit_time);
+            timeout -= spin_time;
+        }
 
-    //the mapped memory itself
-    void *_mapped_mem;
+        for (size_t i = 0; i < num_polls; i++){
+            if (_ring->wait(events, timeout/num_polls)) return true;
+        }
+        return false;
+    }
+
+    e100_mmap_ring::sptr _ring;
 
     //mapped memory sizes
-    usrp_e_ring_buffer_size_t _rb_size;
-    size_t _frame_size, _map_size;
+    const usrp_e_ring_buffer_size_t _rb_size;
+    const size_t _frame_size;
+
+    //time to spin on the flags before blocking
+    const double _busy_poll_time;
 
     //re-usable managed buffers
     std::vector<e100_mmap_zero_copy_mrb> _mrb_pool;
     std::vector<e100_mmap_zero_copy_msb> _msb_pool;
+    std::vector<size_t> _send_batches;
 
     //indexes into sub-sections of mapped memory
     size_t _recv_index, _send_index;
@@ -264,6 +388,8 @@ private:
 /***********************************************************************
  * The zero copy interface make function
  **********************************************************************/
-zero_copy_if::sptr e100_make_mmap_zero_copy(e100_ctrl::sptr iface){
-    return zero_copy_if::sptr(new e100_mmap_zero_copy_impl(iface));
+e100_mmap_zero_copy::sptr e100_mmap_zero_copy::make(
+    e100_mmap_ring::sptr ring, const device_addr_t &hints
+){
+    return sptr(new e100_mmap_zero_copy_impl(ring, hints));
 }
@@ -0,0 +1,117 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_E100_MMAP_ZERO_COPY_HPP
+#define INCLUDED_E100_MMAP_ZERO_COPY_HPP
+
+#include "e100_ctrl.hpp"
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <linux/usrp_e.h>
+#include <vector>
+
+/*!
+ * The mapped ring is the memory shared with the usrp_e driver:
+ * the pages of frame flags and the frames of the rx and tx rings.
+ * The transport claims and releases frames through the flags,
+ * and only calls into the ring to block or to notify the driver.
+ */
+class e100_mmap_ring : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<e100_mmap_ring> sptr;
+
+    //! Make a ring that maps the memory of the driver
+    static sptr make(e100_ctrl::sptr iface);
+
+    //! Get the number of flag pages and frames in each ring
+    virtual const usrp_e_ring_buffer_size_t &get_rb_size(void) const = 0;
+
+    //! Get the page size used to lay out the mapped memory
+    virtual size_t get_page_size(void) const = 0;
+
+    //! Get a pointer to the start of the mapped memory
+    virtual char *get_mem(void) const = 0;
+
+    /*!
+     * Block until the driver signals a frame.
+     * \param events POLLIN for a recv frame or POLLOUT for a send frame
+     * \param timeout the timeout in seconds
+     * \return true when signaled, false on timeout
+     */
+    virtual bool wait(short events, double timeout) = 0;
+
+    //! Notify the driver that send frames were committed
+    virtual void notify(void) = 0;
+};
+
+/*!
+ * The zero copy transport over the mapped rings.
+ * When the frame at the current index is not ready,
+ * the transport spins on the frame flags for the busy poll time,
+ * and then blocks on the ring for the remainder of the timeout.
+ */
+class e100_mmap_zero_copy : public virtual uhd::transport::zero_copy_if{
+public:
+    typedef boost::shared_ptr<e100_mmap_zero_copy> sptr;
+
+    /*!
+     * Make a new zero copy transport over a mapped ring.
+     *
+     * The following hints are recognized:
+     * - busy_poll_time: seconds to spin before blocking (default 0)
+     *
+     * \param ring the mapped ring from the driver (or a stand-in)
+     * \param hints optional parameters for the transport
+     * \return a new zero copy transport
+     */
+    static sptr make(
+        e100_mmap_ring::sptr ring,
+        const uhd::device_addr_t &hints = uhd::device_addr_t()
+    );
+
+    /*!
+     * Claim up to max recv frames in one call.
+     * Only the first frame is waited upon (spin, then block);
+     * the frames that follow are claimed only when already ready.
+     * \param buffs the claimed buffers are appended here
+     * \param max the maximum number of frames to claim
+     * \param timeout the timeout in seconds for the first frame
+     * \return the number of buffers appended
+     */
+    virtual size_t get_recv_buffs(
+        std::vector<uhd::transport::managed_recv_buffer::sptr> &buffs,
+        size_t max, double timeout
+    ) = 0;
+
+    /*!
+     * Claim up to max send frames in one call.
+     * The frames of a batch notify the driver once,
+     * when the last of them has been committed.
+     * \param buffs the claimed buffers are appended here
+     * \param max the maximum number of frames to claim
+     * \param timeout the timeout in seconds for the first frame
+     * \return the number of buffers appended
+     */
+    virtual size_t get_send_buffs(
+        std::vector<uhd::transport::managed_send_buffer::sptr> &buffs,
+        size_t max, double timeout
+    ) = 0;
+};
+
+#endif /* INCLUDED_E100_MMAP_ZERO_COPY_HPP */
@@ -61,8 +61,8 @@ struct e100_impl::io_impl{
     recv_packet_demuxer::sptr demuxer;
 
     //state management for the vrt packet handler code
-    sph::recv_packet_handler recv_handler;
-    sph::send_packet_handler send_handler;
+    sph::recv_packet_handler_t<recv_packet_demuxer::chan_get_buff, sph::vrt_unpack_le> recv_handler;
+    sph::send_packet_handler_t<sph::xport_get_send_buff, sph::vrt_pack_le> send_handler;
 
     //a pirate's life is the life for me!
     void recv_pirate_loop(
@@ -172,6 +172,15 @@ void e100_impl::io_init(void){
     //create new io impl
     _io_impl = UHD_PIMPL_MAKE(io_impl, ());
     _io_impl->demuxer = recv_packet_demuxer::make(_data_transport, _rx_dsps.size(), E100_RX_SID_BASE);
+
+    //expose the demuxer queue statistics for each rx dsp
+    for (size_t dspno = 0; dspno < _rx_dsps.size(); dspno++){
+        const fs_path rx_dsp_path = str(boost::format("/mboards/0/rx_dsps/%u") % dspno);
+        _tree->create<size_t>(rx_dsp_path / "demux/depth")
+            .publish(boost::bind(&recv_packet_demuxer::get_queue_depth, _io_impl->demuxer, dspno));
+        _tree->create<size_t>(rx_dsp_path / "demux/max_depth")
+            .publish(boost::bind(&recv_packet_demuxer::get_max_queue_depth, _io_impl->demuxer, dspno));
+    }
     _io_impl->iface = _fpga_ctrl;
 
     //clear state machines
@@ -189,9 +198,9 @@ void e100_impl::io_init(void){
     ));
 
     //init some handler stuff
-    _io_impl->recv_handler.set_vrt_unpacker(&vrt::if_hdr_unpack_le);
+    _io_impl->recv_handler.set_vrt_unpacker(sph::vrt_unpack_le());
     _io_impl->recv_handler.set_converter(_rx_otw_type);
-    _io_impl->send_handler.set_vrt_packer(&vrt::if_hdr_pack_le);
+    _io_impl->send_handler.set_vrt_packer(sph::vrt_pack_le());
     _io_impl->send_handler.set_converter(_tx_otw_type);
     _io_impl->send_handler.set_max_samples_per_packet(get_max_send_samps_per_packet());
 }
@@ -238,9 +247,9 @@ void e100_impl::update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
     //bind new callbacks for the handler
     for (size_t i = 0; i < _io_impl->recv_handler.size(); i++){
         _rx_dsps[i]->set_nsamps_per_packet(get_max_recv_samps_per_packet()); //seems to be a good place to set this
-        _io_impl->recv_handler.set_xport_chan_get_buff(i, boost::bind(
-            &recv_packet_demuxer::get_recv_buff, _io_impl->demuxer, i, _1
-        ));
+        _io_impl->recv_handler.set_xport_chan_get_buff(i,
+            recv_packet_demuxer::chan_get_buff(_io_impl->demuxer, i)
+        );
         _io_impl->recv_handler.set_overflow_handler(i, boost::bind(&rx_dsp_core_200::handle_overflow, _rx_dsps[i]));
     }
 }
@@ -261,8 +270,12 @@ void e100_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
 
     //bind new callbacks for the handler
     for (size_t i = 0; i < _io_impl->send_handler.size(); i++){
-        _io_impl->send_handler.set_xport_chan_get_buff(i, boost::bind(
-            &zero_copy_if::get_send_buff, _data_transport, _1
+        _io_impl->send_handler.set_xport_chan_get_buff(i,
+            sph::xport_get_send_buff(_data_transport)
+        );
+        //the mmap ring notifies the driver once per batch of frames
+        _io_impl->send_handler.set_xport_chan_get_buffs(i, boost::bind(
+            &zero_copy_if::get_send_buffs, _data_transport, _1, _2, _3
         ));
     }
 }
@@ -316,6 +329,18 @@ size_t e100_impl::recv(
     );
 }
 
+device::recv_lease_type e100_impl::borrow_recv(
+    recv_views_type &views, rx_metadata_t &metadata, double timeout
+){
+    return _io_impl->recv_handler.borrow(views, metadata, timeout);
+}
+
+device::send_commit_type e100_impl::borrow_send(
+    send_views_type &views, const tx_metadata_t &metadata, double timeout
+){
+    return _io_impl->send_handler.borrow(views, metadata, timeout);
+}
+
 /***********************************************************************
  * Async Recv
  **********************************************************************/
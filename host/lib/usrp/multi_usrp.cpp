@@ -501,6 +501,10 @@ public:
         return _tree->access<double>(rx_rf_fe_root(chan) / "bandwidth" / "value").get();
     }
 
+    void set_rx_lo_hop_freqs(const std::vector<double> &freqs, size_t chan){
+        _tree->access<std::vector<double> >(rx_rf_fe_root(chan) / "freq" / "hop_freqs").set(freqs);
+    }
+
     dboard_iface::sptr get_rx_dboard_iface(size_t chan){
         return _tree->access<dboard_iface::sptr>(rx_rf_fe_root(chan).branch_path().branch_path() / "iface").get();
     }
@@ -611,6 +615,10 @@ public:
         return _tree->access<double>(tx_rf_fe_root(chan) / "bandwidth" / "value").get();
     }
 
+    void set_tx_lo_hop_freqs(const std::vector<double> &freqs, size_t chan){
+        _tree->access<std::vector<double> >(tx_rf_fe_root(chan) / "freq" / "hop_freqs").set(freqs);
+    }
+
     dboard_iface::sptr get_tx_dboard_iface(size_t chan){
         return _tree->access<dboard_iface::sptr>(tx_rf_fe_root(chan).branch_path().branch_path() / "iface").get();
     }
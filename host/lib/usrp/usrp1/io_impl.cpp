@@ -348,6 +348,14 @@ void usrp1_impl::update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
     bool s = this->disable_rx();
     _iface->poke32(FR_RX_MUX, calc_rx_mux(mapping));
     this->restore_rx(s);
+
+    //the number of channels changed the aggregate rate
+    const fs_path rate_path = "/mboards/0/rx_dsps/0/rate/value";
+    if (_tree->exists(rate_path) and not _tree->access<double>(rate_path).empty()){
+        _data_transport->set_recv_rate_hint(
+            _tree->access<double>(rate_path).get()*_rx_otw_type.get_sample_size()*spec.size()
+        );
+    }
 }
 
 void usrp1_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
@@ -388,6 +396,11 @@ double usrp1_impl::update_rx_samp_rate(const double samp_rate){
     this->restore_rx(s);
 
     _io_impl->recv_handler.set_samp_rate(_master_clock_rate / rate);
+
+    //tune the usb transfers for the aggregate rate of all channels
+    _data_transport->set_recv_rate_hint(
+        _master_clock_rate / rate * _rx_otw_type.get_sample_size() * _rx_subdev_spec.size()
+    );
     return _master_clock_rate / rate;
 }
 
@@ -229,6 +229,18 @@ usrp1_impl::usrp1_impl(const device_addr_t &device_addr){
         .set(mb_eeprom)
         .subscribe(boost::bind(&usrp1_impl::set_mb_eeprom, this, _1));
 
+    ////////////////////////////////////////////////////////////////////
+    // expose the data transport tuning and latency
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<size_t>(mb_path / "xport/recv_xfer_size")
+        .publish(boost::bind(&usb_zero_copy::get_recv_xfer_size, _data_transport));
+    _tree->create<size_t>(mb_path / "xport/num_recv_xfers")
+        .publish(boost::bind(&usb_zero_copy::get_num_recv_xfers, _data_transport));
+    _tree->create<std::vector<size_t> >(mb_path / "xport/recv_latency_histogram")
+        .publish(boost::bind(&usb_zero_copy::get_recv_latency_histogram, _data_transport));
+    _tree->create<std::vector<size_t> >(mb_path / "xport/send_latency_histogram")
+        .publish(boost::bind(&usb_zero_copy::get_send_latency_histogram, _data_transport));
+
     ////////////////////////////////////////////////////////////////////
     // create clock control objects
     ////////////////////////////////////////////////////////////////////
@@ -35,7 +35,7 @@ using namespace boost::assign;
 
 class usrp2_dboard_iface : public dboard_iface{
 public:
-    usrp2_dboard_iface(usrp2_iface::sptr iface, usrp2_clock_ctrl::sptr clock_ctrl);
+    usrp2_dboard_iface(usrp2_iface::sptr iface, wb_iface::sptr wbiface, usrp2_clock_ctrl::sptr clock_ctrl);
     ~usrp2_dboard_iface(void);
 
     special_props_t get_special_props(void){
@@ -93,9 +93,10 @@ private:
  **********************************************************************/
 dboard_iface::sptr make_usrp2_dboard_iface(
     usrp2_iface::sptr iface,
+    wb_iface::sptr wbiface,
     usrp2_clock_ctrl::sptr clock_ctrl
 ){
-    return dboard_iface::sptr(new usrp2_dboard_iface(iface, clock_ctrl));
+    return dboard_iface::sptr(new usrp2_dboard_iface(iface, wbiface, clock_ctrl));
 }
 
 /***********************************************************************
@@ -103,11 +104,12 @@ dboard_iface::sptr make_usrp2_dboard_iface(
  **********************************************************************/
 usrp2_dboard_iface::usrp2_dboard_iface(
     usrp2_iface::sptr iface,
+    wb_iface::sptr wbiface,
     usrp2_clock_ctrl::sptr clock_ctrl
 ){
     _iface = iface;
     _clock_ctrl = clock_ctrl;
-    _gpio = gpio_core_200::make(_iface, GPIO_BASE);
+    _gpio = gpio_core_200::make(wbiface, GPIO_BASE);
 
     //reset the aux dacs
     _dac_regs[UNIT_RX] = ad5623_regs_t();
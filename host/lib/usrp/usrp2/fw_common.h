@@ -88,6 +88,9 @@ typedef enum{
     USRP2_CTRL_ID_GET_THIS_REGISTER_FOR_ME_BRO = 'r',
     USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE = 'R',
 
+    USRP2_CTRL_ID_POKE_THESE_REGISTERS_BRO = 'p',
+    USRP2_CTRL_ID_POKED_THOSE_REGISTERS_DUDE = 'P',
+
     USRP2_CTRL_ID_HEY_WRITE_THIS_UART_FOR_ME_BRO = 'u',
     USRP2_CTRL_ID_MAN_I_TOTALLY_WROTE_THAT_UART_DUDE = 'U',
 
@@ -144,9 +147,26 @@ typedef struct{
         struct {
             uint32_t len;
         } echo_args;
+        struct {
+            uint32_t num_pokes;
+        } batch_args;
     } data;
 } usrp2_ctrl_data_t;
 
+//the most register writes in a single batch poke request
+#define USRP2_CTRL_MAX_BATCH_POKES 64
+
+typedef struct{
+    uint32_t addr;
+    uint32_t data;
+} usrp2_ctrl_poke_t;
+
+//a batch poke request: the control header, then num_pokes writes
+typedef struct{
+    usrp2_ctrl_data_t ctrl_data;
+    usrp2_ctrl_poke_t pokes[USRP2_CTRL_MAX_BATCH_POKES];
+} usrp2_ctrl_batch_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,12 +25,14 @@
 #include <uhd/utils/tasks.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/utils/thread_priority.hpp>
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/format.hpp>
 #include <boost/bind.hpp>
 #include <boost/thread/mutex.hpp>
+#include <algorithm>
 #include <iostream>
 
 using namespace uhd;
@@ -58,7 +60,8 @@ static const size_t vrt_send_header_offset_words32 = 1;
 /***********************************************************************
  * flow control monitor for a single tx channel
  *  - the pirate thread calls update
- *  - the get send buffer calls check
+ *  - the get send buffer calls check or reserve
+ *  - the ack is atomic, so the sender only locks to wait
  **********************************************************************/
 class flow_control_monitor{
 public:
@@ -71,7 +74,7 @@ public:
      */
     flow_control_monitor(seq_type max_seqs_out){
         _last_seq_out = 0;
-        _last_seq_ack = 0;
+        _last_seq_ack.write(0);
         _max_seqs_out = max_seqs_out;
         _ready_fcn = boost::bind(&flow_control_monitor::ready, this);
     }
@@ -91,31 +94,58 @@ public:
      * \return false on timeout
      */
     UHD_INLINE bool check_fc_condition(double timeout){
-        boost::mutex::scoped_lock lock(_fc_mutex);
         if (this->ready()) return true;
+        boost::mutex::scoped_lock lock(_fc_mutex);
         boost::this_thread::disable_interruption di; //disable because the wait can throw
         return _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
     }
 
+    /*!
+     * Reserve up to max sequence numbers to go out.
+     * Waits on the flow control condition for the first one.
+     * \param first_seq the first reserved sequence number
+     * \param max the maximum number of sequence numbers
+     * \param timeout the timeout in seconds
+     * \return the number reserved, zero on timeout
+     */
+    UHD_INLINE size_t reserve_seqs(seq_type &first_seq, size_t max, double timeout){
+        if (max == 0 or not this->check_fc_condition(timeout)) return 0;
+        const seq_type num_out = seq_type(_last_seq_out - _last_seq_ack.read());
+        const size_t num = std::min(max, size_t(_max_seqs_out - num_out));
+        first_seq = _last_seq_out;
+        _last_seq_out += seq_type(num);
+        return num;
+    }
+
+    /*!
+     * Give back the last reserved sequence numbers that were not sent.
+     * \param num the number of sequence numbers to give back
+     */
+    UHD_INLINE void unreserve_seqs(size_t num){
+        _last_seq_out -= seq_type(num);
+    }
+
     /*!
      * Update the flow control condition.
      * \param seq the last sequence number to be ACK'd
      */
     UHD_INLINE void update_fc_condition(seq_type seq){
+        _last_seq_ack.write(seq);
+        //lock so that a sender cannot miss the notify between check and wait
         boost::mutex::scoped_lock lock(_fc_mutex);
-        _last_seq_ack = seq;
         lock.unlock();
         _fc_cond.notify_one();
     }
 
 private:
     bool ready(void){
-        return seq_type(_last_seq_out -_last_seq_ack) < _max_seqs_out;
+        return seq_type(_last_seq_out - _last_seq_ack.read()) < _max_seqs_out;
     }
 
     boost::mutex _fc_mutex;
     boost::condition _fc_cond;
-    seq_type _last_seq_out, _last_seq_ack, _max_seqs_out;
+    seq_type _last_seq_out, _max_seqs_out; //only the sender writes these
+    atomic_uint32_t _last_seq_ack;
     boost::function<bool(void)> _ready_fcn;
 };
 
@@ -154,13 +184,46 @@ struct usrp2_impl::io_impl{
         return buff;
     }
 
+    size_t get_send_buffs(size_t chan, std::vector<managed_send_buffer::sptr> &buffs, size_t max, double timeout){
+        flow_control_monitor &fc_mon = *fc_mons[chan];
+
+        //reserve the sequence numbers for the batch w/ timeout
+        flow_control_monitor::seq_type seq = 0;
+        const size_t num_reserved = fc_mon.reserve_seqs(seq, max, timeout);
+        if (num_reserved == 0) return 0;
+
+        //get the buffers from the transport w/ timeout, give back the unused sequences
+        const size_t first = buffs.size();
+        const size_t num_buffs = tx_xports[chan]->get_send_buffs(buffs, num_reserved, timeout);
+        fc_mon.unreserve_seqs(num_reserved - num_buffs);
+
+        //write the flow control words into the buffers
+        for (size_t i = first; i < buffs.size(); i++){
+            buffs[i]->cast<boost::uint32_t *>()[0] = uhd::htonx(seq++);
+        }
+        return num_buffs;
+    }
+
+    void return_send_buffs(size_t chan, std::vector<managed_send_buffer::sptr> &buffs){
+        //the unsent buffers hold the last reserved sequence numbers
+        fc_mons[chan]->unreserve_seqs(buffs.size());
+        buffs.clear(); //zero length commits, the transport sends nothing
+    }
+
     //tx dsp: xports and flow control monitors
     std::vector<zero_copy_if::sptr> tx_xports;
     std::vector<flow_control_monitor::sptr> fc_mons;
 
     //state management for the vrt packet handler code
-    sph::recv_packet_handler recv_handler;
-    sph::send_packet_handler send_handler;
+    typedef sph::recv_packet_handler_t<sph::xport_get_recv_buff, sph::vrt_unpack_be> recv_handler_type;
+    recv_handler_type recv_handler;
+    std::vector<convert::rx_symbol_stage::sptr> rx_symbol_stages; //set with nfft, kept for the offset
+    sph::send_packet_handler_t<sph::send_packet_handler::get_buff_type, sph::vrt_pack_be> send_handler;
+
+    //statistics about recovering the multi-channel alignment
+    size_t get_align_recoveries(void){return recv_handler.get_alignment_stats().num_recoveries;}
+    size_t get_align_discarded_samps(void){return recv_handler.get_alignment_stats().num_discarded_samps;}
+    double get_align_max_recovery_time(void){return recv_handler.get_alignment_stats().max_recovery_time;}
 
     //methods and variables for the pirate crew
     void recv_pirate_loop(zero_copy_if::sptr, size_t);
@@ -271,15 +334,56 @@ void usrp2_impl::io_init(void){
     }
 
     //init some handler stuff
-    _io_impl->recv_handler.set_vrt_unpacker(&vrt::if_hdr_unpack_be);
+    _io_impl->recv_handler.set_vrt_unpacker(sph::vrt_unpack_be());
     _io_impl->recv_handler.set_converter(_rx_otw_type);
-    _io_impl->send_handler.set_vrt_packer(&vrt::if_hdr_pack_be, vrt_send_header_offset_words32);
+    _io_impl->recv_handler.set_converter_threads(_recv_convert_threads, _recv_convert_cpu);
+    if (_recv_gap_mode == "report") _io_impl->recv_handler.set_gap_mode(io_impl::recv_handler_type::GAP_MODE_REPORT);
+    else if (_recv_gap_mode == "fill") _io_impl->recv_handler.set_gap_mode(io_impl::recv_handler_type::GAP_MODE_FILL);
+    else if (_recv_gap_mode != "none") throw uhd::value_error("unknown recv_gap_mode: " + _recv_gap_mode);
+    _io_impl->send_handler.set_vrt_packer(sph::vrt_pack_be(), vrt_send_header_offset_words32);
     _io_impl->send_handler.set_converter(_tx_otw_type);
     _io_impl->send_handler.set_max_samples_per_packet(get_max_send_samps_per_packet());
 
-    //set the packet threshold to be an entire socket buffer's worth
-    const size_t packets_per_sock_buff = size_t(50e6/_mbc[_mbc.keys().front()].rx_dsp_xports[0]->get_recv_frame_size());
-    _io_impl->recv_handler.set_alignment_failure_threshold(packets_per_sock_buff);
+    //set the packet threshold to be an entire socket buffer's worth,
+    //plus the frames that can be held by the transport (or prefetch ring)
+    const zero_copy_if::sptr &rx_xport = _mbc[_mbc.keys().front()].rx_dsp_xports[0];
+    const size_t packets_per_sock_buff = _recv_buff_size/rx_xport->get_recv_frame_size();
+    _io_impl->recv_handler.set_alignment_failure_threshold(packets_per_sock_buff + rx_xport->get_num_recv_frames());
+
+    //expose the statistics about recovering the multi-channel alignment
+    _tree->create<size_t>("/rx_align/recoveries")
+        .publish(boost::bind(&io_impl::get_align_recoveries, _io_impl.get()));
+    _tree->create<size_t>("/rx_align/discarded_samps")
+        .publish(boost::bind(&io_impl::get_align_discarded_samps, _io_impl.get()));
+    _tree->create<double>("/rx_align/max_recovery_time")
+        .publish(boost::bind(&io_impl::get_align_max_recovery_time, _io_impl.get()));
+
+    //the post stage shifts each channel (in Hz) and decimates them all on the host,
+    //or it strips the cyclic prefixes of ofdm symbols when nfft is set
+    _tree->create<size_t>("/rx_post/nfft").set(0)
+        .subscribe(boost::bind(&usrp2_impl::update_rx_post_stage, this));
+    _tree->create<size_t>("/rx_post/ncp").set(0)
+        .subscribe(boost::bind(&usrp2_impl::update_rx_post_stage, this));
+    _tree->create<size_t>("/rx_post/decim").set(1)
+        .subscribe(boost::bind(&usrp2_impl::update_rx_post_stage, this));
+    BOOST_FOREACH(const std::string &mb, _mbc.keys()){
+        for (size_t dsp = 0; dsp < _mbc[mb].rx_dsps.size(); dsp++){
+            _tree->create<double>(str(boost::format("/mboards/%s/rx_dsps/%u/post/freq") % mb % dsp)).set(0.0)
+                .coerce(boost::bind(&usrp2_impl::coerce_rx_post_freq, this, _1))
+                .subscribe(boost::bind(&usrp2_impl::update_rx_post_stage, this));
+        }
+    }
+
+    //the coercers reject a combination before it is stored (all nodes exist now)
+    _tree->access<size_t>("/rx_post/nfft")
+        .coerce(boost::bind(&usrp2_impl::coerce_rx_post_nfft, this, _1));
+    _tree->access<size_t>("/rx_post/decim")
+        .coerce(boost::bind(&usrp2_impl::coerce_rx_post_decim, this, _1));
+
+    //the position in the symbol of the next received sample (with nfft set)
+    _tree->create<size_t>("/rx_post/symbol_offset")
+        .publish(boost::bind(&usrp2_impl::get_rx_symbol_offset, this))
+        .subscribe(boost::bind(&usrp2_impl::set_rx_symbol_offset, this, _1));
 }
 
 void usrp2_impl::update_tick_rate(const double rate){
@@ -295,6 +399,85 @@ void usrp2_impl::update_rx_samp_rate(const double rate){
     _io_impl->recv_handler.set_samp_rate(rate);
     const double adj = _mbc[_mbc.keys().front()].rx_dsps.front()->get_scaling_adjustment();
     _io_impl->recv_handler.set_scale_factor(adj/32767.);
+    this->apply_rx_post_stage(); //the frequencies are relative to the rate
+}
+
+void usrp2_impl::update_rx_post_stage(void){
+    boost::mutex::scoped_lock recv_lock = _io_impl->recv_handler.get_scoped_lock();
+    this->apply_rx_post_stage();
+}
+
+size_t usrp2_impl::coerce_rx_post_nfft(const size_t nfft){
+    bool shifted = _tree->access<size_t>("/rx_post/decim").get() != 1;
+    BOOST_FOREACH(const std::string &mb, _mbc.keys()){
+        for (size_t dsp = 0; dsp < _mbc[mb].rx_dsps.size(); dsp++){
+            const fs_path dsp_path = str(boost::format("/mboards/%s/rx_dsps/%u") % mb % dsp);
+            shifted = shifted or _tree->access<double>(dsp_path / "post/freq").get() != 0.0;
+        }
+    }
+    if (nfft != 0 and shifted) throw uhd::value_error(
+        "the rx post stage cannot shift or decimate ofdm symbols"
+    );
+    return nfft;
+}
+
+size_t usrp2_impl::coerce_rx_post_decim(const size_t decim){
+    if (decim == 0) throw uhd::value_error("the rx post stage decimation must be at least 1");
+    if (decim != 1 and _tree->access<size_t>("/rx_post/nfft").get() != 0) throw uhd::value_error(
+        "the rx post stage cannot shift or decimate ofdm symbols"
+    );
+    return decim;
+}
+
+double usrp2_impl::coerce_rx_post_freq(const double freq){
+    if (freq != 0.0 and _tree->access<size_t>("/rx_post/nfft").get() != 0) throw uhd::value_error(
+        "the rx post stage cannot shift or decimate ofdm symbols"
+    );
+    return freq;
+}
+
+size_t usrp2_impl::get_rx_symbol_offset(void){
+    boost::mutex::scoped_lock recv_lock = _io_impl->recv_handler.get_scoped_lock();
+    if (_io_impl->rx_symbol_stages.empty()) return 0;
+    return _io_impl->rx_symbol_stages.front()->get_symbol_offset();
+}
+
+void usrp2_impl::set_rx_symbol_offset(const size_t offset){
+    boost::mutex::scoped_lock recv_lock = _io_impl->recv_handler.get_scoped_lock();
+    BOOST_FOREACH(convert::rx_symbol_stage::sptr &stage, _io_impl->rx_symbol_stages){
+        stage->set_symbol_offset(offset);
+    }
+}
+
+void usrp2_impl::apply_rx_post_stage(void){
+    //the rates and the specs are set before io init makes the nodes
+    if (not _tree->exists("/rx_post/decim")) return;
+
+    //one frequency per channel in cycles per sample
+    std::vector<double> freqs;
+    BOOST_FOREACH(const std::string &mb, _mbc.keys()){
+        for (size_t dsp = 0; dsp < _mbc[mb].rx_chan_occ; dsp++){
+            const fs_path dsp_path = str(boost::format("/mboards/%s/rx_dsps/%u") % mb % dsp);
+            const double rate = _tree->access<double>(dsp_path / "rate/value").get();
+            freqs.push_back(_tree->access<double>(dsp_path / "post/freq").get()/rate);
+        }
+    }
+    const size_t decim = _tree->access<size_t>("/rx_post/decim").get();
+
+    //the symbol stages restart at a prefix every time they are set,
+    //the coercers keep a shift or a decimation out of the symbol layout
+    const size_t nfft = _tree->access<size_t>("/rx_post/nfft").get();
+    _io_impl->rx_symbol_stages.clear();
+    if (nfft != 0){
+        const size_t ncp = _tree->access<size_t>("/rx_post/ncp").get();
+        std::vector<convert::rx_stage::sptr> stages;
+        for (size_t i = 0; i < freqs.size(); i++){
+            _io_impl->rx_symbol_stages.push_back(convert::make_rx_symbol_stage(_rx_otw_type, nfft, ncp));
+            stages.push_back(_io_impl->rx_symbol_stages.back());
+        }
+        _io_impl->recv_handler.set_post_stages(stages);
+    }
+    else _io_impl->recv_handler.set_post_stage(freqs, decim);
 }
 
 void usrp2_impl::update_tx_samp_rate(const double rate){
@@ -326,7 +509,8 @@ subdev_spec_t usrp2_impl::update_rx_subdev_spec(const std::string &which_mb, con
     //sanity checking
     validate_subdev_spec(_tree, spec, "rx", which_mb);
 
-    //setup mux for this spec
+    //setup mux for this spec (the mux writes go out as one batch)
+    wb_shadow_iface::scoped_burst burst(_mbc[which_mb].wbiface);
     bool fe_swapped = false;
     for (size_t i = 0; i < spec.size(); i++){
         const std::string conn = _tree->access<std::string>(root / spec[i].db_name / "rx_frontends" / spec[i].sd_name / "connection").get();
@@ -334,6 +518,7 @@ subdev_spec_t usrp2_impl::update_rx_subdev_spec(const std::string &which_mb, con
         _mbc[which_mb].rx_dsps[i]->set_mux(conn, fe_swapped);
     }
     _mbc[which_mb].rx_fe->set_mux(fe_swapped);
+    burst.end();
 
     //compute the new occupancy and resize
     _mbc[which_mb].rx_chan_occ = spec.size();
@@ -346,11 +531,14 @@ subdev_spec_t usrp2_impl::update_rx_subdev_spec(const std::string &which_mb, con
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
         for (size_t dsp = 0; dsp < _mbc[mb].rx_chan_occ; dsp++){
             _mbc[mb].rx_dsps[dsp]->set_nsamps_per_packet(get_max_recv_samps_per_packet()); //seems to be a good place to set this
-            _io_impl->recv_handler.set_xport_chan_get_buff(chan++, boost::bind(
-                &zero_copy_if::get_recv_buff, _mbc[mb].rx_dsp_xports[dsp], _1
-            ));
+            _io_impl->recv_handler.set_xport_chan_get_buff(chan++,
+                sph::xport_get_recv_buff(_mbc[mb].rx_dsp_xports[dsp])
+            );
         }
     }
+
+    //the resize removed the post stages
+    this->apply_rx_post_stage();
     return spec;
 }
 
@@ -376,9 +564,15 @@ subdev_spec_t usrp2_impl::update_tx_subdev_spec(const std::string &which_mb, con
     size_t chan = 0, i = 0;
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
         for (size_t dsp = 0; dsp < _mbc[mb].tx_chan_occ; dsp++){
-            _io_impl->send_handler.set_xport_chan_get_buff(chan++, boost::bind(
-                &usrp2_impl::io_impl::get_send_buff, _io_impl.get(), i++, _1
+            _io_impl->send_handler.set_xport_chan_get_buff(chan, boost::bind(
+                &usrp2_impl::io_impl::get_send_buff, _io_impl.get(), i, _1
+            ));
+            _io_impl->send_handler.set_xport_chan_get_buffs(chan++, boost::bind(
+                &usrp2_impl::io_impl::get_send_buffs, _io_impl.get(), i, _1, _2, _3
+            ), boost::bind(
+                &usrp2_impl::io_impl::return_send_buffs, _io_impl.get(), i, _1
             ));
+            i++;
         }
     }
     return spec;
@@ -443,3 +637,15 @@ size_t usrp2_impl::recv(
         recv_mode, timeout
     );
 }
+
+device::recv_lease_type usrp2_impl::borrow_recv(
+    recv_views_type &views, rx_metadata_t &metadata, double timeout
+){
+    return _io_impl->recv_handler.borrow(views, metadata, timeout);
+}
+
+device::send_commit_type usrp2_impl::borrow_send(
+    send_views_type &views, const tx_metadata_t &metadata, double timeout
+){
+    return _io_impl->send_handler.borrow(views, metadata, timeout);
+}
@@ -20,6 +20,7 @@
 #include "usrp2_iface.hpp"
 #include <uhd/exception.hpp>
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
 #include <uhd/utils/tasks.hpp>
 #include <uhd/utils/safe_call.hpp>
 #include <uhd/types/dict.hpp>
@@ -33,6 +34,8 @@
 #include <boost/functional/hash.hpp>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <vector>
 
 using namespace uhd;
 using namespace uhd::usrp;
@@ -40,6 +43,10 @@ using namespace uhd::transport;
 
 static const double CTRL_RECV_TIMEOUT = 1.0;
 
+//The most control requests in flight at once.
+//Kept small so that the firmware packet buffers never overflow.
+static const size_t CTRL_PIPELINE_WINDOW = 4;
+
 static const boost::uint32_t MIN_PROTO_COMPAT_SPI = 7;
 static const boost::uint32_t MIN_PROTO_COMPAT_I2C = 7;
 // The register compat number must reflect the protocol compatibility
@@ -82,7 +89,8 @@ public:
     usrp2_iface_impl(udp_simple::sptr ctrl_transport):
         _ctrl_transport(ctrl_transport),
         _ctrl_seq_num(0),
-        _protocol_compat(0) //initialized below...
+        _protocol_compat(0), //initialized below...
+        _batch_pokes_supported(true) //until the firmware says otherwise
     {
         //Obtain the firmware's compat number.
         //Save the response compat number for communication.
@@ -162,6 +170,57 @@ public:
         return this->get_reg<boost::uint16_t, USRP2_REG_ACTION_FPGA_PEEK16>(addr);
     }
 
+    void batch_poke32(const poke32_batch_type &pokes){
+        if (pokes.empty()) return;
+
+        //pack the writes into as few batch requests as possible
+        if (_batch_pokes_supported){
+            const size_t num_batches = (pokes.size() + USRP2_CTRL_MAX_BATCH_POKES - 1)/USRP2_CTRL_MAX_BATCH_POKES;
+            std::vector<usrp2_ctrl_batch_t> batches(num_batches);
+            std::vector<ctrl_packet_type> packets(num_batches);
+            for (size_t i = 0; i < num_batches; i++){
+                const size_t first = i*USRP2_CTRL_MAX_BATCH_POKES;
+                const size_t num_pokes = std::min<size_t>(pokes.size() - first, USRP2_CTRL_MAX_BATCH_POKES);
+                batches[i].ctrl_data = usrp2_ctrl_data_t();
+                batches[i].ctrl_data.id = htonl(USRP2_CTRL_ID_POKE_THESE_REGISTERS_BRO);
+                batches[i].ctrl_data.data.batch_args.num_pokes = htonl(num_pokes);
+                for (size_t j = 0; j < num_pokes; j++){
+                    batches[i].pokes[j].addr = htonl(pokes[first+j].first);
+                    batches[i].pokes[j].data = htonl(pokes[first+j].second);
+                }
+                packets[i] = ctrl_packet_type(&batches[i], sizeof(usrp2_ctrl_data_t) + num_pokes*sizeof(usrp2_ctrl_poke_t));
+            }
+
+            //send and recv, older firmware does not know the request
+            std::vector<usrp2_ctrl_data_t> in_data = this->ctrl_send_and_recv_pipelined(packets, MIN_PROTO_COMPAT_REG);
+            if (ntohl(in_data.front().id) != USRP2_CTRL_ID_HUH_WHAT){
+                for (size_t i = 0; i < num_batches; i++){
+                    UHD_ASSERT_THROW(ntohl(in_data[i].id) == USRP2_CTRL_ID_POKED_THOSE_REGISTERS_DUDE);
+                    UHD_ASSERT_THROW(in_data[i].data.batch_args.num_pokes == batches[i].ctrl_data.data.batch_args.num_pokes);
+                }
+                return;
+            }
+            UHD_LOG << "usrp2 firmware does not support batch pokes, using single pokes" << std::endl;
+            _batch_pokes_supported = false;
+        }
+
+        //otherwise pipeline one register request per write
+        std::vector<usrp2_ctrl_data_t> out_data(pokes.size());
+        std::vector<ctrl_packet_type> packets(pokes.size());
+        for (size_t i = 0; i < pokes.size(); i++){
+            out_data[i] = usrp2_ctrl_data_t();
+            out_data[i].id = htonl(USRP2_CTRL_ID_GET_THIS_REGISTER_FOR_ME_BRO);
+            out_data[i].data.reg_args.addr = htonl(pokes[i].first);
+            out_data[i].data.reg_args.data = htonl(pokes[i].second);
+            out_data[i].data.reg_args.action = USRP2_REG_ACTION_FPGA_POKE32;
+            packets[i] = ctrl_packet_type(&out_data[i], sizeof(usrp2_ctrl_data_t));
+        }
+        std::vector<usrp2_ctrl_data_t> in_data = this->ctrl_send_and_recv_pipelined(packets, MIN_PROTO_COMPAT_REG);
+        for (size_t i = 0; i < pokes.size(); i++){
+            UHD_ASSERT_THROW(ntohl(in_data[i].id) == USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE);
+        }
+    }
+
     template <class T, usrp2_reg_action_t action>
     T get_reg(wb_addr_type addr, T data = 0){
         //setup the out data
@@ -258,19 +317,49 @@ public:
         const usrp2_ctrl_data_t &out_data,
         boost::uint32_t lo = USRP2_FW_COMPAT_NUM,
         boost::uint32_t hi = USRP2_FW_COMPAT_NUM
+    ){
+        const std::vector<ctrl_packet_type> packets(1, ctrl_packet_type(&out_data, sizeof(usrp2_ctrl_data_t)));
+        return this->ctrl_send_and_recv_pipelined(packets, lo, hi).front();
+    }
+
+    //! A control request: the memory starts with the control header
+    typedef std::pair<const void *, size_t> ctrl_packet_type;
+
+    /*!
+     * Send the control requests with several requests in flight.
+     * Each reply is matched to its request by the sequence number.
+     * \return the replies in the order of the requests
+     */
+    std::vector<usrp2_ctrl_data_t> ctrl_send_and_recv_pipelined(
+        const std::vector<ctrl_packet_type> &packets,
+        boost::uint32_t lo = USRP2_FW_COMPAT_NUM,
+        boost::uint32_t hi = USRP2_FW_COMPAT_NUM
     ){
         boost::mutex::scoped_lock lock(_ctrl_mutex);
 
-        //fill in the seq number and send
-        usrp2_ctrl_data_t out_copy = out_data;
-        out_copy.proto_ver = htonl(_protocol_compat);
-        out_copy.seq = htonl(++_ctrl_seq_num);
-        _ctrl_transport->send(boost::asio::buffer(&out_copy, sizeof(usrp2_ctrl_data_t)));
+        std::vector<usrp2_ctrl_data_t> replies(packets.size());
+        std::vector<bool> got_reply(packets.size(), false);
+        const boost::uint32_t first_seq = _ctrl_seq_num + 1;
+        size_t num_sent = 0, num_recvd = 0;
 
-        //loop until we get the packet or timeout
+        boost::uint8_t usrp2_ctrl_data_out_mem[udp_simple::mtu];
+        usrp2_ctrl_data_t *ctrl_data_out = reinterpret_cast<usrp2_ctrl_data_t *>(usrp2_ctrl_data_out_mem);
         boost::uint8_t usrp2_ctrl_data_in_mem[udp_simple::mtu]; //allocate max bytes for recv
         const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
-        while(true){
+
+        while (num_recvd < packets.size()){
+            //fill the window: fill in the seq number and send
+            while (num_sent < packets.size() and num_sent - num_recvd < CTRL_PIPELINE_WINDOW){
+                const size_t len = packets[num_sent].second;
+                UHD_ASSERT_THROW(len >= sizeof(usrp2_ctrl_data_t) and len <= udp_simple::mtu);
+                std::memcpy(usrp2_ctrl_data_out_mem, packets[num_sent].first, len);
+                ctrl_data_out->proto_ver = htonl(_protocol_compat);
+                ctrl_data_out->seq = htonl(_ctrl_seq_num = first_seq + num_sent);
+                _ctrl_transport->send(boost::asio::buffer(usrp2_ctrl_data_out_mem, len));
+                num_sent++;
+            }
+
+            //loop until we get a packet or timeout
             size_t len = _ctrl_transport->recv(boost::asio::buffer(usrp2_ctrl_data_in_mem), CTRL_RECV_TIMEOUT);
             boost::uint32_t compat = ntohl(ctrl_data_in->proto_ver);
             if(len >= sizeof(boost::uint32_t) and (hi < compat or lo > compat)){
@@ -281,13 +370,19 @@ public:
                     "The firmware build is not compatible with the host code build."
                 ) % ((lo == hi)? (boost::format("%d") % hi) : (boost::format("[%d to %d]") % lo % hi)) % compat));
             }
-            if (len >= sizeof(usrp2_ctrl_data_t) and ntohl(ctrl_data_in->seq) == _ctrl_seq_num){
-                return *ctrl_data_in;
+            if (len >= sizeof(usrp2_ctrl_data_t)){
+                const boost::uint32_t index = ntohl(ctrl_data_in->seq) - first_seq; //stale seqs wrap out of range
+                if (index < num_sent and not got_reply[index]){
+                    replies[index] = *ctrl_data_in;
+                    got_reply[index] = true;
+                    num_recvd++;
+                }
+                continue;
             }
-            if (len == 0) break; //timeout
+            if (len == 0) throw uhd::runtime_error("no control response"); //timeout
             //didnt get seq or bad packet, continue looking...
         }
-        throw uhd::runtime_error("no control response");
+        return replies;
     }
 
     rev_type get_rev(void){
@@ -331,6 +426,7 @@ private:
     boost::mutex _ctrl_mutex;
     boost::uint32_t _ctrl_seq_num;
     boost::uint32_t _protocol_compat;
+    bool _batch_pokes_supported;
 
     //lock thread stuff
     task::sptr _lock_task;
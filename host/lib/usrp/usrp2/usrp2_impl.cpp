@@ -22,7 +22,9 @@
 #include <uhd/exception.hpp>
 #include <uhd/transport/if_addrs.hpp>
 #include <uhd/transport/udp_zero_copy.hpp>
+#include <uhd/transport/zero_copy_prefetch.hpp>
 #include <uhd/types/ranges.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/static.hpp>
 #include <uhd/utils/byteswap.hpp>
@@ -32,6 +34,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/asio/ip/address_v4.hpp>
 #include <boost/asio.hpp> //used for htonl and ntohl
 
@@ -255,7 +258,7 @@ static zero_copy_if::sptr make_xport(
     //Send a small data packet so the usrp2 knows the udp source port.
     //This setup must happen before further initialization occurs
     //or the async update packets will cause ICMP destination unreachable.
-    static const boost::uint32_t data[2] = {
+    const boost::uint32_t data[2] = {
         uhd::htonx(boost::uint32_t(0 /* don't care seq num */)),
         uhd::htonx(boost::uint32_t(USRP2_INVALID_VRT_HEADER))
     };
@@ -266,11 +269,21 @@ static zero_copy_if::sptr make_xport(
     return xport;
 }
 
+/***********************************************************************
+ * Log the time taken by an init phase and start the next phase
+ **********************************************************************/
+static void log_init_phase(const std::string &phase, time_spec_t &start){
+    const time_spec_t now = time_spec_t::get_system_time();
+    UHD_LOG << boost::format("%s took %.1f ms") % phase % ((now - start).get_real_secs()*1e3) << std::endl;
+    start = now;
+}
+
 /***********************************************************************
  * Structors
  **********************************************************************/
 usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
     UHD_MSG(status) << "Opening a USRP2/N-Series device..." << std::endl;
+    time_spec_t init_start = time_spec_t::get_system_time();
     device_addr_t device_addr = _device_addr;
 
     //setup the dsp transport hints (default to a large recv buff)
@@ -288,6 +301,15 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
         //because we will never commit more than the SRAM can hold.
         device_addr["send_buff_size"] = boost::lexical_cast<std::string>(USRP2_SRAM_BYTES);
     }
+    if (device_addr.has_key("recv_prefetch") and not device_addr.has_key("num_recv_frames")){
+        //The prefetch ring holds transport frames,
+        //so the transport must allocate enough frames to fill it.
+        device_addr["num_recv_frames"] = device_addr["recv_prefetch"];
+    }
+    _recv_buff_size = size_t(device_addr.cast<double>("recv_buff_size", 0.0));
+    _recv_convert_threads = size_t(device_addr.cast<double>("recv_convert_threads", 0));
+    _recv_convert_cpu = int(device_addr.cast<double>("recv_convert_cpu", -1));
+    _recv_gap_mode = device_addr.has_key("recv_gap_mode")? device_addr["recv_gap_mode"] : "none";
 
     device_addrs_t device_args = separate_device_addr(device_addr);
 
@@ -323,275 +345,36 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
     _tree = property_tree::make();
     _tree->create<std::string>("/name").set("USRP2 / N-Series Device");
 
+    //the mboard containers and tree nodes are created up front,
+    //so the init threads below only read the container dict,
+    //and /mboards lists the boards in order (not in thread completion order)
     for (size_t mbi = 0; mbi < device_args.size(); mbi++){
-        const device_addr_t device_args_i = device_args[mbi];
         const std::string mb = boost::lexical_cast<std::string>(mbi);
-        const std::string addr = device_args_i["addr"];
-        const fs_path mb_path = "/mboards/" + mb;
-
-        ////////////////////////////////////////////////////////////////
-        // create the iface that controls i2c, spi, uart, and wb
-        ////////////////////////////////////////////////////////////////
-        _mbc[mb].iface = usrp2_iface::make(udp_simple::make_connected(
-            addr, BOOST_STRINGIZE(USRP2_UDP_CTRL_PORT)
-        ));
-        _tree->create<std::string>(mb_path / "name").set(_mbc[mb].iface->get_cname());
-        _tree->create<std::string>(mb_path / "fw_version").set(_mbc[mb].iface->get_fw_version_string());
-
-        //check the fpga compatibility number
-        const boost::uint32_t fpga_compat_num = _mbc[mb].iface->peek32(U2_REG_COMPAT_NUM_RB);
-        boost::uint16_t fpga_major = fpga_compat_num >> 16, fpga_minor = fpga_compat_num & 0xffff;
-        if (fpga_major == 0){ //old version scheme
-            fpga_major = fpga_minor;
-            fpga_minor = 0;
-        }
-        if (fpga_major != USRP2_FPGA_COMPAT_NUM){
-            throw uhd::runtime_error(str(boost::format(
-                "\nPlease update the firmware and FPGA images for your device.\n"
-                "See the application notes for USRP2/N-Series for instructions.\n"
-                "Expected FPGA compatibility number %d, but got %d:\n"
-                "The FPGA build is not compatible with the host code build."
-            ) % int(USRP2_FPGA_COMPAT_NUM) % fpga_major));
-        }
-        _tree->create<std::string>(mb_path / "fpga_version").set(str(boost::format("%u.%u") % fpga_major % fpga_minor));
-
-        //lock the device/motherboard to this process
-        _mbc[mb].iface->lock_device(true);
-
-        ////////////////////////////////////////////////////////////////
-        // construct transports for RX and TX DSPs
-        ////////////////////////////////////////////////////////////////
-        UHD_LOG << "Making transport for RX DSP0..." << std::endl;
-        _mbc[mb].rx_dsp_xports.push_back(make_xport(
-            addr, BOOST_STRINGIZE(USRP2_UDP_RX_DSP0_PORT), device_args_i, "recv"
-        ));
-        UHD_LOG << "Making transport for RX DSP1..." << std::endl;
-        _mbc[mb].rx_dsp_xports.push_back(make_xport(
-            addr, BOOST_STRINGIZE(USRP2_UDP_RX_DSP1_PORT), device_args_i, "recv"
-        ));
-        UHD_LOG << "Making transport for TX DSP0..." << std::endl;
-        _mbc[mb].tx_dsp_xport = make_xport(
-            addr, BOOST_STRINGIZE(USRP2_UDP_TX_DSP0_PORT), device_args_i, "send"
-        );
-        //set the filter on the router to take dsp data from this port
-        _mbc[mb].iface->poke32(U2_REG_ROUTER_CTRL_PORTS, USRP2_UDP_TX_DSP0_PORT);
-
-        ////////////////////////////////////////////////////////////////
-        // setup the mboard eeprom
-        ////////////////////////////////////////////////////////////////
-        _tree->create<mboard_eeprom_t>(mb_path / "eeprom")
-            .set(_mbc[mb].iface->mb_eeprom)
-            .subscribe(boost::bind(&usrp2_impl::set_mb_eeprom, this, mb, _1));
-
-        ////////////////////////////////////////////////////////////////
-        // create clock control objects
-        ////////////////////////////////////////////////////////////////
-        _mbc[mb].clock = usrp2_clock_ctrl::make(_mbc[mb].iface);
-        _tree->create<double>(mb_path / "tick_rate")
-            .publish(boost::bind(&usrp2_clock_ctrl::get_master_clock_rate, _mbc[mb].clock))
-            .subscribe(boost::bind(&usrp2_impl::update_tick_rate, this, _1));
-
-        ////////////////////////////////////////////////////////////////
-        // create codec control objects
-        ////////////////////////////////////////////////////////////////
-        const fs_path rx_codec_path = mb_path / "rx_codecs/A";
-        const fs_path tx_codec_path = mb_path / "tx_codecs/A";
-        _tree->create<int>(rx_codec_path / "gains"); //phony property so this dir exists
-        _tree->create<int>(tx_codec_path / "gains"); //phony property so this dir exists
-        _mbc[mb].codec = usrp2_codec_ctrl::make(_mbc[mb].iface);
-        switch(_mbc[mb].iface->get_rev()){
-        case usrp2_iface::USRP_N200:
-        case usrp2_iface::USRP_N210:
-        case usrp2_iface::USRP_N200_R4:
-        case usrp2_iface::USRP_N210_R4:{
-            _tree->create<std::string>(rx_codec_path / "name").set("ads62p44");
-            _tree->create<meta_range_t>(rx_codec_path / "gains/digital/range").set(meta_range_t(0, 6.0, 0.5));
-            _tree->create<double>(rx_codec_path / "gains/digital/value")
-                .subscribe(boost::bind(&usrp2_codec_ctrl::set_rx_digital_gain, _mbc[mb].codec, _1)).set(0);
-            _tree->create<meta_range_t>(rx_codec_path / "gains/fine/range").set(meta_range_t(0, 0.5, 0.05));
-            _tree->create<double>(rx_codec_path / "gains/fine/value")
-                .subscribe(boost::bind(&usrp2_codec_ctrl::set_rx_digital_fine_gain, _mbc[mb].codec, _1)).set(0);
-        }break;
-
-        case usrp2_iface::USRP2_REV3:
-        case usrp2_iface::USRP2_REV4:
-            _tree->create<std::string>(rx_codec_path / "name").set("ltc2284");
-            break;
-
-        case usrp2_iface::USRP_NXXX:
-            _tree->create<std::string>(rx_codec_path / "name").set("??????");
-            break;
-        }
-        _tree->create<std::string>(tx_codec_path / "name").set("ad9777");
-
-        ////////////////////////////////////////////////////////////////
-        // create gpsdo control objects
-        ////////////////////////////////////////////////////////////////
-        if (_mbc[mb].iface->mb_eeprom["gpsdo"] == "internal"){
-            _mbc[mb].gps = gps_ctrl::make(udp_simple::make_uart(udp_simple::make_connected(
-                addr, BOOST_STRINGIZE(USRP2_UDP_UART_GPS_PORT)
-            )));
-            if(_mbc[mb].gps->gps_detected()) {
-                BOOST_FOREACH(const std::string &name, _mbc[mb].gps->get_sensors()){
-                    _tree->create<sensor_value_t>(mb_path / "sensors" / name)
-                        .publish(boost::bind(&gps_ctrl::get_sensor, _mbc[mb].gps, name));
-                }
-            }
-        }
-
-        ////////////////////////////////////////////////////////////////
-        // and do the misc mboard sensors
-        ////////////////////////////////////////////////////////////////
-        _tree->create<sensor_value_t>(mb_path / "sensors/mimo_locked")
-            .publish(boost::bind(&usrp2_impl::get_mimo_locked, this, mb));
-        _tree->create<sensor_value_t>(mb_path / "sensors/ref_locked")
-            .publish(boost::bind(&usrp2_impl::get_ref_locked, this, mb));
-
-        ////////////////////////////////////////////////////////////////
-        // create frontend control objects
-        ////////////////////////////////////////////////////////////////
-        _mbc[mb].rx_fe = rx_frontend_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_RX_FRONT)
-        );
-        _mbc[mb].tx_fe = tx_frontend_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_TX_FRONT)
-        );
-        //TODO lots of properties to expose here for frontends
-        _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec")
-            .coerce(boost::bind(&usrp2_impl::update_rx_subdev_spec, this, mb, _1));
-        _tree->create<subdev_spec_t>(mb_path / "tx_subdev_spec")
-            .coerce(boost::bind(&usrp2_impl::update_tx_subdev_spec, this, mb, _1));
-
-        ////////////////////////////////////////////////////////////////
-        // create rx dsp control objects
-        ////////////////////////////////////////////////////////////////
-        _mbc[mb].rx_dsps.push_back(rx_dsp_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_RX_DSP0), U2_REG_SR_ADDR(SR_RX_CTRL0), USRP2_RX_SID_BASE + 0, true
-        ));
-        _mbc[mb].rx_dsps.push_back(rx_dsp_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_RX_DSP1), U2_REG_SR_ADDR(SR_RX_CTRL1), USRP2_RX_SID_BASE + 1, true
-        ));
-        for (size_t dspno = 0; dspno < _mbc[mb].rx_dsps.size(); dspno++){
-            _mbc[mb].rx_dsps[dspno]->set_link_rate(USRP2_LINK_RATE_BPS);
-            _tree->access<double>(mb_path / "tick_rate")
-                .subscribe(boost::bind(&rx_dsp_core_200::set_tick_rate, _mbc[mb].rx_dsps[dspno], _1));
-            //This is a hack/fix for the lingering packet problem.
-            //The dsp core starts streaming briefly... now we flush
-            _mbc[mb].rx_dsp_xports[dspno]->get_recv_buff(0.01).get(); //recv with timeout for lingering
-            _mbc[mb].rx_dsp_xports[dspno]->get_recv_buff(0.01).get(); //recv with timeout for expected
-            fs_path rx_dsp_path = mb_path / str(boost::format("rx_dsps/%u") % dspno);
-            _tree->create<double>(rx_dsp_path / "rate/value")
-                .coerce(boost::bind(&rx_dsp_core_200::set_host_rate, _mbc[mb].rx_dsps[dspno], _1))
-                .subscribe(boost::bind(&usrp2_impl::update_rx_samp_rate, this, _1));
-            _tree->create<double>(rx_dsp_path / "freq/value")
-                .coerce(boost::bind(&rx_dsp_core_200::set_freq, _mbc[mb].rx_dsps[dspno], _1));
-            _tree->create<meta_range_t>(rx_dsp_path / "freq/range")
-                .publish(boost::bind(&rx_dsp_core_200::get_freq_range, _mbc[mb].rx_dsps[dspno]));
-            _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
-                .subscribe(boost::bind(&rx_dsp_core_200::issue_stream_command, _mbc[mb].rx_dsps[dspno], _1));
-        }
-
-        ////////////////////////////////////////////////////////////////
-        // create tx dsp control objects
-        ////////////////////////////////////////////////////////////////
-        _mbc[mb].tx_dsp = tx_dsp_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_TX_DSP), U2_REG_SR_ADDR(SR_TX_CTRL), USRP2_TX_ASYNC_SID
-        );
-        _mbc[mb].tx_dsp->set_link_rate(USRP2_LINK_RATE_BPS);
-        _tree->access<double>(mb_path / "tick_rate")
-            .subscribe(boost::bind(&tx_dsp_core_200::set_tick_rate, _mbc[mb].tx_dsp, _1));
-        _tree->create<double>(mb_path / "tx_dsps/0/rate/value")
-            .coerce(boost::bind(&tx_dsp_core_200::set_host_rate, _mbc[mb].tx_dsp, _1))
-            .subscribe(boost::bind(&usrp2_impl::update_tx_samp_rate, this, _1));
-        _tree->create<double>(mb_path / "tx_dsps/0/freq/value")
-            .coerce(boost::bind(&usrp2_impl::set_tx_dsp_freq, this, mb, _1));
-        _tree->create<meta_range_t>(mb_path / "tx_dsps/0/freq/range")
-            .publish(boost::bind(&usrp2_impl::get_tx_dsp_freq_range, this, mb));
-
-        //setup dsp flow control
-        const double ups_per_sec = device_args_i.cast<double>("ups_per_sec", 20);
-        const size_t send_frame_size = _mbc[mb].tx_dsp_xport->get_send_frame_size();
-        const double ups_per_fifo = device_args_i.cast<double>("ups_per_fifo", 8.0);
-        _mbc[mb].tx_dsp->set_updates(
-            (ups_per_sec > 0.0)? size_t(100e6/*approx tick rate*//ups_per_sec) : 0,
-            (ups_per_fifo > 0.0)? size_t(USRP2_SRAM_BYTES/ups_per_fifo/send_frame_size) : 0
-        );
-
-        ////////////////////////////////////////////////////////////////
-        // create time control objects
-        ////////////////////////////////////////////////////////////////
-        time64_core_200::readback_bases_type time64_rb_bases;
-        time64_rb_bases.rb_secs_now = U2_REG_TIME64_SECS_RB_IMM;
-        time64_rb_bases.rb_ticks_now = U2_REG_TIME64_TICKS_RB_IMM;
-        time64_rb_bases.rb_secs_pps = U2_REG_TIME64_SECS_RB_PPS;
-        time64_rb_bases.rb_ticks_pps = U2_REG_TIME64_TICKS_RB_PPS;
-        _mbc[mb].time64 = time64_core_200::make(
-            _mbc[mb].iface, U2_REG_SR_ADDR(SR_TIME64), time64_rb_bases, mimo_clock_sync_delay_cycles
-        );
-        _tree->access<double>(mb_path / "tick_rate")
-            .subscribe(boost::bind(&time64_core_200::set_tick_rate, _mbc[mb].time64, _1));
-        _tree->create<time_spec_t>(mb_path / "time/now")
-            .publish(boost::bind(&time64_core_200::get_time_now, _mbc[mb].time64))
-            .subscribe(boost::bind(&time64_core_200::set_time_now, _mbc[mb].time64, _1));
-        _tree->create<time_spec_t>(mb_path / "time/pps")
-            .publish(boost::bind(&time64_core_200::get_time_last_pps, _mbc[mb].time64))
-            .subscribe(boost::bind(&time64_core_200::set_time_next_pps, _mbc[mb].time64, _1));
-        //setup time source props
-        _tree->create<std::string>(mb_path / "time_source/value")
-            .subscribe(boost::bind(&time64_core_200::set_time_source, _mbc[mb].time64, _1));
-        _tree->create<std::vector<std::string> >(mb_path / "time_source/options")
-            .publish(boost::bind(&time64_core_200::get_time_sources, _mbc[mb].time64));
-        //setup reference source props
-        _tree->create<std::string>(mb_path / "clock_source/value")
-            .subscribe(boost::bind(&usrp2_impl::update_clock_source, this, mb, _1));
-        static const std::vector<std::string> clock_sources = boost::assign::list_of("internal")("external")("mimo");
-        _tree->create<std::vector<std::string> >(mb_path / "clock_source/options").set(clock_sources);
-
-        ////////////////////////////////////////////////////////////////
-        // create dboard control objects
-        ////////////////////////////////////////////////////////////////
-
-        //read the dboard eeprom to extract the dboard ids
-        dboard_eeprom_t rx_db_eeprom, tx_db_eeprom, gdb_eeprom;
-        rx_db_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_RX_DB);
-        tx_db_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_TX_DB);
-        gdb_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_TX_DB ^ 5);
-
-        //create the properties and register subscribers
-        _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/rx_eeprom")
-            .set(rx_db_eeprom)
-            .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "rx", _1));
-        _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/tx_eeprom")
-            .set(tx_db_eeprom)
-            .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "tx", _1));
-        _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/gdb_eeprom")
-            .set(gdb_eeprom)
-            .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "gdb", _1));
-
-        //create a new dboard interface and manager
-        _mbc[mb].dboard_iface = make_usrp2_dboard_iface(_mbc[mb].iface, _mbc[mb].clock);
-        _tree->create<dboard_iface::sptr>(mb_path / "dboards/A/iface").set(_mbc[mb].dboard_iface);
-        _mbc[mb].dboard_manager = dboard_manager::make(
-            rx_db_eeprom.id,
-            ((gdb_eeprom.id == dboard_id_t::none())? tx_db_eeprom : gdb_eeprom).id,
-            _mbc[mb].dboard_iface
-        );
-        BOOST_FOREACH(const std::string &name, _mbc[mb].dboard_manager->get_rx_subdev_names()){
-            dboard_manager::populate_prop_tree_from_subdev(
-                _tree->subtree(mb_path / "dboards/A/rx_frontends" / name),
-                _mbc[mb].dboard_manager->get_rx_subdev(name)
-            );
+        _mbc[mb] = mb_container_type();
+        _tree->create<std::string>("/mboards/" + mb + "/name");
+    }
+    log_init_phase("Device setup", init_start);
+
+    //initialize each motherboard on its own thread
+    if (device_args.size() == 1) this->setup_mb(0, device_args[0]);
+    else{
+        std::vector<boost::shared_ptr<uhd::exception> > mb_errors(device_args.size());
+        boost::thread_group mb_threads;
+        for (size_t mbi = 0; mbi < device_args.size(); mbi++){
+            mb_threads.create_thread(boost::bind(
+                &usrp2_impl::setup_mb_task, this, mbi, device_args[mbi], boost::ref(mb_errors[mbi])
+            ));
         }
-        BOOST_FOREACH(const std::string &name, _mbc[mb].dboard_manager->get_tx_subdev_names()){
-            dboard_manager::populate_prop_tree_from_subdev(
-                _tree->subtree(mb_path / "dboards/A/tx_frontends" / name),
-                _mbc[mb].dboard_manager->get_tx_subdev(name)
-            );
+        mb_threads.join_all();
+        BOOST_FOREACH(const boost::shared_ptr<uhd::exception> &error, mb_errors){
+            if (error.get() != NULL) error->dynamic_throw();
         }
     }
+    log_init_phase("Motherboard init", init_start);
 
     //initialize io handling
     this->io_init();
+    log_init_phase("IO init", init_start);
 
     //do some post-init tasks
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
@@ -620,7 +403,333 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
             _mbc[mb].time64->set_time_next_pps(time_spec_t(time_t(_mbc[mb].gps->get_sensor("gps_time").to_int()+1)));
         }
     }
+    log_init_phase("Post init", init_start);
+}
+
+void usrp2_impl::setup_mb_task(
+    const size_t mbi, const device_addr_t &device_args_i, boost::shared_ptr<uhd::exception> &error
+){
+    try{
+        this->setup_mb(mbi, device_args_i);
+    }
+    catch(const uhd::exception &e){
+        error.reset(e.dynamic_clone());
+    }
+    catch(const std::exception &e){
+        error.reset(new uhd::runtime_error(e.what()));
+    }
+    catch(...){
+        error.reset(new uhd::runtime_error("unknown error in the setup of mboard " + boost::lexical_cast<std::string>(mbi)));
+    }
+}
+
+void usrp2_impl::setup_mb(const size_t mbi, const device_addr_t &device_args_i){
+    time_spec_t init_start = time_spec_t::get_system_time();
+    const std::string mb = boost::lexical_cast<std::string>(mbi);
+    const std::string addr = device_args_i["addr"];
+    const fs_path mb_path = "/mboards/" + mb;
+
+    ////////////////////////////////////////////////////////////////////
+    // create the iface that controls i2c, spi, uart, and wb
+    ////////////////////////////////////////////////////////////////////
+    _mbc[mb].iface = usrp2_iface::make(udp_simple::make_connected(
+        addr, BOOST_STRINGIZE(USRP2_UDP_CTRL_PORT)
+    ));
+    _tree->access<std::string>(mb_path / "name").set(_mbc[mb].iface->get_cname());
+
+    //the dsp, frontend, and gpio settings hold state: skip rewrites of the same values
+    _mbc[mb].wbiface = wb_shadow_iface::make(_mbc[mb].iface);
+    _mbc[mb].wbiface->set_shadowed(U2_REG_SR_ADDR(SR_RX_FRONT), U2_REG_SR_ADDR(SR_RX_FRONT + 4));
+    _mbc[mb].wbiface->set_shadowed(U2_REG_SR_ADDR(SR_RX_DSP0), U2_REG_SR_ADDR(SR_RX_DSP0 + 6));
+    _mbc[mb].wbiface->set_shadowed(U2_REG_SR_ADDR(SR_RX_DSP1), U2_REG_SR_ADDR(SR_RX_DSP1 + 6));
+    _mbc[mb].wbiface->set_shadowed(U2_REG_SR_ADDR(SR_TX_FRONT), U2_REG_SR_ADDR(SR_TX_FRONT + 4));
+    _mbc[mb].wbiface->set_shadowed(U2_REG_SR_ADDR(SR_TX_DSP), U2_REG_SR_ADDR(SR_TX_DSP + 4));
+    _mbc[mb].wbiface->set_shadowed(GPIO_BASE, GPIO_BASE + 16);
+    _tree->create<std::string>(mb_path / "fw_version").set(_mbc[mb].iface->get_fw_version_string());
+
+    //check the fpga compatibility number
+    const boost::uint32_t fpga_compat_num = _mbc[mb].iface->peek32(U2_REG_COMPAT_NUM_RB);
+    boost::uint16_t fpga_major = fpga_compat_num >> 16, fpga_minor = fpga_compat_num & 0xffff;
+    if (fpga_major == 0){ //old version scheme
+        fpga_major = fpga_minor;
+        fpga_minor = 0;
+    }
+    if (fpga_major != USRP2_FPGA_COMPAT_NUM){
+        throw uhd::runtime_error(str(boost::format(
+            "\nPlease update the firmware and FPGA images for your device.\n"
+            "See the application notes for USRP2/N-Series for instructions.\n"
+            "Expected FPGA compatibility number %d, but got %d:\n"
+            "The FPGA build is not compatible with the host code build."
+        ) % int(USRP2_FPGA_COMPAT_NUM) % fpga_major));
+    }
+    _tree->create<std::string>(mb_path / "fpga_version").set(str(boost::format("%u.%u") % fpga_major % fpga_minor));
+
+    //lock the device/motherboard to this process
+    _mbc[mb].iface->lock_device(true);
+    log_init_phase("Mboard " + mb + " control", init_start);
+
+    ////////////////////////////////////////////////////////////////////
+    // construct transports for RX and TX DSPs
+    ////////////////////////////////////////////////////////////////////
+    UHD_LOG << "Making transport for RX DSP0..." << std::endl;
+    _mbc[mb].rx_dsp_xports.push_back(make_xport(
+        addr, BOOST_STRINGIZE(USRP2_UDP_RX_DSP0_PORT), device_args_i, "recv"
+    ));
+    UHD_LOG << "Making transport for RX DSP1..." << std::endl;
+    _mbc[mb].rx_dsp_xports.push_back(make_xport(
+        addr, BOOST_STRINGIZE(USRP2_UDP_RX_DSP1_PORT), device_args_i, "recv"
+    ));
+    if (device_args_i.has_key("recv_prefetch")){
+        //drain each rx dsp socket from a background reader thread
+        for (size_t dspno = 0; dspno < _mbc[mb].rx_dsp_xports.size(); dspno++){
+            device_addr_t prefetch_hints;
+            if (device_args_i.has_key("recv_prefetch_cpu")){
+                //pin each reader to its own core, counting up from the given core
+                const size_t cpu = size_t(device_args_i.cast<double>("recv_prefetch_cpu", 0))
+                    + mbi*_mbc[mb].rx_dsp_xports.size() + dspno;
+                prefetch_hints["prefetch_cpu"] = boost::lexical_cast<std::string>(cpu);
+            }
+            UHD_LOG << "Making prefetch reader for RX DSP" << dspno << "..." << std::endl;
+            _mbc[mb].rx_dsp_xports[dspno] = zero_copy_prefetch::make(
+                _mbc[mb].rx_dsp_xports[dspno], prefetch_hints
+            );
+        }
+    }
+    UHD_LOG << "Making transport for TX DSP0..." << std::endl;
+    _mbc[mb].tx_dsp_xport = make_xport(
+        addr, BOOST_STRINGIZE(USRP2_UDP_TX_DSP0_PORT), device_args_i, "send"
+    );
+    //set the filter on the router to take dsp data from this port
+    _mbc[mb].iface->poke32(U2_REG_ROUTER_CTRL_PORTS, USRP2_UDP_TX_DSP0_PORT);
+
+    log_init_phase("Mboard " + mb + " transports", init_start);
+
+    ////////////////////////////////////////////////////////////////////
+    // setup the mboard eeprom
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<mboard_eeprom_t>(mb_path / "eeprom")
+        .set(_mbc[mb].iface->mb_eeprom)
+        .subscribe(boost::bind(&usrp2_impl::set_mb_eeprom, this, mb, _1));
+
+    ////////////////////////////////////////////////////////////////////
+    // create clock control objects
+    ////////////////////////////////////////////////////////////////////
+    _mbc[mb].clock = usrp2_clock_ctrl::make(_mbc[mb].iface);
+    _tree->create<double>(mb_path / "tick_rate")
+        .publish(boost::bind(&usrp2_clock_ctrl::get_master_clock_rate, _mbc[mb].clock))
+        .subscribe(boost::bind(&usrp2_impl::update_tick_rate, this, _1));
+
+    ////////////////////////////////////////////////////////////////////
+    // create codec control objects
+    ////////////////////////////////////////////////////////////////////
+    const fs_path rx_codec_path = mb_path / "rx_codecs/A";
+    const fs_path tx_codec_path = mb_path / "tx_codecs/A";
+    _tree->create<int>(rx_codec_path / "gains"); //phony property so this dir exists
+    _tree->create<int>(tx_codec_path / "gains"); //phony property so this dir exists
+    _mbc[mb].codec = usrp2_codec_ctrl::make(_mbc[mb].iface);
+    switch(_mbc[mb].iface->get_rev()){
+    case usrp2_iface::USRP_N200:
+    case usrp2_iface::USRP_N210:
+    case usrp2_iface::USRP_N200_R4:
+    case usrp2_iface::USRP_N210_R4:{
+        _tree->create<std::string>(rx_codec_path / "name").set("ads62p44");
+        _tree->create<meta_range_t>(rx_codec_path / "gains/digital/range").set(meta_range_t(0, 6.0, 0.5));
+        _tree->create<double>(rx_codec_path / "gains/digital/value")
+            .subscribe(boost::bind(&usrp2_codec_ctrl::set_rx_digital_gain, _mbc[mb].codec, _1)).set(0);
+        _tree->create<meta_range_t>(rx_codec_path / "gains/fine/range").set(meta_range_t(0, 0.5, 0.05));
+        _tree->create<double>(rx_codec_path / "gains/fine/value")
+            .subscribe(boost::bind(&usrp2_codec_ctrl::set_rx_digital_fine_gain, _mbc[mb].codec, _1)).set(0);
+    }break;
 
+    case usrp2_iface::USRP2_REV3:
+    case usrp2_iface::USRP2_REV4:
+        _tree->create<std::string>(rx_codec_path / "name").set("ltc2284");
+        break;
+
+    case usrp2_iface::USRP_NXXX:
+        _tree->create<std::string>(rx_codec_path / "name").set("??????");
+        break;
+    }
+    _tree->create<std::string>(tx_codec_path / "name").set("ad9777");
+
+    ////////////////////////////////////////////////////////////////////
+    // create gpsdo control objects
+    ////////////////////////////////////////////////////////////////////
+    if (_mbc[mb].iface->mb_eeprom["gpsdo"] == "internal"){
+        _mbc[mb].gps = gps_ctrl::make(udp_simple::make_uart(udp_simple::make_connected(
+            addr, BOOST_STRINGIZE(USRP2_UDP_UART_GPS_PORT)
+        )));
+        if(_mbc[mb].gps->gps_detected()) {
+            BOOST_FOREACH(const std::string &name, _mbc[mb].gps->get_sensors()){
+                _tree->create<sensor_value_t>(mb_path / "sensors" / name)
+                    .publish(boost::bind(&gps_ctrl::get_sensor, _mbc[mb].gps, name));
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // and do the misc mboard sensors
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<sensor_value_t>(mb_path / "sensors/mimo_locked")
+        .publish(boost::bind(&usrp2_impl::get_mimo_locked, this, mb));
+    _tree->create<sensor_value_t>(mb_path / "sensors/ref_locked")
+        .publish(boost::bind(&usrp2_impl::get_ref_locked, this, mb));
+
+    ////////////////////////////////////////////////////////////////////
+    // create frontend control objects
+    ////////////////////////////////////////////////////////////////////
+    _mbc[mb].rx_fe = rx_frontend_core_200::make(
+        _mbc[mb].wbiface, U2_REG_SR_ADDR(SR_RX_FRONT)
+    );
+    _mbc[mb].tx_fe = tx_frontend_core_200::make(
+        _mbc[mb].wbiface, U2_REG_SR_ADDR(SR_TX_FRONT)
+    );
+    //TODO lots of properties to expose here for frontends
+    _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec")
+        .coerce(boost::bind(&usrp2_impl::update_rx_subdev_spec, this, mb, _1));
+    _tree->create<subdev_spec_t>(mb_path / "tx_subdev_spec")
+        .coerce(boost::bind(&usrp2_impl::update_tx_subdev_spec, this, mb, _1));
+
+    ////////////////////////////////////////////////////////////////////
+    // create rx dsp control objects
+    ////////////////////////////////////////////////////////////////////
+    _mbc[mb].rx_dsps.push_back(rx_dsp_core_200::make(
+        _mbc[mb].wbiface, U2_REG_SR_ADDR(SR_RX_DSP0), U2_REG_SR_ADDR(SR_RX_CTRL0), USRP2_RX_SID_BASE + 0, true
+    ));
+    _mbc[mb].rx_dsps.push_back(rx_dsp_core_200::make(
+        _mbc[mb].wbiface, U2_REG_SR_ADDR(SR_RX_DSP1), U2_REG_SR_ADDR(SR_RX_CTRL1), USRP2_RX_SID_BASE + 1, true
+    ));
+    for (size_t dspno = 0; dspno < _mbc[mb].rx_dsps.size(); dspno++){
+        _mbc[mb].rx_dsps[dspno]->set_link_rate(USRP2_LINK_RATE_BPS);
+        _tree->access<double>(mb_path / "tick_rate")
+            .subscribe(boost::bind(&rx_dsp_core_200::set_tick_rate, _mbc[mb].rx_dsps[dspno], _1));
+        //This is a hack/fix for the lingering packet problem.
+        //The dsp core starts streaming briefly... now we flush
+        _mbc[mb].rx_dsp_xports[dspno]->get_recv_buff(0.01).get(); //recv with timeout for lingering
+        _mbc[mb].rx_dsp_xports[dspno]->get_recv_buff(0.01).get(); //recv with timeout for expected
+        fs_path rx_dsp_path = mb_path / str(boost::format("rx_dsps/%u") % dspno);
+        _tree->create<double>(rx_dsp_path / "rate/value")
+            .coerce(boost::bind(&rx_dsp_core_200::set_host_rate, _mbc[mb].rx_dsps[dspno], _1))
+            .subscribe(boost::bind(&usrp2_impl::update_rx_samp_rate, this, _1));
+        _tree->create<double>(rx_dsp_path / "freq/value")
+            .coerce(boost::bind(&rx_dsp_core_200::set_freq, _mbc[mb].rx_dsps[dspno], _1));
+        _tree->create<meta_range_t>(rx_dsp_path / "freq/range")
+            .publish(boost::bind(&rx_dsp_core_200::get_freq_range, _mbc[mb].rx_dsps[dspno]));
+        _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
+            .subscribe(boost::bind(&rx_dsp_core_200::issue_stream_command, _mbc[mb].rx_dsps[dspno], _1));
+        //expose the prefetch ring statistics when enabled
+        zero_copy_prefetch::sptr prefetch_xport =
+            boost::dynamic_pointer_cast<zero_copy_prefetch>(_mbc[mb].rx_dsp_xports[dspno]);
+        if (prefetch_xport.get() != NULL){
+            _tree->create<size_t>(rx_dsp_path / "prefetch/depth")
+                .set(prefetch_xport->get_prefetch_depth());
+            _tree->create<size_t>(rx_dsp_path / "prefetch/prefetched")
+                .publish(boost::bind(&zero_copy_prefetch::get_num_prefetched_frames, prefetch_xport));
+            _tree->create<size_t>(rx_dsp_path / "prefetch/dropped")
+                .publish(boost::bind(&zero_copy_prefetch::get_num_dropped_frames, prefetch_xport));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // create tx dsp control objects
+    ////////////////////////////////////////////////////////////////////
+    _mbc[mb].tx_dsp = tx_dsp_core_200::make(
+        _mbc[mb].wbiface, U2_REG_SR_ADDR(SR_TX_DSP), U2_REG_SR_ADDR(SR_TX_CTRL), USRP2_TX_ASYNC_SID
+    );
+    _mbc[mb].tx_dsp->set_link_rate(USRP2_LINK_RATE_BPS);
+    _tree->access<double>(mb_path / "tick_rate")
+        .subscribe(boost::bind(&tx_dsp_core_200::set_tick_rate, _mbc[mb].tx_dsp, _1));
+    _tree->create<double>(mb_path / "tx_dsps/0/rate/value")
+        .coerce(boost::bind(&tx_dsp_core_200::set_host_rate, _mbc[mb].tx_dsp, _1))
+        .subscribe(boost::bind(&usrp2_impl::update_tx_samp_rate, this, _1));
+    _tree->create<double>(mb_path / "tx_dsps/0/freq/value")
+        .coerce(boost::bind(&usrp2_impl::set_tx_dsp_freq, this, mb, _1));
+    _tree->create<meta_range_t>(mb_path / "tx_dsps/0/freq/range")
+        .publish(boost::bind(&usrp2_impl::get_tx_dsp_freq_range, this, mb));
+
+    //setup dsp flow control
+    const double ups_per_sec = device_args_i.cast<double>("ups_per_sec", 20);
+    const size_t send_frame_size = _mbc[mb].tx_dsp_xport->get_send_frame_size();
+    const double ups_per_fifo = device_args_i.cast<double>("ups_per_fifo", 8.0);
+    _mbc[mb].tx_dsp->set_updates(
+        (ups_per_sec > 0.0)? size_t(100e6/*approx tick rate*//ups_per_sec) : 0,
+        (ups_per_fifo > 0.0)? size_t(USRP2_SRAM_BYTES/ups_per_fifo/send_frame_size) : 0
+    );
+
+    ////////////////////////////////////////////////////////////////////
+    // create time control objects
+    ////////////////////////////////////////////////////////////////////
+    time64_core_200::readback_bases_type time64_rb_bases;
+    time64_rb_bases.rb_secs_now = U2_REG_TIME64_SECS_RB_IMM;
+    time64_rb_bases.rb_ticks_now = U2_REG_TIME64_TICKS_RB_IMM;
+    time64_rb_bases.rb_secs_pps = U2_REG_TIME64_SECS_RB_PPS;
+    time64_rb_bases.rb_ticks_pps = U2_REG_TIME64_TICKS_RB_PPS;
+    _mbc[mb].time64 = time64_core_200::make(
+        _mbc[mb].iface, U2_REG_SR_ADDR(SR_TIME64), time64_rb_bases, mimo_clock_sync_delay_cycles
+    );
+    _tree->access<double>(mb_path / "tick_rate")
+        .subscribe(boost::bind(&time64_core_200::set_tick_rate, _mbc[mb].time64, _1));
+    _tree->create<time_spec_t>(mb_path / "time/now")
+        .publish(boost::bind(&time64_core_200::get_time_now, _mbc[mb].time64))
+        .subscribe(boost::bind(&time64_core_200::set_time_now, _mbc[mb].time64, _1));
+    _tree->create<time_spec_t>(mb_path / "time/pps")
+        .publish(boost::bind(&time64_core_200::get_time_last_pps, _mbc[mb].time64))
+        .subscribe(boost::bind(&time64_core_200::set_time_next_pps, _mbc[mb].time64, _1));
+    //setup time source props
+    _tree->create<std::string>(mb_path / "time_source/value")
+        .subscribe(boost::bind(&time64_core_200::set_time_source, _mbc[mb].time64, _1));
+    _tree->create<std::vector<std::string> >(mb_path / "time_source/options")
+        .publish(boost::bind(&time64_core_200::get_time_sources, _mbc[mb].time64));
+    //setup reference source props
+    _tree->create<std::string>(mb_path / "clock_source/value")
+        .subscribe(boost::bind(&usrp2_impl::update_clock_source, this, mb, _1));
+    const std::vector<std::string> clock_sources = boost::assign::list_of("internal")("external")("mimo");
+    _tree->create<std::vector<std::string> >(mb_path / "clock_source/options").set(clock_sources);
+
+    log_init_phase("Mboard " + mb + " cores", init_start);
+
+    ////////////////////////////////////////////////////////////////////
+    // create dboard control objects
+    ////////////////////////////////////////////////////////////////////
+
+    //read the dboard eeprom to extract the dboard ids
+    dboard_eeprom_t rx_db_eeprom, tx_db_eeprom, gdb_eeprom;
+    rx_db_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_RX_DB);
+    tx_db_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_TX_DB);
+    gdb_eeprom.load(*_mbc[mb].iface, USRP2_I2C_ADDR_TX_DB ^ 5);
+
+    //create the properties and register subscribers
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/rx_eeprom")
+        .set(rx_db_eeprom)
+        .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "rx", _1));
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/tx_eeprom")
+        .set(tx_db_eeprom)
+        .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "tx", _1));
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards/A/gdb_eeprom")
+        .set(gdb_eeprom)
+        .subscribe(boost::bind(&usrp2_impl::set_db_eeprom, this, mb, "gdb", _1));
+
+    //create a new dboard interface and manager
+    _mbc[mb].dboard_iface = make_usrp2_dboard_iface(_mbc[mb].iface, _mbc[mb].wbiface, _mbc[mb].clock);
+    _tree->create<dboard_iface::sptr>(mb_path / "dboards/A/iface").set(_mbc[mb].dboard_iface);
+    _mbc[mb].dboard_manager = dboard_manager::make(
+        rx_db_eeprom.id,
+        ((gdb_eeprom.id == dboard_id_t::none())? tx_db_eeprom : gdb_eeprom).id,
+        _mbc[mb].dboard_iface
+    );
+    BOOST_FOREACH(const std::string &name, _mbc[mb].dboard_manager->get_rx_subdev_names()){
+        dboard_manager::populate_prop_tree_from_subdev(
+            _tree->subtree(mb_path / "dboards/A/rx_frontends" / name),
+            _mbc[mb].dboard_manager->get_rx_subdev(name)
+        );
+    }
+    BOOST_FOREACH(const std::string &name, _mbc[mb].dboard_manager->get_tx_subdev_names()){
+        dboard_manager::populate_prop_tree_from_subdev(
+            _tree->subtree(mb_path / "dboards/A/tx_frontends" / name),
+            _mbc[mb].dboard_manager->get_tx_subdev(name)
+        );
+    }
+    log_init_phase("Mboard " + mb + " dboards", init_start);
 }
 
 usrp2_impl::~usrp2_impl(void){UHD_SAFE_CALL(
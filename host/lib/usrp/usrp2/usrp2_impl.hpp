@@ -26,6 +26,7 @@
 #include "rx_dsp_core_200.hpp"
 #include "tx_dsp_core_200.hpp"
 #include "time64_core_200.hpp"
+#include "wb_shadow_iface.hpp"
 #include <uhd/property_tree.hpp>
 #include <uhd/usrp/gps_ctrl.hpp>
 #include <uhd/device.hpp>
@@ -34,6 +35,7 @@
 #include <uhd/types/otw_type.hpp>
 #include <uhd/types/stream_cmd.hpp>
 #include <uhd/types/clock_config.hpp>
+#include <uhd/exception.hpp>
 #include <uhd/usrp/dboard_eeprom.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
@@ -59,6 +61,7 @@ static const boost::uint32_t USRP2_RX_SID_BASE = 3;
  */
 uhd::usrp::dboard_iface::sptr make_usrp2_dboard_iface(
     usrp2_iface::sptr iface,
+    wb_iface::sptr wbiface,
     usrp2_clock_ctrl::sptr clk_ctrl
 );
 
@@ -83,6 +86,8 @@ public:
         uhd::rx_metadata_t &, const uhd::io_type_t &,
         uhd::device::recv_mode_t, double
     );
+    recv_lease_type borrow_recv(recv_views_type &, uhd::rx_metadata_t &, double);
+    send_commit_type borrow_send(send_views_type &, const uhd::tx_metadata_t &, double);
     size_t get_max_send_samps_per_packet(void) const;
     size_t get_max_recv_samps_per_packet(void) const;
     bool recv_async_msg(uhd::async_metadata_t &, double);
@@ -91,6 +96,7 @@ private:
     uhd::property_tree::sptr _tree;
     struct mb_container_type{
         usrp2_iface::sptr iface;
+        wb_shadow_iface::sptr wbiface;
         usrp2_clock_ctrl::sptr clock;
         usrp2_codec_ctrl::sptr codec;
         uhd::gps_ctrl::sptr gps;
@@ -108,6 +114,9 @@ private:
     };
     uhd::dict<std::string, mb_container_type> _mbc;
 
+    void setup_mb(const size_t, const uhd::device_addr_t &);
+    void setup_mb_task(const size_t, const uhd::device_addr_t &, boost::shared_ptr<uhd::exception> &);
+
     void set_mb_eeprom(const std::string &, const uhd::usrp::mboard_eeprom_t &);
     void set_db_eeprom(const std::string &, const std::string &, const uhd::usrp::dboard_eeprom_t &);
 
@@ -121,10 +130,21 @@ private:
 
     //io impl methods and members
     uhd::otw_type_t _rx_otw_type, _tx_otw_type;
+    size_t _recv_buff_size;
+    size_t _recv_convert_threads;
+    int _recv_convert_cpu;
+    std::string _recv_gap_mode;
     UHD_PIMPL_DECL(io_impl) _io_impl;
     void io_init(void);
     void update_tick_rate(const double rate);
     void update_rx_samp_rate(const double rate);
+    void update_rx_post_stage(void);
+    void apply_rx_post_stage(void);
+    size_t coerce_rx_post_nfft(const size_t);
+    size_t coerce_rx_post_decim(const size_t);
+    double coerce_rx_post_freq(const double);
+    size_t get_rx_symbol_offset(void);
+    void set_rx_symbol_offset(const size_t);
     void update_tx_samp_rate(const double rate);
     //update spec methods are coercers until we only accept db_name == A
     uhd::usrp::subdev_spec_t update_rx_subdev_spec(const std::string &, const uhd::usrp::subdev_spec_t &);
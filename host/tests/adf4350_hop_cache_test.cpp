@@ -0,0 +1,175 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "adf4350_hop_cache.hpp"
+#include <uhd/exception.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+
+/***********************************************************************
+ * A synthesizer that records the computations and the spi writes:
+ * The frequency sets R0 (int and frac), the band sets R4 (power),
+ * and the reference clock rate sets R2 (the reference divider).
+ **********************************************************************/
+class fake_synth{
+public:
+    fake_synth(void): rate(10e6), num_computes(0), fail_at(~size_t(0)){ /* NOP */ }
+
+    double compute(double target_freq, adf4350_regs_t &regs){
+        num_computes++;
+        regs.int_16_bit = boost::uint16_t(target_freq/1e6);
+        regs.frac_12_bit = boost::uint16_t(size_t(target_freq/1e3) % 1000);
+        regs.output_power = (target_freq > 2e9)?
+            adf4350_regs_t::OUTPUT_POWER_2DBM : adf4350_regs_t::OUTPUT_POWER_5DBM;
+        regs.r_counter_10_bit = boost::uint16_t(rate/1e6);
+        return target_freq + rate/1e6;
+    }
+
+    void write(boost::uint32_t word){
+        if (writes.size() == fail_at) throw uhd::runtime_error("fake spi failure");
+        writes.push_back(word);
+    }
+
+    double get_rate(void){
+        return rate;
+    }
+
+    //the address of a register word is in the control bits
+    static size_t addr(boost::uint32_t word){
+        return word & 0x7;
+    }
+
+    adf4350_hop_cache::sptr make_cache(void){
+        return adf4350_hop_cache::make(
+            boost::bind(&fake_synth::compute, this, _1, _2),
+            boost::bind(&fake_synth::write, this, _1),
+            boost::bind(&fake_synth::get_rate, this),
+            "fake"
+        );
+    }
+
+    double rate;
+    size_t num_computes;
+    size_t fail_at; //the number of writes before a failure
+    std::vector<boost::uint32_t> writes;
+};
+
+BOOST_AUTO_TEST_CASE(test_hop_cache_diffed_writes){
+    fake_synth synth;
+    adf4350_hop_cache::sptr cache = synth.make_cache();
+
+    //the first tune writes every register, 5 down to 0
+    BOOST_CHECK_EQUAL(cache->tune(1e9), 1e9 + 10);
+    BOOST_REQUIRE_EQUAL(synth.writes.size(), size_t(6));
+    for (size_t i = 0; i < 6; i++){
+        BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[i]), 5 - i);
+    }
+    BOOST_CHECK_EQUAL(cache->get_timing().num_writes, size_t(6));
+
+    //a new frequency in the same band only changes R0
+    synth.writes.clear();
+    cache->tune(1.5e9);
+    BOOST_REQUIRE_EQUAL(synth.writes.size(), size_t(1));
+    BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[0]), size_t(0));
+
+    //a new band changes R4, and R0 is still written last
+    synth.writes.clear();
+    cache->tune(2.5e9);
+    BOOST_REQUIRE_EQUAL(synth.writes.size(), size_t(2));
+    BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[0]), size_t(4));
+    BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[1]), size_t(0));
+
+    //the same frequency again still writes R0 to relock
+    synth.writes.clear();
+    cache->tune(2.5e9);
+    BOOST_REQUIRE_EQUAL(synth.writes.size(), size_t(1));
+    BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[0]), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_hop_cache_table){
+    fake_synth synth;
+    adf4350_hop_cache::sptr cache = synth.make_cache();
+
+    //the table computes every frequency once
+    std::vector<double> freqs;
+    freqs.push_back(3e9);
+    freqs.push_back(1e9);
+    cache->set_hop_freqs(freqs);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(2));
+    BOOST_REQUIRE_EQUAL(cache->get_hop_freqs().size(), size_t(2));
+    BOOST_CHECK_EQUAL(cache->get_hop_freqs()[0], 1e9);
+
+    //a frequency in the table is a lookup
+    BOOST_CHECK_EQUAL(cache->tune(3e9), 3e9 + 10);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(2));
+    BOOST_CHECK(cache->get_timing().precomputed);
+
+    //any other frequency is computed
+    BOOST_CHECK_EQUAL(cache->tune(2e9), 2e9 + 10);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(3));
+    BOOST_CHECK(not cache->get_timing().precomputed);
+
+    //an empty list clears the table
+    cache->set_hop_freqs(std::vector<double>());
+    BOOST_CHECK(cache->get_hop_freqs().empty());
+    cache->tune(3e9);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(4));
+}
+
+BOOST_AUTO_TEST_CASE(test_hop_cache_invalidate){
+    fake_synth synth;
+    adf4350_hop_cache::sptr cache = synth.make_cache();
+    cache->tune(1e9);
+
+    //after a failed write, every register is written again
+    synth.writes.clear();
+    synth.fail_at = 1;
+    BOOST_CHECK_THROW(cache->tune(2.5e9), uhd::runtime_error);
+    synth.fail_at = ~size_t(0);
+    synth.writes.clear();
+    cache->tune(2.5e9);
+    BOOST_CHECK_EQUAL(synth.writes.size(), size_t(6));
+
+    //after an invalidate, every register is written again
+    cache->invalidate();
+    synth.writes.clear();
+    cache->tune(2.5e9);
+    BOOST_CHECK_EQUAL(synth.writes.size(), size_t(6));
+}
+
+BOOST_AUTO_TEST_CASE(test_hop_cache_rate_change){
+    fake_synth synth;
+    adf4350_hop_cache::sptr cache = synth.make_cache();
+    std::vector<double> freqs(1, 1e9);
+    cache->set_hop_freqs(freqs);
+    cache->tune(1e9);
+
+    //the table is recomputed for the new reference clock
+    synth.rate = 20e6;
+    synth.num_computes = 0;
+    synth.writes.clear();
+    BOOST_CHECK_EQUAL(cache->tune(1e9), 1e9 + 20);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(1));
+    BOOST_CHECK(cache->get_timing().precomputed);
+    BOOST_REQUIRE_EQUAL(synth.writes.size(), size_t(2)); //R2 and R0
+    BOOST_CHECK_EQUAL(fake_synth::addr(synth.writes[0]), size_t(2));
+
+    //the recomputed table is used from then on
+    BOOST_CHECK_EQUAL(cache->tune(1e9), 1e9 + 20);
+    BOOST_CHECK_EQUAL(synth.num_computes, size_t(1));
+}
@@ -16,13 +16,21 @@
 //
 
 #include <uhd/convert.hpp>
+#include <uhd/utils/byteswap.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/foreach.hpp>
 #include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
 #include <complex>
+#include <cmath>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <sstream>
 
 using namespace uhd;
 
@@ -260,3 +268,343 @@ BOOST_AUTO_TEST_CASE(test_convert_types_sc16_to_fc32){
         MY_CHECK_CLOSE(input[i].imag()/float(32767), output[i].imag(), float(0.01));
     }
 }
+
+/***********************************************************************
+ * Test the multi-channel converters:
+ * Interleave width channels into items, check the exact items,
+ * and convert back. The lengths cover the vectorized block sizes.
+ **********************************************************************/
+static boost::uint32_t expected_item32(const sc16_t &num, const otw_type_t &otw_type){
+    const boost::uint32_t item = (boost::uint32_t(boost::uint16_t(num.real())) << 16) | boost::uint16_t(num.imag());
+    return (otw_type.byteorder == otw_type_t::BO_BIG_ENDIAN)? uhd::htonx(item) : uhd::htowx(item);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_multi_width){
+    io_type_t io_type(io_type_t::COMPLEX_INT16);
+    io_type_t fc32_io_type(io_type_t::COMPLEX_FLOAT32);
+    otw_type_t otw_type;
+    otw_type.width = 16;
+
+    for (size_t bo = 0; bo < 2; bo++) for (size_t width = 1; width <= 4; width++){
+        otw_type.byteorder = (bo == 0)? otw_type_t::BO_BIG_ENDIAN : otw_type_t::BO_LITTLE_ENDIAN;
+        for (size_t nsamps = 1; nsamps < 40; nsamps++){
+            std::vector<std::vector<sc16_t> > input(width, std::vector<sc16_t>(nsamps));
+            std::vector<std::vector<sc16_t> > output(width, std::vector<sc16_t>(nsamps));
+            std::vector<std::vector<fc32_t> > fc32_output(width, std::vector<fc32_t>(nsamps));
+            std::vector<boost::uint32_t> interm(nsamps*width);
+            std::vector<const void *> input0, input1(1, &interm[0]);
+            std::vector<void *> output0(1, &interm[0]), output1, fc32_output1;
+            for (size_t w = 0; w < width; w++){
+                BOOST_FOREACH(sc16_t &in, input[w]) in = sc16_t(
+                    std::rand()-(RAND_MAX/2),
+                    std::rand()-(RAND_MAX/2)
+                );
+                input0.push_back(&input[w][0]);
+                output1.push_back(&output[w][0]);
+                fc32_output1.push_back(&fc32_output[w][0]);
+            }
+
+            //convert to the interleaved items and check them
+            convert::get_converter_cpu_to_otw(
+                io_type, otw_type, input0.size(), output0.size()
+            )(input0, output0, nsamps, 32767.);
+            for (size_t i = 0; i < nsamps; i++) for (size_t w = 0; w < width; w++){
+                BOOST_CHECK_EQUAL(interm[i*width + w], expected_item32(input[w][i], otw_type));
+            }
+
+            //convert back to every channel
+            convert::get_converter_otw_to_cpu(
+                io_type, otw_type, input1.size(), output1.size()
+            )(input1, output1, nsamps, 1/32767.);
+            convert::get_converter_otw_to_cpu(
+                fc32_io_type, otw_type, input1.size(), fc32_output1.size()
+            )(input1, fc32_output1, nsamps, 1/32767.);
+            for (size_t w = 0; w < width; w++){
+                BOOST_CHECK_EQUAL_COLLECTIONS(input[w].begin(), input[w].end(), output[w].begin(), output[w].end());
+                for (size_t i = 0; i < nsamps; i++){
+                    MY_CHECK_CLOSE(input[w][i].real()/float(32767), fc32_output[w][i].real(), float(0.01));
+                    MY_CHECK_CLOSE(input[w][i].imag()/float(32767), fc32_output[w][i].imag(), float(0.01));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_long_floats){
+    otw_type_t otw_type;
+    otw_type.width = 16;
+
+    //lengths past the vectorized block sizes, with unaligned starts
+    for (size_t bo = 0; bo < 2; bo++){
+        otw_type.byteorder = (bo == 0)? otw_type_t::BO_BIG_ENDIAN : otw_type_t::BO_LITTLE_ENDIAN;
+        for (size_t nsamps = 16; nsamps < 80; nsamps += 7){
+            test_convert_types_for_floats<fc32_t>(nsamps, io_type_t::COMPLEX_FLOAT32, otw_type);
+            test_convert_types_for_floats<fc64_t>(nsamps, io_type_t::COMPLEX_FLOAT64, otw_type);
+            test_convert_types_sc16(nsamps, io_type_t::COMPLEX_INT16, otw_type);
+        }
+    }
+}
+
+/***********************************************************************
+ * Test the sc8 wire format:
+ * Two samples per item, the first sample in the upper half.
+ * Check the exact items, the padding of an odd sample,
+ * and a conversion that starts in the middle of an item.
+ **********************************************************************/
+static boost::uint32_t sc8_bits(const sc16_t &num){
+    return (boost::uint32_t(boost::uint8_t(num.real() >> 8)) << 8) | boost::uint8_t(num.imag() >> 8);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_sc8){
+    otw_type_t otw_type;
+    otw_type.width = 8;
+    BOOST_CHECK_EQUAL(otw_type.get_sample_size(), size_t(2));
+
+    for (size_t bo = 0; bo < 2; bo++) for (size_t width = 1; width <= 2; width++){
+        otw_type.byteorder = (bo == 0)? otw_type_t::BO_BIG_ENDIAN : otw_type_t::BO_LITTLE_ENDIAN;
+        for (size_t nsamps = 1; nsamps < 40; nsamps++){
+            //the inputs are exact in 8 bits
+            std::vector<std::vector<sc16_t> > input(width, std::vector<sc16_t>(nsamps));
+            std::vector<std::vector<sc16_t> > output(width, std::vector<sc16_t>(nsamps));
+            std::vector<std::vector<fc32_t> > fc32_output(width, std::vector<fc32_t>(nsamps));
+            std::vector<boost::uint32_t> interm((nsamps*width + 1)/2, ~0);
+            std::vector<const void *> input0, input1(1, &interm[0]);
+            std::vector<void *> output0(1, &interm[0]), output1, fc32_output1;
+            for (size_t w = 0; w < width; w++){
+                BOOST_FOREACH(sc16_t &in, input[w]) in = sc16_t(
+                    boost::int16_t(boost::int8_t(std::rand()) << 8),
+                    boost::int16_t(boost::int8_t(std::rand()) << 8)
+                );
+                input0.push_back(&input[w][0]);
+                output1.push_back(&output[w][0]);
+                fc32_output1.push_back(&fc32_output[w][0]);
+            }
+
+            convert::get_converter_cpu_to_otw(
+                io_type_t::COMPLEX_INT16, otw_type, input0.size(), output0.size()
+            )(input0, output0, nsamps, 32767.);
+            for (size_t k = 0; k < interm.size()*2; k++){
+                const boost::uint32_t bits = (k < nsamps*width)? sc8_bits(input[k%width][k/width]) : 0;
+                const boost::uint32_t item = (otw_type.byteorder == otw_type_t::BO_BIG_ENDIAN)?
+                    uhd::ntohx(interm[k/2]) : uhd::wtohx(interm[k/2]);
+                BOOST_CHECK_EQUAL((item >> ((k%2 == 0)? 16 : 0)) & 0xffff, bits);
+            }
+
+            convert::get_converter_otw_to_cpu(
+                io_type_t::COMPLEX_INT16, otw_type, input1.size(), output1.size()
+            )(input1, output1, nsamps, 1/32767.);
+            convert::get_converter_otw_to_cpu(
+                io_type_t::COMPLEX_FLOAT32, otw_type, input1.size(), fc32_output1.size()
+            )(input1, fc32_output1, nsamps, 1/32767.);
+            for (size_t w = 0; w < width; w++){
+                BOOST_CHECK_EQUAL_COLLECTIONS(input[w].begin(), input[w].end(), output[w].begin(), output[w].end());
+                for (size_t i = 0; i < nsamps; i++){
+                    MY_CHECK_CLOSE(input[w][i].real()/float(32767), fc32_output[w][i].real(), float(0.01));
+                    MY_CHECK_CLOSE(input[w][i].imag()/float(32767), fc32_output[w][i].imag(), float(0.01));
+                }
+            }
+
+            //start on the second sample (the lower half of the first item)
+            if (width != 1 or nsamps < 2) continue;
+            std::vector<const void *> input2(1, reinterpret_cast<const char *>(&interm[0]) + 2);
+            std::vector<sc16_t> output2(nsamps-1);
+            std::vector<void *> output3(1, &output2[0]);
+            convert::get_converter_otw_to_cpu(
+                io_type_t::COMPLEX_INT16, otw_type, input2.size(), output3.size()
+            )(input2, output3, nsamps-1, 1/32767.);
+            BOOST_CHECK_EQUAL_COLLECTIONS(input[0].begin()+1, input[0].end(), output2.begin(), output2.end());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_sc8_rounding){
+    otw_type_t otw_type;
+    otw_type.width = 8;
+    otw_type.byteorder = otw_type_t::BO_BIG_ENDIAN;
+
+    //round to nearest and saturate at the limits (in and out of the vector blocks)
+    std::vector<sc16_t> sc16_input(11);
+    std::vector<fc32_t> fc32_input(11);
+    for (size_t i = 0; i < 11; i += 10){
+        sc16_input[i] = sc16_t(32767, -32768);
+        fc32_input[i] = fc32_t(1.0f, -1.0f);
+    }
+    for (size_t i = 1; i < 10; i++){
+        sc16_input[i] = sc16_t(383, -385);
+        fc32_input[i] = fc32_t(383/32767.f, -385/32767.f);
+    }
+
+    std::vector<boost::uint32_t> sc16_interm(6), fc32_interm(6);
+    std::vector<const void *> sc16_in(1, &sc16_input[0]), fc32_in(1, &fc32_input[0]);
+    std::vector<void *> sc16_out(1, &sc16_interm[0]), fc32_out(1, &fc32_interm[0]);
+    convert::get_converter_cpu_to_otw(io_type_t::COMPLEX_INT16, otw_type, 1, 1)(sc16_in, sc16_out, 11, 32767.);
+    convert::get_converter_cpu_to_otw(io_type_t::COMPLEX_FLOAT32, otw_type, 1, 1)(fc32_in, fc32_out, 11, 32767.);
+
+    for (size_t k = 0; k < 11; k++){
+        const boost::uint32_t expected = (k%10 == 0)? 0x7f80 : 0x01fe; //(127, -128) or (1, -2)
+        BOOST_CHECK_EQUAL((uhd::ntohx(sc16_interm[k/2]) >> ((k%2 == 0)? 16 : 0)) & 0xffff, expected);
+        BOOST_CHECK_EQUAL((uhd::ntohx(fc32_interm[k/2]) >> ((k%2 == 0)? 16 : 0)) & 0xffff, expected);
+    }
+}
+
+/***********************************************************************
+ * Fused receive stage: compare with converting, rotating in double
+ * precision, and averaging the groups. The input is split into calls
+ * of several sizes to check the phase and the partial group carry over.
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_convert_fused_rx_stage){
+    const size_t nsamps = 2000;
+    const double freq = 0.0123;
+    const size_t chunks[] = {1, 7, 256, 300, 3, 513, 4, 920};
+    otw_type_t otw_type;
+    otw_type.width = 16;
+
+    for (size_t bo = 0; bo < 2; bo++) for (size_t decim = 1; decim <= 8; decim++){
+        otw_type.byteorder = (bo == 0)? otw_type_t::BO_BIG_ENDIAN : otw_type_t::BO_LITTLE_ENDIAN;
+        std::vector<sc16_t> input(nsamps);
+        std::vector<boost::uint32_t> interm(nsamps);
+        for (size_t i = 0; i < nsamps; i++){
+            input[i] = sc16_t(std::rand()-(RAND_MAX/2), std::rand()-(RAND_MAX/2));
+            interm[i] = expected_item32(input[i], otw_type);
+        }
+
+        //the reference in double precision
+        std::vector<fc64_t> expected(nsamps/decim);
+        for (size_t i = 0; i < expected.size()*decim; i++){
+            const fc64_t s(input[i].real()/32767., input[i].imag()/32767.);
+            expected[i/decim] += s*std::polar(1.0, 2*M_PI*freq*i)/double(decim);
+        }
+
+        convert::rx_fused_stage::sptr stage = convert::make_rx_fused_stage(otw_type);
+        stage->set_freq(freq);
+        stage->set_decim(decim);
+        std::vector<fc32_t> output(nsamps);
+        size_t nins = 0, nouts = 0;
+        for (size_t c = 0; nins < nsamps; c++){
+            const size_t n = std::min(chunks[c%8], nsamps - nins);
+            nouts += (*stage)(&interm[nins], &output[nouts], n, 1/32767.);
+            nins += n;
+            BOOST_CHECK_EQUAL(stage->get_pending(), nins%decim);
+        }
+        BOOST_REQUIRE_EQUAL(nouts, expected.size());
+        for (size_t i = 0; i < nouts; i++){
+            BOOST_CHECK_SMALL(std::abs(fc64_t(output[i]) - expected[i]), 1e-4);
+        }
+    }
+}
+
+/***********************************************************************
+ * Symbol stage: convert a stream of symbols with cyclic prefixes
+ * into back to back symbols, in calls that split the prefixes.
+ * Filling a buffer of get_max_inputs() inputs gives the exact outputs.
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_convert_symbol_stage){
+    const size_t nfft = 64, ncp = 16, nsyms = 20;
+    const size_t chunks[] = {5, 11, 80, 3, 100, 17, 64};
+    otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.byteorder = otw_type_t::BO_BIG_ENDIAN;
+
+    //sample n of symbol k is (k, n), the prefixes are (-1, -1)
+    std::vector<boost::uint32_t> interm;
+    for (size_t k = 0; k < nsyms; k++){
+        for (size_t n = 0; n < ncp; n++) interm.push_back(expected_item32(sc16_t(-1, -1), otw_type));
+        for (size_t n = 0; n < nfft; n++) interm.push_back(expected_item32(sc16_t(k, n), otw_type));
+    }
+
+    convert::rx_symbol_stage::sptr stage = convert::make_rx_symbol_stage(otw_type, nfft, ncp);
+    std::vector<fc32_t> output(nsyms*nfft);
+    size_t nins = 0, nouts = 0;
+    for (size_t c = 0; nins < interm.size(); c++){
+        const size_t n = std::min(chunks[c%7], interm.size() - nins);
+        nouts += (*stage)(&interm[nins], &output[nouts], n, 1.0);
+        nins += n;
+        BOOST_CHECK_EQUAL(stage->get_symbol_offset(), nins%(nfft + ncp));
+    }
+    BOOST_REQUIRE_EQUAL(nouts, output.size());
+    for (size_t i = 0; i < output.size(); i++){
+        BOOST_CHECK_EQUAL(output[i], fc32_t(float(i/nfft), float(i%nfft)));
+    }
+
+    //the inputs for a number of outputs end with the last output
+    for (size_t offset = 0; offset < nfft + ncp; offset += 7){
+        for (size_t nouts_max = 1; nouts_max < 3*nfft; nouts_max += 13){
+            stage->set_symbol_offset(offset);
+            const long output_offset = stage->get_output_offset();
+            BOOST_CHECK_EQUAL(output_offset, long((offset < ncp)? ncp - offset : 0));
+            const size_t nins_max = stage->get_max_inputs(nouts_max);
+            BOOST_CHECK_EQUAL((*stage)(&interm[offset], &output[0], nins_max, 1.0), nouts_max);
+            BOOST_CHECK(stage->get_symbol_offset() >= ncp or stage->get_symbol_offset() == 0);
+        }
+    }
+}
+
+/***********************************************************************
+ * Report the throughput of every registered converter
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_convert_benchmark_report){
+    const std::vector<convert::benchmark_type> results = convert::benchmark_converters();
+    BOOST_REQUIRE(not results.empty());
+
+    std::cout << "converter throughput (1024 samples per call):" << std::endl;
+    BOOST_FOREACH(const convert::benchmark_type &result, results){
+        std::cout << boost::format("  %-32s prio %d: %8.1f Msps%s")
+            % result.markup % result.prio % (result.samps_per_sec/1e6)
+            % (result.selected? " (selected)" : "") << std::endl;
+        BOOST_CHECK(result.samps_per_sec > 0);
+    }
+}
+
+/***********************************************************************
+ * Calibrate the selections, and reload them from the cache file
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_convert_calibration){
+    const std::string cache_file = "convert_test_cal.txt";
+    std::remove(cache_file.c_str());
+    otw_type_t otw_type;
+    otw_type.byteorder = otw_type_t::BO_BIG_ENDIAN;
+    otw_type.width = 16;
+
+    //the lookups calibrate and write the cache file
+    convert::set_calibration(true, cache_file);
+    test_convert_types_for_floats<fc32_t>(1111, io_type_t::COMPLEX_FLOAT32, otw_type);
+    test_convert_types_sc16(1111, io_type_t::COMPLEX_INT16, otw_type);
+
+    //the registered converters and the ones returned by the lookups
+    typedef std::pair<std::string, int> converter_id_type;
+    std::set<converter_id_type> registered, selected;
+    bool has_choices = false; //only signatures with a choice are cached
+    BOOST_FOREACH(const convert::benchmark_type &result, convert::benchmark_converters(16)){
+        registered.insert(converter_id_type(result.markup, int(result.prio)));
+        if (result.selected) selected.insert(converter_id_type(result.markup, int(result.prio)));
+        else has_choices = true;
+    }
+
+    //every cache line (cpu model, markup, priority) names a registered converter in use
+    size_t num_markups = 0;
+    std::ifstream cache_in(cache_file.c_str());
+    std::string line;
+    while (std::getline(cache_in, line)){
+        num_markups++;
+        std::istringstream fields(line.substr(line.find('\t') + 1));
+        converter_id_type id;
+        fields >> id.first >> id.second;
+        BOOST_CHECK_MESSAGE(registered.count(id) == 1, "cached " + id.first + " is not registered");
+        BOOST_CHECK_MESSAGE(selected.count(id) == 1, "cached " + id.first + " is not selected");
+    }
+    cache_in.close();
+    BOOST_CHECK(not selected.empty());
+    BOOST_CHECK(num_markups > 0 or not has_choices);
+
+    //the second calibration uses the cached selections
+    convert::set_calibration(true, cache_file);
+    test_convert_types_for_floats<fc32_t>(1111, io_type_t::COMPLEX_FLOAT32, otw_type);
+    test_convert_types_sc16(1111, io_type_t::COMPLEX_INT16, otw_type);
+    size_t num_lines = 0;
+    std::ifstream cache_again(cache_file.c_str());
+    while (std::getline(cache_again, line)) num_lines++;
+    BOOST_CHECK_EQUAL(num_lines, num_markups);
+
+    convert::set_calibration(false);
+    std::remove(cache_file.c_str());
+}
@@ -0,0 +1,231 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "e100_mmap_zero_copy.hpp"
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <iostream>
+#include <poll.h>
+#include <vector>
+
+using namespace uhd::transport;
+
+static const size_t page_size = 4096;
+static const size_t num_frames = 32;
+static const double timeout = 0.1/*secs*/;
+
+/***********************************************************************
+ * A ring in user-space that stands in for the usrp_e driver:
+ *  - A thread plays the driver, filling recv frames with a counter
+ *    and turning committed send frames around.
+ *  - Waiting blocks on a condition until a frame is ready.
+ **********************************************************************/
+class fake_ring : public e100_mmap_ring{
+public:
+    fake_ring(size_t num_recv_packets):
+        _mem((2*page_size + 2*num_frames*page_size/2), 0),
+        _num_recv_packets(num_recv_packets),
+        _num_sent(0), _num_waits(0), _num_notifies(0)
+    {
+        _rb_size.num_pages_rx_flags = 1;
+        _rb_size.num_rx_frames = num_frames;
+        _rb_size.num_pages_tx_flags = 1;
+        _rb_size.num_tx_frames = num_frames;
+        for (size_t i = 0; i < num_frames; i++){
+            recv_info(i).flags = RB_KERNEL;
+            send_info(i).flags = RB_KERNEL;
+        }
+        _driver = boost::thread(&fake_ring::driver_loop, this);
+    }
+
+    ~fake_ring(void){
+        _driver.interrupt();
+        _driver.join();
+    }
+
+    const usrp_e_ring_buffer_size_t &get_rb_size(void) const{return _rb_size;}
+    size_t get_page_size(void) const{return page_size;}
+    char *get_mem(void) const{return const_cast<char *>(&_mem.front());}
+
+    bool wait(short events, double timeout){
+        boost::mutex::scoped_lock lock(_mutex);
+        _num_waits++;
+        const boost::system_time exit_time = boost::get_system_time() +
+            boost::posix_time::microseconds(long(timeout*1e6));
+        while (not any_ready(events)){
+            if (not _cond.timed_wait(lock, exit_time)) return any_ready(events);
+        }
+        return true;
+    }
+
+    void notify(void){_num_notifies++;}
+
+    size_t get_num_sent(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _num_sent;
+    }
+    size_t get_num_waits(void) const{return _num_waits;}
+    size_t get_num_notifies(void) const{return _num_notifies;}
+
+private:
+    volatile ring_buffer_info &recv_info(size_t i){
+        return reinterpret_cast<ring_buffer_info *>(get_mem())[i];
+    }
+
+    volatile ring_buffer_info &send_info(size_t i){
+        return reinterpret_cast<ring_buffer_info *>(get_mem() + page_size + num_frames*page_size/2)[i];
+    }
+
+    boost::uint32_t *recv_frame(size_t i){
+        return reinterpret_cast<boost::uint32_t *>(get_mem() + page_size + i*page_size/2);
+    }
+
+    bool any_ready(short events){
+        for (size_t i = 0; i < num_frames; i++){
+            if ((events & POLLIN) and (recv_info(i).flags & RB_USER)) return true;
+            if ((events & POLLOUT) and (send_info(i).flags & RB_KERNEL)) return true;
+        }
+        return false;
+    }
+
+    void driver_loop(void){
+        size_t recv_index = 0, send_index = 0, num_recvd = 0;
+        while (not boost::this_thread::interruption_requested()){
+            bool signal = false;
+
+            //fill the next free recv frame with the packet count
+            if (num_recvd < _num_recv_packets and recv_info(recv_index).flags & RB_KERNEL){
+                recv_frame(recv_index)[0] = boost::uint32_t(num_recvd++);
+                recv_info(recv_index).len = sizeof(boost::uint32_t);
+                recv_info(recv_index).flags = RB_USER;
+                if (++recv_index == num_frames) recv_index = 0;
+                signal = true;
+            }
+
+            //turn around the next committed send frame
+            if (send_info(send_index).flags & RB_USER){
+                send_info(send_index).flags = RB_KERNEL;
+                if (++send_index == num_frames) send_index = 0;
+                boost::mutex::scoped_lock lock(_mutex);
+                _num_sent++;
+                signal = true;
+            }
+
+            if (signal){
+                boost::mutex::scoped_lock lock(_mutex);
+                _cond.notify_one();
+            }
+            else boost::this_thread::yield();
+        }
+    }
+
+    std::vector<char> _mem;
+    usrp_e_ring_buffer_size_t _rb_size;
+    const size_t _num_recv_packets;
+    size_t _num_sent, _num_waits, _num_notifies;
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    boost::thread _driver;
+};
+
+/***********************************************************************
+ * Receive all packets and check that they arrive in order
+ **********************************************************************/
+static double recv_all(const std::string &args, size_t num_packets, size_t batch, size_t &num_waits){
+    boost::shared_ptr<fake_ring> ring(new fake_ring(num_packets));
+    e100_mmap_zero_copy::sptr xport = e100_mmap_zero_copy::make(ring, uhd::device_addr_t(args));
+
+    const boost::system_time start = boost::get_system_time();
+    std::vector<managed_recv_buffer::sptr> buffs;
+    for (size_t i = 0; i < num_packets;){
+        buffs.clear();
+        const size_t num_claimed = xport->get_recv_buffs(buffs, std::min(batch, num_packets - i), timeout);
+        BOOST_REQUIRE(num_claimed > 0);
+        BOOST_REQUIRE_EQUAL(num_claimed, buffs.size());
+        for (size_t j = 0; j < num_claimed; j++, i++){
+            BOOST_REQUIRE_EQUAL(buffs[j]->size(), sizeof(boost::uint32_t));
+            BOOST_REQUIRE_EQUAL(buffs[j]->cast<const boost::uint32_t *>()[0], boost::uint32_t(i));
+        }
+    }
+    const double elapsed = (boost::get_system_time() - start).total_microseconds()/1e6;
+
+    buffs.clear();
+    BOOST_CHECK(xport->get_recv_buff(0.01).get() == NULL);
+    num_waits = ring->get_num_waits();
+    return elapsed;
+}
+
+BOOST_AUTO_TEST_CASE(test_e100_mmap_recv){
+    size_t num_waits = 0;
+    recv_all("", 1000, 1, num_waits);
+    recv_all("", 1000, 8, num_waits);
+    recv_all("busy_poll_time=0.0001", 1000, 1, num_waits);
+    recv_all("busy_poll_time=0.0001", 1000, 8, num_waits);
+}
+
+BOOST_AUTO_TEST_CASE(test_e100_mmap_send_batch){
+    boost::shared_ptr<fake_ring> ring(new fake_ring(0));
+    e100_mmap_zero_copy::sptr xport = e100_mmap_zero_copy::make(ring);
+
+    //a single buffer notifies the driver on commit
+    managed_send_buffer::sptr buff = xport->get_send_buff(timeout);
+    BOOST_REQUIRE(buff.get() != NULL);
+    buff->commit(4);
+    buff.reset();
+    BOOST_CHECK_EQUAL(ring->get_num_notifies(), size_t(1));
+
+    //a batch notifies the driver once, after the last commit
+    std::vector<managed_send_buffer::sptr> buffs;
+    BOOST_REQUIRE_EQUAL(xport->get_send_buffs(buffs, 8, timeout), size_t(8));
+    for (size_t i = 0; i < buffs.size(); i++){
+        BOOST_CHECK_EQUAL(ring->get_num_notifies(), size_t(1));
+        buffs[i]->commit(4);
+    }
+    buffs.clear();
+    BOOST_CHECK_EQUAL(ring->get_num_notifies(), size_t(2));
+
+    //the driver turns all of the frames around
+    for (size_t i = 0; i < 1000 and ring->get_num_sent() < 9; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(ring->get_num_sent(), size_t(9));
+}
+
+/***********************************************************************
+ * Benchmark the wait strategies against the fake ring:
+ * blocking waits versus busy polling, single versus batched claims.
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_e100_mmap_benchmark){
+    static const size_t num_packets = 100000;
+    const char *args[] = {"", "busy_poll_time=0.0001"};
+    const size_t batches[] = {1, 8};
+    for (size_t a = 0; a < 2; a++){
+        for (size_t b = 0; b < 2; b++){
+            size_t num_waits = 0;
+            const double elapsed = recv_all(args[a], num_packets, batches[b], num_waits);
+            std::cout << boost::format(
+                "e100 mmap recv: busy poll %-5s batch %u: %8.1f ns/frame, %u blocking waits"
+            ) % (a? "on" : "off") % batches[b] % (elapsed*1e9/num_packets) % num_waits << std::endl;
+        }
+    }
+}
@@ -173,3 +173,51 @@ BOOST_AUTO_TEST_CASE(test_prop_subtree){
     BOOST_CHECK_EQUAL_COLLECTIONS(tree_dirs2.begin(), tree_dirs2.end(), subtree2_dirs.begin(), subtree2_dirs.end());
 
 }
+
+BOOST_AUTO_TEST_CASE(test_prop_tree_paths){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    tree->create<int>("/test/prop0").set(42);
+
+    //paths with extra slashes find the same property
+    BOOST_CHECK(tree->exists("test/prop0"));
+    BOOST_CHECK(tree->exists("/test//prop0/"));
+    BOOST_CHECK_EQUAL(tree->access<int>("//test/prop0").get(), 42);
+    BOOST_CHECK_EQUAL(tree->list("/test/").size(), size_t(1));
+
+    //a removed path is gone, and it can be created again
+    tree->remove("/test");
+    BOOST_CHECK(not tree->exists("/test"));
+    BOOST_CHECK(not tree->exists("/test/prop0"));
+    BOOST_CHECK_THROW(tree->access<int>("/test/prop0"), std::exception);
+    BOOST_CHECK_THROW(tree->list("/test"), std::exception);
+    tree->create<int>("/test/prop0").set(34);
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop0").get(), 34);
+
+    //removing a path does not remove a sibling with the same prefix
+    tree->create<int>("/test/prop00").set(56);
+    tree->remove("/test/prop0");
+    BOOST_CHECK(tree->exists("/test/prop00"));
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop00").get(), 56);
+}
+
+BOOST_AUTO_TEST_CASE(test_prop_handle){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    tree->create<int>("/test/prop0");
+
+    setter_type setter;
+    boost::shared_ptr<uhd::property<int> > prop = tree->handle<int>("/test/prop0");
+    prop->subscribe(boost::bind(&setter_type::doit, &setter, _1));
+
+    //the handle and the path reach the same property
+    prop->set(42);
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop0").get(), 42);
+    BOOST_CHECK_EQUAL(setter._x, 42);
+    tree->access<int>("/test/prop0").set(34);
+    BOOST_CHECK_EQUAL(prop->get(), 34);
+
+    //the handle outlives the path
+    tree->remove("/test/prop0");
+    prop->set(56);
+    BOOST_CHECK_EQUAL(prop->get(), 56);
+    BOOST_CHECK_EQUAL(setter._x, 56);
+}
@@ -0,0 +1,164 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "recv_packet_demuxer.hpp"
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+#include <vector>
+
+using namespace uhd::transport;
+using namespace uhd::usrp;
+
+static const boost::uint32_t SID_BASE = 10;
+
+/***********************************************************************
+ * A fake receive frame: word 0 is a sequence number, word 1 the sid
+ **********************************************************************/
+class fake_mrb : public managed_recv_buffer{
+public:
+    fake_mrb(bounded_buffer<fake_mrb *> &available): _available(available){ /* NOP */ }
+
+    void release(void){
+        _available.push_with_haste(this);
+    }
+
+    sptr get_new(const boost::uint32_t sid, const boost::uint32_t seq){
+        _words[0] = seq;
+        _words[1] = uhd::wtohx(sid); //the demuxer reads little endian
+        return make_managed_buffer(this);
+    }
+
+private:
+    const void *get_buff(void) const{return _words;}
+    size_t get_size(void) const{return sizeof(_words);}
+
+    bounded_buffer<fake_mrb *> &_available;
+    boost::uint32_t _words[2];
+};
+
+/***********************************************************************
+ * A fake transport that interleaves the sids of several channels:
+ * Packet number n goes to channel (n*7)%nchan, until num_packets.
+ * A frame comes back to the transport when the caller releases it.
+ **********************************************************************/
+class fake_recv_xport : public zero_copy_if{
+public:
+    fake_recv_xport(const size_t num_frames, const size_t num_packets, const size_t nchan):
+        _available(num_frames), _num_packets(num_packets), _nchan(nchan), _count(0)
+    {
+        for (size_t i = 0; i < num_frames; i++) _frames.push_back(new fake_mrb(_available));
+        for (size_t i = 0; i < num_frames; i++) _available.push_with_haste(_frames[i]);
+    }
+
+    ~fake_recv_xport(void){
+        for (size_t i = 0; i < _frames.size(); i++) delete _frames[i];
+    }
+
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        boost::mutex::scoped_lock lock(_mutex); //catches two owners at once
+        fake_mrb *frame = NULL;
+        if (_count == _num_packets or not _available.pop_with_timed_wait(frame, timeout)){
+            return managed_recv_buffer::sptr();
+        }
+        const boost::uint32_t seq = boost::uint32_t(_count++);
+        return frame->get_new(SID_BASE + boost::uint32_t((seq*7)%_nchan), seq);
+    }
+
+    size_t get_num_recv_frames(void) const{return _frames.size();}
+    size_t get_recv_frame_size(void) const{return 8;}
+    managed_send_buffer::sptr get_send_buff(double){return managed_send_buffer::sptr();}
+    size_t get_num_send_frames(void) const{return 0;}
+    size_t get_send_frame_size(void) const{return 0;}
+
+private:
+    bounded_buffer<fake_mrb *> _available;
+    std::vector<fake_mrb *> _frames;
+    const size_t _num_packets, _nchan;
+    size_t _count;
+    boost::mutex _mutex;
+};
+
+/***********************************************************************
+ * Receive one channel until a timeout, check the order of its packets
+ **********************************************************************/
+struct chan_result_type{
+    chan_result_type(void): num_packets(0), in_order(true), right_sid(true){}
+    size_t num_packets;
+    bool in_order, right_sid;
+};
+
+static void recv_chan(recv_packet_demuxer::sptr demuxer, const size_t index, chan_result_type &result){
+    boost::uint32_t last_seq = 0;
+    while (true){
+        managed_recv_buffer::sptr buff = demuxer->get_recv_buff(index, 0.5);
+        if (buff.get() == NULL) break;
+        const boost::uint32_t seq = buff->cast<const boost::uint32_t *>()[0];
+        const boost::uint32_t sid = uhd::wtohx(buff->cast<const boost::uint32_t *>()[1]);
+        if (result.num_packets != 0 and seq <= last_seq) result.in_order = false;
+        if (sid != SID_BASE + index) result.right_sid = false;
+        last_seq = seq;
+        result.num_packets++;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_demuxer_one_thread){
+    static const size_t NCHAN = 3, NUM_PACKETS = 30;
+    recv_packet_demuxer::sptr demuxer = recv_packet_demuxer::make(
+        zero_copy_if::sptr(new fake_recv_xport(32, NUM_PACKETS, NCHAN)), NCHAN, SID_BASE
+    );
+
+    //the packets for the other channels are queued for them
+    std::vector<chan_result_type> results(NCHAN);
+    for (size_t i = 0; i < NCHAN; i++) recv_chan(demuxer, i, results[i]);
+    for (size_t i = 0; i < NCHAN; i++){
+        BOOST_CHECK_EQUAL(results[i].num_packets, NUM_PACKETS/NCHAN);
+        BOOST_CHECK(results[i].in_order);
+        BOOST_CHECK(results[i].right_sid);
+        BOOST_CHECK_EQUAL(demuxer->get_queue_depth(i), size_t(0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_demuxer_threads){
+    static const size_t NCHAN = 4, NUM_PACKETS = 100000;
+    recv_packet_demuxer::sptr demuxer = recv_packet_demuxer::make(
+        zero_copy_if::sptr(new fake_recv_xport(32, NUM_PACKETS, NCHAN)), NCHAN, SID_BASE
+    );
+
+    //one thread per channel, every packet arrives once and in order
+    std::vector<chan_result_type> results(NCHAN);
+    boost::thread_group threads;
+    for (size_t i = 0; i < NCHAN; i++){
+        threads.create_thread(boost::bind(&recv_chan, demuxer, i, boost::ref(results[i])));
+    }
+    threads.join_all();
+
+    size_t num_packets = 0;
+    for (size_t i = 0; i < NCHAN; i++){
+        std::cout << "channel " << i << ": " << results[i].num_packets << " packets, max queue depth "
+            << demuxer->get_max_queue_depth(i) << std::endl;
+        BOOST_CHECK(results[i].in_order);
+        BOOST_CHECK(results[i].right_sid);
+        BOOST_CHECK_EQUAL(demuxer->get_queue_depth(i), size_t(0));
+        num_packets += results[i].num_packets;
+    }
+    BOOST_CHECK_EQUAL(num_packets, NUM_PACKETS);
+}
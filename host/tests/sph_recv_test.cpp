@@ -19,7 +19,12 @@
 #include "../lib/transport/super_recv_packet_handler.hpp"
 #include <boost/shared_array.hpp>
 #include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <boost/math/special_functions/round.hpp>
 #include <complex>
+#include <cmath>
+#include <cstdlib>
 #include <vector>
 #include <list>
 
@@ -69,6 +74,7 @@ class dummy_recv_xport_class{
 public:
     dummy_recv_xport_class(const uhd::otw_type_t &otw_type){
         _otw_type = otw_type;
+        _back_payload = NULL;
     }
 
     void push_back_packet(
@@ -83,8 +89,16 @@ public:
         if (_otw_type.byteorder == uhd::otw_type_t::BO_LITTLE_ENDIAN){
             uhd::transport::vrt::if_hdr_pack_le(reinterpret_cast<boost::uint32_t *>(_mems.back().get()), ifpi);
         }
-        (reinterpret_cast<boost::uint32_t *>(_mems.back().get()) + ifpi.num_header_words32)[0] = optional_msg_word | uhd::byteswap(optional_msg_word);
+        boost::uint32_t *payload = reinterpret_cast<boost::uint32_t *>(_mems.back().get()) + ifpi.num_header_words32;
+        for (size_t i = 0; i < ifpi.num_payload_words32; i++) payload[i] = boost::uint32_t(std::rand());
+        payload[0] = optional_msg_word | uhd::byteswap(optional_msg_word);
         _lens.push_back(ifpi.num_packet_words32*sizeof(boost::uint32_t));
+        _back_payload = payload;
+    }
+
+    //the payload of the last pushed packet (to write known samples)
+    boost::uint32_t *back_payload(void){
+        return _back_payload;
     }
 
     uhd::transport::managed_recv_buffer::sptr get_recv_buff(double){
@@ -101,6 +115,7 @@ private:
     std::list<size_t> _lens;
     std::list<dummy_mrb> _mrbs; //list means no-realloc
     uhd::otw_type_t _otw_type;
+    boost::uint32_t *_back_payload;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -177,6 +192,225 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_normal){
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_sc8){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 8;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    dummy_recv_xport_class dummy_recv_xport(otw_type);
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+
+    //generate packets of two samples per word, sample n is (n, -n)
+    size_t num_total_samps = 0;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        dummy_recv_xport.push_back_packet(ifpi);
+        boost::uint32_t *payload = dummy_recv_xport.back_payload();
+        for (size_t j = 0; j < ifpi.num_payload_words32; j++, num_total_samps += 2){
+            const boost::uint8_t n0 = boost::uint8_t(num_total_samps), n1 = boost::uint8_t(num_total_samps+1);
+            payload[j] = uhd::htonx(boost::uint32_t(
+                (n0 << 24) | (boost::uint8_t(-n0) << 16) | (n1 << 8) | (boost::uint8_t(-n1) << 0)
+            ));
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += 2*ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    handler.set_converter(otw_type);
+
+    //receive in odd fragments, so that fragments start in the middle of items
+    size_t num_accum_samps = 0;
+    std::vector<std::complex<boost::int16_t> > buff(7);
+    uhd::rx_metadata_t metadata;
+    while (num_accum_samps < num_total_samps){
+        size_t num_samps_ret = handler.recv(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_INT16,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_REQUIRE_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+        for (size_t i = 0; i < num_samps_ret; i++, num_accum_samps++){
+            const boost::int8_t n = boost::int8_t(num_accum_samps);
+            BOOST_CHECK_EQUAL(buff[i], std::complex<boost::int16_t>(n << 8, boost::int8_t(-n) << 8));
+        }
+    }
+    BOOST_CHECK_EQUAL(num_accum_samps, num_total_samps);
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_post_stage){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    dummy_recv_xport_class dummy_recv_xport(otw_type);
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const double FREQ = 0.05; //cycles per sample
+    static const size_t DECIM = 3;
+
+    //generate a tone at -FREQ, the post stage shifts it to DC
+    size_t num_total_samps = 0;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        dummy_recv_xport.push_back_packet(ifpi);
+        boost::uint32_t *payload = dummy_recv_xport.back_payload();
+        for (size_t j = 0; j < ifpi.num_payload_words32; j++, num_total_samps++){
+            const std::complex<double> tone = std::polar(16384.0, -2*M_PI*FREQ*num_total_samps);
+            const boost::uint16_t re = boost::int16_t(boost::math::iround(tone.real()));
+            const boost::uint16_t im = boost::int16_t(boost::math::iround(tone.imag()));
+            payload[j] = uhd::htonx(boost::uint32_t((re << 16) | im));
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    handler.set_converter(otw_type);
+    handler.set_scale_factor(1/32768.);
+    handler.set_post_stage(std::vector<double>(1, FREQ), DECIM);
+
+    //the groups straddle the packets, and the outputs are stamped at the group start
+    size_t num_accum_samps = 0;
+    std::vector<std::complex<float> > buff(7);
+    uhd::rx_metadata_t metadata;
+    while (num_accum_samps < num_total_samps/DECIM){
+        size_t num_samps_ret = handler.recv(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_REQUIRE_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        if (num_samps_ret == 0) continue;
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps*DECIM, SAMP_RATE));
+        for (size_t i = 0; i < num_samps_ret; i++, num_accum_samps++){
+            BOOST_CHECK_SMALL(std::abs(buff[i] - std::complex<float>(0.5, 0.0)), float(1e-3));
+        }
+    }
+    BOOST_CHECK_EQUAL(num_accum_samps, num_total_samps/DECIM);
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_symbol_stage){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    dummy_recv_xport_class dummy_recv_xport(otw_type);
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NFFT = 16, NCP = 4;
+
+    //sample n of the stream is (n, 0), so the symbols are easy to check
+    size_t num_total_samps = 0;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        dummy_recv_xport.push_back_packet(ifpi);
+        boost::uint32_t *payload = dummy_recv_xport.back_payload();
+        for (size_t j = 0; j < ifpi.num_payload_words32; j++, num_total_samps++){
+            payload[j] = uhd::htonx(boost::uint32_t(num_total_samps << 16));
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    handler.set_converter(otw_type);
+    handler.set_scale_factor(1.0);
+    handler.set_post_stages(std::vector<uhd::convert::rx_stage::sptr>(
+        1, uhd::convert::make_rx_symbol_stage(otw_type, NFFT, NCP)
+    ));
+
+    //receive two symbols per call, stamped at the end of the first prefix
+    const size_t num_syms = num_total_samps/(NFFT + NCP);
+    std::vector<std::complex<float> > buff(2*NFFT);
+    uhd::rx_metadata_t metadata;
+    for (size_t k = 0; k+2 <= num_syms; k += 2){
+        size_t num_samps_ret = handler.recv(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_FULL_BUFF, 1.0
+        );
+        BOOST_REQUIRE_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_REQUIRE_EQUAL(num_samps_ret, buff.size());
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, k*(NFFT + NCP) + NCP, SAMP_RATE));
+        for (size_t i = 0; i < num_samps_ret; i++){
+            const size_t n = (k + i/NFFT)*(NFFT + NCP) + NCP + i%NFFT;
+            BOOST_CHECK_EQUAL(buff[i], std::complex<float>(float(n), 0));
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_sequence_error){
 ////////////////////////////////////////////////////////////////////////
@@ -261,6 +495,111 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_sequence_error){
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_gap_modes){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_MISSING_SAMPS = 2*16; //two lost packets
+
+    typedef uhd::transport::sph::recv_packet_handler handler_type;
+    const handler_type::gap_mode_t gap_modes[] = {handler_type::GAP_MODE_REPORT, handler_type::GAP_MODE_FILL};
+    for (size_t m = 0; m < 2; m++){
+    for (size_t has_time = 0; has_time < 2; has_time++){
+        std::cout << "gap mode " << m << " has time " << has_time << std::endl;
+
+        dummy_recv_xport_class dummy_recv_xport(otw_type);
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        ifpi.num_payload_words32 = 0;
+        ifpi.packet_count = 0;
+        ifpi.sob = true;
+        ifpi.eob = false;
+        ifpi.has_sid = false;
+        ifpi.has_cid = false;
+        ifpi.has_tsi = has_time != 0;
+        ifpi.has_tsf = has_time != 0;
+        ifpi.tsi = 0;
+        ifpi.tsf = 0;
+        ifpi.has_tlr = false;
+
+        //generate a bunch of packets, the lost packets and the next are the same size
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            ifpi.num_payload_words32 = (i/3 == NUM_PKTS_TO_TEST/6)? 16 : 10 + i%10;
+            if (i != NUM_PKTS_TO_TEST/2 and i != NUM_PKTS_TO_TEST/2 + 1){ //simulate lost packets
+                dummy_recv_xport.push_back_packet(ifpi);
+            }
+            ifpi.packet_count++;
+            ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+        }
+
+        //create the super receive packet handler
+        handler_type handler(1);
+        handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+        handler.set_tick_rate(TICK_RATE);
+        handler.set_samp_rate(SAMP_RATE);
+        handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+        handler.set_converter(otw_type);
+        handler.set_gap_mode(gap_modes[m]);
+
+        //check the received packets
+        size_t num_accum_samps = 0;
+        std::vector<std::complex<float> > buff(20);
+        uhd::rx_metadata_t metadata;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            if (i == NUM_PKTS_TO_TEST/2 + 1) continue; //the second lost packet
+            std::cout << "data check " << i << std::endl;
+            size_t num_samps_ret = handler.recv(
+                &buff.front(), buff.size(), metadata,
+                uhd::io_type_t::COMPLEX_FLOAT32,
+                uhd::device::RECV_MODE_ONE_PACKET, 1.0
+            );
+            if (i == NUM_PKTS_TO_TEST/2 and gap_modes[m] == handler_type::GAP_MODE_REPORT){
+                //the overflow starts at the first missing sample
+                BOOST_REQUIRE(metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW);
+                if (has_time) BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+                num_accum_samps += NUM_MISSING_SAMPS;
+            }
+            else if (i == NUM_PKTS_TO_TEST/2){
+                //the missing samples arrive as zeros, in fragments
+                size_t num_fill_samps = 0;
+                do{
+                    BOOST_REQUIRE_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+                    BOOST_CHECK_EQUAL(metadata.fragment_offset, num_fill_samps);
+                    if (has_time) BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+                    for (size_t j = 0; j < num_samps_ret; j++){
+                        BOOST_CHECK_EQUAL(buff[j], std::complex<float>(0, 0));
+                    }
+                    num_fill_samps += num_samps_ret;
+                    num_accum_samps += num_samps_ret;
+                    if (not metadata.more_fragments) break;
+                    num_samps_ret = handler.recv(
+                        &buff.front(), buff.size(), metadata,
+                        uhd::io_type_t::COMPLEX_FLOAT32,
+                        uhd::device::RECV_MODE_ONE_PACKET, 1.0
+                    );
+                } while(true);
+                BOOST_CHECK_EQUAL(num_fill_samps, NUM_MISSING_SAMPS);
+            }
+            else{
+                BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+                BOOST_CHECK(not metadata.more_fragments);
+                BOOST_CHECK_EQUAL(metadata.has_time_spec, has_time != 0);
+                if (has_time) BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+                const size_t num_samps_exp = (i/3 == NUM_PKTS_TO_TEST/6)? 16 : 10 + i%10;
+                BOOST_CHECK_EQUAL(num_samps_ret, num_samps_exp);
+                num_accum_samps += num_samps_ret;
+            }
+        }
+    }}
+}
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_inline_message){
 ////////////////////////////////////////////////////////////////////////
@@ -540,6 +879,116 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_sequence_error){
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_gap_fill){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 3;
+
+    typedef uhd::transport::sph::recv_packet_handler handler_type;
+    for (size_t all_lost = 0; all_lost < 2; all_lost++){
+        std::cout << "all channels lost " << all_lost << std::endl;
+
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        ifpi.num_payload_words32 = 0;
+        ifpi.packet_count = 0;
+        ifpi.sob = true;
+        ifpi.eob = false;
+        ifpi.has_sid = false;
+        ifpi.has_cid = false;
+        ifpi.has_tsi = true;
+        ifpi.has_tsf = true;
+        ifpi.tsi = 0;
+        ifpi.tsf = 0;
+        ifpi.has_tlr = false;
+
+        std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class(otw_type));
+
+        //generate a bunch of packets, lose one on every channel or on one channel
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            ifpi.num_payload_words32 = 10 + i%10;
+            for (size_t ch = 0; ch < NCHANNELS; ch++){
+                if (i == NUM_PKTS_TO_TEST/2 and (all_lost or ch == 2)){
+                    continue; //simulates a lost packet
+                }
+                dummy_recv_xports[ch].push_back_packet(ifpi);
+            }
+            ifpi.packet_count++;
+            ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+        }
+
+        //create the super receive packet handler
+        handler_type handler(NCHANNELS);
+        handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+        handler.set_tick_rate(TICK_RATE);
+        handler.set_samp_rate(SAMP_RATE);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+        }
+        handler.set_converter(otw_type);
+        handler.set_gap_mode(handler_type::GAP_MODE_FILL);
+
+        //check the received packets
+        size_t num_accum_samps = 0;
+        std::vector<std::complex<float> > mem(NUM_SAMPS_PER_BUFF*NCHANNELS, std::complex<float>(1, 1));
+        std::vector<std::complex<float> *> buffs(NCHANNELS);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+        }
+        uhd::rx_metadata_t metadata;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            std::cout << "data check " << i << std::endl;
+            size_t num_samps_ret = handler.recv(
+                buffs, NUM_SAMPS_PER_BUFF, metadata,
+                uhd::io_type_t::COMPLEX_FLOAT32,
+                uhd::device::RECV_MODE_ONE_PACKET, 1.0
+            );
+            BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+            if (i == NUM_PKTS_TO_TEST/2 and all_lost){
+                //the same gap on every channel is filled with zeros
+                BOOST_REQUIRE_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+                BOOST_CHECK(not metadata.more_fragments);
+                BOOST_REQUIRE_EQUAL(num_samps_ret, 10 + i%10);
+                for (size_t ch = 0; ch < NCHANNELS; ch++){
+                    for (size_t j = 0; j < num_samps_ret; j++){
+                        BOOST_CHECK_EQUAL(buffs[ch][j], std::complex<float>(0, 0));
+                    }
+                }
+                num_accum_samps += num_samps_ret;
+            }
+            else if (i == NUM_PKTS_TO_TEST/2){
+                //the channels disagree on the gap, it cannot be filled
+                BOOST_REQUIRE(metadata.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW);
+                num_accum_samps += 10 + i%10;
+            }
+            else{
+                BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+                BOOST_CHECK(not metadata.more_fragments);
+                BOOST_CHECK(metadata.has_time_spec);
+                BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
+                num_accum_samps += num_samps_ret;
+            }
+        }
+
+        //subsequent receives should be a timeout
+        handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_time_error){
 ////////////////////////////////////////////////////////////////////////
@@ -631,6 +1080,104 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_time_error){
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_realign){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_PKTS_LAGGING = 10;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 4;
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class(otw_type));
+
+    //generate a bunch of packets:
+    //the last channel lost its first packets (flushed after an overflow),
+    //so the other channels lag behind it and hold older packets
+    size_t num_lagging_samps = 0;
+    std::vector<size_t> packet_counts(NCHANNELS, 0);
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST + NUM_PKTS_LAGGING; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            if (ch == NCHANNELS-1 and i < NUM_PKTS_LAGGING) continue;
+            ifpi.packet_count = packet_counts[ch]++;
+            dummy_recv_xports[ch].push_back_packet(ifpi);
+        }
+        if (i < NUM_PKTS_LAGGING) num_lagging_samps += ifpi.num_payload_words32;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(NCHANNELS);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+    }
+    handler.set_converter(otw_type);
+    handler.set_alignment_failure_threshold(NUM_PKTS_LAGGING);
+
+    //check the received packets
+    size_t num_accum_samps = num_lagging_samps;
+    std::vector<std::complex<float> > mem(NUM_SAMPS_PER_BUFF*NCHANNELS);
+    std::vector<std::complex<float> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::rx_metadata_t metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        size_t num_samps_ret = handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK(not metadata.more_fragments);
+        BOOST_CHECK(metadata.has_time_spec);
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+        BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
+        num_accum_samps += num_samps_ret;
+    }
+
+    //one recovery threw out the lagging packets of the other channels
+    const uhd::transport::sph::recv_packet_handler::alignment_stats_type stats = handler.get_alignment_stats();
+    BOOST_CHECK_EQUAL(stats.num_recoveries, size_t(1));
+    BOOST_CHECK_EQUAL(stats.num_discarded_samps, (NCHANNELS-1)*num_lagging_samps);
+    BOOST_CHECK(stats.max_recovery_time >= stats.last_recovery_time);
+
+    //subsequent receives should be a timeout
+    for (size_t i = 0; i < 3; i++){
+        std::cout << "timeout check " << i << std::endl;
+        handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_fragment){
 ////////////////////////////////////////////////////////////////////////
@@ -730,3 +1277,313 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_fragment){
     }
 
 }
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_borrow){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 5;
+    static const size_t NCHANNELS = 4;
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class(otw_type));
+
+    //generate a bunch of packets
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            dummy_recv_xports[ch].push_back_packet(ifpi);
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(NCHANNELS);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+    }
+    handler.set_converter(otw_type);
+
+    //check the borrowed packets, every odd packet starts with a partial recv
+    size_t num_accum_samps = 0;
+    std::vector<std::complex<float> > mem(NUM_SAMPS_PER_BUFF*NCHANNELS);
+    std::vector<std::complex<float> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::device::recv_views_type views;
+    uhd::rx_metadata_t metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        size_t fragment_offset = 0;
+        if (i%2 == 1){
+            fragment_offset = handler.recv(
+                buffs, NUM_SAMPS_PER_BUFF, metadata,
+                uhd::io_type_t::COMPLEX_FLOAT32,
+                uhd::device::RECV_MODE_ONE_PACKET, 1.0
+            );
+            BOOST_CHECK_EQUAL(fragment_offset, NUM_SAMPS_PER_BUFF);
+            BOOST_CHECK(metadata.more_fragments);
+        }
+
+        uhd::device::recv_lease_type lease = handler.borrow(views, metadata, 1.0);
+        BOOST_REQUIRE(lease.get() != NULL);
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK(not metadata.more_fragments);
+        BOOST_CHECK_EQUAL(metadata.fragment_offset, fragment_offset);
+        BOOST_CHECK(metadata.has_time_spec);
+        num_accum_samps += fragment_offset;
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+        BOOST_REQUIRE_EQUAL(views.size(), NCHANNELS);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            BOOST_CHECK(views[ch].mem != NULL);
+            BOOST_CHECK_EQUAL(views[ch].nsamps, 10 + i%10 - fragment_offset);
+            BOOST_CHECK_TS_CLOSE(views[ch].time_spec, metadata.time_spec);
+        }
+        num_accum_samps += views[0].nsamps;
+    }
+
+    //subsequent borrows should be a timeout
+    for (size_t i = 0; i < 3; i++){
+        std::cout << "timeout check " << i << std::endl;
+        BOOST_CHECK(handler.borrow(views, metadata, 1.0).get() == NULL);
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+        BOOST_CHECK(views.empty());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_convert_threads){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 6;
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class(otw_type));
+
+    //generate a bunch of packets
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            dummy_recv_xports[ch].push_back_packet(ifpi);
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //the copies share the packet memory, one handler converts serially
+    std::vector<dummy_recv_xport_class> serial_recv_xports(dummy_recv_xports);
+
+    //create the super receive packet handlers
+    uhd::transport::sph::recv_packet_handler handler(NCHANNELS), serial_handler(NCHANNELS);
+    handler.set_converter_threads(2);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    serial_handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    serial_handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    serial_handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xports[ch], _1));
+        serial_handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &serial_recv_xports[ch], _1));
+    }
+    handler.set_converter(otw_type);
+    serial_handler.set_converter(otw_type);
+
+    //check the received packets against the serial conversion
+    std::vector<std::complex<float> > mem(NUM_SAMPS_PER_BUFF*NCHANNELS), serial_mem(mem.size());
+    std::vector<std::complex<float> *> buffs(NCHANNELS), serial_buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+        serial_buffs[ch] = &serial_mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::rx_metadata_t metadata, serial_metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        size_t num_samps_ret = handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        size_t serial_num_samps_ret = serial_handler.recv(
+            serial_buffs, NUM_SAMPS_PER_BUFF, serial_metadata,
+            uhd::io_type_t::COMPLEX_FLOAT32,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
+        BOOST_CHECK_EQUAL(num_samps_ret, serial_num_samps_ret);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            for (size_t j = 0; j < num_samps_ret; j++){
+                BOOST_CHECK_EQUAL(buffs[ch][j], serial_buffs[ch][j]);
+            }
+        }
+    }
+}
+
+/***********************************************************************
+ * A transport that cycles through prepared packets for benchmarks
+ **********************************************************************/
+class bench_mrb : public uhd::transport::managed_recv_buffer{
+public:
+    void release(void){
+        //NOP
+    }
+
+    sptr get_new(const std::vector<boost::uint32_t> &mem){
+        _mem = &mem;
+        return make_managed_buffer(this);
+    }
+
+private:
+    const void *get_buff(void) const{return &_mem->front();}
+    size_t get_size(void) const{return _mem->size()*sizeof(boost::uint32_t);}
+
+    const std::vector<boost::uint32_t> *_mem;
+};
+
+class bench_recv_xport_class{
+public:
+    bench_recv_xport_class(const size_t num_payload_words32):
+        _mems(16), _mrbs(16), _index(0)
+    {
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        ifpi.num_payload_words32 = num_payload_words32;
+        ifpi.sob = false;
+        ifpi.eob = false;
+        ifpi.has_sid = false;
+        ifpi.has_cid = false;
+        ifpi.has_tsi = true;
+        ifpi.has_tsf = true;
+        ifpi.tsi = 0;
+        ifpi.tsf = 0; //same time for all, never out of order
+        ifpi.has_tlr = false;
+        for (size_t i = 0; i < _mems.size(); i++){
+            ifpi.packet_count = i;
+            _mems[i].resize(num_payload_words32 + uhd::transport::vrt::max_if_hdr_words32);
+            uhd::transport::vrt::if_hdr_pack_be(&_mems[i].front(), ifpi);
+            _mems[i].resize(ifpi.num_packet_words32);
+        }
+    }
+
+    UHD_INLINE uhd::transport::managed_recv_buffer::sptr get_recv_buff(double){
+        const size_t index = _index;
+        _index = (_index + 1)%_mems.size();
+        return _mrbs[index].get_new(_mems[index]);
+    }
+
+private:
+    std::vector<std::vector<boost::uint32_t> > _mems;
+    std::vector<bench_mrb> _mrbs;
+    size_t _index;
+};
+
+//! The buffer getter policy for the specialized handler
+class bench_get_recv_buff{
+public:
+    bench_get_recv_buff(void): _xport(NULL){}
+    bench_get_recv_buff(bench_recv_xport_class *xport): _xport(xport){}
+    UHD_INLINE uhd::transport::managed_recv_buffer::sptr operator()(double timeout) const{
+        return _xport->get_recv_buff(timeout);
+    }
+private:
+    bench_recv_xport_class *_xport;
+};
+
+template <typename handler_type> static double bench_recv(
+    handler_type &handler, const size_t num_samps, const size_t num_packets
+){
+    std::vector<std::complex<boost::int16_t> > buff(num_samps);
+    uhd::rx_metadata_t metadata;
+    const boost::system_time start = boost::get_system_time();
+    for (size_t i = 0; i < num_packets; i++){
+        handler.recv(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_INT16,
+            uhd::device::RECV_MODE_ONE_PACKET, 1.0
+        );
+    }
+    BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+    return (boost::get_system_time() - start).total_microseconds()*1e3/num_packets;
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_benchmark){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const size_t NUM_PKTS_TO_TEST = 200000;
+    static const size_t NUM_SAMPS_PER_PKT = 100;
+    bench_recv_xport_class bench_recv_xport(NUM_SAMPS_PER_PKT);
+
+    //the handler with run-time function objects
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    handler.set_xport_chan_get_buff(0, boost::bind(&bench_recv_xport_class::get_recv_buff, &bench_recv_xport, _1));
+    handler.set_converter(otw_type);
+
+    //the handler specialized at compile-time
+    uhd::transport::sph::recv_packet_handler_t<bench_get_recv_buff, uhd::transport::sph::vrt_unpack_be> fast_handler(1);
+    fast_handler.set_vrt_unpacker(uhd::transport::sph::vrt_unpack_be());
+    fast_handler.set_tick_rate(100e6);
+    fast_handler.set_samp_rate(10e6);
+    fast_handler.set_xport_chan_get_buff(0, bench_get_recv_buff(&bench_recv_xport));
+    fast_handler.set_converter(otw_type);
+
+    const double ns = bench_recv(handler, NUM_SAMPS_PER_PKT, NUM_PKTS_TO_TEST);
+    const double fast_ns = bench_recv(fast_handler, NUM_SAMPS_PER_PKT, NUM_PKTS_TO_TEST);
+    std::cout << boost::format(
+        "recv %u samps/packet: %.1f ns/packet (run-time), %.1f ns/packet (specialized)"
+    ) % NUM_SAMPS_PER_PKT % ns % fast_ns << std::endl;
+}
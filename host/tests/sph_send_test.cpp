@@ -19,6 +19,11 @@
 #include "../lib/transport/super_send_packet_handler.hpp"
 #include <boost/shared_array.hpp>
 #include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <algorithm>
 #include <complex>
 #include <vector>
 #include <list>
@@ -32,13 +37,15 @@
 class dummy_msb : public uhd::transport::managed_send_buffer{
 public:
     void commit(size_t len){
-        if (len == 0) return;
-        *_len = len;
+        if (_committed) return;
+        _committed = true;
+        *_len = len; //zero when discarded, nothing is sent
     }
 
     sptr get_new(boost::shared_array<char> mem, size_t *len){
         _mem = mem;
         _len = len;
+        _committed = false;
         return make_managed_buffer(this);
     }
 
@@ -48,6 +55,7 @@ private:
 
     boost::shared_array<char> _mem;
     size_t *_len;
+    bool _committed;
 };
 
 /***********************************************************************
@@ -57,20 +65,65 @@ class dummy_send_xport_class{
 public:
     dummy_send_xport_class(const uhd::otw_type_t &otw_type){
         _otw_type = otw_type;
+        _max_batch = 0;
+        _num_batches = 0;
+        _max_buffs = ~size_t(0);
+        _num_returned = 0;
+    }
+
+    //limit the buffers handed out in batches (the next batches time out)
+    void set_max_buffs(size_t max_buffs){
+        _max_buffs = max_buffs;
+    }
+
+    size_t get_num_returned(void) const{
+        return _num_returned;
+    }
+
+    //the number of buffers committed with a length (sent on a real transport)
+    size_t get_num_sent(void) const{
+        return _lens.size() - std::count(_lens.begin(), _lens.end(), size_t(0));
+    }
+
+    //limit the buffers per batch (zero for no limit)
+    void set_max_batch(size_t max_batch){
+        _max_batch = max_batch;
+    }
+
+    size_t get_num_batches(void) const{
+        return _num_batches;
     }
 
     void pop_front_packet(
-        uhd::transport::vrt::if_packet_info_t &ifpi
+        uhd::transport::vrt::if_packet_info_t &ifpi,
+        std::vector<boost::uint32_t> *payload = NULL
     ){
+        const boost::uint32_t *mem = reinterpret_cast<boost::uint32_t *>(_mems.front().get());
         ifpi.num_packet_words32 = _lens.front()/sizeof(boost::uint32_t);
         if (_otw_type.byteorder == uhd::otw_type_t::BO_BIG_ENDIAN){
-            uhd::transport::vrt::if_hdr_unpack_be(reinterpret_cast<boost::uint32_t *>(_mems.front().get()), ifpi);
+            uhd::transport::vrt::if_hdr_unpack_be(mem, ifpi);
         }
         if (_otw_type.byteorder == uhd::otw_type_t::BO_LITTLE_ENDIAN){
-            uhd::transport::vrt::if_hdr_unpack_le(reinterpret_cast<boost::uint32_t *>(_mems.front().get()), ifpi);
+            uhd::transport::vrt::if_hdr_unpack_le(mem, ifpi);
         }
+        if (payload != NULL) payload->assign(
+            mem + ifpi.num_header_words32,
+            mem + ifpi.num_header_words32 + ifpi.num_payload_words32
+        );
+        _mems.pop_front();
+        _lens.pop_front();
+    }
+
+    std::vector<boost::uint32_t> pop_front_words(void){
+        const boost::uint32_t *mem = reinterpret_cast<boost::uint32_t *>(_mems.front().get());
+        std::vector<boost::uint32_t> words(mem, mem + _lens.front()/sizeof(boost::uint32_t));
         _mems.pop_front();
         _lens.pop_front();
+        return words;
+    }
+
+    size_t size(void) const{
+        return _mems.size();
     }
 
     uhd::transport::managed_send_buffer::sptr get_send_buff(double){
@@ -81,11 +134,28 @@ public:
         return mrb;
     }
 
+    size_t get_send_buffs(std::vector<uhd::transport::managed_send_buffer::sptr> &buffs, size_t max, double timeout){
+        if (_max_batch != 0) max = std::min(max, _max_batch);
+        max = std::min(max, _max_buffs);
+        if (max == 0) return 0;
+        for (size_t i = 0; i < max; i++) buffs.push_back(this->get_send_buff(timeout));
+        _max_buffs -= max;
+        _num_batches++;
+        return max;
+    }
+
+    void return_send_buffs(std::vector<uhd::transport::managed_send_buffer::sptr> &buffs){
+        _num_returned += buffs.size();
+        buffs.clear();
+    }
+
 private:
     std::list<boost::shared_array<char> > _mems;
     std::list<size_t> _lens;
     std::list<dummy_msb> _msbs; //list means no-realloc
     uhd::otw_type_t _otw_type;
+    size_t _max_batch, _num_batches;
+    size_t _max_buffs, _num_returned;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -147,6 +217,71 @@ BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_one_packet_mode){
     }
 }
 
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_sc8){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 8;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    dummy_send_xport_class dummy_send_xport(otw_type);
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xport, _1));
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(20);
+
+    //sample n is (n, -n) in the upper byte
+    std::vector<std::complex<boost::int16_t> > buff(20);
+    uhd::tx_metadata_t metadata;
+    metadata.has_time_spec = true;
+    metadata.time_spec = uhd::time_spec_t(0.0);
+
+    //send packets of odd and even lengths
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        for (size_t j = 0; j < buff.size(); j++){
+            const boost::int8_t n = boost::int8_t(i + j);
+            buff[j] = std::complex<boost::int16_t>(n << 8, boost::int8_t(-n) << 8);
+        }
+        metadata.start_of_burst = (i == 0);
+        metadata.end_of_burst = (i == NUM_PKTS_TO_TEST-1);
+        const size_t num_sent = handler.send(
+            &buff.front(), 10 + i%10, metadata,
+            uhd::io_type_t::COMPLEX_INT16,
+            uhd::device::SEND_MODE_ONE_PACKET, 1.0
+        );
+        BOOST_CHECK_EQUAL(num_sent, 10 + i%10);
+        metadata.time_spec += uhd::time_spec_t(0, num_sent, SAMP_RATE);
+    }
+
+    //check the sent packets: two samples per word, an odd sample is padded
+    size_t num_accum_samps = 0;
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    std::vector<boost::uint32_t> payload;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        const size_t nsamps = 10 + i%10;
+        dummy_send_xport.pop_front_packet(ifpi, &payload);
+        BOOST_CHECK_EQUAL(ifpi.num_payload_words32, (nsamps+1)/2);
+        BOOST_CHECK_EQUAL(ifpi.tsf, num_accum_samps*TICK_RATE/SAMP_RATE);
+        for (size_t j = 0; j < ifpi.num_payload_words32*2; j++){
+            const boost::uint8_t n = boost::uint8_t(i + j);
+            const boost::uint32_t bits = (j < nsamps)? ((n << 8) | boost::uint8_t(-n)) : 0;
+            BOOST_CHECK_EQUAL((uhd::ntohx(payload[j/2]) >> ((j%2 == 0)? 16 : 0)) & 0xffff, bits);
+        }
+        num_accum_samps += nsamps;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_full_buffer_mode){
 ////////////////////////////////////////////////////////////////////////
@@ -202,3 +337,479 @@ BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_full_buffer_mode){
         num_accum_samps += ifpi.num_payload_words32;
     }
 }
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_multi_channel_full_buffer_batched){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 70;
+    static const size_t NCHANNELS = 2;
+
+    std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class(otw_type));
+    dummy_send_xports[1].set_max_batch(5); //the second channel shrinks the batches
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+        handler.set_xport_chan_get_buffs(ch, boost::bind(&dummy_send_xport_class::get_send_buffs, &dummy_send_xports[ch], _1, _2, _3));
+    }
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(20);
+
+    //allocate metadata and buffers with a ramp per channel
+    std::vector<std::complex<boost::int16_t> > mem(20*NUM_PKTS_TO_TEST*NCHANNELS - 5*NCHANNELS);
+    const size_t nsamps_per_buff = mem.size()/NCHANNELS;
+    std::vector<std::complex<boost::int16_t> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*nsamps_per_buff];
+        for (size_t j = 0; j < nsamps_per_buff; j++){
+            buffs[ch][j] = std::complex<boost::int16_t>(boost::int16_t(ch), boost::int16_t(j));
+        }
+    }
+    uhd::tx_metadata_t metadata;
+    metadata.start_of_burst = true;
+    metadata.end_of_burst = true;
+    metadata.has_time_spec = true;
+    metadata.time_spec = uhd::time_spec_t(0.0);
+
+    const size_t num_sent = handler.send(
+        buffs, nsamps_per_buff, metadata,
+        uhd::io_type_t::COMPLEX_INT16,
+        uhd::device::SEND_MODE_FULL_BUFF, 1.0
+    );
+    BOOST_CHECK_EQUAL(num_sent, nsamps_per_buff);
+
+    //check the sent packets
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        size_t num_accum_samps = 0;
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        std::vector<boost::uint32_t> payload;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            std::cout << "data check " << i << std::endl;
+            dummy_send_xports[ch].pop_front_packet(ifpi, &payload);
+            BOOST_CHECK_EQUAL(ifpi.num_payload_words32, (i == NUM_PKTS_TO_TEST-1)? 15 : 20);
+            BOOST_CHECK_EQUAL(ifpi.packet_count, i%16);
+            BOOST_CHECK(ifpi.has_tsi);
+            BOOST_CHECK(ifpi.has_tsf);
+            BOOST_CHECK_EQUAL(ifpi.tsf, num_accum_samps*TICK_RATE/SAMP_RATE);
+            BOOST_CHECK_EQUAL(ifpi.sob, i == 0);
+            BOOST_CHECK_EQUAL(ifpi.eob, i == NUM_PKTS_TO_TEST-1);
+            for (size_t j = 0; j < payload.size(); j++){
+                BOOST_CHECK_EQUAL(uhd::ntohx(payload[j]), boost::uint32_t((ch << 16) | (num_accum_samps + j)));
+            }
+            num_accum_samps += ifpi.num_payload_words32;
+        }
+        BOOST_CHECK_EQUAL(dummy_send_xports[ch].size(), size_t(0));
+    }
+
+    //one claim per batch of five on the limited channel
+    BOOST_CHECK_EQUAL(dummy_send_xports[1].get_num_batches(), NUM_PKTS_TO_TEST/5);
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_multi_channel_batched_timeout){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const size_t NUM_PKTS_TO_TEST = 20;
+    static const size_t NUM_PKTS_AVAILABLE = 7;
+    static const size_t NCHANNELS = 2;
+
+    std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class(otw_type));
+    dummy_send_xports[1].set_max_buffs(NUM_PKTS_AVAILABLE); //the second channel times out
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+        handler.set_xport_chan_get_buffs(ch,
+            boost::bind(&dummy_send_xport_class::get_send_buffs, &dummy_send_xports[ch], _1, _2, _3),
+            boost::bind(&dummy_send_xport_class::return_send_buffs, &dummy_send_xports[ch], _1)
+        );
+    }
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(20);
+
+    std::vector<std::complex<boost::int16_t> > mem(20*NUM_PKTS_TO_TEST*NCHANNELS);
+    const size_t nsamps_per_buff = mem.size()/NCHANNELS;
+    std::vector<std::complex<boost::int16_t> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        buffs[ch] = &mem[ch*nsamps_per_buff];
+    }
+    uhd::tx_metadata_t metadata;
+
+    const size_t num_sent = handler.send(
+        buffs, nsamps_per_buff, metadata,
+        uhd::io_type_t::COMPLEX_INT16,
+        uhd::device::SEND_MODE_FULL_BUFF, 0.0
+    );
+    BOOST_CHECK_EQUAL(num_sent, 20*NUM_PKTS_AVAILABLE);
+
+    //the buffers claimed but not sent go back to the transport unsent
+    BOOST_CHECK_EQUAL(dummy_send_xports[0].get_num_returned(), NUM_PKTS_TO_TEST - NUM_PKTS_AVAILABLE);
+    BOOST_CHECK_EQUAL(dummy_send_xports[1].get_num_returned(), size_t(0));
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        BOOST_CHECK_EQUAL(dummy_send_xports[ch].get_num_sent(), NUM_PKTS_AVAILABLE);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_multi_channel_borrow){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NCHANNELS = 2;
+
+    std::vector<dummy_send_xport_class> dummy_send_xports(NCHANNELS, dummy_send_xport_class(otw_type));
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(NCHANNELS);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        handler.set_xport_chan_get_buff(ch, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[ch], _1));
+    }
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(20);
+
+    uhd::tx_metadata_t metadata;
+    metadata.has_time_spec = true;
+    metadata.time_spec = uhd::time_spec_t(0.0);
+
+    //fill the borrowed packets in place with a counter per channel
+    uhd::device::send_views_type views;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        metadata.start_of_burst = (i == 0);
+        metadata.end_of_burst = (i == NUM_PKTS_TO_TEST-1);
+        uhd::device::send_commit_type commit = handler.borrow(views, metadata, 1.0);
+        BOOST_REQUIRE(not commit.empty());
+        BOOST_REQUIRE_EQUAL(views.size(), NCHANNELS);
+        const size_t nsamps = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            BOOST_REQUIRE_EQUAL(views[ch].nsamps, size_t(20));
+            boost::uint32_t *items = reinterpret_cast<boost::uint32_t *>(views[ch].mem);
+            for (size_t j = 0; j < nsamps; j++) items[j] = boost::uint32_t((ch << 16) | (i << 8) | j);
+        }
+        BOOST_CHECK_EQUAL(commit(nsamps), nsamps);
+        BOOST_CHECK_EQUAL(commit(nsamps), size_t(0)); //only once
+        metadata.time_spec += uhd::time_spec_t(0, nsamps, SAMP_RATE);
+    }
+
+    //a normal send after the borrows continues the sequence
+    std::vector<std::complex<float> > mem(20*NCHANNELS);
+    std::vector<std::complex<float> *> buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++) buffs[ch] = &mem[ch*20];
+    metadata.start_of_burst = false;
+    metadata.end_of_burst = false;
+    BOOST_CHECK_EQUAL(handler.send(
+        buffs, 20, metadata, uhd::io_type_t::COMPLEX_FLOAT32,
+        uhd::device::SEND_MODE_ONE_PACKET, 1.0
+    ), size_t(20));
+
+    //check the sent packets
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        size_t num_accum_samps = 0;
+        uhd::transport::vrt::if_packet_info_t ifpi;
+        std::vector<boost::uint32_t> payload;
+        for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+            std::cout << "data check " << i << std::endl;
+            dummy_send_xports[ch].pop_front_packet(ifpi, &payload);
+            BOOST_CHECK_EQUAL(ifpi.num_payload_words32, 10+i%10);
+            BOOST_CHECK_EQUAL(ifpi.packet_count, i%16);
+            BOOST_CHECK(ifpi.has_tsi);
+            BOOST_CHECK(ifpi.has_tsf);
+            BOOST_CHECK_EQUAL(ifpi.tsf, num_accum_samps*TICK_RATE/SAMP_RATE);
+            BOOST_CHECK_EQUAL(ifpi.sob, i == 0);
+            BOOST_CHECK_EQUAL(ifpi.eob, i == NUM_PKTS_TO_TEST-1);
+            for (size_t j = 0; j < payload.size(); j++){
+                BOOST_CHECK_EQUAL(payload[j], boost::uint32_t((ch << 16) | (i << 8) | j));
+            }
+            num_accum_samps += ifpi.num_payload_words32;
+        }
+        dummy_send_xports[ch].pop_front_packet(ifpi);
+        BOOST_CHECK_EQUAL(ifpi.num_payload_words32, size_t(20));
+        BOOST_CHECK_EQUAL(ifpi.packet_count, NUM_PKTS_TO_TEST%16);
+    }
+}
+
+//borrow one packet and commit it, for a second sender thread
+static void borrow_and_commit(
+    uhd::transport::sph::send_packet_handler *handler,
+    const size_t nsamps, uhd::atomic_uint32_t *num_done
+){
+    uhd::device::send_views_type views;
+    uhd::device::send_commit_type commit = handler->borrow(views, uhd::tx_metadata_t(), 1.0);
+    if (not commit.empty()) commit(nsamps);
+    num_done->inc();
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_borrow_threads){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    dummy_send_xport_class dummy_send_xport(otw_type);
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xport, _1));
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(20);
+
+    //a second borrower blocks until the first one commits
+    uhd::device::send_views_type views;
+    uhd::atomic_uint32_t num_done;
+    uhd::device::send_commit_type commit = handler.borrow(views, uhd::tx_metadata_t(), 1.0);
+    BOOST_REQUIRE(not commit.empty());
+    boost::thread sender(boost::bind(&borrow_and_commit, &handler, 5, &num_done));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    BOOST_CHECK_EQUAL(num_done.read(), boost::uint32_t(0));
+    BOOST_CHECK_EQUAL(commit(10), size_t(10));
+    BOOST_REQUIRE(sender.timed_join(boost::posix_time::seconds(1)));
+    BOOST_CHECK_EQUAL(num_done.read(), boost::uint32_t(1));
+
+    //the packets went out one after the other
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    BOOST_REQUIRE_EQUAL(dummy_send_xport.size(), size_t(2));
+    dummy_send_xport.pop_front_packet(ifpi);
+    BOOST_CHECK_EQUAL(ifpi.num_payload_words32, size_t(10));
+    BOOST_CHECK_EQUAL(ifpi.packet_count, size_t(0));
+    dummy_send_xport.pop_front_packet(ifpi);
+    BOOST_CHECK_EQUAL(ifpi.num_payload_words32, size_t(5));
+    BOOST_CHECK_EQUAL(ifpi.packet_count, size_t(1));
+
+    //an old commit function neither holds nor commits a newer borrow
+    BOOST_REQUIRE(not handler.borrow(views, uhd::tx_metadata_t(), 1.0).empty()); //dropped unused
+    BOOST_CHECK_EQUAL(commit(10), size_t(0));
+    boost::thread late_sender(boost::bind(&borrow_and_commit, &handler, 7, &num_done));
+    BOOST_REQUIRE(late_sender.timed_join(boost::posix_time::seconds(1)));
+    BOOST_REQUIRE_EQUAL(dummy_send_xport.size(), size_t(2));
+    BOOST_CHECK(dummy_send_xport.pop_front_words().empty()); //the dropped borrow sent nothing
+    dummy_send_xport.pop_front_packet(ifpi);
+    BOOST_CHECK_EQUAL(ifpi.num_payload_words32, size_t(7));
+    BOOST_CHECK_EQUAL(ifpi.packet_count, size_t(2));
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_header_templates){
+////////////////////////////////////////////////////////////////////////
+    static const double TICK_RATE = 100e6;
+    const double samp_rates[] = {25e6, 3e6}; //integral and non-integral ticks per sample
+
+    for (size_t b = 0; b < 2; b++) for (size_t r = 0; r < 2; r++){
+        uhd::otw_type_t otw_type;
+        otw_type.width = 16;
+        otw_type.shift = 0;
+        otw_type.byteorder = (b == 0)?
+            uhd::otw_type_t::BO_BIG_ENDIAN :
+            uhd::otw_type_t::BO_LITTLE_ENDIAN;
+
+        //the same bursts from handlers with and without header templates
+        std::vector<dummy_send_xport_class> dummy_send_xports(2, dummy_send_xport_class(otw_type));
+        for (size_t i = 0; i < 2; i++){
+            uhd::transport::sph::send_packet_handler handler(1);
+            handler.set_vrt_packer((b == 0)?
+                &uhd::transport::vrt::if_hdr_pack_be :
+                &uhd::transport::vrt::if_hdr_pack_le
+            );
+            handler.set_header_templates(i == 0);
+            handler.set_tick_rate(TICK_RATE);
+            handler.set_samp_rate(samp_rates[r]);
+            handler.set_xport_chan_get_buff(0, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xports[i], _1));
+            handler.set_converter(otw_type);
+            handler.set_max_samples_per_packet(20);
+
+            //bursts that cross a second boundary, with and without time
+            std::vector<std::complex<float> > buff(20*30);
+            uhd::tx_metadata_t metadata;
+            for (size_t j = 0; j < 4; j++){
+                metadata.start_of_burst = (j%2 == 0);
+                metadata.end_of_burst = (j%2 == 1);
+                metadata.has_time_spec = (j < 2);
+                metadata.time_spec = uhd::time_spec_t(1.0) - uhd::time_spec_t(0, 100*(j+1), samp_rates[r]);
+                BOOST_CHECK_EQUAL(handler.send(
+                    &buff.front(), buff.size() - j, metadata,
+                    uhd::io_type_t::COMPLEX_FLOAT32,
+                    uhd::device::SEND_MODE_FULL_BUFF, 1.0
+                ), buff.size() - j);
+            }
+            handler.send(
+                &buff.front(), 0, metadata,
+                uhd::io_type_t::COMPLEX_FLOAT32,
+                uhd::device::SEND_MODE_ONE_PACKET, 1.0
+            );
+        }
+
+        //the packets are identical to the words
+        BOOST_REQUIRE_EQUAL(dummy_send_xports[0].size(), dummy_send_xports[1].size());
+        while (dummy_send_xports[0].size() != 0){
+            const std::vector<boost::uint32_t> words = dummy_send_xports[0].pop_front_words();
+            const std::vector<boost::uint32_t> expected = dummy_send_xports[1].pop_front_words();
+            BOOST_REQUIRE_EQUAL(words.size(), expected.size());
+            for (size_t k = 0; k < words.size(); k++) BOOST_CHECK_EQUAL(words[k], expected[k]);
+        }
+    }
+}
+
+/***********************************************************************
+ * A transport that sends into one buffer for benchmarks
+ **********************************************************************/
+class bench_msb : public uhd::transport::managed_send_buffer{
+public:
+    void commit(size_t){
+        //NOP
+    }
+
+    sptr get_new(std::vector<boost::uint32_t> &mem){
+        _mem = &mem;
+        return make_managed_buffer(this);
+    }
+
+private:
+    void *get_buff(void) const{return &_mem->front();}
+    size_t get_size(void) const{return _mem->size()*sizeof(boost::uint32_t);}
+
+    std::vector<boost::uint32_t> *_mem;
+};
+
+class bench_send_xport_class{
+public:
+    bench_send_xport_class(void): _mem(1000/sizeof(boost::uint32_t)){}
+
+    UHD_INLINE uhd::transport::managed_send_buffer::sptr get_send_buff(double){
+        return _msb.get_new(_mem);
+    }
+
+private:
+    std::vector<boost::uint32_t> _mem;
+    bench_msb _msb;
+};
+
+//! The buffer getter policy for the specialized handler
+class bench_get_send_buff{
+public:
+    bench_get_send_buff(void): _xport(NULL){}
+    bench_get_send_buff(bench_send_xport_class *xport): _xport(xport){}
+    UHD_INLINE uhd::transport::managed_send_buffer::sptr operator()(double timeout) const{
+        return _xport->get_send_buff(timeout);
+    }
+private:
+    bench_send_xport_class *_xport;
+};
+
+template <typename handler_type> static double bench_send(
+    handler_type &handler, const size_t num_samps, const size_t num_packets
+){
+    std::vector<std::complex<boost::int16_t> > buff(num_samps);
+    uhd::tx_metadata_t metadata;
+    metadata.has_time_spec = false;
+    const boost::system_time start = boost::get_system_time();
+    for (size_t i = 0; i < num_packets; i++){
+        handler.send(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_INT16,
+            uhd::device::SEND_MODE_ONE_PACKET, 1.0
+        );
+    }
+    return (boost::get_system_time() - start).total_microseconds()*1e3/num_packets;
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_benchmark){
+////////////////////////////////////////////////////////////////////////
+    uhd::otw_type_t otw_type;
+    otw_type.width = 16;
+    otw_type.shift = 0;
+    otw_type.byteorder = uhd::otw_type_t::BO_BIG_ENDIAN;
+
+    static const size_t NUM_PKTS_TO_TEST = 200000;
+    static const size_t NUM_SAMPS_PER_PKT = 100;
+    bench_send_xport_class bench_send_xport;
+
+    //the handler with run-time function objects
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    handler.set_xport_chan_get_buff(0, boost::bind(&bench_send_xport_class::get_send_buff, &bench_send_xport, _1));
+    handler.set_converter(otw_type);
+    handler.set_max_samples_per_packet(NUM_SAMPS_PER_PKT);
+
+    //the handler specialized at compile-time
+    uhd::transport::sph::send_packet_handler_t<bench_get_send_buff, uhd::transport::sph::vrt_pack_be> fast_handler(1);
+    fast_handler.set_vrt_packer(uhd::transport::sph::vrt_pack_be());
+    fast_handler.set_tick_rate(100e6);
+    fast_handler.set_samp_rate(10e6);
+    fast_handler.set_xport_chan_get_buff(0, bench_get_send_buff(&bench_send_xport));
+    fast_handler.set_converter(otw_type);
+    fast_handler.set_max_samples_per_packet(NUM_SAMPS_PER_PKT);
+
+    const double ns = bench_send(handler, NUM_SAMPS_PER_PKT, NUM_PKTS_TO_TEST);
+    const double fast_ns = bench_send(fast_handler, NUM_SAMPS_PER_PKT, NUM_PKTS_TO_TEST);
+
+    //the specialized handler with the samples written in place
+    uhd::tx_metadata_t metadata;
+    metadata.has_time_spec = false;
+    uhd::device::send_views_type views;
+    const boost::system_time start = boost::get_system_time();
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        fast_handler.borrow(views, metadata, 1.0)(NUM_SAMPS_PER_PKT);
+    }
+    const double borrow_ns = (boost::get_system_time() - start).total_microseconds()*1e3/NUM_PKTS_TO_TEST;
+
+    std::cout << boost::format(
+        "send %u samps/packet: %.1f ns/packet (run-time), %.1f ns/packet (specialized), %.1f ns/packet (borrowed)"
+    ) % NUM_SAMPS_PER_PKT % ns % fast_ns % borrow_ns << std::endl;
+
+    //small fragments of a timed burst, where the header dominates
+    static const size_t NUM_SAMPS_PER_FRAG = 4;
+    std::vector<std::complex<boost::int16_t> > buff(NUM_SAMPS_PER_FRAG*NUM_PKTS_TO_TEST);
+    metadata.has_time_spec = true;
+    metadata.start_of_burst = true;
+    metadata.end_of_burst = true;
+    fast_handler.set_max_samples_per_packet(NUM_SAMPS_PER_FRAG);
+    double frag_ns[2];
+    for (size_t i = 0; i < 2; i++){
+        fast_handler.set_header_templates(i == 1);
+        const boost::system_time frag_start = boost::get_system_time();
+        fast_handler.send(
+            &buff.front(), buff.size(), metadata,
+            uhd::io_type_t::COMPLEX_INT16,
+            uhd::device::SEND_MODE_FULL_BUFF, 1.0
+        );
+        frag_ns[i] = (boost::get_system_time() - frag_start).total_microseconds()*1e3/NUM_PKTS_TO_TEST;
+    }
+
+    std::cout << boost::format(
+        "send %u samps/fragment: %.1f ns/fragment (vrt packer), %.1f ns/fragment (header templates)"
+    ) % NUM_SAMPS_PER_FRAG % frag_ns[0] % frag_ns[1] << std::endl;
+}
@@ -97,3 +97,92 @@ BOOST_AUTO_TEST_CASE(test_time_spec_neg_values){
     BOOST_CHECK(tsa > tsb);
     BOOST_CHECK(tsc > tsd);
 }
+
+#include <uhd/types/tick_spec.hpp>
+#include <boost/cstdint.hpp>
+#include <cstdlib>
+
+BOOST_AUTO_TEST_CASE(test_tick_spec_equivalence){
+    std::cout << "Testing tick specification equivalence..." << std::endl;
+    static const double TICK_RATE = 100e6;
+
+    for (size_t i = 0; i < 1000; i++){
+        const time_t secs = std::rand()%100000;
+        const long ticks = std::rand()%long(TICK_RATE);
+        const uhd::tick_spec_t tick_spec(secs, boost::uint64_t(ticks), TICK_RATE);
+        const uhd::time_spec_t time_spec(secs, ticks, TICK_RATE);
+
+        //the same time either way, and back to the same ticks
+        BOOST_CHECK_EQUAL(tick_spec.get_ticks(), boost::int64_t(secs)*100000000 + ticks);
+        BOOST_CHECK_EQUAL(tick_spec.to_time_spec().get_full_secs(), time_spec.get_full_secs());
+        BOOST_CHECK_EQUAL(tick_spec.to_time_spec().get_tick_count(TICK_RATE), time_spec.get_tick_count(TICK_RATE));
+        BOOST_CHECK(uhd::tick_spec_t(time_spec, TICK_RATE) == tick_spec);
+        BOOST_CHECK(uhd::tick_spec_t(tick_spec.to_time_spec(), TICK_RATE) == tick_spec);
+    }
+
+    //negative times keep positive fractional seconds
+    const uhd::time_spec_t neg = uhd::tick_spec_t(-110, 100).to_time_spec();
+    BOOST_CHECK_EQUAL(neg.get_full_secs(), -2);
+    BOOST_CHECK_EQUAL(neg.get_tick_count(100), 90);
+    BOOST_CHECK_EQUAL(uhd::tick_spec_t(neg, 100).get_ticks(), -110);
+
+    //a fractional tick rate rounds to the nearest tick
+    const double frac_rate = 100e6/3;
+    const uhd::tick_spec_t frac_spec(boost::int64_t(123456789012LL), frac_rate);
+    BOOST_CHECK_EQUAL(uhd::tick_spec_t(frac_spec.to_time_spec(), frac_rate).get_ticks(), frac_spec.get_ticks());
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_spec_arithmetic){
+    std::cout << "Testing tick specification arithmetic..." << std::endl;
+    static const double TICK_RATE = 100e6;
+
+    //a day of 363-sample packets at 25 Msps: the ticks are exact
+    const boost::int64_t ticks_per_packet = 363*4;
+    const boost::int64_t num_packets = boost::int64_t(24*3600*25e6/363);
+    uhd::tick_spec_t tick_spec(0, TICK_RATE);
+    uhd::time_spec_t time_spec(0.0);
+    for (boost::int64_t i = 0; i < num_packets; i += 1000){
+        tick_spec += 1000*ticks_per_packet;
+        time_spec += uhd::time_spec_t(0, long(1000*ticks_per_packet), TICK_RATE);
+    }
+    BOOST_CHECK_EQUAL(tick_spec.get_ticks() % ticks_per_packet, 0);
+    CHECK_TS_EQUAL(tick_spec.to_time_spec(), time_spec);
+
+    //the operators on mixed tick rates go through the time spec
+    BOOST_CHECK(uhd::tick_spec_t(100, 100) == uhd::tick_spec_t(1000, 1000));
+    BOOST_CHECK(uhd::tick_spec_t(100, 100) < uhd::tick_spec_t(1001, 1000));
+    BOOST_CHECK_EQUAL((uhd::tick_spec_t(100, 100) + uhd::tick_spec_t(1000, 1000)).get_ticks(), 200);
+    BOOST_CHECK_EQUAL((uhd::tick_spec_t(100, 100) - 30).get_ticks(), 70);
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_spec_speed){
+    std::cout << "Testing tick specification speed..." << std::endl;
+    static const double TICK_RATE = 100e6;
+    static const size_t NUM_PACKETS = 1000000;
+
+    //construct a timestamp per packet, compare it, and advance the expected time
+    size_t num_time_ordered = 0, num_tick_ordered = 0;
+    const uhd::time_spec_t time_start = uhd::time_spec_t::get_system_time();
+    uhd::time_spec_t time_next(0.0);
+    for (size_t i = 0; i < NUM_PACKETS; i++){
+        const uhd::time_spec_t time(time_t(i/1000), long((i%1000)*100000), TICK_RATE);
+        if (not (time < time_next)) num_time_ordered++;
+        time_next = time + uhd::time_spec_t(0, 100000, TICK_RATE);
+    }
+    const double time_elapsed = (uhd::time_spec_t::get_system_time() - time_start).get_real_secs();
+
+    const uhd::time_spec_t tick_start = uhd::time_spec_t::get_system_time();
+    uhd::tick_spec_t tick_next(0, TICK_RATE);
+    for (size_t i = 0; i < NUM_PACKETS; i++){
+        const uhd::tick_spec_t tick(time_t(i/1000), boost::uint64_t((i%1000)*100000), TICK_RATE);
+        if (not (tick < tick_next)) num_tick_ordered++;
+        tick_next = tick + 100000;
+    }
+    const double tick_elapsed = (uhd::time_spec_t::get_system_time() - tick_start).get_real_secs();
+
+    //the floating point sums may put a timestamp before the expected time
+    BOOST_CHECK_EQUAL(num_tick_ordered, NUM_PACKETS);
+    std::cout << "time_spec_t: " << NUM_PACKETS - num_time_ordered << " timestamps before the expected time" << std::endl;
+    std::cout << "time_spec_t: " << time_elapsed*1e9/NUM_PACKETS << " ns/packet" << std::endl;
+    std::cout << "tick_spec_t: " << tick_elapsed*1e9/NUM_PACKETS << " ns/packet" << std::endl;
+}
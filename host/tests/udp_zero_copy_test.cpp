@@ -0,0 +1,93 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/transport/udp_common.hpp"
+#include <uhd/transport/udp_zero_copy.hpp>
+#include <uhd/transport/udp_simple.hpp> //mtu
+#include <boost/lexical_cast.hpp>
+#include <cstring>
+#include <vector>
+
+using namespace uhd::transport;
+namespace asio = boost::asio;
+
+/***********************************************************************
+ * A loopback receiver for the datagrams of a udp transport
+ **********************************************************************/
+class loopback_receiver{
+public:
+    loopback_receiver(void):
+        _socket(_io_service, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0))
+    {
+        /* NOP */
+    }
+
+    udp_zero_copy::sptr make_xport(void){
+        return udp_zero_copy::make("127.0.0.1",
+            boost::lexical_cast<std::string>(_socket.local_endpoint().port())
+        );
+    }
+
+    //the number of datagrams waiting, an empty datagram counts too
+    size_t num_datagrams(void){
+        std::vector<char> mem(udp_simple::mtu);
+        size_t num_datagrams = 0;
+        while (wait_for_recv_ready(_socket.native(), 0.1)){
+            _socket.receive(asio::buffer(mem));
+            num_datagrams++;
+        }
+        return num_datagrams;
+    }
+
+private:
+    asio::io_service _io_service;
+    asio::ip::udp::socket _socket;
+};
+
+BOOST_AUTO_TEST_CASE(test_udp_zero_copy_dropped_buffs){
+    loopback_receiver receiver;
+    udp_zero_copy::sptr xport = receiver.make_xport();
+
+    //a dropped buffer goes back to the transport unsent
+    for (size_t i = 0; i < xport->get_num_send_frames()*2; i++){
+        BOOST_REQUIRE(xport->get_send_buff(0.1).get() != NULL);
+    }
+    BOOST_CHECK_EQUAL(receiver.num_datagrams(), size_t(0));
+
+    //a committed buffer is sent
+    managed_send_buffer::sptr buff = xport->get_send_buff(0.1);
+    BOOST_REQUIRE(buff.get() != NULL);
+    std::memset(buff->cast<void *>(), 0, 100);
+    buff->commit(100);
+    buff.reset();
+    BOOST_CHECK_EQUAL(receiver.num_datagrams(), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(test_udp_zero_copy_returned_batch){
+    loopback_receiver receiver;
+    udp_zero_copy::sptr xport = receiver.make_xport();
+
+    //a batch given back after a timeout (see the send handler) is not sent
+    std::vector<managed_send_buffer::sptr> buffs;
+    BOOST_REQUIRE_EQUAL(xport->get_send_buffs(buffs, 8, 0.1), size_t(8));
+    buffs.clear();
+    BOOST_CHECK_EQUAL(receiver.num_datagrams(), size_t(0));
+
+    //every frame is available again
+    BOOST_CHECK_EQUAL(xport->get_send_buffs(buffs, xport->get_num_send_frames(), 0.1), xport->get_num_send_frames());
+}
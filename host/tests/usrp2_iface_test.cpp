@@ -0,0 +1,271 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "usrp2_iface.hpp"
+#include "fw_common.h"
+#include <boost/asio.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/format.hpp>
+#include <boost/cstdint.hpp>
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <map>
+
+using namespace uhd::transport;
+namespace asio = boost::asio;
+
+/***********************************************************************
+ * A local udp socket that stands in for the usrp2 firmware:
+ *  - A thread answers control requests like the firmware handler.
+ *  - Register writes go into a map and a log of the writes in order.
+ *  - The batch poke request can be disabled to look like older firmware.
+ *  - Each reply can be sent twice to look like a retransmitting network.
+ **********************************************************************/
+class fw_ctrl_emulator{
+public:
+    fw_ctrl_emulator(bool batch_pokes, bool duplicate_replies):
+        _socket(_io_service, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0)),
+        _batch_pokes(batch_pokes), _duplicate_replies(duplicate_replies),
+        _num_requests(0)
+    {
+        _thread = boost::thread(&fw_ctrl_emulator::run, this);
+    }
+
+    ~fw_ctrl_emulator(void){
+        //tell the thread to exit with a peace out request
+        usrp2_ctrl_data_t ctrl_data = usrp2_ctrl_data_t();
+        ctrl_data.id = htonl(USRP2_CTRL_ID_PEACE_OUT);
+        asio::ip::udp::socket socket(_io_service, asio::ip::udp::v4());
+        socket.send_to(asio::buffer(&ctrl_data, sizeof(ctrl_data)), _socket.local_endpoint());
+        _thread.join();
+    }
+
+    std::string get_port(void){
+        return boost::lexical_cast<std::string>(_socket.local_endpoint().port());
+    }
+
+    size_t get_num_requests(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _num_requests;
+    }
+
+    std::vector<std::pair<boost::uint32_t, boost::uint32_t> > get_poke_log(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _poke_log;
+    }
+
+private:
+    void run(void){
+        boost::uint32_t mem[udp_simple::mtu/sizeof(boost::uint32_t)];
+        const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(mem);
+        const usrp2_ctrl_batch_t *batch_in = reinterpret_cast<const usrp2_ctrl_batch_t *>(mem);
+        while (true){
+            asio::ip::udp::endpoint sender;
+            const size_t len = _socket.receive_from(asio::buffer(mem, sizeof(mem)), sender);
+            if (len < sizeof(usrp2_ctrl_data_t)) continue;
+            boost::uint32_t id = ntohl(ctrl_data_in->id);
+            if (id == USRP2_CTRL_ID_PEACE_OUT) return;
+            if (ntohl(ctrl_data_in->proto_ver) != USRP2_FW_COMPAT_NUM) id = USRP2_CTRL_ID_WAZZUP_BRO;
+
+            boost::mutex::scoped_lock lock(_mutex);
+            _num_requests++;
+
+            usrp2_ctrl_data_t ctrl_data_out = usrp2_ctrl_data_t();
+            ctrl_data_out.proto_ver = htonl(USRP2_FW_COMPAT_NUM);
+            ctrl_data_out.id = htonl(USRP2_CTRL_ID_HUH_WHAT);
+            ctrl_data_out.seq = ctrl_data_in->seq;
+
+            switch(id){
+            case USRP2_CTRL_ID_WAZZUP_BRO:
+                ctrl_data_out.id = htonl(USRP2_CTRL_ID_WAZZUP_DUDE);
+                break;
+
+            case USRP2_CTRL_ID_DO_AN_I2C_READ_FOR_ME_BRO: //an erased eeprom
+                std::memset(ctrl_data_out.data.i2c_args.data, 0xff, sizeof(ctrl_data_out.data.i2c_args.data));
+                ctrl_data_out.data.i2c_args.bytes = ctrl_data_in->data.i2c_args.bytes;
+                ctrl_data_out.id = htonl(USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE);
+                break;
+
+            case USRP2_CTRL_ID_WRITE_THESE_I2C_VALUES_BRO:
+                ctrl_data_out.data.i2c_args.bytes = ctrl_data_in->data.i2c_args.bytes;
+                ctrl_data_out.id = htonl(USRP2_CTRL_ID_COOL_IM_DONE_I2C_WRITE_DUDE);
+                break;
+
+            case USRP2_CTRL_ID_GET_THIS_REGISTER_FOR_ME_BRO:{
+                    const boost::uint32_t addr = ntohl(ctrl_data_in->data.reg_args.addr);
+                    switch(ctrl_data_in->data.reg_args.action){
+                    case USRP2_REG_ACTION_FPGA_PEEK32:
+                        ctrl_data_out.data.reg_args.data = htonl(_regs[addr]);
+                        break;
+
+                    case USRP2_REG_ACTION_FPGA_POKE32:
+                        poke(addr, ntohl(ctrl_data_in->data.reg_args.data));
+                        break;
+
+                    case USRP2_REG_ACTION_FW_PEEK32:
+                        ctrl_data_out.data.reg_args.data = htonl(_fw_regs[addr]);
+                        break;
+
+                    case USRP2_REG_ACTION_FW_POKE32:
+                        _fw_regs[addr] = ntohl(ctrl_data_in->data.reg_args.data);
+                        break;
+                    }
+                    ctrl_data_out.id = htonl(USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE);
+                }
+                break;
+
+            case USRP2_CTRL_ID_POKE_THESE_REGISTERS_BRO:{
+                    if (not _batch_pokes) break;
+                    const boost::uint32_t num_pokes = ntohl(ctrl_data_in->data.batch_args.num_pokes);
+                    if (num_pokes > USRP2_CTRL_MAX_BATCH_POKES) break;
+                    if (len < sizeof(usrp2_ctrl_data_t) + num_pokes*sizeof(usrp2_ctrl_poke_t)) break;
+                    for (size_t i = 0; i < num_pokes; i++){
+                        poke(ntohl(batch_in->pokes[i].addr), ntohl(batch_in->pokes[i].data));
+                    }
+                    ctrl_data_out.data.batch_args.num_pokes = htonl(num_pokes);
+                    ctrl_data_out.id = htonl(USRP2_CTRL_ID_POKED_THOSE_REGISTERS_DUDE);
+                }
+                break;
+            }
+
+            _socket.send_to(asio::buffer(&ctrl_data_out, sizeof(ctrl_data_out)), sender);
+            if (_duplicate_replies) _socket.send_to(asio::buffer(&ctrl_data_out, sizeof(ctrl_data_out)), sender);
+        }
+    }
+
+    void poke(boost::uint32_t addr, boost::uint32_t data){
+        _regs[addr] = data;
+        _poke_log.push_back(std::make_pair(addr, data));
+    }
+
+    asio::io_service _io_service;
+    asio::ip::udp::socket _socket;
+    const bool _batch_pokes, _duplicate_replies;
+    boost::thread _thread;
+
+    boost::mutex _mutex;
+    size_t _num_requests;
+    std::map<boost::uint32_t, boost::uint32_t> _regs, _fw_regs;
+    std::vector<std::pair<boost::uint32_t, boost::uint32_t> > _poke_log;
+};
+
+static usrp2_iface::sptr make_iface(fw_ctrl_emulator &fw){
+    return usrp2_iface::make(udp_simple::make_connected("127.0.0.1", fw.get_port()));
+}
+
+static wb_iface::poke32_batch_type make_pokes(size_t num_pokes){
+    wb_iface::poke32_batch_type pokes;
+    for (size_t i = 0; i < num_pokes; i++){
+        pokes.push_back(std::make_pair(boost::uint32_t(4*(i%16)), boost::uint32_t(i*7 + 1)));
+    }
+    return pokes;
+}
+
+/***********************************************************************
+ * Test cases
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_peek_poke){
+    fw_ctrl_emulator fw(true, false);
+    usrp2_iface::sptr iface = make_iface(fw);
+
+    iface->poke32(0x40, 0xdeadbeef);
+    iface->poke32(0x44, 0x12345678);
+    BOOST_CHECK_EQUAL(iface->peek32(0x40), boost::uint32_t(0xdeadbeef));
+    BOOST_CHECK_EQUAL(iface->peek32(0x44), boost::uint32_t(0x12345678));
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_poke32){
+    fw_ctrl_emulator fw(true, false);
+    usrp2_iface::sptr iface = make_iface(fw);
+
+    //more than fit in one batch request
+    const wb_iface::poke32_batch_type pokes = make_pokes(2*USRP2_CTRL_MAX_BATCH_POKES + 3);
+    const size_t num_requests = fw.get_num_requests();
+    iface->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fw.get_num_requests() - num_requests, size_t(3));
+
+    //the writes land in order
+    const std::vector<std::pair<boost::uint32_t, boost::uint32_t> > log = fw.get_poke_log();
+    BOOST_REQUIRE_EQUAL(log.size(), pokes.size());
+    for (size_t i = 0; i < pokes.size(); i++){
+        BOOST_CHECK_EQUAL(log[i].first, pokes[i].first);
+        BOOST_CHECK_EQUAL(log[i].second, pokes[i].second);
+    }
+    BOOST_CHECK_EQUAL(iface->peek32(pokes.back().first), pokes.back().second);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_poke32_fallback){
+    fw_ctrl_emulator fw(false, false);
+    usrp2_iface::sptr iface = make_iface(fw);
+
+    //the first batch is refused, then one pipelined request per write
+    const wb_iface::poke32_batch_type pokes = make_pokes(USRP2_CTRL_MAX_BATCH_POKES + 3);
+    size_t num_requests = fw.get_num_requests();
+    iface->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fw.get_num_requests() - num_requests, 2 + pokes.size());
+
+    //the iface remembers that the firmware has no batch request
+    num_requests = fw.get_num_requests();
+    iface->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fw.get_num_requests() - num_requests, pokes.size());
+
+    const std::vector<std::pair<boost::uint32_t, boost::uint32_t> > log = fw.get_poke_log();
+    BOOST_REQUIRE_EQUAL(log.size(), 2*pokes.size());
+    for (size_t i = 0; i < log.size(); i++){
+        BOOST_CHECK_EQUAL(log[i].first, pokes[i%pokes.size()].first);
+        BOOST_CHECK_EQUAL(log[i].second, pokes[i%pokes.size()].second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_duplicate_replies){
+    fw_ctrl_emulator fw(false, true);
+    usrp2_iface::sptr iface = make_iface(fw);
+
+    //stale replies from earlier requests are skipped by sequence number
+    const wb_iface::poke32_batch_type pokes = make_pokes(40);
+    iface->batch_poke32(pokes);
+    for (size_t i = 0; i < 16; i++){
+        iface->poke32(0x100 + 4*i, i);
+        BOOST_CHECK_EQUAL(iface->peek32(0x100 + 4*i), boost::uint32_t(i));
+    }
+    BOOST_CHECK_EQUAL(fw.get_poke_log().size(), pokes.size() + 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_poke32_speed){
+    fw_ctrl_emulator fw(true, false);
+    usrp2_iface::sptr iface = make_iface(fw);
+    const wb_iface::poke32_batch_type pokes = make_pokes(32);
+    const size_t num_iters = 100;
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < num_iters; n++){
+        for (size_t i = 0; i < pokes.size(); i++) iface->poke32(pokes[i].first, pokes[i].second);
+    }
+    const double single_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()/double(num_iters);
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (size_t n = 0; n < num_iters; n++) iface->batch_poke32(pokes);
+    const double batch_us = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()/double(num_iters);
+
+    std::cout << boost::format("%d pokes over loopback: single %.1f us, batch %.1f us") % pokes.size() % single_us % batch_us << std::endl;
+    BOOST_CHECK_EQUAL(fw.get_poke_log().size(), 2*num_iters*pokes.size());
+}
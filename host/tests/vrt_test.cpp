@@ -17,6 +17,9 @@
 
 #include <boost/test/unit_test.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <iostream>
+#include <vector>
 #include <cstdlib>
 
 using namespace uhd::transport;
@@ -139,3 +142,144 @@ BOOST_AUTO_TEST_CASE(test_with_all){
     if_packet_info.num_payload_words32 = 44444;
     pack_and_unpack(if_packet_info);
 }
+
+/***********************************************************************
+ * Test the batch unpacker against the single packet unpacker.
+ * A stream of packets with a context packet and a dropped packet
+ * is unpacked in two batches to test the continuity checks.
+ **********************************************************************/
+static const size_t batch_payload_words32 = 100;
+static const size_t batch_tick_rate = 1000;
+
+static void pack_stream(
+    std::vector<boost::uint32_t> &buffs, size_t num_packets, size_t drop_index
+){
+    static const size_t words_per_packet = batch_payload_words32 + vrt::max_if_hdr_words32;
+    buffs.assign(num_packets*words_per_packet, 0);
+    for (size_t i = 0, n = 0; i < num_packets; i++, n++){
+        if (i == drop_index) n++;
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        if_packet_info.packet_count = n;
+        if_packet_info.sob = false;
+        if_packet_info.eob = false;
+        if_packet_info.has_sid = true;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tsi = true;
+        if_packet_info.has_tsf = true;
+        if_packet_info.has_tlr = false;
+        if_packet_info.sid = 42;
+        if_packet_info.tsi = (n*batch_payload_words32)/batch_tick_rate;
+        if_packet_info.tsf = (n*batch_payload_words32)%batch_tick_rate;
+        if_packet_info.num_payload_words32 = batch_payload_words32;
+        if (i == 5){ //an inline message out of the stream
+            if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
+            if_packet_info.packet_count = 0;
+            n--;
+        }
+        vrt::if_hdr_pack_be(&buffs[i*words_per_packet], if_packet_info);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_unpack){
+    static const size_t num_packets = 32;
+    static const size_t drop_index = 20;
+    std::vector<boost::uint32_t> buffs;
+    pack_stream(buffs, num_packets, drop_index);
+
+    std::vector<const boost::uint32_t *> packet_buffs(num_packets);
+    std::vector<vrt::if_packet_info_t> if_packet_infos(num_packets);
+    for (size_t i = 0; i < num_packets; i++){
+        packet_buffs[i] = &buffs[i*(buffs.size()/num_packets)];
+        if_packet_infos[i].num_packet_words32 = buffs.size()/num_packets;
+    }
+
+    vrt::if_batch_info_t if_batch_info;
+    if_batch_info.tick_rate = batch_tick_rate;
+    if_batch_info.ticks_per_payload_word32 = 1.0;
+    if_batch_info.has_next_count = false;
+    if_batch_info.has_next_time = false;
+
+    //the first batch is continuous, the second batch has the drop
+    vrt::if_hdr_unpack_batch_be(&packet_buffs[0], &if_packet_infos[0], 16, if_batch_info);
+    BOOST_CHECK_EQUAL(if_batch_info.num_sequence_gaps, size_t(0));
+    BOOST_CHECK_EQUAL(if_batch_info.num_time_gaps, size_t(0));
+    BOOST_CHECK_EQUAL(if_batch_info.first_sequence_gap, size_t(16));
+    BOOST_CHECK_EQUAL(if_batch_info.first_time_gap, size_t(16));
+
+    vrt::if_hdr_unpack_batch_be(&packet_buffs[16], &if_packet_infos[16], num_packets-16, if_batch_info);
+    BOOST_CHECK_EQUAL(if_batch_info.num_sequence_gaps, size_t(1));
+    BOOST_CHECK_EQUAL(if_batch_info.num_time_gaps, size_t(1));
+    BOOST_CHECK_EQUAL(if_batch_info.first_sequence_gap, drop_index-16);
+    BOOST_CHECK_EQUAL(if_batch_info.first_time_gap, drop_index-16);
+
+    //the batch and the single packet unpacker agree
+    for (size_t i = 0; i < num_packets; i++){
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = buffs.size()/num_packets;
+        vrt::if_hdr_unpack_be(packet_buffs[i], if_packet_info);
+        BOOST_CHECK_EQUAL(if_packet_info.packet_type, if_packet_infos[i].packet_type);
+        BOOST_CHECK_EQUAL(if_packet_info.packet_count, if_packet_infos[i].packet_count);
+        BOOST_CHECK_EQUAL(if_packet_info.num_header_words32, if_packet_infos[i].num_header_words32);
+        BOOST_CHECK_EQUAL(if_packet_info.num_payload_words32, if_packet_infos[i].num_payload_words32);
+        BOOST_CHECK_EQUAL(if_packet_info.sid, if_packet_infos[i].sid);
+        BOOST_CHECK_EQUAL(if_packet_info.tsi, if_packet_infos[i].tsi);
+        BOOST_CHECK_EQUAL(if_packet_info.tsf, if_packet_infos[i].tsf);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_unpack_speed){
+    static const size_t num_packets = 64;
+    static const size_t num_batches = 100000;
+    std::vector<boost::uint32_t> buffs;
+    pack_stream(buffs, num_packets, num_packets);
+
+    std::vector<const boost::uint32_t *> packet_buffs(num_packets);
+    std::vector<vrt::if_packet_info_t> if_packet_infos(num_packets);
+    for (size_t i = 0; i < num_packets; i++){
+        packet_buffs[i] = &buffs[i*(buffs.size()/num_packets)];
+        if_packet_infos[i].num_packet_words32 = buffs.size()/num_packets;
+    }
+
+    //one call through a function pointer per packet, like the recv handler
+    void (*unpacker)(const boost::uint32_t *, vrt::if_packet_info_t &) = &vrt::if_hdr_unpack_be;
+    size_t num_single_gaps = 0, next_packet_count = 0;
+    boost::uint64_t next_ticks = 0;
+    const uhd::time_spec_t single_start = uhd::time_spec_t::get_system_time();
+    for (size_t n = 0; n < num_batches; n++){
+        bool has_next_time = false; //the stream repeats
+        for (size_t i = 0; i < num_packets; i++){
+            vrt::if_packet_info_t &if_packet_info = if_packet_infos[i];
+            unpacker(packet_buffs[i], if_packet_info);
+            if (if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA) continue;
+            if (if_packet_info.packet_count != next_packet_count) num_single_gaps++;
+            next_packet_count = (if_packet_info.packet_count + 1)%16;
+            const boost::uint64_t ticks = if_packet_info.tsi*batch_tick_rate + if_packet_info.tsf;
+            if (has_next_time and ticks != next_ticks) num_single_gaps++;
+            next_ticks = ticks + if_packet_info.num_payload_words32;
+            has_next_time = true;
+        }
+    }
+    const double single_elapsed = (uhd::time_spec_t::get_system_time() - single_start).get_real_secs();
+
+    vrt::if_batch_info_t if_batch_info;
+    if_batch_info.tick_rate = batch_tick_rate;
+    if_batch_info.ticks_per_payload_word32 = 1.0;
+    if_batch_info.has_next_count = false;
+    if_batch_info.has_next_time = false;
+    size_t num_batch_gaps = 0;
+    const uhd::time_spec_t batch_start = uhd::time_spec_t::get_system_time();
+    for (size_t n = 0; n < num_batches; n++){
+        if_batch_info.has_next_time = false; //the stream repeats
+        vrt::if_hdr_unpack_batch_be(&packet_buffs[0], &if_packet_infos[0], num_packets, if_batch_info);
+        num_batch_gaps += if_batch_info.num_sequence_gaps + if_batch_info.num_time_gaps;
+    }
+    const double batch_elapsed = (uhd::time_spec_t::get_system_time() - batch_start).get_real_secs();
+
+    //the stream is 63 data packets long, so it wraps with a count gap
+    BOOST_CHECK_EQUAL(num_batch_gaps, num_batches-1);
+    BOOST_CHECK_EQUAL(num_single_gaps, num_batches-1);
+    const double total = double(num_packets*num_batches);
+    std::cout << "single unpack: " << total/single_elapsed/1e6 << " Mpackets/s" << std::endl;
+    std::cout << "batch unpack: " << total/batch_elapsed/1e6 << " Mpackets/s" << std::endl;
+}
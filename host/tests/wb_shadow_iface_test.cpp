@@ -0,0 +1,205 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "wb_shadow_iface.hpp"
+#include <uhd/exception.hpp>
+#include <vector>
+#include <map>
+
+/***********************************************************************
+ * A register map that records every call made on it
+ **********************************************************************/
+class fake_wb_iface : public wb_iface{
+public:
+    typedef boost::shared_ptr<fake_wb_iface> sptr;
+
+    fake_wb_iface(void): num_calls(0), fail(false){ /* NOP */ }
+
+    void poke32(wb_addr_type addr, boost::uint32_t data){
+        num_calls++;
+        if (fail) throw uhd::runtime_error("fake wb iface failure");
+        regs[addr] = data;
+        log.push_back(std::make_pair(addr, data));
+    }
+
+    void batch_poke32(const poke32_batch_type &pokes){
+        num_calls++;
+        if (fail) throw uhd::runtime_error("fake wb iface failure");
+        for (size_t i = 0; i < pokes.size(); i++){
+            regs[pokes[i].first] = pokes[i].second;
+            log.push_back(pokes[i]);
+        }
+    }
+
+    boost::uint32_t peek32(wb_addr_type addr){
+        num_calls++;
+        return regs[addr];
+    }
+
+    void poke16(wb_addr_type addr, boost::uint16_t data){
+        num_calls++;
+        regs[addr & ~wb_addr_type(0x3)] = data;
+    }
+
+    boost::uint16_t peek16(wb_addr_type addr){
+        num_calls++;
+        return boost::uint16_t(regs[addr & ~wb_addr_type(0x3)]);
+    }
+
+    size_t num_calls;
+    bool fail;
+    std::map<wb_addr_type, boost::uint32_t> regs;
+    poke32_batch_type log;
+};
+
+BOOST_AUTO_TEST_CASE(test_shadow_skips_redundant){
+    fake_wb_iface::sptr fake(new fake_wb_iface());
+    wb_shadow_iface::sptr shadow = wb_shadow_iface::make(fake);
+    shadow->set_shadowed(0x100, 0x1ff);
+
+    //the first write always goes out, rewrites of the same value do not
+    shadow->poke32(0x100, 1);
+    shadow->poke32(0x100, 1);
+    shadow->poke32(0x104, 2);
+    shadow->poke32(0x100, 3);
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(3));
+    BOOST_CHECK_EQUAL(fake->regs[0x100], boost::uint32_t(3));
+
+    //registers outside of the shadow are always written (strobes)
+    shadow->poke32(0x200, 5);
+    shadow->poke32(0x200, 5);
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(5));
+
+    //forget the shadow: the next write goes out
+    shadow->clear_shadow();
+    shadow->poke32(0x104, 2);
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(6));
+
+    const wb_shadow_iface::stats_type stats = shadow->get_stats();
+    BOOST_CHECK_EQUAL(stats.num_pokes, size_t(7));
+    BOOST_CHECK_EQUAL(stats.num_redundant, size_t(1));
+    BOOST_CHECK_EQUAL(stats.num_transactions, size_t(6));
+}
+
+BOOST_AUTO_TEST_CASE(test_shadow_batch_poke32){
+    fake_wb_iface::sptr fake(new fake_wb_iface());
+    wb_shadow_iface::sptr shadow = wb_shadow_iface::make(fake);
+    shadow->set_shadowed(0x0, 0xf);
+
+    wb_iface::poke32_batch_type pokes;
+    for (size_t i = 0; i < 4; i++) pokes.push_back(std::make_pair(boost::uint32_t(4*i), boost::uint32_t(i)));
+    shadow->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(1));
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(4));
+
+    //only the changed register is left, sent as a single poke
+    pokes[2].second = 42;
+    shadow->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(2));
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(5));
+    BOOST_CHECK_EQUAL(fake->log.back().first, boost::uint32_t(8));
+    BOOST_CHECK_EQUAL(fake->log.back().second, boost::uint32_t(42));
+
+    //nothing changed: no call at all
+    shadow->batch_poke32(pokes);
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(test_shadow_burst){
+    fake_wb_iface::sptr fake(new fake_wb_iface());
+    wb_shadow_iface::sptr shadow = wb_shadow_iface::make(fake);
+
+    //pokes in a nested burst go out once, in order
+    shadow->begin_burst();
+    shadow->poke32(0x10, 1);
+    shadow->begin_burst();
+    shadow->poke32(0x14, 2);
+    shadow->end_burst();
+    shadow->poke32(0x10, 3);
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(0));
+    shadow->end_burst();
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(1));
+    BOOST_REQUIRE_EQUAL(fake->log.size(), size_t(3));
+    BOOST_CHECK_EQUAL(fake->log[0].first, boost::uint32_t(0x10));
+    BOOST_CHECK_EQUAL(fake->log[1].first, boost::uint32_t(0x14));
+    BOOST_CHECK_EQUAL(fake->log[2].second, boost::uint32_t(3));
+
+    //a read sends the queued pokes first
+    shadow->begin_burst();
+    shadow->poke32(0x18, 7);
+    BOOST_CHECK_EQUAL(shadow->peek32(0x18), boost::uint32_t(7));
+    shadow->end_burst();
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(4));
+}
+
+BOOST_AUTO_TEST_CASE(test_shadow_scoped_burst){
+    fake_wb_iface::sptr fake(new fake_wb_iface());
+    wb_shadow_iface::sptr shadow = wb_shadow_iface::make(fake);
+
+    //the burst ends with the scope
+    {
+        wb_shadow_iface::scoped_burst burst(shadow);
+        shadow->poke32(0x10, 1);
+        shadow->poke32(0x14, 2);
+        BOOST_CHECK_EQUAL(fake->num_calls, size_t(0));
+    }
+    BOOST_CHECK_EQUAL(fake->num_calls, size_t(1));
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(2));
+
+    //an exception that leaves the scope ends the burst
+    try{
+        wb_shadow_iface::scoped_burst burst(shadow);
+        shadow->poke32(0x18, 3);
+        throw uhd::value_error("leave the scope");
+    }
+    catch(const uhd::value_error &){}
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(3));
+    shadow->poke32(0x1c, 4);
+    BOOST_CHECK_EQUAL(fake->log.size(), size_t(4)); //not queued in a burst
+
+    //an explicit end sends the pokes and throws their errors
+    {
+        wb_shadow_iface::scoped_burst burst(shadow);
+        shadow->poke32(0x20, 5);
+        fake->fail = true;
+        BOOST_CHECK_THROW(burst.end(), uhd::runtime_error);
+        fake->fail = false;
+    }
+    shadow->poke32(0x24, 6);
+    BOOST_CHECK_EQUAL(fake->regs[0x24], boost::uint32_t(6));
+}
+
+BOOST_AUTO_TEST_CASE(test_shadow_failure){
+    fake_wb_iface::sptr fake(new fake_wb_iface());
+    wb_shadow_iface::sptr shadow = wb_shadow_iface::make(fake);
+    shadow->set_shadowed(0x0, 0xff);
+
+    shadow->poke32(0x20, 1);
+    fake->fail = true;
+    BOOST_CHECK_THROW(shadow->poke32(0x20, 2), uhd::runtime_error);
+    fake->fail = false;
+
+    //the failed write may not have landed, so it is not skipped
+    shadow->poke32(0x20, 2);
+    BOOST_CHECK_EQUAL(fake->regs[0x20], boost::uint32_t(2));
+
+    //a 16 bit write makes the 32 bit shadow unknown
+    shadow->poke16(0x22, 5);
+    shadow->poke32(0x20, 2);
+    BOOST_CHECK_EQUAL(fake->regs[0x20], boost::uint32_t(2));
+}
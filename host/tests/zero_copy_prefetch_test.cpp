@@ -0,0 +1,122 @@
+//
+// Copyright 2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/transport/zero_copy_prefetch.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+
+using namespace uhd::transport;
+
+/***********************************************************************
+ * A dummy managed receive buffer for testing
+ **********************************************************************/
+class dummy_mrb : public managed_recv_buffer{
+public:
+    dummy_mrb(bounded_buffer<dummy_mrb *> &available):
+        _available(available), _word(0){/* NOP */}
+
+    void release(void){
+        _available.push_with_haste(this);
+    }
+
+    sptr get_new(boost::uint32_t word){
+        _word = word;
+        return make_managed_buffer(this);
+    }
+
+private:
+    const void *get_buff(void) const{return &_word;}
+    size_t get_size(void) const{return sizeof(_word);}
+
+    bounded_buffer<dummy_mrb *> &_available;
+    boost::uint32_t _word;
+};
+
+/***********************************************************************
+ * A dummy transport that produces a fixed number of counting packets
+ **********************************************************************/
+class dummy_xport : public zero_copy_if{
+public:
+    dummy_xport(size_t num_frames, size_t num_packets):
+        _available(num_frames), _num_packets(num_packets), _count(0)
+    {
+        _mrbs.reserve(num_frames);
+        for (size_t i = 0; i < num_frames; i++){
+            _mrbs.push_back(dummy_mrb(_available));
+            _available.push_with_haste(&_mrbs.back());
+        }
+    }
+
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        dummy_mrb *mrb = NULL;
+        if (_count < _num_packets and _available.pop_with_timed_wait(mrb, timeout)){
+            return mrb->get_new(boost::uint32_t(_count++));
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        return managed_recv_buffer::sptr();
+    }
+
+    size_t get_num_recv_frames(void) const{return _mrbs.size();}
+    size_t get_recv_frame_size(void) const{return sizeof(boost::uint32_t);}
+    managed_send_buffer::sptr get_send_buff(double){return managed_send_buffer::sptr();}
+    size_t get_num_send_frames(void) const{return 0;}
+    size_t get_send_frame_size(void) const{return 0;}
+
+private:
+    bounded_buffer<dummy_mrb *> _available;
+    std::vector<dummy_mrb> _mrbs;
+    const size_t _num_packets;
+    size_t _count;
+};
+
+static const double timeout = 0.01/*secs*/;
+
+BOOST_AUTO_TEST_CASE(test_zero_copy_prefetch_timeout){
+    zero_copy_prefetch::sptr prefetch = zero_copy_prefetch::make(
+        zero_copy_if::sptr(new dummy_xport(8, 0))
+    );
+    BOOST_CHECK(prefetch->get_recv_buff(timeout).get() == NULL);
+    BOOST_CHECK_EQUAL(prefetch->get_num_prefetched_frames(), size_t(0));
+    BOOST_CHECK_EQUAL(prefetch->get_num_dropped_frames(), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_zero_copy_prefetch_drop_oldest){
+    static const size_t num_packets = 20;
+    zero_copy_prefetch::sptr prefetch = zero_copy_prefetch::make(
+        zero_copy_if::sptr(new dummy_xport(8, num_packets))
+    );
+    const size_t depth = prefetch->get_prefetch_depth();
+    BOOST_REQUIRE(depth > 0 and depth < num_packets);
+
+    //let the reader drain the transport without any consumer
+    for (size_t i = 0; i < 1000 and prefetch->get_num_prefetched_frames() < num_packets; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(prefetch->get_num_prefetched_frames(), num_packets);
+    BOOST_CHECK_EQUAL(prefetch->get_num_dropped_frames(), num_packets - depth);
+
+    //the ring holds only the freshest packets, in order
+    for (size_t i = num_packets - depth; i < num_packets; i++){
+        managed_recv_buffer::sptr buff = prefetch->get_recv_buff(timeout);
+        BOOST_REQUIRE(buff.get() != NULL);
+        BOOST_CHECK_EQUAL(buff->cast<const boost::uint32_t *>()[0], boost::uint32_t(i));
+    }
+    BOOST_CHECK(prefetch->get_recv_buff(timeout).get() == NULL);
+}